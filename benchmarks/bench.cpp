@@ -0,0 +1,353 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cachersize/Provider.hpp>
+#include <cachersize/Admin.hpp>
+#include <cachersize/Client.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <tclap/CmdLine.h>
+#include <thallium.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace tl = thallium;
+using json = nlohmann::json;
+
+enum Op { PUT, GET, ERASE, EXISTS, SUM, NUM_OPS };
+static const char* g_op_names[NUM_OPS] = { "put", "get", "erase", "exists", "sum" };
+
+static std::string g_protocol;
+static std::string g_server;
+static uint16_t    g_provider_id;
+static std::string g_backend;
+static std::string g_cache_config;
+static unsigned    g_num_clients;
+static unsigned    g_num_xstreams;
+static unsigned    g_queue_depth;
+static double      g_duration;
+static size_t      g_num_ops;
+static size_t      g_num_keys;
+static bool        g_prefill;
+static double      g_op_weights[NUM_OPS];
+static size_t      g_value_min;
+static size_t      g_value_max;
+static std::string g_log_level;
+
+static void parse_command_line(int argc, char** argv);
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * Operation in flight. Its key and value must stay alive until its
+ * request has been waited on.
+ */
+struct Slot {
+    Op                       op;
+    clock_type::time_point   start;
+    std::string              key;
+    std::string              value;
+    bool                     exists;
+    int32_t                  sum;
+    cachersize::AsyncRequest req;
+};
+
+struct ClientStats {
+    std::vector<double> latencies[NUM_OPS]; // microseconds
+    size_t              errors[NUM_OPS] = {};
+};
+
+/**
+ * Runs one client: keeps g_queue_depth operations in flight until
+ * g_num_ops operations have been issued or g_duration has elapsed.
+ */
+static void run_client(const cachersize::CacheHandle& cache,
+                       const std::string& payload,
+                       unsigned index,
+                       ClientStats* stats) {
+    std::mt19937_64 rng(index);
+    std::discrete_distribution<int> op_dist(g_op_weights, g_op_weights + NUM_OPS);
+    std::uniform_int_distribution<size_t> key_dist(0, g_num_keys - 1);
+    std::uniform_int_distribution<size_t> size_dist(g_value_min, g_value_max);
+
+    std::vector<Slot> slots(g_queue_depth);
+    std::vector<cachersize::AsyncRequest> requests(g_queue_depth);
+    auto deadline = clock_type::now() + std::chrono::duration_cast<clock_type::duration>(
+                                            std::chrono::duration<double>(g_duration));
+    size_t issued = 0;
+
+    auto can_issue = [&]() {
+        if(g_num_ops) return issued < g_num_ops;
+        return clock_type::now() < deadline;
+    };
+
+    auto issue = [&](size_t i) {
+        auto& slot = slots[i];
+        slot.op    = static_cast<Op>(op_dist(rng));
+        slot.key   = "key" + std::to_string(key_dist(rng));
+        slot.start = clock_type::now();
+        switch(slot.op) {
+        case PUT:
+            slot.value.assign(payload, 0, size_dist(rng));
+            cache.put(slot.key, slot.value, &slot.req);
+            break;
+        case GET:
+            cache.get(slot.key, &slot.value, &slot.req);
+            break;
+        case ERASE:
+            cache.erase(slot.key, &slot.req);
+            break;
+        case EXISTS:
+            cache.exists(slot.key, &slot.exists, &slot.req);
+            break;
+        default:
+            cache.computeSum(42, (int32_t)i, &slot.sum, &slot.req);
+        }
+        requests[i] = slot.req;
+        issued += 1;
+    };
+
+    for(size_t i = 0; i < slots.size() && can_issue(); i++)
+        issue(i);
+
+    while(true) {
+        size_t i = cachersize::AsyncRequest::waitAny(requests);
+        if(i == requests.size()) break;
+        auto& slot = slots[i];
+        try {
+            slot.req.wait();
+        } catch(const cachersize::Exception&) {
+            stats->errors[slot.op] += 1;
+        }
+        stats->latencies[slot.op].push_back(
+            std::chrono::duration<double, std::micro>(clock_type::now() - slot.start).count());
+        requests[i] = cachersize::AsyncRequest();
+        slot.req    = cachersize::AsyncRequest();
+        if(can_issue()) issue(i);
+    }
+}
+
+static json summarize(std::vector<double>& latencies, size_t errors, double seconds) {
+    json r = json::object();
+    r["count"]  = latencies.size();
+    r["errors"] = errors;
+    r["throughput_ops_per_sec"] = latencies.size() / seconds;
+    if(latencies.empty()) return r;
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for(auto t : latencies) total += t;
+    auto pct = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))];
+    };
+    r["mean_us"]  = total / latencies.size();
+    r["p50_us"]   = pct(0.5);
+    r["p99_us"]   = pct(0.99);
+    r["p99.9_us"] = pct(0.999);
+    r["max_us"]   = latencies.back();
+    return r;
+}
+
+int main(int argc, char** argv) {
+    parse_command_line(argc, argv);
+    spdlog::set_level(spdlog::level::from_str(g_log_level));
+
+    bool local = g_server.empty();
+    tl::engine engine(local ? g_protocol : g_server.substr(0, g_server.find(':')),
+                      local ? THALLIUM_SERVER_MODE : THALLIUM_CLIENT_MODE);
+    std::unique_ptr<cachersize::Provider> provider;
+    if(local) provider.reset(new cachersize::Provider(engine, g_provider_id));
+    std::string address = local ? std::string(engine.self()) : g_server;
+
+    json report = json::object();
+    try {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        auto cache_id = admin.createCache(address, g_provider_id, g_backend, g_cache_config);
+        auto cache = client.makeCacheHandle(address, g_provider_id, cache_id);
+
+        std::string payload(g_value_max, 0);
+        std::mt19937_64 rng(0);
+        std::uniform_int_distribution<int> byte_dist('a', 'z');
+        for(auto& c : payload) c = (char)byte_dist(rng);
+
+        if(g_prefill) {
+            std::vector<std::string> keys, values;
+            for(size_t k = 0; k < g_num_keys; k++) {
+                keys.push_back("key" + std::to_string(k));
+                values.emplace_back(payload, 0, g_value_max);
+                if(keys.size() == 256 || k + 1 == g_num_keys) {
+                    std::vector<cachersize::Status> statuses;
+                    cache.putMulti(keys, values, &statuses);
+                    keys.clear();
+                    values.clear();
+                }
+            }
+        }
+
+        auto pool = tl::pool::create(tl::pool::access::mpmc);
+        std::vector<tl::managed<tl::xstream>> xstreams;
+        for(unsigned i = 0; i < g_num_xstreams; i++)
+            xstreams.push_back(tl::xstream::create(tl::scheduler::predef::deflt, *pool));
+
+        std::vector<ClientStats> stats(g_num_clients);
+        std::vector<tl::managed<tl::thread>> ults;
+        auto start = clock_type::now();
+        for(unsigned i = 0; i < g_num_clients; i++) {
+            ults.push_back(pool->make_thread([&cache, &payload, &stats, i]() {
+                run_client(cache, payload, i, &stats[i]);
+            }));
+        }
+        for(auto& ult : ults) ult->join();
+        double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+        for(auto& x : xstreams) x->join();
+
+        std::vector<double> all;
+        size_t all_errors = 0;
+        json ops = json::object();
+        for(int op = 0; op < NUM_OPS; op++) {
+            if(g_op_weights[op] == 0) continue;
+            std::vector<double> latencies;
+            size_t errors = 0;
+            for(auto& s : stats) {
+                latencies.insert(latencies.end(), s.latencies[op].begin(), s.latencies[op].end());
+                errors += s.errors[op];
+            }
+            all.insert(all.end(), latencies.begin(), latencies.end());
+            all_errors += errors;
+            ops[g_op_names[op]] = summarize(latencies, errors, seconds);
+        }
+
+        json config = json::object();
+        config["address"]       = address;
+        config["backend"]       = g_backend;
+        config["clients"]       = g_num_clients;
+        config["xstreams"]      = g_num_xstreams;
+        config["queue_depth"]   = g_queue_depth;
+        config["num_keys"]      = g_num_keys;
+        config["value_size"]    = { g_value_min, g_value_max };
+        report["config"]     = config;
+        report["duration_s"] = seconds;
+        report["total"]      = summarize(all, all_errors, seconds);
+        report["ops"]        = ops;
+
+        admin.destroyCache(address, g_provider_id, cache_id);
+    } catch(const cachersize::Exception& ex) {
+        std::cerr << "error: " << ex.what() << std::endl;
+        provider.reset();
+        engine.finalize();
+        return -1;
+    }
+
+    std::cout << report.dump(4) << std::endl;
+    provider.reset();
+    engine.finalize();
+    return 0;
+}
+
+/**
+ * Parses an operation mix of the form "get:80,put:20".
+ */
+static void parse_mix(const std::string& mix) {
+    std::fill(g_op_weights, g_op_weights + NUM_OPS, 0.0);
+    std::stringstream ss(mix);
+    std::string item;
+    while(std::getline(ss, item, ',')) {
+        auto colon = item.find(':');
+        std::string name = item.substr(0, colon);
+        double weight = colon == std::string::npos ? 1.0 : std::stod(item.substr(colon + 1));
+        auto it = std::find(g_op_names, g_op_names + NUM_OPS, name);
+        if(it == g_op_names + NUM_OPS)
+            throw TCLAP::ArgException("unknown operation " + name, "mix");
+        g_op_weights[it - g_op_names] = weight;
+    }
+    if(std::all_of(g_op_weights, g_op_weights + NUM_OPS, [](double w) { return w <= 0; }))
+        throw TCLAP::ArgException("no operation with a positive weight", "mix");
+}
+
+/**
+ * Parses a value size distribution: "N" or "fixed:N" for a fixed
+ * size, "uniform:MIN:MAX" for sizes uniformly distributed in [MIN,MAX].
+ */
+static void parse_value_size(const std::string& dist) {
+    std::vector<std::string> fields;
+    std::stringstream ss(dist);
+    std::string field;
+    while(std::getline(ss, field, ':')) fields.push_back(field);
+    try {
+        if(fields.size() == 1) {
+            g_value_min = g_value_max = std::stoull(fields[0]);
+        } else if(fields.size() == 2 && fields[0] == "fixed") {
+            g_value_min = g_value_max = std::stoull(fields[1]);
+        } else if(fields.size() == 3 && fields[0] == "uniform") {
+            g_value_min = std::stoull(fields[1]);
+            g_value_max = std::stoull(fields[2]);
+        } else {
+            throw std::invalid_argument(dist);
+        }
+    } catch(const std::logic_error&) {
+        throw TCLAP::ArgException("invalid distribution " + dist, "value-size");
+    }
+    if(g_value_min > g_value_max)
+        throw TCLAP::ArgException("invalid distribution " + dist, "value-size");
+}
+
+void parse_command_line(int argc, char** argv) {
+    try {
+        TCLAP::CmdLine cmd("Generates load on a Cachersize cache and reports throughput and latency as JSON", ' ', "0.1");
+        TCLAP::ValueArg<std::string> protocolArg("p","protocol","Protocol of the local provider (e.g. na+sm, ofi+tcp; default na+sm)", false, "na+sm", "string");
+        TCLAP::ValueArg<std::string> serverArg("s","server","Address of an existing server (default: start a local provider)", false, "", "string");
+        TCLAP::ValueArg<uint16_t> providerArg("i","provider-id","Provider id (default 0)", false, 0, "int");
+        TCLAP::ValueArg<std::string> backendArg("b","backend","Cache type (default memory)", false, "memory", "string");
+        TCLAP::ValueArg<std::string> configArg("j","config","Cache configuration (JSON, default {})", false, "{}", "string");
+        TCLAP::ValueArg<unsigned> clientsArg("c","num-clients","Number of client ULTs (default 1)", false, 1, "int");
+        TCLAP::ValueArg<unsigned> xstreamsArg("x","num-xstreams","Number of xstreams running the clients (default 1)", false, 1, "int");
+        TCLAP::ValueArg<unsigned> depthArg("q","queue-depth","Operations in flight per client (default 1)", false, 1, "int");
+        TCLAP::ValueArg<double> durationArg("d","duration","Duration of the run in seconds (default 10)", false, 10.0, "float");
+        TCLAP::ValueArg<size_t> opsArg("n","num-ops","Operations per client; overrides --duration if not 0", false, 0, "int");
+        TCLAP::ValueArg<size_t> keysArg("k","num-keys","Number of distinct keys (default 100000)", false, 100000, "int");
+        TCLAP::SwitchArg noPrefillArg("","no-prefill","Do not store all the keys before the run", cmd, false);
+        TCLAP::ValueArg<std::string> mixArg("m","mix","Operation mix, e.g. get:80,put:20 (operations: put, get, erase, exists, sum)", false, "get:90,put:10", "string");
+        TCLAP::ValueArg<std::string> sizeArg("v","value-size","Value sizes: N, fixed:N, or uniform:MIN:MAX (default 1024)", false, "1024", "string");
+        TCLAP::ValueArg<std::string> logLevel("l","log-level", "Log level (trace, debug, info, warning, error, critical, off)", false, "warning", "string");
+        cmd.add(protocolArg);
+        cmd.add(serverArg);
+        cmd.add(providerArg);
+        cmd.add(backendArg);
+        cmd.add(configArg);
+        cmd.add(clientsArg);
+        cmd.add(xstreamsArg);
+        cmd.add(depthArg);
+        cmd.add(durationArg);
+        cmd.add(opsArg);
+        cmd.add(keysArg);
+        cmd.add(mixArg);
+        cmd.add(sizeArg);
+        cmd.add(logLevel);
+        cmd.parse(argc, argv);
+        g_protocol     = protocolArg.getValue();
+        g_server       = serverArg.getValue();
+        g_provider_id  = providerArg.getValue();
+        g_backend      = backendArg.getValue();
+        g_cache_config = configArg.getValue();
+        g_num_clients  = std::max(1u, clientsArg.getValue());
+        g_num_xstreams = std::max(1u, xstreamsArg.getValue());
+        g_queue_depth  = std::max(1u, depthArg.getValue());
+        g_duration     = durationArg.getValue();
+        g_num_ops      = opsArg.getValue();
+        g_num_keys     = std::max<size_t>(1, keysArg.getValue());
+        g_prefill      = not noPrefillArg.getValue();
+        g_log_level    = logLevel.getValue();
+        parse_mix(mixArg.getValue());
+        parse_value_size(sizeArg.getValue());
+    } catch(TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(-1);
+    }
+}
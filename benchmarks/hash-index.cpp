@@ -0,0 +1,120 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include "HashIndex.hpp"
+#include <nlohmann/json.hpp>
+#include <tclap/CmdLine.h>
+#include <unordered_map>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+
+using json = nlohmann::json;
+
+static std::vector<size_t> g_sizes;
+static size_t              g_num_lookups;
+static unsigned            g_seed;
+
+static void parse_command_line(int argc, char** argv);
+
+using clock_type = std::chrono::steady_clock;
+
+static double elapsed(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+static std::string make_key(size_t i) {
+    return "key-" + std::to_string(i);
+}
+
+/**
+ * Runs the insert/hit/miss/erase phases against a map type exposing
+ * a find function that returns something testable as a boolean.
+ */
+template<typename Map, typename Find>
+static json run(const char* name, size_t n, Find&& find) {
+    json result = json::object();
+    result["index"]   = name;
+    result["entries"] = n;
+
+    std::mt19937_64 rng(g_seed);
+    std::vector<size_t> hits(g_num_lookups), misses(g_num_lookups);
+    for(auto& i : hits)   i = rng() % n;
+    for(auto& i : misses) i = n + rng() % n;
+    std::vector<std::string> hit_keys, miss_keys;
+    hit_keys.reserve(g_num_lookups);
+    miss_keys.reserve(g_num_lookups);
+    for(auto i : hits)   hit_keys.push_back(make_key(i));
+    for(auto i : misses) miss_keys.push_back(make_key(i));
+
+    Map map;
+    auto t = clock_type::now();
+    for(size_t i = 0; i < n; i++)
+        map[make_key(i)] = i;
+    result["insert_mops"] = n / elapsed(t) / 1e6;
+
+    size_t found = 0;
+    t = clock_type::now();
+    for(auto& k : hit_keys)
+        if(find(map, k)) found += 1;
+    result["hit_mops"] = g_num_lookups / elapsed(t) / 1e6;
+
+    t = clock_type::now();
+    for(auto& k : miss_keys)
+        if(find(map, k)) found += 1;
+    result["miss_mops"] = g_num_lookups / elapsed(t) / 1e6;
+
+    t = clock_type::now();
+    for(size_t i = 0; i < n; i += 2)
+        map.erase(make_key(i));
+    result["erase_mops"] = (n/2) / elapsed(t) / 1e6;
+
+    if(found != g_num_lookups) // all hits should be found, no misses
+        result["error"] = "unexpected number of keys found";
+    return result;
+}
+
+int main(int argc, char** argv) {
+    parse_command_line(argc, argv);
+    json results = json::array();
+    for(auto n : g_sizes) {
+        results.push_back(run<std::unordered_map<std::string, size_t>>(
+            "std::unordered_map", n,
+            [](std::unordered_map<std::string, size_t>& m, const std::string& k) {
+                return m.find(k) != m.end();
+            }));
+        std::cerr << results.back().dump() << std::endl;
+        results.push_back(run<cachersize::HashIndex<size_t>>(
+            "cachersize::HashIndex", n,
+            [](cachersize::HashIndex<size_t>& m, const std::string& k) {
+                return m.find(k) != nullptr;
+            }));
+        std::cerr << results.back().dump() << std::endl;
+    }
+    std::cout << results.dump(4) << std::endl;
+    return 0;
+}
+
+void parse_command_line(int argc, char** argv) {
+    try {
+        TCLAP::CmdLine cmd("Compares cachersize::HashIndex with std::unordered_map", ' ', "0.1");
+        TCLAP::MultiArg<size_t> sizesArg("n","num-entries","Number of entries (may be repeated, default 1M, 10M, 100M)", false, "int");
+        TCLAP::ValueArg<size_t> lookupsArg("l","num-lookups","Number of hit and miss lookups per run (default 1M)", false, 1000000, "int");
+        TCLAP::ValueArg<unsigned> seedArg("s","seed","Random seed (default 0)", false, 0, "int");
+        cmd.add(sizesArg);
+        cmd.add(lookupsArg);
+        cmd.add(seedArg);
+        cmd.parse(argc, argv);
+        g_sizes = sizesArg.getValue();
+        if(g_sizes.empty())
+            g_sizes = { 1000000, 10000000, 100000000 };
+        g_num_lookups = lookupsArg.getValue();
+        g_seed = seedArg.getValue();
+    } catch(TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(-1);
+    }
+}
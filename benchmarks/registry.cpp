@@ -0,0 +1,130 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include "CacheRegistry.hpp"
+#include <cachersize/UUID.hpp>
+#include <nlohmann/json.hpp>
+#include <tclap/CmdLine.h>
+#include <thallium.hpp>
+#include <unordered_map>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <mutex>
+
+namespace tl = thallium;
+using json = nlohmann::json;
+
+static std::vector<unsigned> g_num_xstreams;
+static size_t                g_num_lookups;
+static size_t                g_num_caches;
+
+static void parse_command_line(int argc, char** argv);
+
+struct FakeBackend {
+    std::atomic<uint64_t> calls = { 0 };
+};
+
+/**
+ * Registry protected the way ProviderImpl used to protect it:
+ * a tl::mutex and a shared_ptr copy per lookup.
+ */
+struct MutexRegistry {
+    std::unordered_map<cachersize::UUID, std::shared_ptr<FakeBackend>> map;
+    tl::mutex mtx;
+
+    void lookup(const cachersize::UUID& id) {
+        std::shared_ptr<FakeBackend> backend;
+        {
+            std::lock_guard<tl::mutex> lock(mtx);
+            auto it = map.find(id);
+            if(it == map.end()) return;
+            backend = it->second;
+        }
+        backend->calls.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+struct RCURegistry {
+    cachersize::CacheRegistry<cachersize::UUID, FakeBackend> registry;
+
+    void lookup(const cachersize::UUID& id) {
+        auto guard = registry.read();
+        auto backend = guard.find(id);
+        if(backend) backend->calls.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Runs one ULT per xstream, each performing g_num_lookups lookups,
+ * and returns the aggregate number of lookups per second.
+ */
+template<typename Registry>
+static double run(Registry& registry, const std::vector<cachersize::UUID>& ids, unsigned num_xstreams) {
+    auto pool = tl::pool::create(tl::pool::access::mpmc);
+    std::vector<tl::managed<tl::xstream>> xstreams;
+    for(unsigned i = 0; i < num_xstreams; i++)
+        xstreams.push_back(tl::xstream::create(tl::scheduler::predef::deflt, *pool));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<tl::managed<tl::thread>> ults;
+    for(unsigned i = 0; i < num_xstreams; i++) {
+        ults.push_back(pool->make_thread([&registry, &ids, i]() {
+            for(size_t j = 0; j < g_num_lookups; j++)
+                registry.lookup(ids[(i + j) % ids.size()]);
+        }));
+    }
+    for(auto& ult : ults) ult->join();
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for(auto& x : xstreams) x->join();
+    return num_xstreams * g_num_lookups / t;
+}
+
+int main(int argc, char** argv) {
+    parse_command_line(argc, argv);
+    tl::abt scope;
+
+    std::vector<cachersize::UUID> ids;
+    MutexRegistry mutex_registry;
+    RCURegistry rcu_registry;
+    for(size_t i = 0; i < g_num_caches; i++) {
+        ids.push_back(cachersize::UUID::generate());
+        auto backend = std::make_shared<FakeBackend>();
+        mutex_registry.map[ids.back()] = backend;
+        rcu_registry.registry.insert(ids.back(), backend);
+    }
+
+    json results = json::array();
+    for(auto n : g_num_xstreams) {
+        json r = json::object();
+        r["xstreams"] = n;
+        r["mutex_lookups_per_sec"] = run(mutex_registry, ids, n);
+        r["rcu_lookups_per_sec"]   = run(rcu_registry, ids, n);
+        std::cerr << r.dump() << std::endl;
+        results.push_back(r);
+    }
+    std::cout << results.dump(4) << std::endl;
+    return 0;
+}
+
+void parse_command_line(int argc, char** argv) {
+    try {
+        TCLAP::CmdLine cmd("Measures cache registry lookup throughput under contention", ' ', "0.1");
+        TCLAP::MultiArg<unsigned> xstreamsArg("x","num-xstreams","Number of handler xstreams (may be repeated, default 1 to 64)", false, "int");
+        TCLAP::ValueArg<size_t> lookupsArg("l","num-lookups","Number of lookups per xstream (default 1M)", false, 1000000, "int");
+        TCLAP::ValueArg<size_t> cachesArg("c","num-caches","Number of caches in the registry (default 8)", false, 8, "int");
+        cmd.add(xstreamsArg);
+        cmd.add(lookupsArg);
+        cmd.add(cachesArg);
+        cmd.parse(argc, argv);
+        g_num_xstreams = xstreamsArg.getValue();
+        if(g_num_xstreams.empty())
+            g_num_xstreams = { 1, 2, 4, 8, 16, 32, 64 };
+        g_num_lookups = lookupsArg.getValue();
+        g_num_caches = cachesArg.getValue();
+    } catch(TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(-1);
+    }
+}
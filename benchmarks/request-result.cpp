@@ -0,0 +1,113 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cachersize/RequestResult.hpp>
+#include <nlohmann/json.hpp>
+#include <tclap/CmdLine.h>
+#include <thallium.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+namespace tl = thallium;
+using json = nlohmann::json;
+
+static std::string g_protocol;
+static size_t      g_num_calls;
+static size_t      g_num_warmup;
+
+static void parse_command_line(int argc, char** argv);
+
+/**
+ * RequestResult as it was serialized before the compact encoding:
+ * a bool, an error string (even when empty), and the value.
+ */
+template<typename T>
+struct LegacyResult {
+    bool        success = true;
+    std::string error   = "";
+    T           value;
+
+    template<typename Archive>
+    void serialize(Archive& a) {
+        a & success;
+        a & error;
+        a & value;
+    }
+};
+
+/**
+ * Calls rpc g_num_calls times on the engine itself (after g_num_warmup
+ * calls) and returns latency statistics in microseconds.
+ */
+template<typename Result>
+static json run(tl::engine& engine, const tl::remote_procedure& rpc) {
+    tl::provider_handle ph(engine.self(), 0);
+    std::vector<double> latencies;
+    latencies.reserve(g_num_calls);
+    for(size_t i = 0; i < g_num_warmup + g_num_calls; i++) {
+        auto start = std::chrono::steady_clock::now();
+        Result result = rpc.on(ph)((int32_t)i, (int32_t)1);
+        auto t = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count();
+        (void)result;
+        if(i >= g_num_warmup) latencies.push_back(t);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for(auto t : latencies) total += t;
+    json r = json::object();
+    r["mean_us"] = total / latencies.size();
+    r["p50_us"]  = latencies[latencies.size() / 2];
+    r["p99_us"]  = latencies[latencies.size() * 99 / 100];
+    return r;
+}
+
+int main(int argc, char** argv) {
+    parse_command_line(argc, argv);
+    tl::engine engine(g_protocol, THALLIUM_SERVER_MODE);
+
+    auto legacy = engine.define("legacy_sum",
+        [](const tl::request& req, int32_t x, int32_t y) {
+            LegacyResult<int32_t> result;
+            result.value = x + y;
+            req.respond(result);
+        });
+    auto compact = engine.define("compact_sum",
+        [](const tl::request& req, int32_t x, int32_t y) {
+            cachersize::RequestResult<int32_t> result;
+            result.value() = x + y;
+            req.respond(result);
+        });
+
+    json results = json::object();
+    results["legacy"]  = run<LegacyResult<int32_t>>(engine, legacy);
+    results["compact"] = run<cachersize::RequestResult<int32_t>>(engine, compact);
+    std::cout << results.dump(4) << std::endl;
+
+    engine.finalize();
+    return 0;
+}
+
+void parse_command_line(int argc, char** argv) {
+    try {
+        TCLAP::CmdLine cmd("Measures computeSum round-trip latency with the legacy and compact RequestResult encodings", ' ', "0.1");
+        TCLAP::ValueArg<std::string> protocolArg("p","protocol","Mercury protocol (default na+sm)", false, "na+sm", "string");
+        TCLAP::ValueArg<size_t> callsArg("n","num-calls","Number of measured calls per encoding (default 100k)", false, 100000, "int");
+        TCLAP::ValueArg<size_t> warmupArg("w","num-warmup","Number of warmup calls per encoding (default 1000)", false, 1000, "int");
+        cmd.add(protocolArg);
+        cmd.add(callsArg);
+        cmd.add(warmupArg);
+        cmd.parse(argc, argv);
+        g_protocol = protocolArg.getValue();
+        g_num_calls = callsArg.getValue();
+        g_num_warmup = warmupArg.getValue();
+    } catch(TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(-1);
+    }
+}
@@ -191,6 +191,95 @@ class Admin {
                          const UUID& cache_id,
                          const std::string& token="") const;
 
+    /**
+     * @brief Returns the statistics of a cache as a JSON-formatted
+     * string (see CacheHandle::getStats).
+     *
+     * @param address Address of the target provider.
+     * @param provider_id Provider id.
+     * @param cache_id UUID of the cache.
+     */
+    std::string getCacheStats(const std::string& address,
+                              uint16_t provider_id,
+                              const UUID& cache_id) const;
+
+    /**
+     * @brief Writes the entries of a cache to a snapshot file on the
+     * target provider's node, while the cache keeps serving requests.
+     * The snapshot can be loaded with restoreCache, or when opening a
+     * cache by adding a "snapshot" field to its configuration, either
+     * the path of the snapshot or an object { "path" : ..., "wait" : ... }.
+     * If "wait" is false, openCache returns before the snapshot is loaded
+     * and the cache serves requests meanwhile; its statistics report the
+     * progress of the restoration. An existing file at path is only
+     * replaced once the snapshot is complete.
+     *
+     * @param address Address of the target provider.
+     * @param provider_id Provider id.
+     * @param cache_id UUID of the cache.
+     * @param path Path of the snapshot file on the provider's node.
+     *
+     * @return the number of entries written.
+     */
+    uint64_t snapshotCache(const std::string& address,
+                           uint16_t provider_id,
+                           const UUID& cache_id,
+                           const std::string& path,
+                           const std::string& token="") const;
+
+    /**
+     * @brief Loads a snapshot written by snapshotCache into a cache.
+     * Entries that expired since the snapshot, and keys that are already
+     * in the cache, are skipped.
+     *
+     * @param address Address of the target provider.
+     * @param provider_id Provider id.
+     * @param cache_id UUID of the cache.
+     * @param path Path of the snapshot file on the provider's node.
+     *
+     * @return the number of entries loaded.
+     */
+    uint64_t restoreCache(const std::string& address,
+                          uint16_t provider_id,
+                          const UUID& cache_id,
+                          const std::string& path,
+                          const std::string& token="") const;
+
+    /**
+     * @brief Moves a cache from a provider to another, under the same
+     * UUID. The source streams the entries of the cache to the destination
+     * with pipelined RDMA transfers while it keeps serving requests, then
+     * sends again the keys written meanwhile, and finally switches over:
+     * requests that reach the source during the switchover wait for it,
+     * and later ones are redirected, so CacheHandle objects created for
+     * the source transparently follow the cache to the destination. On
+     * failure, the cache stays on the source.
+     *
+     * The destination creates the cache with the type and configuration
+     * it was created or opened with on the source, unless config is given
+     * (e.g. to use other files for a cache backed by storage). Once the
+     * migration succeeds, the source destroys its copy. The security
+     * token must be accepted by both providers.
+     *
+     * @param source_address Address of the provider holding the cache.
+     * @param source_provider_id Provider id of the source.
+     * @param cache_id UUID of the cache.
+     * @param dest_address Address of the destination provider.
+     * @param dest_provider_id Provider id of the destination.
+     * @param config JSON configuration of the cache on the destination,
+     * or an empty string to use the source's.
+     *
+     * @return the number of entries inserted, updated or erased at the
+     * destination.
+     */
+    uint64_t migrateCache(const std::string& source_address,
+                          uint16_t source_provider_id,
+                          const UUID& cache_id,
+                          const std::string& dest_address,
+                          uint16_t dest_provider_id,
+                          const std::string& config = "",
+                          const std::string& token="") const;
+
     /**
      * @brief Shuts down the target server. The Thallium engine
      * used by the server must have remote shutdown enabled.
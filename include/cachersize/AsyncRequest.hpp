@@ -6,13 +6,18 @@
 #ifndef __CACHERSIZE_ASYNC_REQUEST_HPP
 #define __CACHERSIZE_ASYNC_REQUEST_HPP
 
+#include <thallium.hpp>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace cachersize {
 
 class AsyncRequestImpl;
 class CacheHandle;
+class DistributedCacheHandle;
 
 /**
  * @brief AsyncRequest objects are used to keep track of
@@ -21,6 +26,7 @@ class CacheHandle;
 class AsyncRequest {
 
     friend CacheHandle;
+    friend DistributedCacheHandle;
 
     public:
 
@@ -55,15 +61,60 @@ class AsyncRequest {
     ~AsyncRequest();
 
     /**
-     * @brief Wait for the request to complete.
+     * @brief Wait for the request to complete. Waiting again on a
+     * completed request returns immediately, or rethrows the error
+     * the request completed with.
      */
     void wait() const;
 
     /**
      * @brief Test if the request has completed, without blocking.
+     * A request that has completed still needs to be waited on for
+     * its outputs to be filled.
      */
     bool completed() const;
 
+    /**
+     * @brief Completion callback. The argument is null if the request
+     * succeeded, otherwise it holds the error it failed with.
+     */
+    using Callback = std::function<void(std::exception_ptr)>;
+
+    /**
+     * @brief Completes the request in a ULT pushed to the given pool,
+     * then calls the callback from that ULT. The request's outputs are
+     * filled before the callback is called. The caller does not have
+     * to wait on the request anymore (waiting remains valid).
+     *
+     * @param callback Function to call once the request completes.
+     * @param pool Argobots pool in which to run the callback.
+     */
+    void onCompletion(Callback callback, const thallium::pool& pool) const;
+
+    /**
+     * @brief Waits for all the requests of a set (invalid ones are
+     * ignored). If some of them fail, the error of the first one is
+     * rethrown once all have completed.
+     */
+    static void waitAll(const std::vector<AsyncRequest>& requests);
+
+    /**
+     * @brief Waits until one of the requests of a set that have not yet
+     * been waited on completes, and returns its index. The request is
+     * not waited on: calling wait() on it (which does not block) fills
+     * its outputs or throws its error. Returns requests.size() if no
+     * request of the set remains to be waited on.
+     */
+    static size_t waitAny(const std::vector<AsyncRequest>& requests);
+
+    /**
+     * @brief Fills indices with the indices of the requests of a set
+     * that have completed but have not yet been waited on, without
+     * blocking, and returns their number.
+     */
+    static size_t testSome(const std::vector<AsyncRequest>& requests,
+                           std::vector<size_t>* indices);
+
     /**
      * @brief Checks if the Collection object is valid.
      */
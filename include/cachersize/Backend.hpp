@@ -7,9 +7,11 @@
 #define __CACHERSIZE_BACKEND_HPP
 
 #include <cachersize/RequestResult.hpp>
+#include <cachersize/Status.hpp>
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include <thallium.hpp>
 
@@ -37,6 +39,20 @@ class Backend {
     
     public:
 
+    /**
+     * @brief Memory used by a cache, which the provider charges against
+     * its memory budget (if it has one). A resizable cache also reports
+     * the hits it would gain with more memory, which the provider uses
+     * to move memory to the caches that benefit the most from it.
+     */
+    struct MemoryProfile {
+        size_t   capacity_bytes = 0;     // bytes the cache may use
+        size_t   max_bytes      = 0;     // configured capacity (0 = unlimited)
+        size_t   used_bytes     = 0;     // bytes the cache uses
+        bool     resizable      = false; // whether setMemoryCapacity() is supported
+        uint64_t ghost_hits     = 0;     // misses on recently evicted keys, since creation
+    };
+
     /**
      * @brief Constructor.
      */
@@ -82,6 +98,218 @@ class Backend {
      */
     virtual RequestResult<int32_t> computeSum(int32_t x, int32_t y) = 0;
 
+    /**
+     * @brief Stores a value associated with a key, replacing any
+     * value previously associated with this key.
+     *
+     * @param key key
+     * @param value value (the backend may take ownership of its content)
+     *
+     * @return a RequestResult<bool> indicating whether the value was stored.
+     */
+    virtual RequestResult<bool> put(const std::string& key, std::string&& value) = 0;
+
+    /**
+     * @brief Stores a value that expires ttl_ms milliseconds from now.
+     * A ttl_ms of 0 stands for the cache's default TTL, if any. The
+     * default implementation, for backends that do not support
+     * expiration, calls put() if ttl_ms is 0 and fails otherwise.
+     *
+     * @param key key
+     * @param value value (the backend may take ownership of its content)
+     * @param ttl_ms time to live in milliseconds
+     *
+     * @return a RequestResult<bool> indicating whether the value was stored.
+     */
+    virtual RequestResult<bool> putWithTTL(const std::string& key, std::string&& value,
+                                           uint64_t ttl_ms);
+
+    /**
+     * @brief Retrieves the value associated with a key.
+     * If the key does not exist, the returned RequestResult
+     * must have its success field set to false.
+     *
+     * @param key key
+     *
+     * @return a RequestResult containing the value.
+     */
+    virtual RequestResult<std::string> get(const std::string& key) = 0;
+
+    /**
+     * @brief Retrieves the value associated with a key as a compression
+     * frame (one byte for the algorithm, the uncompressed size as 8 bytes
+     * in little endian, then the payload), which the provider sends to
+     * clients that decompress values themselves. Backends that store
+     * compressed values should return them without decompressing them.
+     * The default implementation calls get() and wraps the value in a
+     * frame of algorithm 0 (none).
+     *
+     * @param key key
+     *
+     * @return a RequestResult containing the frame.
+     */
+    virtual RequestResult<std::string> getCompressed(const std::string& key);
+
+    /**
+     * @brief Erases a key and its associated value.
+     * Erasing a key that does not exist is not an error.
+     *
+     * @param key key
+     *
+     * @return a RequestResult<bool> indicating whether the operation succeeded.
+     */
+    virtual RequestResult<bool> erase(const std::string& key) = 0;
+
+    /**
+     * @brief Checks whether a key exists.
+     *
+     * @param key key
+     *
+     * @return a RequestResult whose value is 1 if the key exists, 0 otherwise.
+     */
+    virtual RequestResult<uint8_t> exists(const std::string& key) = 0;
+
+    /**
+     * @brief Stores a batch of key/value pairs. The default
+     * implementation calls put() on each pair; backends should
+     * override it to amortize locking across the batch.
+     *
+     * @param keys keys
+     * @param values values (same size as keys, may be moved from)
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    virtual RequestResult<std::vector<Status>> putMulti(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>&& values);
+
+    /**
+     * @brief Stores a batch of key/value pairs that expire ttl_ms
+     * milliseconds from now (see putWithTTL). The default
+     * implementation calls putMulti() if ttl_ms is 0 and fails otherwise.
+     *
+     * @param keys keys
+     * @param values values (same size as keys, may be moved from)
+     * @param ttl_ms time to live in milliseconds
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    virtual RequestResult<std::vector<Status>> putMultiWithTTL(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>&& values,
+            uint64_t ttl_ms);
+
+    /**
+     * @brief Retrieves the values associated with a batch of keys.
+     * The default implementation calls get() on each key, reporting
+     * any failure as Status::NotFound.
+     *
+     * @param[in] keys keys
+     * @param[out] values values (resized to the number of keys)
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    virtual RequestResult<std::vector<Status>> getMulti(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>* values);
+
+    /**
+     * @brief Retrieves a batch of values as compression frames (see
+     * getCompressed). The default implementation calls getMulti() and
+     * wraps the values in frames of algorithm 0 (none).
+     *
+     * @param[in] keys keys
+     * @param[out] frames frames (resized to the number of keys)
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    virtual RequestResult<std::vector<Status>> getMultiCompressed(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>* frames);
+
+    /**
+     * @brief Erases a batch of keys. The default implementation
+     * calls erase() on each key.
+     *
+     * @param keys keys
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    virtual RequestResult<std::vector<Status>> eraseMulti(
+            const std::vector<std::string>& keys);
+
+    /**
+     * @brief Writes any data the backend holds only in memory (e.g.
+     * dirty blocks of a write-back cache) to persistent storage. The
+     * provider calls it before closing or destroying a cache. The
+     * default implementation does nothing.
+     *
+     * @return a RequestResult<bool> indicating whether all the data was written.
+     */
+    virtual RequestResult<bool> flush();
+
+    /**
+     * @brief Function called by scan() with the key, the value, and the
+     * remaining time to live in milliseconds (0 if the entry does not
+     * expire) of each entry.
+     */
+    using ScanFunction = std::function<void(const std::string& key,
+                                            const std::string& value,
+                                            uint64_t ttl_ms)>;
+
+    /**
+     * @brief Calls fn on every entry of the cache (e.g. to snapshot it),
+     * without holding the cache's locks while fn runs. Entries inserted
+     * or removed during the scan may or may not be visited. The default
+     * implementation returns an error: the cache cannot be scanned.
+     *
+     * @param fn function to call on each entry
+     *
+     * @return a RequestResult<bool> indicating whether the scan completed.
+     */
+    virtual RequestResult<bool> scan(const ScanFunction& fn);
+
+    /**
+     * @brief Inserts entries restored from a snapshot. Keys that are
+     * already in the cache are skipped, since their value is more recent.
+     * Unlike putWithTTL, a TTL of 0 means that the entry does not expire.
+     * The default implementation calls exists() and putWithTTL().
+     *
+     * @param keys keys
+     * @param values values
+     * @param ttls_ms time to live of each entry (0 = none)
+     *
+     * @return a RequestResult whose value is the number of entries inserted.
+     */
+    virtual RequestResult<size_t> load(const std::vector<std::string>& keys,
+                                       std::vector<std::string>&& values,
+                                       const std::vector<uint64_t>& ttls_ms);
+
+    /**
+     * @brief Fills a MemoryProfile. The default implementation returns
+     * false, i.e. the cache does not use a significant amount of memory.
+     *
+     * @param[out] profile memory profile
+     *
+     * @return whether the cache is charged against the provider's budget.
+     */
+    virtual bool getMemoryProfile(MemoryProfile* profile) const;
+
+    /**
+     * @brief Changes the capacity of a resizable cache, evicting entries
+     * if it shrinks. Only called if getMemoryProfile() reports the cache
+     * as resizable. The default implementation does nothing.
+     *
+     * @param bytes new capacity in bytes
+     */
+    virtual void setMemoryCapacity(size_t bytes);
+
+    /**
+     * @brief Returns backend-specific statistics as a JSON object.
+     * The default implementation returns an empty object.
+     */
+    virtual nlohmann::json getStats() const;
+
     /**
      * @brief Destroys the underlying cache.
      *
@@ -9,10 +9,13 @@
 #include <thallium.hpp>
 #include <memory>
 #include <unordered_set>
+#include <vector>
+#include <string>
 #include <nlohmann/json.hpp>
 #include <cachersize/Client.hpp>
 #include <cachersize/Exception.hpp>
 #include <cachersize/AsyncRequest.hpp>
+#include <cachersize/Status.hpp>
 
 namespace cachersize {
 
@@ -21,6 +24,40 @@ namespace tl = thallium;
 class Client;
 class CacheHandleImpl;
 
+/**
+ * @brief Statistics of the near cache of a CacheHandle.
+ */
+struct NearCacheStats {
+    uint64_t hits          = 0; // gets served locally
+    uint64_t misses        = 0; // gets sent to the provider
+    uint64_t expirations   = 0; // misses due to an expired lease
+    uint64_t invalidations = 0; // entries dropped because their key changed
+    uint64_t evictions     = 0; // entries dropped to make room
+
+    /**
+     * @brief Fraction of the gets served by the near cache.
+     */
+    double hitRatio() const {
+        auto total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+};
+
+/**
+ * @brief Options of a put or putMulti operation.
+ */
+struct PutOptions {
+    /**
+     * Time to live of the stored values, in milliseconds. 0 stands for
+     * the cache's default TTL ("default_ttl_ms" in the configuration of
+     * the memory backend). Backends that do not support expiration
+     * ignore it. Since expirations do not revoke near-cache leases, a
+     * near cache may serve a value for up to one lease duration after
+     * it expired.
+     */
+    uint64_t ttl_ms = 0;
+};
+
 /**
  * @brief A CacheHandle object is a handle for a remote cache
  * on a server. It enables invoking the cache's functionalities.
@@ -92,6 +129,156 @@ class CacheHandle {
                     int32_t* result = nullptr,
                     AsyncRequest* req = nullptr) const;
 
+    /**
+     * @brief Stores a value associated with a key in the target cache.
+     * Values larger than the client's eager limit are transferred
+     * using RDMA. If req is not null, this call will be non-blocking
+     * and the caller is responsible for keeping the key and value
+     * alive until the request has been waited on.
+     *
+     * @param[in] key key
+     * @param[in] value value
+     * @param[out] req request for a non-blocking operation
+     */
+    void put(const std::string& key,
+             const std::string& value,
+             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Same as the above put, with options such as a TTL.
+     *
+     * @param[in] key key
+     * @param[in] value value
+     * @param[in] options options
+     * @param[out] req request for a non-blocking operation
+     */
+    void put(const std::string& key,
+             const std::string& value,
+             const PutOptions& options,
+             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Retrieves the value associated with a key. Throws an
+     * Exception if the key does not exist. If value is null, it will
+     * be ignored. If req is not null, this call will be non-blocking
+     * and the caller is responsible for waiting on the request.
+     *
+     * @param[in] key key
+     * @param[out] value value
+     * @param[out] req request for a non-blocking operation
+     */
+    void get(const std::string& key,
+             std::string* value,
+             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Erases a key and its value from the target cache.
+     * Erasing a key that does not exist is not an error.
+     *
+     * @param[in] key key
+     * @param[out] req request for a non-blocking operation
+     */
+    void erase(const std::string& key,
+               AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Checks whether a key exists in the target cache.
+     * If result is null, it will be ignored.
+     *
+     * @param[in] key key
+     * @param[out] result whether the key exists
+     * @param[out] req request for a non-blocking operation
+     */
+    void exists(const std::string& key,
+                bool* result,
+                AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Stores a batch of key/value pairs with a single RPC.
+     * Keys and values are packed into one contiguous buffer moved
+     * using RDMA. If statuses is not null, it is filled with the
+     * status of each item (Status::OK or Status::Error); otherwise
+     * the call throws if any item could not be stored. If req is not
+     * null, this call will be non-blocking and the caller is
+     * responsible for keeping keys and statuses alive until the
+     * request has been waited on.
+     *
+     * @param[in] keys keys
+     * @param[in] values values (same number as keys)
+     * @param[out] statuses per-item statuses
+     * @param[out] req request for a non-blocking operation
+     */
+    void putMulti(const std::vector<std::string>& keys,
+                  const std::vector<std::string>& values,
+                  std::vector<Status>* statuses = nullptr,
+                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Same as the above putMulti, with options such as a TTL
+     * applied to all the items.
+     *
+     * @param[in] keys keys
+     * @param[in] values values (same number as keys)
+     * @param[in] options options
+     * @param[out] statuses per-item statuses
+     * @param[out] req request for a non-blocking operation
+     */
+    void putMulti(const std::vector<std::string>& keys,
+                  const std::vector<std::string>& values,
+                  const PutOptions& options,
+                  std::vector<Status>* statuses = nullptr,
+                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Retrieves a batch of values with a single RPC (plus one
+     * RPC per value too large for the batch's receive buffer). values
+     * is resized to the number of keys. If statuses is not null, it is
+     * filled with the status of each item (Status::OK or
+     * Status::NotFound); otherwise the call throws if any key was not
+     * found. If req is not null, this call will be non-blocking and
+     * the caller is responsible for keeping keys, values, and statuses
+     * alive until the request has been waited on.
+     *
+     * @param[in] keys keys
+     * @param[out] values values
+     * @param[out] statuses per-item statuses
+     * @param[out] req request for a non-blocking operation
+     */
+    void getMulti(const std::vector<std::string>& keys,
+                  std::vector<std::string>* values,
+                  std::vector<Status>* statuses = nullptr,
+                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Erases a batch of keys with a single RPC. Erasing a key
+     * that does not exist is not an error. If statuses is not null,
+     * it is filled with the status of each item.
+     *
+     * @param[in] keys keys
+     * @param[out] statuses per-item statuses
+     * @param[out] req request for a non-blocking operation
+     */
+    void eraseMulti(const std::vector<std::string>& keys,
+                    std::vector<Status>* statuses = nullptr,
+                    AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Returns the statistics of the handle's near cache
+     * (all zero if the handle was created without a near cache).
+     * Copies of a CacheHandle share the same near cache.
+     */
+    NearCacheStats nearCacheStats() const;
+
+    /**
+     * @brief Returns the statistics maintained by the provider for
+     * the target cache, as a JSON-formatted string: hits, misses,
+     * hit_ratio, bytes_in and bytes_out (key and value bytes received
+     * and sent), latency (per RPC type: count, mean and percentiles
+     * in microseconds), entries, bytes_stored and evictions if the
+     * backend reports them, and backend (backend-specific statistics).
+     */
+    std::string getStats() const;
+
     private:
 
     /**
@@ -102,6 +289,13 @@ class CacheHandle {
      */
     CacheHandle(const std::shared_ptr<CacheHandleImpl>& impl);
 
+    /**
+     * @brief Implementation of get() for handles with a near cache.
+     */
+    void getThroughNearCache(const std::string& key,
+                             std::string* value,
+                             AsyncRequest* req) const;
+
     std::shared_ptr<CacheHandleImpl> self;
 };
 
@@ -10,11 +10,14 @@
 #include <cachersize/UUID.hpp>
 #include <thallium.hpp>
 #include <memory>
+#include <vector>
 
 namespace cachersize {
 
 class ClientImpl;
 class CacheHandle;
+class DistributedCacheHandle;
+struct CacheMember;
 
 /**
  * @brief The Client object is the main object used to establish
@@ -80,17 +83,51 @@ class Client {
      * You may set "check" to false if you know for sure that the
      * corresponding cache exists, which will avoid one RPC.
      *
+     * The JSON-formatted options may enable a client-local near cache
+     * for the values read through the handle, for example:
+     * { "near_cache" : { "max_entries" : 1024, "max_bytes" : 1048576 } }.
+     * Values are kept in the near cache for the duration of a lease
+     * granted by the provider. If the client's engine is listening,
+     * the provider also revokes leases as soon as their key changes;
+     * otherwise a value may be served until its lease expires even
+     * if it has been modified in the meantime.
+     *
+     * With { "compressed_transfer" : true }, values that the cache
+     * stores compressed are sent as is and decompressed by the client,
+     * reducing the bytes sent over the network. Values read through
+     * the near cache are still decompressed by the provider.
+     *
      * @param address Address of the provider holding the database.
      * @param provider_id Provider id.
      * @param cache_id Cache UUID.
      * @param check Checks if the Database exists by issuing an RPC.
+     * @param options JSON-formatted options.
      *
      * @return a CacheHandle instance.
      */
     CacheHandle makeCacheHandle(const std::string& address,
                                       uint16_t provider_id,
                                       const UUID& cache_id,
-                                      bool check = true) const;
+                                      bool check = true,
+                                      const std::string& options = "{}") const;
+
+    /**
+     * @brief Creates a handle to a cache distributed over the given
+     * members using consistent hashing (see DistributedCacheHandle).
+     * The options are those of makeCacheHandle, applied to each
+     * member, plus "virtual_nodes" (default 128), the number of points
+     * each member is given on the hash ring.
+     *
+     * @param members Caches forming the distributed cache.
+     * @param check Checks if the caches exist by issuing RPCs.
+     * @param options JSON-formatted options.
+     *
+     * @return a DistributedCacheHandle instance.
+     */
+    DistributedCacheHandle makeDistributedCacheHandle(
+            const std::vector<CacheMember>& members,
+            bool check = true,
+            const std::string& options = "{}") const;
 
     /**
      * @brief Checks that the Client instance is valid.
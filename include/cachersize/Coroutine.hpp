@@ -0,0 +1,436 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_COROUTINE_HPP
+#define __CACHERSIZE_COROUTINE_HPP
+
+#if !defined(__cpp_impl_coroutine) || __cplusplus < 202002L
+#error "cachersize/Coroutine.hpp requires C++20 (configure with -DENABLE_COROUTINES=ON)"
+#endif
+
+#include <cachersize/CacheHandle.hpp>
+#include <cachersize/AsyncRequest.hpp>
+#include <cachersize/Exception.hpp>
+#include <thallium.hpp>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Coroutine API for cachersize. Operations of an AwaitableCacheHandle
+ * return awaitables that issue the corresponding non-blocking operation
+ * and suspend the calling Task until it completes, for example:
+ *
+ *     cachersize::Task<void> work(cachersize::AwaitableCacheHandle cache) {
+ *         co_await cache.put("matthieu", "dorier");
+ *         std::string value = co_await cache.get("matthieu");
+ *     }
+ *
+ *     cachersize::EventLoop loop;
+ *     loop.spawn(work(cache));
+ *     loop.run();
+ *
+ * Tasks are driven by an EventLoop, which runs them in the ULT that calls
+ * EventLoop::run(). Suspended tasks are resumed by this same ULT when their
+ * operation's response arrives, so a suspension costs no ULT creation or
+ * context switch; the loop only yields to the Argobots scheduler when none
+ * of its tasks can make progress.
+ */
+
+namespace cachersize {
+
+class EventLoop;
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+
+    EventLoop*              loop = nullptr;
+    std::coroutine_handle<> continuation;
+    std::exception_ptr      error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            auto continuation = h.promise().continuation;
+            if(continuation) return continuation;
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept {
+        error = std::current_exception();
+    }
+};
+
+template<typename T>
+struct Promise : PromiseBase {
+
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+
+    T result() {
+        if(error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template<>
+struct Promise<void> : PromiseBase {
+
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if(error) std::rethrow_exception(error);
+    }
+};
+
+}
+
+/**
+ * @brief Lazily-started coroutine returning a T. A Task runs either
+ * when it is co_awaited by another Task, or when it is spawned in an
+ * EventLoop.
+ */
+template<typename T>
+class Task {
+
+    friend class EventLoop;
+
+    public:
+
+    using promise_type = detail::Promise<T>;
+    using handle_type  = std::coroutine_handle<promise_type>;
+
+    Task(Task&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if(this != &other) {
+            if(m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if(m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template<typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> parent) noexcept {
+        m_handle.promise().loop = parent.promise().loop;
+        m_handle.promise().continuation = parent;
+        return m_handle;
+    }
+
+    T await_resume() {
+        return m_handle.promise().result();
+    }
+
+    private:
+
+    explicit Task(handle_type handle)
+    : m_handle(handle) {}
+
+    friend struct detail::Promise<T>;
+
+    handle_type m_handle;
+};
+
+namespace detail {
+
+template<typename T>
+inline Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(Task<T>::handle_type::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(Task<void>::handle_type::from_promise(*this));
+}
+
+}
+
+/**
+ * @brief An EventLoop runs Tasks in the calling ULT, resuming them when
+ * the operations they wait on complete. An EventLoop is not thread-safe:
+ * tasks must only be spawned from the ULT running it or before it runs.
+ */
+class EventLoop {
+
+    public:
+
+    EventLoop() = default;
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ~EventLoop() {
+        for(auto& root : m_roots) root.handle.destroy();
+    }
+
+    /**
+     * @brief Adds a task to the loop. It starts running in run().
+     */
+    template<typename T>
+    void spawn(Task<T>&& task) {
+        auto handle = std::exchange(task.m_handle, nullptr);
+        handle.promise().loop = this;
+        m_roots.push_back(Root{handle, &handle.promise()});
+        m_ready.push_back(handle);
+    }
+
+    /**
+     * @brief Runs the spawned tasks until they have all completed.
+     * If some of them failed, the error of the first one is rethrown
+     * once all have completed. The results of tasks are discarded.
+     */
+    void run() {
+        std::vector<size_t> indices;
+        while(true) {
+            while(not m_ready.empty()) {
+                auto handle = m_ready.front();
+                m_ready.pop_front();
+                handle.resume();
+            }
+            if(m_waiting.empty()) break;
+            AsyncRequest::testSome(m_requests, &indices);
+            if(indices.empty()) {
+                thallium::thread::yield();
+                continue;
+            }
+            // remove completed entries from the back so indices stay valid
+            for(auto it = indices.rbegin(); it != indices.rend(); ++it) {
+                m_ready.push_back(m_waiting[*it]);
+                m_waiting[*it]  = m_waiting.back();
+                m_requests[*it] = std::move(m_requests.back());
+                m_waiting.pop_back();
+                m_requests.pop_back();
+            }
+        }
+        std::exception_ptr error;
+        for(auto& root : m_roots) {
+            if(not error) error = root.promise->error;
+            root.handle.destroy();
+        }
+        m_roots.clear();
+        if(error) std::rethrow_exception(error);
+    }
+
+    /**
+     * @brief Suspends a coroutine until a request completes.
+     * Used by the awaitables of AwaitableCacheHandle.
+     */
+    void suspend(const AsyncRequest& request, std::coroutine_handle<> handle) {
+        m_requests.push_back(request);
+        m_waiting.push_back(handle);
+    }
+
+    private:
+
+    struct Root {
+        std::coroutine_handle<>  handle;
+        detail::PromiseBase*     promise;
+    };
+
+    std::vector<Root>                    m_roots;
+    std::deque<std::coroutine_handle<>>  m_ready;
+    // m_waiting[i] waits for m_requests[i]
+    std::vector<std::coroutine_handle<>> m_waiting;
+    std::vector<AsyncRequest>            m_requests;
+};
+
+namespace detail {
+
+/**
+ * @brief Awaitable issuing a non-blocking operation when awaited. The
+ * operation's outputs and arguments (captured by issue) live in the
+ * awaitable, hence in the awaiting coroutine's frame, until it resumes.
+ */
+template<typename T, typename Issue>
+class OperationAwaiter {
+
+    public:
+
+    explicit OperationAwaiter(Issue&& issue)
+    : m_issue(std::move(issue)) {}
+
+    bool await_ready() {
+        m_issue(&m_value, &m_request);
+        return m_request.completed();
+    }
+
+    template<typename P>
+    void await_suspend(std::coroutine_handle<P> handle) {
+        handle.promise().loop->suspend(m_request, handle);
+    }
+
+    T await_resume() {
+        m_request.wait();
+        return std::move(m_value);
+    }
+
+    private:
+
+    Issue        m_issue;
+    T            m_value{};
+    AsyncRequest m_request;
+};
+
+template<typename Issue>
+class OperationAwaiter<void, Issue> {
+
+    public:
+
+    explicit OperationAwaiter(Issue&& issue)
+    : m_issue(std::move(issue)) {}
+
+    bool await_ready() {
+        m_issue(nullptr, &m_request);
+        return m_request.completed();
+    }
+
+    template<typename P>
+    void await_suspend(std::coroutine_handle<P> handle) {
+        handle.promise().loop->suspend(m_request, handle);
+    }
+
+    void await_resume() {
+        m_request.wait();
+    }
+
+    private:
+
+    Issue        m_issue;
+    AsyncRequest m_request;
+};
+
+template<typename T, typename Issue>
+OperationAwaiter<T, Issue> makeAwaiter(Issue&& issue) {
+    return OperationAwaiter<T, Issue>(std::move(issue));
+}
+
+}
+
+/**
+ * @brief Values and per-item statuses returned by AwaitableCacheHandle::getMulti.
+ */
+struct GetMultiResult {
+    std::vector<std::string> values;
+    std::vector<Status>      statuses;
+};
+
+/**
+ * @brief Wrapper around a CacheHandle whose operations are awaitable
+ * from a Task. Errors are reported by throwing an Exception from the
+ * co_await expression, as the synchronous operations do.
+ */
+class AwaitableCacheHandle {
+
+    public:
+
+    AwaitableCacheHandle() = default;
+
+    AwaitableCacheHandle(CacheHandle handle)
+    : m_handle(std::move(handle)) {}
+
+    const CacheHandle& handle() const {
+        return m_handle;
+    }
+
+    auto computeSum(int32_t x, int32_t y) const {
+        return detail::makeAwaiter<int32_t>(
+            [h=m_handle, x, y](int32_t* result, AsyncRequest* req) {
+                h.computeSum(x, y, result, req);
+            });
+    }
+
+    auto put(std::string key, std::string value, PutOptions options = PutOptions()) const {
+        return detail::makeAwaiter<void>(
+            [h=m_handle, key=std::move(key), value=std::move(value), options](void*, AsyncRequest* req) {
+                h.put(key, value, options, req);
+            });
+    }
+
+    auto get(std::string key) const {
+        return detail::makeAwaiter<std::string>(
+            [h=m_handle, key=std::move(key)](std::string* value, AsyncRequest* req) {
+                h.get(key, value, req);
+            });
+    }
+
+    auto erase(std::string key) const {
+        return detail::makeAwaiter<void>(
+            [h=m_handle, key=std::move(key)](void*, AsyncRequest* req) {
+                h.erase(key, req);
+            });
+    }
+
+    auto exists(std::string key) const {
+        return detail::makeAwaiter<bool>(
+            [h=m_handle, key=std::move(key)](bool* result, AsyncRequest* req) {
+                h.exists(key, result, req);
+            });
+    }
+
+    auto putMulti(std::vector<std::string> keys, std::vector<std::string> values,
+                  PutOptions options = PutOptions()) const {
+        return detail::makeAwaiter<std::vector<Status>>(
+            [h=m_handle, keys=std::move(keys), values=std::move(values), options]
+            (std::vector<Status>* statuses, AsyncRequest* req) {
+                h.putMulti(keys, values, options, statuses, req);
+            });
+    }
+
+    auto getMulti(std::vector<std::string> keys) const {
+        return detail::makeAwaiter<GetMultiResult>(
+            [h=m_handle, keys=std::move(keys)](GetMultiResult* result, AsyncRequest* req) {
+                h.getMulti(keys, &result->values, &result->statuses, req);
+            });
+    }
+
+    auto eraseMulti(std::vector<std::string> keys) const {
+        return detail::makeAwaiter<std::vector<Status>>(
+            [h=m_handle, keys=std::move(keys)](std::vector<Status>* statuses, AsyncRequest* req) {
+                h.eraseMulti(keys, statuses, req);
+            });
+    }
+
+    private:
+
+    CacheHandle m_handle;
+};
+
+}
+
+#endif
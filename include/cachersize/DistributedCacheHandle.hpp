@@ -0,0 +1,198 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_DISTRIBUTED_CACHE_HANDLE_HPP
+#define __CACHERSIZE_DISTRIBUTED_CACHE_HANDLE_HPP
+
+#include <cachersize/CacheHandle.hpp>
+#include <cachersize/UUID.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cachersize {
+
+class Client;
+class DistributedCacheHandleImpl;
+
+/**
+ * @brief Location of one of the caches forming a distributed cache.
+ */
+struct CacheMember {
+    std::string address;
+    uint16_t    provider_id;
+    UUID        cache_id;
+};
+
+/**
+ * @brief A DistributedCacheHandle spreads keys over a set of caches,
+ * typically hosted by different providers, using consistent hashing.
+ * Single-key operations are forwarded to the cache owning the key.
+ * Batched operations are split by owner and sent to all the owners
+ * in parallel.
+ *
+ * All the clients of a distributed cache must be given the same set
+ * of members (in any order) and the same number of virtual nodes to
+ * agree on where keys live.
+ */
+class DistributedCacheHandle {
+
+    friend class Client;
+
+    public:
+
+    /**
+     * @brief Constructor. The resulting handle will be invalid.
+     */
+    DistributedCacheHandle();
+
+    /**
+     * @brief Copy-constructor.
+     */
+    DistributedCacheHandle(const DistributedCacheHandle&);
+
+    /**
+     * @brief Move-constructor.
+     */
+    DistributedCacheHandle(DistributedCacheHandle&&);
+
+    /**
+     * @brief Copy-assignment operator.
+     */
+    DistributedCacheHandle& operator=(const DistributedCacheHandle&);
+
+    /**
+     * @brief Move-assignment operator.
+     */
+    DistributedCacheHandle& operator=(DistributedCacheHandle&&);
+
+    /**
+     * @brief Destructor.
+     */
+    ~DistributedCacheHandle();
+
+    /**
+     * @brief Checks if the DistributedCacheHandle instance is valid.
+     */
+    operator bool() const;
+
+    /**
+     * @brief Returns the number of member caches.
+     */
+    size_t numMembers() const;
+
+    /**
+     * @brief Returns the handle of a member cache.
+     */
+    const CacheHandle& member(size_t index) const;
+
+    /**
+     * @brief Returns the index of the member cache owning a key.
+     */
+    size_t memberOf(const std::string& key) const;
+
+    /**
+     * @brief Stores a value in the cache owning the key.
+     * See CacheHandle::put.
+     */
+    void put(const std::string& key,
+             const std::string& value,
+             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Stores a value in the cache owning the key, with options.
+     * See CacheHandle::put.
+     */
+    void put(const std::string& key,
+             const std::string& value,
+             const PutOptions& options,
+             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Retrieves a value from the cache owning the key.
+     * See CacheHandle::get.
+     */
+    void get(const std::string& key,
+             std::string* value,
+             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Erases a key from the cache owning it.
+     * See CacheHandle::erase.
+     */
+    void erase(const std::string& key,
+               AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Checks whether a key exists in the cache owning it.
+     * See CacheHandle::exists.
+     */
+    void exists(const std::string& key,
+                bool* result,
+                AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Stores a batch of key/value pairs, sending one batch to
+     * each member cache concerned, in parallel. See CacheHandle::putMulti.
+     * If req is not null, keys, values, and statuses must stay alive
+     * until the request has been waited on.
+     */
+    void putMulti(const std::vector<std::string>& keys,
+                  const std::vector<std::string>& values,
+                  std::vector<Status>* statuses = nullptr,
+                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Same as the above putMulti, with options
+     * applied to all the items.
+     */
+    void putMulti(const std::vector<std::string>& keys,
+                  const std::vector<std::string>& values,
+                  const PutOptions& options,
+                  std::vector<Status>* statuses = nullptr,
+                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Retrieves a batch of values, sending one batch to each
+     * member cache concerned, in parallel. See CacheHandle::getMulti.
+     * If req is not null, keys, values, and statuses must stay alive
+     * until the request has been waited on.
+     */
+    void getMulti(const std::vector<std::string>& keys,
+                  std::vector<std::string>* values,
+                  std::vector<Status>* statuses = nullptr,
+                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Erases a batch of keys, sending one batch to each member
+     * cache concerned, in parallel. See CacheHandle::eraseMulti.
+     * If req is not null, keys and statuses must stay alive until the
+     * request has been waited on.
+     */
+    void eraseMulti(const std::vector<std::string>& keys,
+                    std::vector<Status>* statuses = nullptr,
+                    AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Returns the sum of the near cache statistics of the members.
+     */
+    NearCacheStats nearCacheStats() const;
+
+    private:
+
+    /**
+     * @brief Constructor is private. Use a Client object
+     * to create a DistributedCacheHandle instance.
+     *
+     * @param impl Pointer to implementation.
+     */
+    DistributedCacheHandle(const std::shared_ptr<DistributedCacheHandleImpl>& impl);
+
+    std::shared_ptr<DistributedCacheHandleImpl> self;
+};
+
+}
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_EVICTION_POLICY_HPP
+#define __CACHERSIZE_EVICTION_POLICY_HPP
+
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <string>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Helper class to register eviction policies into the factory.
+ */
+template<typename PolicyType>
+class __CachersizeEvictionPolicyRegistration;
+
+namespace cachersize {
+
+/**
+ * @brief Interface for eviction policies. A policy keeps track of the
+ * keys resident in (a shard of) a cache and decides which one to evict
+ * when the cache needs space. To build a new policy, implement a class
+ * MyPolicy that inherits from EvictionPolicy, and put
+ * CACHERSIZE_REGISTER_EVICTION_POLICY(mypolicy, MyPolicy); in a cpp file.
+ * The class should have a static function to create an instance:
+ *
+ * std::unique_ptr<EvictionPolicy> create(const json& config, size_t capacity)
+ *
+ * where capacity is the maximum number of entries the policy will
+ * have to track (0 if unknown).
+ *
+ * All functions except touch() are called with exclusive access to the
+ * policy. touch() is called on the hit path; if concurrentTouch() returns
+ * true, it may be called concurrently with other calls to touch() (but
+ * not with any other function) and must therefore only update atomic
+ * state. Every function must run in O(1) (amortized) time.
+ */
+class EvictionPolicy {
+
+    public:
+
+    /**
+     * @brief Per-key metadata allocated by the policy. Policies
+     * extend this structure with their own fields. A cache keeps
+     * a pointer to the Entry of each of its keys, so that hits and
+     * removals do not need another lookup by key.
+     */
+    struct Entry {
+        std::string key;
+    };
+
+    EvictionPolicy() = default;
+    EvictionPolicy(const EvictionPolicy&) = delete;
+    EvictionPolicy& operator=(const EvictionPolicy&) = delete;
+
+    /**
+     * @brief Destructor.
+     */
+    virtual ~EvictionPolicy() = default;
+
+    /**
+     * @brief Starts tracking a key that has just been inserted.
+     *
+     * @param key key
+     *
+     * @return the Entry associated with the key.
+     */
+    virtual Entry* insert(const std::string& key) = 0;
+
+    /**
+     * @brief Records an access to a resident key.
+     *
+     * @param entry Entry returned by insert().
+     */
+    virtual void touch(Entry* entry) = 0;
+
+    /**
+     * @brief Stops tracking a key that the cache has removed
+     * (e.g. because it was erased). The entry is freed.
+     *
+     * @param entry Entry returned by insert().
+     */
+    virtual void remove(Entry* entry) = 0;
+
+    /**
+     * @brief Selects a victim, stops tracking it, and returns its key.
+     * The caller is responsible for removing the key from the cache.
+     *
+     * @param[out] key key of the victim
+     *
+     * @return false if there is no key to evict.
+     */
+    virtual bool evict(std::string* key) = 0;
+
+    /**
+     * @brief Returns the key that evict() would select next, without
+     * changing the state of the policy (e.g. an admission filter uses
+     * it to compare a new key with the victim it would replace).
+     * It is called on every insertion into a full cache with an
+     * admission filter, so it must not search for the victim: policies
+     * whose evict() updates metadata while searching return the first
+     * candidate instead. The default returns false.
+     *
+     * @param[out] key key of the victim
+     *
+     * @return false if there is no key to evict or the policy
+     * cannot tell which one it would evict.
+     */
+    virtual bool victim(std::string* key) const {
+        (void)key;
+        return false;
+    }
+
+    /**
+     * @brief Number of resident keys tracked by the policy.
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Whether touch() may be called concurrently by
+     * multiple threads holding a shared lock.
+     */
+    virtual bool concurrentTouch() const {
+        return false;
+    }
+};
+
+/**
+ * @brief The EvictionPolicyFactory contains functions to create
+ * eviction policies by name.
+ */
+class EvictionPolicyFactory {
+
+    template<typename PolicyType>
+    friend class ::__CachersizeEvictionPolicyRegistration;
+
+    using json = nlohmann::json;
+
+    public:
+
+    EvictionPolicyFactory() = delete;
+
+    /**
+     * @brief Creates an eviction policy.
+     *
+     * @param policy_name Name of the policy.
+     * @param config Configuration object to pass to the policy's create function.
+     * @param capacity Maximum number of entries to track (0 if unknown).
+     *
+     * @return a unique_ptr to the policy, or nullptr if the name is unknown.
+     */
+    static std::unique_ptr<EvictionPolicy> createPolicy(const std::string& policy_name,
+                                                        const json& config,
+                                                        size_t capacity);
+
+    private:
+
+    static std::unordered_map<std::string,
+                std::function<std::unique_ptr<EvictionPolicy>(const json&, size_t)>> create_fn;
+};
+
+} // namespace cachersize
+
+
+#define CACHERSIZE_REGISTER_EVICTION_POLICY(__policy_name, __policy_type) \
+    static __CachersizeEvictionPolicyRegistration<__policy_type> __cachersize ## __policy_name ## _eviction_policy( #__policy_name )
+
+template<typename PolicyType>
+class __CachersizeEvictionPolicyRegistration {
+
+    using json = nlohmann::json;
+
+    public:
+
+    __CachersizeEvictionPolicyRegistration(const std::string& policy_name)
+    {
+        cachersize::EvictionPolicyFactory::create_fn[policy_name] = [](const json& config, size_t capacity) {
+            return PolicyType::create(config, capacity);
+        };
+    }
+};
+
+#endif
@@ -18,6 +18,49 @@ class ProviderImpl;
 /**
  * @brief A Provider is an object that can receive RPCs
  * and dispatch them to specific caches.
+ *
+ * The provider's JSON configuration may contain a "pools" object
+ * naming the Argobots pools (as named in the Margo configuration)
+ * that handle each class of RPC:
+ * - "admin": cache creation, opening, closing, and destruction;
+ * - "data": RPCs whose arguments and responses are sent inline
+ *   (e.g. small puts and gets);
+ * - "bulk": RPCs that issue RDMA transfers (large puts and gets,
+ *   batched operations).
+ * Classes without a pool use the pool passed to the constructor.
+ * For example: { "pools" : { "admin" : "admin_pool",
+ * "data" : "data_pool", "bulk" : "bulk_pool" } }.
+ *
+ * "lease_duration_ms" (default 1000) is the duration of the leases
+ * granted to the near caches of clients (see Client::makeCacheHandle).
+ * 0 disables near caching for the caches of this provider.
+ *
+ * "memory_budget" bounds the memory used by the caches of the provider:
+ * - "bytes" (default 0 = no budget): budget shared by the caches;
+ * - "min_cache_bytes" (default 1 MiB): capacity under which a cache is
+ *   never shrunk;
+ * - "rebalance_interval_ms" (default 1000): period of rebalancing;
+ * - "step" (default 0.05): fraction of the budget moved at each period.
+ * Caches that cannot be resized are charged their capacity, and their
+ * creation fails if it exceeds what is left. Resizable caches (memory
+ * caches with an eviction policy) start with an equal share of the rest,
+ * then memory moves from the caches that would lose few hits by shrinking
+ * to those that would gain the most by growing. Caches that receive no
+ * request shrink at each period down to min_cache_bytes.
+ *
+ * "snapshot" configures the snapshots of caches (see Admin::snapshotCache):
+ * - "abt_io_threads" (default 4): number of abt-io xstreams reading and
+ *   writing snapshot files, and of ULTs loading a snapshot;
+ * - "chunk_bytes" (default 4 MiB): size of the chunks of a snapshot,
+ *   the unit of parallel writes and loads.
+ *
+ * "migration" configures the migrations of caches from this provider
+ * (see Admin::migrateCache):
+ * - "batch_bytes" (default 4 MiB): size of the batches of entries
+ *   pulled by the destination;
+ * - "pipeline_depth" (default 4): number of batches in flight;
+ * - "max_rounds" (default 4): number of times the keys written during
+ *   the migration are sent again before the switchover.
  */
 class Provider {
 
@@ -28,8 +71,8 @@ class Provider {
      *
      * @param engine Thallium engine to use to receive RPCs.
      * @param provider_id Provider id.
-     * @param config JSON-formatted configuration.
-     * @param pool Argobots pool to use to handle RPCs.
+     * @param config JSON-formatted configuration (see above).
+     * @param pool Default Argobots pool to use to handle RPCs.
      */
     Provider(const tl::engine& engine,
              uint16_t provider_id = 0,
@@ -41,8 +84,8 @@ class Provider {
      *
      * @param mid Margo instance id to use to receive RPCs.
      * @param provider_id Provider id.
-     * @param config JSON-formatted configuration.
-     * @param pool Argobots pool to use to handle RPCs.
+     * @param config JSON-formatted configuration (see above).
+     * @param pool Default Argobots pool to use to handle RPCs.
      */
     Provider(margo_instance_id mid,
              uint16_t provider_id = 0,
@@ -83,12 +126,23 @@ class Provider {
     void setSecurityToken(const std::string& token);
 
     /**
-     * @brief Return a JSON-formatted configuration of the provider.
+     * @brief Return the effective JSON-formatted configuration of the
+     * provider, in which RPC classes handled by the default pool have
+     * a null pool name.
      *
      * @return JSON formatted string.
      */
     std::string getConfig() const;
 
+    /**
+     * @brief Return the statistics of all the caches managed by
+     * the provider, as a JSON object mapping the UUID of each cache
+     * to its statistics (see CacheHandle::getStats).
+     *
+     * @return JSON formatted string.
+     */
+    std::string getStats() const;
+
     /**
      * @brief Checks whether the Provider instance is valid.
      */
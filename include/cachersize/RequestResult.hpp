@@ -6,10 +6,41 @@
 #ifndef __CACHERSIZE_REQUEST_RESULT_HPP
 #define __CACHERSIZE_REQUEST_RESULT_HPP
 
+#include <cstdint>
 #include <string>
+#include <type_traits>
 
 namespace cachersize {
 
+/**
+ * @brief Numeric code sent in place of the success flag of a
+ * RequestResult. Codes other than Success give the category of
+ * the error; the error string is only sent along with them.
+ */
+enum class ResultCode : uint8_t {
+    Success       = 0,
+    Error         = 1, /* generic error, described by the error string */
+    CacheNotFound = 2, /* no cache with the requested UUID */
+    KeyNotFound   = 3, /* the requested key does not exist */
+    InvalidToken  = 4, /* the security token was rejected */
+    CacheMoved    = 5  /* the cache migrated; the error string holds its
+                          new location as "<provider id>@<address>" */
+};
+
+namespace detail {
+
+/**
+ * @brief Code to send for a result with the given success
+ * flag and (possibly unset) error category.
+ */
+inline uint8_t wireCode(bool success, ResultCode code) {
+    if(success) return static_cast<uint8_t>(ResultCode::Success);
+    if(code == ResultCode::Success) return static_cast<uint8_t>(ResultCode::Error);
+    return static_cast<uint8_t>(code);
+}
+
+}
+
 /**
  * @brief The RequestResult object is a generic object
  * used to hold and send back the result of an RPC.
@@ -17,6 +48,11 @@ namespace cachersize {
  * - success must be set to true if the request succeeded, false otherwise
  * - error must be set to an error string if an error occured
  * - value must be set to the result of the request if it succeeded
+ * In addition, code may be set to the category of the error.
+ *
+ * On the wire, a RequestResult is a one-byte ResultCode followed by
+ * either the error string, if the request failed, or the value, if
+ * it succeeded. Trivially-copyable values are copied as raw bytes.
  *
  * This class is specialized for two types: bool and std::string.
  * If bool is used, both the value and the success fields will be
@@ -65,6 +101,23 @@ class RequestResult {
         return m_error;
     }
 
+    /**
+     * @brief Category of the error if the request failed
+     * (ResultCode::Error if left unset).
+     */
+    ResultCode& code() {
+        return m_code;
+    }
+
+    /**
+     * @brief Category of the error if the request failed
+     * (ResultCode::Error if left unset).
+     */
+    ResultCode code() const {
+        return m_success ? ResultCode::Success
+            : static_cast<ResultCode>(detail::wireCode(m_success, m_code));
+    }
+
     /**
      * @brief Value if the request succeeded. 
      */
@@ -86,15 +139,53 @@ class RequestResult {
      * @param a Archive instance.
      */
     template<typename Archive>
-    void serialize(Archive& a) {
-        a & m_success;
-        a & m_error;
-        a & m_value;
+    void save(Archive& a) const {
+        uint8_t code = detail::wireCode(m_success, m_code);
+        a.write(&code);
+        if(m_success) saveValue(a, std::is_trivially_copyable<T>());
+        else a & m_error;
+    }
+
+    /**
+     * @brief Deserialization function for Thallium.
+     *
+     * @tparam Archive Archive type.
+     * @param a Archive instance.
+     */
+    template<typename Archive>
+    void load(Archive& a) {
+        uint8_t code;
+        a.read(&code);
+        m_code    = static_cast<ResultCode>(code);
+        m_success = m_code == ResultCode::Success;
+        if(m_success) loadValue(a, std::is_trivially_copyable<T>());
+        else a & m_error;
     }
 
     private:
 
+    template<typename Archive>
+    void saveValue(Archive& a, std::true_type) const {
+        a.write(&m_value);
+    }
+
+    template<typename Archive>
+    void saveValue(Archive& a, std::false_type) const {
+        a & m_value;
+    }
+
+    template<typename Archive>
+    void loadValue(Archive& a, std::true_type) {
+        a.read(&m_value);
+    }
+
+    template<typename Archive>
+    void loadValue(Archive& a, std::false_type) {
+        a & m_value;
+    }
+
     bool        m_success = true;
+    ResultCode  m_code    = ResultCode::Success;
     std::string m_error   = "";
     T           m_value;
 };
@@ -118,6 +209,15 @@ class RequestResult<std::string> {
         return m_success;
     }
 
+    ResultCode& code() {
+        return m_code;
+    }
+
+    ResultCode code() const {
+        return m_success ? ResultCode::Success
+            : static_cast<ResultCode>(detail::wireCode(m_success, m_code));
+    }
+
     std::string& error() {
         return m_content;
     }
@@ -135,14 +235,25 @@ class RequestResult<std::string> {
     }
 
     template<typename Archive>
-    void serialize(Archive& a) {
-        a & m_success;
+    void save(Archive& a) const {
+        uint8_t code = detail::wireCode(m_success, m_code);
+        a.write(&code);
+        a & m_content;
+    }
+
+    template<typename Archive>
+    void load(Archive& a) {
+        uint8_t code;
+        a.read(&code);
+        m_code    = static_cast<ResultCode>(code);
+        m_success = m_code == ResultCode::Success;
         a & m_content;
     }
 
     private:
 
     bool        m_success = true;
+    ResultCode  m_code    = ResultCode::Success;
     std::string m_content = "";
 };
 
@@ -165,6 +276,15 @@ class RequestResult<bool> {
         return m_success;
     }
 
+    ResultCode& code() {
+        return m_code;
+    }
+
+    ResultCode code() const {
+        return m_success ? ResultCode::Success
+            : static_cast<ResultCode>(detail::wireCode(m_success, m_code));
+    }
+
     std::string& error() {
         return m_error;
     }
@@ -182,14 +302,25 @@ class RequestResult<bool> {
     }
 
     template<typename Archive>
-    void serialize(Archive& a) {
-        a & m_success;
-        a & m_error;
+    void save(Archive& a) const {
+        uint8_t code = detail::wireCode(m_success, m_code);
+        a.write(&code);
+        if(not m_success) a & m_error;
+    }
+
+    template<typename Archive>
+    void load(Archive& a) {
+        uint8_t code;
+        a.read(&code);
+        m_code    = static_cast<ResultCode>(code);
+        m_success = m_code == ResultCode::Success;
+        if(not m_success) a & m_error;
     }
 
     private:
 
     bool        m_success = true;
+    ResultCode  m_code    = ResultCode::Success;
     std::string m_error   = "";
 };
 
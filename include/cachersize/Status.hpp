@@ -0,0 +1,28 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_STATUS_HPP
+#define __CACHERSIZE_STATUS_HPP
+
+#include <cstdint>
+
+namespace cachersize {
+
+/**
+ * @brief Per-item status of a batched (multi-key) operation.
+ * Values are sent over the wire as a single byte.
+ */
+enum class Status : uint8_t {
+    OK       = 0, /* the operation succeeded for this item */
+    NotFound = 1, /* the key does not exist */
+    Error    = 2, /* the operation failed for this item (e.g. cache full) */
+    Deferred = 3  /* protocol-internal: the value did not fit in the
+                     client's receive buffer and must be fetched on its
+                     own; never returned by CacheHandle functions */
+};
+
+}
+
+#endif
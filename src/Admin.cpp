@@ -43,9 +43,8 @@ UUID Admin::createCache(const std::string& address,
                            const std::string& cache_type,
                            const std::string& cache_config,
                            const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
-    auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<UUID> result = self->m_create_cache.on(ph)(token, cache_type, cache_config);
+    auto result = self->call<RequestResult<UUID>>(
+        self->m_create_cache, address, provider_id, token, cache_type, cache_config);
     if(not result.success()) {
         throw Exception(result.error());
     }
@@ -57,9 +56,8 @@ UUID Admin::openCache(const std::string& address,
                          const std::string& cache_type,
                          const std::string& cache_config,
                          const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
-    auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<UUID> result = self->m_open_cache.on(ph)(token, cache_type, cache_config);
+    auto result = self->call<RequestResult<UUID>>(
+        self->m_open_cache, address, provider_id, token, cache_type, cache_config);
     if(not result.success()) {
         throw Exception(result.error());
     }
@@ -70,9 +68,8 @@ void Admin::closeCache(const std::string& address,
                            uint16_t provider_id,
                            const UUID& cache_id,
                            const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
-    auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<bool> result = self->m_close_cache.on(ph)(token, cache_id);
+    auto result = self->call<RequestResult<bool>>(
+        self->m_close_cache, address, provider_id, token, cache_id);
     if(not result.success()) {
         throw Exception(result.error());
     }
@@ -82,16 +79,70 @@ void Admin::destroyCache(const std::string& address,
                             uint16_t provider_id,
                             const UUID& cache_id,
                             const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
-    auto ph        = tl::provider_handle(endpoint, provider_id);
-    RequestResult<bool> result = self->m_destroy_cache.on(ph)(token, cache_id);
+    auto result = self->call<RequestResult<bool>>(
+        self->m_destroy_cache, address, provider_id, token, cache_id);
     if(not result.success()) {
         throw Exception(result.error());
     }
 }
 
+std::string Admin::getCacheStats(const std::string& address,
+                                 uint16_t provider_id,
+                                 const UUID& cache_id) const {
+    auto result = self->call<RequestResult<std::string>>(
+        self->m_get_stats, address, provider_id, cache_id);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+    return result.value();
+}
+
+uint64_t Admin::snapshotCache(const std::string& address,
+                              uint16_t provider_id,
+                              const UUID& cache_id,
+                              const std::string& path,
+                              const std::string& token) const {
+    auto result = self->call<RequestResult<uint64_t>>(
+        self->m_snapshot_cache, address, provider_id, token, cache_id, path);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+    return result.value();
+}
+
+uint64_t Admin::restoreCache(const std::string& address,
+                             uint16_t provider_id,
+                             const UUID& cache_id,
+                             const std::string& path,
+                             const std::string& token) const {
+    auto result = self->call<RequestResult<uint64_t>>(
+        self->m_restore_cache, address, provider_id, token, cache_id, path);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+    return result.value();
+}
+
+uint64_t Admin::migrateCache(const std::string& source_address,
+                             uint16_t source_provider_id,
+                             const UUID& cache_id,
+                             const std::string& dest_address,
+                             uint16_t dest_provider_id,
+                             const std::string& config,
+                             const std::string& token) const {
+    auto result = self->call<RequestResult<uint64_t>>(
+        self->m_migrate_cache, source_address, source_provider_id,
+        token, cache_id, dest_address, dest_provider_id, config);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+    return result.value();
+}
+
 void Admin::shutdownServer(const std::string& address) const {
-    auto ep = self->m_engine.lookup(address);
+    auto ep = self->m_endpoints->lookup(self->m_engine, address);
+    // the process behind the address is going away
+    self->m_endpoints->invalidate(address);
     self->m_engine.shutdown_remote_engine(ep);
 }
 
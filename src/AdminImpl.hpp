@@ -7,6 +7,7 @@
 #define __CACHERSIZE_ADMIN_IMPL_H
 
 #include <thallium.hpp>
+#include "EndpointCache.hpp"
 
 namespace cachersize {
 
@@ -21,6 +22,11 @@ class AdminImpl {
     tl::remote_procedure m_open_cache;
     tl::remote_procedure m_close_cache;
     tl::remote_procedure m_destroy_cache;
+    tl::remote_procedure m_get_stats;
+    tl::remote_procedure m_snapshot_cache;
+    tl::remote_procedure m_restore_cache;
+    tl::remote_procedure m_migrate_cache;
+    std::shared_ptr<EndpointCache> m_endpoints;
 
     AdminImpl(const tl::engine& engine)
     : m_engine(engine)
@@ -28,6 +34,11 @@ class AdminImpl {
     , m_open_cache(m_engine.define("cachersize_open_cache"))
     , m_close_cache(m_engine.define("cachersize_close_cache"))
     , m_destroy_cache(m_engine.define("cachersize_destroy_cache"))
+    , m_get_stats(m_engine.define("cachersize_get_stats"))
+    , m_snapshot_cache(m_engine.define("cachersize_snapshot_cache"))
+    , m_restore_cache(m_engine.define("cachersize_restore_cache"))
+    , m_migrate_cache(m_engine.define("cachersize_migrate_cache"))
+    , m_endpoints(EndpointCache::of(m_engine))
     {}
 
     AdminImpl(margo_instance_id mid)
@@ -35,6 +46,26 @@ class AdminImpl {
     }
 
     ~AdminImpl() {}
+
+    /**
+     * @brief Sends an RPC to a provider, resolving its address through
+     * the endpoint cache. The address is invalidated if the RPC fails
+     * to be sent or its response to be received.
+     */
+    template<typename Result, typename ... Args>
+    Result call(const tl::remote_procedure& rpc,
+                const std::string& address,
+                uint16_t provider_id,
+                Args&&... args) {
+        auto ph = tl::provider_handle(m_endpoints->lookup(m_engine, address), provider_id);
+        try {
+            Result result = rpc.on(ph)(std::forward<Args>(args)...);
+            return result;
+        } catch(const std::exception&) {
+            m_endpoints->invalidate(address);
+            throw;
+        }
+    }
 };
 
 }
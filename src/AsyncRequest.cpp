@@ -1,6 +1,6 @@
 /*
  * (C) 2020 The University of Chicago
- * 
+ *
  * See COPYRIGHT in top-level directory.
  */
 #include "cachersize/Exception.hpp"
@@ -21,41 +21,100 @@ AsyncRequest::AsyncRequest(AsyncRequest&& other) {
     other.self = nullptr;
 }
 
+// A request that is dropped without having been waited on is completed
+// first, since its RPC may still be writing to the caller's outputs.
+// Its error, if any, cannot be reported.
+static void completeDropped(const std::shared_ptr<AsyncRequestImpl>& impl) {
+    if(not impl || impl.use_count() != 1 || impl->done()) return;
+    try {
+        impl->complete();
+    } catch(...) {}
+}
+
 AsyncRequest::~AsyncRequest() {
-    if(self && self.unique()) {
-        wait();
-    }
+    completeDropped(self);
 }
 
 AsyncRequest& AsyncRequest::operator=(const AsyncRequest& other) {
     if(this == &other || self == other.self) return *this;
-    if(self && self.unique()) {
-        wait();
-    }
+    completeDropped(self);
     self = other.self;
     return *this;
 }
 
 AsyncRequest& AsyncRequest::operator=(AsyncRequest&& other) {
     if(this == &other || self == other.self) return *this;
-    if(self && self.unique()) {
-        wait();
-    }
+    completeDropped(self);
     self = std::move(other.self);
     other.self = nullptr;
     return *this;
 }
 
+AsyncRequest::operator bool() const {
+    return static_cast<bool>(self);
+}
+
 void AsyncRequest::wait() const {
     if(not self) throw Exception("Invalid cachersize::AsyncRequest object");
-    if(self->m_waited) return;
-    self->m_wait_callback(*self);
-    self->m_waited = true;
+    self->complete();
 }
 
 bool AsyncRequest::completed() const {
     if(not self) throw Exception("Invalid cachersize::AsyncRequest object");
-    return self->m_async_response.received();
+    return self->completed();
+}
+
+void AsyncRequest::onCompletion(Callback callback, const thallium::pool& pool) const {
+    if(not self) throw Exception("Invalid cachersize::AsyncRequest object");
+    pool.make_thread([impl=self, callback=std::move(callback)]() {
+        std::exception_ptr error;
+        try {
+            impl->complete();
+        } catch(...) {
+            error = std::current_exception();
+        }
+        callback(error);
+    }, tl::anonymous());
+}
+
+void AsyncRequest::waitAll(const std::vector<AsyncRequest>& requests) {
+    std::exception_ptr error;
+    for(auto& request : requests) {
+        if(not request) continue;
+        try {
+            request.self->complete();
+        } catch(...) {
+            if(not error) error = std::current_exception();
+        }
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+size_t AsyncRequest::waitAny(const std::vector<AsyncRequest>& requests) {
+    // There is no way to block on several RPC responses at once, so we
+    // poll them, yielding between passes to let the progress loop run.
+    while(true) {
+        bool pending = false;
+        for(size_t i = 0; i < requests.size(); i++) {
+            auto& impl = requests[i].self;
+            if(not impl || impl->done()) continue;
+            if(impl->completed()) return i;
+            pending = true;
+        }
+        if(not pending) return requests.size();
+        tl::thread::yield();
+    }
+}
+
+size_t AsyncRequest::testSome(const std::vector<AsyncRequest>& requests,
+                              std::vector<size_t>* indices) {
+    indices->clear();
+    for(size_t i = 0; i < requests.size(); i++) {
+        auto& impl = requests[i].self;
+        if(impl && not impl->done() && impl->completed())
+            indices->push_back(i);
+    }
+    return indices->size();
 }
 
 }
@@ -1,13 +1,19 @@
 /*
  * (C) 2020 The University of Chicago
- * 
+ *
  * See COPYRIGHT in top-level directory.
  */
 #ifndef __CACHERSIZE_ASYNC_REQUEST_IMPL_H
 #define __CACHERSIZE_ASYNC_REQUEST_IMPL_H
 
-#include <functional>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <vector>
 #include <thallium.hpp>
+#include <cachersize/AsyncRequest.hpp>
+#include "InlineFunction.hpp"
+#include "PoolAllocator.hpp"
 
 namespace cachersize {
 
@@ -15,12 +21,86 @@ namespace tl = thallium;
 
 struct AsyncRequestImpl {
 
+    // Large enough for the state captured by the CacheHandle operations
+    static constexpr size_t CALLBACK_CAPACITY = 192;
+
+    using WaitCallback = InlineFunction<void(AsyncRequestImpl&), CALLBACK_CAPACITY>;
+
+    /**
+     * @brief Creates a request. The request and its control block are
+     * allocated together from a per-thread pool (see PoolAllocator).
+     */
+    template<typename ... Args>
+    static std::shared_ptr<AsyncRequestImpl> make(Args&&... args) {
+        return std::allocate_shared<AsyncRequestImpl>(
+            PoolAllocator<AsyncRequestImpl>(), std::forward<Args>(args)...);
+    }
+
+    // a request that completed without sending any RPC,
+    // or that is composed of the requests in m_children
+    AsyncRequestImpl() = default;
+
     AsyncRequestImpl(tl::async_response&& async_response)
-    : m_async_response(std::move(async_response)) {}
+    : m_async_response(new (&m_response_storage) tl::async_response(std::move(async_response))) {}
+
+    AsyncRequestImpl(const AsyncRequestImpl&) = delete;
+    AsyncRequestImpl& operator=(const AsyncRequestImpl&) = delete;
+
+    ~AsyncRequestImpl() {
+        if(m_async_response) m_async_response->~async_response();
+    }
+
+    /**
+     * @brief Whether the request can complete without blocking.
+     */
+    bool completed() const {
+        if(m_state.load(std::memory_order_acquire) == DONE)
+            return true;
+        if(m_async_response)
+            return m_async_response->received();
+        for(auto& child : m_children)
+            if(not child.completed()) return false;
+        return true;
+    }
+
+    bool done() const {
+        return m_state.load(std::memory_order_acquire) == DONE;
+    }
+
+    /**
+     * @brief Completes the request by running the wait callback, the
+     * first time it is called. Concurrent callers yield until the first
+     * one is done. Rethrows the error raised by the callback, if any,
+     * on every call.
+     */
+    void complete() {
+        int expected = PENDING;
+        if(m_state.compare_exchange_strong(expected, COMPLETING, std::memory_order_acq_rel)) {
+            try {
+                if(m_wait_callback) m_wait_callback(*this);
+            } catch(...) {
+                m_error = std::current_exception();
+            }
+            // release the captured state as early as possible
+            m_wait_callback = nullptr;
+            m_state.store(DONE, std::memory_order_release);
+        } else {
+            while(m_state.load(std::memory_order_acquire) != DONE)
+                tl::thread::yield();
+        }
+        if(m_error) std::rethrow_exception(m_error);
+    }
+
+    enum State : int { PENDING, COMPLETING, DONE };
 
-    tl::async_response                     m_async_response;
-    bool                                   m_waited = false;
-    std::function<void(AsyncRequestImpl&)> m_wait_callback;
+    typename std::aligned_storage<sizeof(tl::async_response),
+                                  alignof(tl::async_response)>::type m_response_storage;
+    // points to m_response_storage if the request has an RPC response
+    tl::async_response*       m_async_response = nullptr;
+    std::vector<AsyncRequest> m_children;
+    std::atomic<int>          m_state{PENDING};
+    std::exception_ptr        m_error;
+    WaitCallback              m_wait_callback;
 
 };
 
@@ -4,6 +4,7 @@
  * See COPYRIGHT in top-level directory.
  */
 #include "cachersize/Backend.hpp"
+#include "Compression.hpp"
 
 namespace tl = thallium;
 
@@ -11,6 +12,134 @@ namespace cachersize {
 
 using json = nlohmann::json;
 
+RequestResult<bool> Backend::putWithTTL(const std::string& key, std::string&& value,
+                                        uint64_t ttl_ms) {
+    if(ttl_ms == 0) return put(key, std::move(value));
+    RequestResult<bool> result;
+    result.success() = false;
+    result.error() = "This cache does not support expiration";
+    return result;
+}
+
+RequestResult<std::vector<Status>> Backend::putMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>&& values) {
+    RequestResult<std::vector<Status>> result;
+    auto& status = result.value();
+    status.reserve(keys.size());
+    for(size_t i = 0; i < keys.size(); i++) {
+        auto r = put(keys[i], std::move(values[i]));
+        status.push_back(r.success() ? Status::OK : Status::Error);
+    }
+    return result;
+}
+
+RequestResult<std::vector<Status>> Backend::putMultiWithTTL(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>&& values,
+        uint64_t ttl_ms) {
+    if(ttl_ms == 0) return putMulti(keys, std::move(values));
+    RequestResult<std::vector<Status>> result;
+    result.success() = false;
+    result.error() = "This cache does not support expiration";
+    return result;
+}
+
+RequestResult<std::vector<Status>> Backend::getMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* values) {
+    RequestResult<std::vector<Status>> result;
+    auto& status = result.value();
+    status.reserve(keys.size());
+    values->resize(keys.size());
+    for(size_t i = 0; i < keys.size(); i++) {
+        auto r = get(keys[i]);
+        if(r.success()) {
+            (*values)[i] = std::move(r.value());
+            status.push_back(Status::OK);
+        } else {
+            status.push_back(Status::NotFound);
+        }
+    }
+    return result;
+}
+
+RequestResult<std::string> Backend::getCompressed(const std::string& key) {
+    auto result = get(key);
+    if(result.success()) {
+        std::string frame;
+        compression::appendRawFrame(result.value().data(), result.value().size(), &frame);
+        result.value() = std::move(frame);
+    }
+    return result;
+}
+
+RequestResult<std::vector<Status>> Backend::getMultiCompressed(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* frames) {
+    std::vector<std::string> values;
+    auto result = getMulti(keys, &values);
+    frames->resize(keys.size());
+    if(not result.success()) return result;
+    for(size_t i = 0; i < keys.size(); i++) {
+        (*frames)[i].clear();
+        if(result.value()[i] == Status::OK)
+            compression::appendRawFrame(values[i].data(), values[i].size(), &(*frames)[i]);
+    }
+    return result;
+}
+
+RequestResult<std::vector<Status>> Backend::eraseMulti(
+        const std::vector<std::string>& keys) {
+    RequestResult<std::vector<Status>> result;
+    auto& status = result.value();
+    status.reserve(keys.size());
+    for(auto& key : keys) {
+        auto r = erase(key);
+        status.push_back(r.success() ? Status::OK : Status::Error);
+    }
+    return result;
+}
+
+RequestResult<bool> Backend::flush() {
+    return RequestResult<bool>();
+}
+
+json Backend::getStats() const {
+    return json::object();
+}
+
+RequestResult<bool> Backend::scan(const ScanFunction& fn) {
+    (void)fn;
+    RequestResult<bool> result;
+    result.success() = false;
+    result.error() = "This cache does not support snapshots";
+    return result;
+}
+
+RequestResult<size_t> Backend::load(const std::vector<std::string>& keys,
+                                    std::vector<std::string>&& values,
+                                    const std::vector<uint64_t>& ttls_ms) {
+    RequestResult<size_t> result;
+    result.value() = 0;
+    for(size_t i = 0; i < keys.size(); i++) {
+        auto found = exists(keys[i]);
+        if(found.success() && found.value()) continue;
+        if(putWithTTL(keys[i], std::move(values[i]), ttls_ms[i]).success())
+            result.value() += 1;
+    }
+    return result;
+}
+
+bool Backend::getMemoryProfile(MemoryProfile* profile) const {
+    (void)profile;
+    return false;
+}
+
+void Backend::setMemoryCapacity(size_t bytes) {
+    (void)bytes;
+}
+
 std::unordered_map<std::string,
                 std::function<std::unique_ptr<Backend>(const tl::engine&, const json&)>> CacheFactory::create_fn;
 
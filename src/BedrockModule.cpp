@@ -7,6 +7,7 @@
 #include "cachersize/Provider.hpp"
 #include "cachersize/ProviderHandle.hpp"
 #include <bedrock/AbstractServiceFactory.hpp>
+#include <nlohmann/json.hpp>
 
 namespace tl = thallium;
 
@@ -29,7 +30,9 @@ class CachersizeFactory : public bedrock::AbstractServiceFactory {
 
     std::string getProviderConfig(void *p) override {
         auto provider = static_cast<cachersize::Provider *>(p);
-        return provider->getConfig();
+        auto config = nlohmann::json::parse(provider->getConfig());
+        config["stats"] = nlohmann::json::parse(provider->getStats());
+        return config.dump();
     }
 
     void *initClient(const bedrock::FactoryArgs& args) override {
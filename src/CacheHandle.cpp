@@ -10,12 +10,209 @@
 #include "AsyncRequestImpl.hpp"
 #include "ClientImpl.hpp"
 #include "CacheHandleImpl.hpp"
+#include "Lease.hpp"
+#include "Compression.hpp"
 
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/pair.hpp>
+#include <thallium/serialization/stl/vector.hpp>
 
 namespace cachersize {
 
+CacheHandleImpl::Location CacheHandleImpl::moveTo(const std::string& location) {
+    auto at = location.find('@');
+    unsigned long provider_id = UINT16_MAX + 1ul;
+    if(at != std::string::npos) {
+        try {
+            provider_id = std::stoul(location.substr(0, at));
+        } catch(const std::exception&) {}
+    }
+    if(provider_id > UINT16_MAX)
+        throw Exception("Invalid location of migrated cache: " + location);
+    auto ph = std::make_shared<const tl::provider_handle>(
+        m_client->m_endpoints->lookup(m_client->m_engine, location.substr(at + 1)),
+        static_cast<uint16_t>(provider_id));
+    std::lock_guard<tl::mutex> lock(m_ph_mtx);
+    m_ph = ph;
+    return ph;
+}
+
+using GetResponse = RequestResult<std::pair<uint64_t, std::string>>;
+
+/**
+ * @brief Completes a get operation from the response of the
+ * cachersize_get RPC sent to ph, fetching the value with
+ * cachersize_get_bulk if it was too large to be sent back inline.
+ */
+static void completeGet(CacheHandleImpl& impl,
+                        CacheHandleImpl::Location ph,
+                        const std::string& key,
+                        uint64_t eager_limit,
+                        bool compressed,
+                        GetResponse& response,
+                        std::string* value) {
+    auto& client = *impl.m_client;
+    auto& cache_id = impl.m_cache_id;
+    if(not response.success())
+        throw Exception(response.error());
+    uint64_t size = response.value().first;
+    if(size <= eager_limit) {
+        if(not value) return;
+        if(compressed) compression::decompress(response.value().second, value);
+        else *value = std::move(response.value().second);
+        return;
+    }
+    if(not value) return;
+    std::string buffer;
+    // the value may be replaced by a larger one between the two RPCs,
+    // in which case the server reports the new size and we retry
+    while(true) {
+        buffer.resize(size);
+        std::vector<std::pair<void*, size_t>> segment = {{ &buffer[0], buffer.size() }};
+        auto local_bulk = client.m_engine.expose(segment, tl::bulk_mode::write_only);
+        auto send = [&](const tl::provider_handle& ph) -> RequestResult<uint64_t> {
+            return client.m_get_bulk.on(ph)(cache_id, key, local_bulk, compressed);
+        };
+        RequestResult<uint64_t> r = send(*ph);
+        impl.followMoves(ph, r, send);
+        if(not r.success())
+            throw Exception(r.error());
+        if(r.value() <= buffer.size()) {
+            buffer.resize(r.value());
+            break;
+        }
+        size = r.value();
+    }
+    if(compressed) compression::decompress(buffer, value);
+    else *value = std::move(buffer);
+}
+
+using LeasedGetResponse = RequestResult<LeasedValue>;
+
+/**
+ * @brief Completes a get operation sent with the cachersize_get_leased
+ * RPC, inserting the value in the near cache if it came with a lease.
+ */
+static void completeLeasedGet(CacheHandleImpl& impl,
+                              CacheHandleImpl::Location ph,
+                              const std::string& key,
+                              uint64_t eager_limit,
+                              NearCache& near_cache,
+                              uint64_t generation,
+                              double sent,
+                              LeasedGetResponse& response,
+                              std::string* value) {
+    if(not response.success())
+        throw Exception(response.error());
+    auto& leased = response.value();
+    // the lease is counted from the time the request was sent, which
+    // precedes the time the provider granted it, so the entry never
+    // outlives the provider's view of the lease
+    if(leased.size <= eager_limit && leased.lease > 0)
+        near_cache.insert(key, leased.value, sent + leased.lease, generation);
+    GetResponse get_response;
+    get_response.value().first  = leased.size;
+    get_response.value().second = std::move(leased.value);
+    completeGet(impl, std::move(ph), key, eager_limit, false, get_response, value);
+}
+
+using MultiResponse = RequestResult<std::vector<uint8_t>>;
+using GetMultiResponse = RequestResult<std::pair<std::vector<uint8_t>, std::vector<uint64_t>>>;
+
+/**
+ * @brief State of a batched operation that must outlive the call
+ * when it is non-blocking: the packed buffer and its bulk handle.
+ */
+struct MultiState {
+    std::string           buffer;
+    std::vector<uint64_t> key_sizes;
+    std::vector<uint64_t> value_sizes;
+    uint64_t              keys_size = 0;
+    bool                  compressed = false; // values are received as compression frames
+    tl::bulk              bulk;
+};
+
+static void pack(const std::vector<std::string>& items,
+                 std::vector<uint64_t>* sizes,
+                 std::string* buffer) {
+    sizes->reserve(items.size());
+    for(auto& item : items) {
+        sizes->push_back(item.size());
+        buffer->append(item);
+    }
+}
+
+static void exposeMulti(ClientImpl& client, MultiState& state, tl::bulk_mode mode) {
+    // an empty region cannot be exposed
+    if(state.buffer.empty()) state.buffer.push_back('\0');
+    std::vector<std::pair<void*, size_t>> segment = {{ &state.buffer[0], state.buffer.size() }};
+    state.bulk = client.m_engine.expose(segment, mode);
+}
+
+/**
+ * @brief Converts the statuses received from the server, throwing
+ * if the caller did not ask for them and an item failed.
+ */
+static void completeMulti(MultiResponse& response,
+                          std::vector<Status>* statuses,
+                          const char* error) {
+    if(not response.success())
+        throw Exception(response.error());
+    auto& wire = response.value();
+    if(statuses) {
+        statuses->resize(wire.size());
+        for(size_t i = 0; i < wire.size(); i++)
+            (*statuses)[i] = static_cast<Status>(wire[i]);
+    } else {
+        for(auto s : wire)
+            if(static_cast<Status>(s) != Status::OK) throw Exception(error);
+    }
+}
+
+/**
+ * @brief Completes a getMulti operation: copies the values out of
+ * the receive area and fetches deferred ones with individual gets.
+ */
+static void completeGetMulti(const CacheHandle& handle,
+                             const std::vector<std::string>& keys,
+                             const MultiState& state,
+                             GetMultiResponse& response,
+                             std::vector<std::string>* values,
+                             std::vector<Status>* statuses) {
+    if(not response.success())
+        throw Exception(response.error());
+    auto& wire  = response.value().first;
+    auto& sizes = response.value().second;
+    std::vector<Status> local_statuses;
+    if(not statuses) statuses = &local_statuses;
+    statuses->resize(keys.size());
+    if(values) values->resize(keys.size());
+    size_t offset = state.keys_size;
+    for(size_t i = 0; i < keys.size(); i++) {
+        auto status = static_cast<Status>(wire[i]);
+        if(status == Status::OK) {
+            if(values && state.compressed)
+                compression::decompress(&state.buffer[offset], sizes[i], &(*values)[i]);
+            else if(values)
+                (*values)[i].assign(state.buffer, offset, sizes[i]);
+            offset += sizes[i];
+        } else if(status == Status::Deferred) {
+            try {
+                handle.get(keys[i], values ? &(*values)[i] : nullptr);
+                status = Status::OK;
+            } catch(const Exception&) {
+                // erased since the batch was processed
+                status = Status::NotFound;
+            }
+        }
+        (*statuses)[i] = status;
+    }
+    if(statuses == &local_statuses) {
+        for(auto s : local_statuses)
+            if(s != Status::OK) throw Exception("Key not found");
+    }
+}
+
 CacheHandle::CacheHandle() = default;
 
 CacheHandle::CacheHandle(const std::shared_ptr<CacheHandleImpl>& impl)
@@ -42,9 +239,9 @@ Client CacheHandle::client() const {
 void CacheHandle::sayHello() const {
     if(not self) throw Exception("Invalid cachersize::CacheHandle object");
     auto& rpc = self->m_client->m_say_hello;
-    auto& ph  = self->m_ph;
+    auto ph  = self->location();
     auto& cache_id = self->m_cache_id;
-    rpc.on(ph)(cache_id);
+    rpc.on(*ph)(cache_id);
 }
 
 void CacheHandle::computeSum(
@@ -53,24 +250,29 @@ void CacheHandle::computeSum(
         AsyncRequest* req) const
 {
     if(not self) throw Exception("Invalid cachersize::CacheHandle object");
-    auto& rpc = self->m_client->m_compute_sum;
-    auto& ph  = self->m_ph;
-    auto& cache_id = self->m_cache_id;
+    auto ph  = self->location();
+    auto send = [client=self->m_client, cache_id=self->m_cache_id, x, y]
+                (const tl::provider_handle& ph) -> RequestResult<int32_t> {
+        return client->m_compute_sum.on(ph)(cache_id, x, y);
+    };
     if(req == nullptr) { // synchronous call
-        RequestResult<int32_t> response = rpc.on(ph)(cache_id, x, y);
+        RequestResult<int32_t> response = send(*ph);
+        self->followMoves(ph, response, send);
         if(response.success()) {
             if(result) *result = response.value();
         } else {
             throw Exception(response.error());
         }
     } else { // asynchronous call
-        auto async_response = rpc.on(ph).async(cache_id, x, y);
+        auto async_response = self->m_client->m_compute_sum.on(*ph).async(self->m_cache_id, x, y);
         auto async_request_impl =
-            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+            AsyncRequestImpl::make(std::move(async_response));
         async_request_impl->m_wait_callback =
-            [result](AsyncRequestImpl& async_request_impl) {
+            [impl=self, ph, send, result](AsyncRequestImpl& async_request_impl) {
                 RequestResult<int32_t> response =
-                    async_request_impl.m_async_response.wait();
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response, send);
                     if(response.success()) {
                         if(result) *result = response.value();
                     } else {
@@ -81,4 +283,388 @@ void CacheHandle::computeSum(
     }
 }
 
+void CacheHandle::put(
+        const std::string& key,
+        const std::string& value,
+        AsyncRequest* req) const
+{
+    put(key, value, PutOptions(), req);
+}
+
+void CacheHandle::put(
+        const std::string& key,
+        const std::string& value,
+        const PutOptions& options,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto& client = *self->m_client;
+    auto ph  = self->location();
+    auto& cache_id = self->m_cache_id;
+    if(self->m_near_cache) self->m_near_cache->invalidate(key);
+    bool eager = value.size() <= client.m_eager_limit;
+    uint64_t ttl_ms = options.ttl_ms;
+    tl::bulk local_bulk;
+    if(not eager) {
+        std::vector<std::pair<void*, size_t>> segment =
+            {{ const_cast<char*>(value.data()), value.size() }};
+        local_bulk = client.m_engine.expose(segment, tl::bulk_mode::read_only);
+    }
+    if(req == nullptr) { // synchronous call
+        auto send = [&](const tl::provider_handle& ph) -> RequestResult<bool> {
+            return eager ? client.m_put.on(ph)(cache_id, key, value, ttl_ms)
+                         : client.m_put_bulk.on(ph)(cache_id, key, local_bulk, ttl_ms);
+        };
+        RequestResult<bool> response = send(*ph);
+        self->followMoves(ph, response, send);
+        if(not response.success()) throw Exception(response.error());
+        return;
+    }
+    auto async_request_impl = AsyncRequestImpl::make(eager
+        ? client.m_put.on(*ph).async(cache_id, key, value, ttl_ms)
+        : client.m_put_bulk.on(*ph).async(cache_id, key, local_bulk, ttl_ms));
+    // the bulk handle is captured so it stays valid until completion;
+    // eager values are copied, to be sent again if the cache moved
+    auto send = [client=self->m_client, cache_id, key, value=eager ? value : std::string(),
+                 local_bulk, ttl_ms, eager](const tl::provider_handle& ph) -> RequestResult<bool> {
+        return eager ? client->m_put.on(ph)(cache_id, key, value, ttl_ms)
+                     : client->m_put_bulk.on(ph)(cache_id, key, local_bulk, ttl_ms);
+    };
+    async_request_impl->m_wait_callback =
+        [impl=self, ph, send](AsyncRequestImpl& async_request_impl) {
+            RequestResult<bool> response =
+                async_request_impl.m_async_response->wait();
+            auto location = ph;
+            impl->followMoves(location, response, send);
+            if(not response.success()) {
+                throw Exception(response.error());
+            }
+        };
+    *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void CacheHandle::get(
+        const std::string& key,
+        std::string* value,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto& client = *self->m_client;
+    auto& cache_id = self->m_cache_id;
+    uint64_t eager_limit = client.m_eager_limit;
+    bool compressed = self->m_compressed_transfer;
+    if(self->m_near_cache) {
+        getThroughNearCache(key, value, req);
+        return;
+    }
+    auto ph = self->location();
+    if(req == nullptr) { // synchronous call
+        auto send = [&](const tl::provider_handle& ph) -> GetResponse {
+            return client.m_get.on(ph)(cache_id, key, eager_limit, compressed);
+        };
+        GetResponse response = send(*ph);
+        self->followMoves(ph, response, send);
+        completeGet(*self, ph, key, eager_limit, compressed, response, value);
+    } else { // asynchronous call
+        auto async_response = client.m_get.on(*ph).async(cache_id, key, eager_limit, compressed);
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [impl=self, ph, key, eager_limit, compressed, value]
+            (AsyncRequestImpl& async_request_impl) {
+                GetResponse response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response,
+                    [&](const tl::provider_handle& ph) -> GetResponse {
+                        return impl->m_client->m_get.on(ph)(
+                            impl->m_cache_id, key, eager_limit, compressed);
+                    });
+                completeGet(*impl, location, key, eager_limit, compressed, response, value);
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void CacheHandle::getThroughNearCache(
+        const std::string& key,
+        std::string* value,
+        AsyncRequest* req) const
+{
+    auto& client = *self->m_client;
+    auto& near_cache = self->m_near_cache;
+    if(near_cache->lookup(key, value)) {
+        if(req) {
+            auto async_request_impl = AsyncRequestImpl::make();
+            async_request_impl->m_wait_callback = [](AsyncRequestImpl&) {};
+            *req = AsyncRequest(std::move(async_request_impl));
+        }
+        return;
+    }
+    auto ph  = self->location();
+    auto& cache_id = self->m_cache_id;
+    uint64_t eager_limit = client.m_eager_limit;
+    uint64_t generation = near_cache->generation();
+    double sent = tl::timer::wtime();
+    if(req == nullptr) { // synchronous call
+        auto send = [&](const tl::provider_handle& ph) -> LeasedGetResponse {
+            return client.m_get_leased.on(ph)(
+                cache_id, key, eager_limit, client.m_self_address, near_cache->id());
+        };
+        LeasedGetResponse response = send(*ph);
+        self->followMoves(ph, response, send);
+        completeLeasedGet(*self, ph, key, eager_limit,
+                          *near_cache, generation, sent, response, value);
+    } else { // asynchronous call
+        auto async_response = client.m_get_leased.on(*ph).async(
+            cache_id, key, eager_limit, client.m_self_address, near_cache->id());
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [impl=self, ph, key, eager_limit,
+             near_cache, generation, sent, value]
+            (AsyncRequestImpl& async_request_impl) {
+                LeasedGetResponse response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response,
+                    [&](const tl::provider_handle& ph) -> LeasedGetResponse {
+                        auto& client = *impl->m_client;
+                        return client.m_get_leased.on(ph)(
+                            impl->m_cache_id, key, eager_limit, client.m_self_address, near_cache->id());
+                    });
+                completeLeasedGet(*impl, location, key, eager_limit,
+                                  *near_cache, generation, sent, response, value);
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void CacheHandle::erase(
+        const std::string& key,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto ph  = self->location();
+    auto send = [client=self->m_client, cache_id=self->m_cache_id, key]
+                (const tl::provider_handle& ph) -> RequestResult<bool> {
+        return client->m_erase.on(ph)(cache_id, key);
+    };
+    if(self->m_near_cache) self->m_near_cache->invalidate(key);
+    if(req == nullptr) { // synchronous call
+        RequestResult<bool> response = send(*ph);
+        self->followMoves(ph, response, send);
+        if(not response.success()) {
+            throw Exception(response.error());
+        }
+    } else { // asynchronous call
+        auto async_response = self->m_client->m_erase.on(*ph).async(self->m_cache_id, key);
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [impl=self, ph, send](AsyncRequestImpl& async_request_impl) {
+                RequestResult<bool> response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response, send);
+                if(not response.success()) {
+                    throw Exception(response.error());
+                }
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void CacheHandle::exists(
+        const std::string& key,
+        bool* result,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto ph  = self->location();
+    auto send = [client=self->m_client, cache_id=self->m_cache_id, key]
+                (const tl::provider_handle& ph) -> RequestResult<uint8_t> {
+        return client->m_exists.on(ph)(cache_id, key);
+    };
+    if(req == nullptr) { // synchronous call
+        RequestResult<uint8_t> response = send(*ph);
+        self->followMoves(ph, response, send);
+        if(response.success()) {
+            if(result) *result = response.value();
+        } else {
+            throw Exception(response.error());
+        }
+    } else { // asynchronous call
+        auto async_response = self->m_client->m_exists.on(*ph).async(self->m_cache_id, key);
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [impl=self, ph, send, result](AsyncRequestImpl& async_request_impl) {
+                RequestResult<uint8_t> response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response, send);
+                if(response.success()) {
+                    if(result) *result = response.value();
+                } else {
+                    throw Exception(response.error());
+                }
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void CacheHandle::putMulti(
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& values,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    putMulti(keys, values, PutOptions(), statuses, req);
+}
+
+void CacheHandle::putMulti(
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& values,
+        const PutOptions& options,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    if(keys.size() != values.size())
+        throw Exception("putMulti requires as many values as keys");
+    if(self->m_near_cache && not keys.empty()) self->m_near_cache->invalidate(keys);
+    auto& client = *self->m_client;
+    auto ph  = self->location();
+    auto& cache_id = self->m_cache_id;
+    auto state = std::make_shared<MultiState>();
+    pack(keys, &state->key_sizes, &state->buffer);
+    pack(values, &state->value_sizes, &state->buffer);
+    exposeMulti(client, *state, tl::bulk_mode::read_only);
+    auto send = [client=self->m_client, cache_id, state, ttl_ms=options.ttl_ms]
+                (const tl::provider_handle& ph) -> MultiResponse {
+        return client->m_put_multi.on(ph)(
+            cache_id, state->key_sizes, state->value_sizes, state->bulk, ttl_ms);
+    };
+    if(req == nullptr) { // synchronous call
+        MultiResponse response = send(*ph);
+        self->followMoves(ph, response, send);
+        completeMulti(response, statuses, "Failed to store some of the values");
+    } else { // asynchronous call
+        auto async_response = client.m_put_multi.on(*ph).async(
+            cache_id, state->key_sizes, state->value_sizes, state->bulk, options.ttl_ms);
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [impl=self, ph, send, statuses](AsyncRequestImpl& async_request_impl) {
+                MultiResponse response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response, send);
+                completeMulti(response, statuses, "Failed to store some of the values");
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void CacheHandle::getMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* values,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto& client = *self->m_client;
+    auto ph  = self->location();
+    auto& cache_id = self->m_cache_id;
+    auto state = std::make_shared<MultiState>();
+    pack(keys, &state->key_sizes, &state->buffer);
+    state->keys_size = state->buffer.size();
+    state->compressed = self->m_compressed_transfer;
+    state->buffer.resize(state->keys_size + keys.size() * client.m_multi_get_item_size);
+    exposeMulti(client, *state, tl::bulk_mode::read_write);
+    auto send = [client=self->m_client, cache_id, state]
+                (const tl::provider_handle& ph) -> GetMultiResponse {
+        return client->m_get_multi.on(ph)(
+            cache_id, state->key_sizes, state->bulk, state->keys_size, state->compressed);
+    };
+    if(req == nullptr) { // synchronous call
+        GetMultiResponse response = send(*ph);
+        self->followMoves(ph, response, send);
+        completeGetMulti(*this, keys, *state, response, values, statuses);
+    } else { // asynchronous call
+        auto async_response = client.m_get_multi.on(*ph).async(
+            cache_id, state->key_sizes, state->bulk, state->keys_size, state->compressed);
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [handle=*this, ph, send, &keys, state, values, statuses]
+            (AsyncRequestImpl& async_request_impl) {
+                GetMultiResponse response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                handle.self->followMoves(location, response, send);
+                completeGetMulti(handle, keys, *state, response, values, statuses);
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+void CacheHandle::eraseMulti(
+        const std::vector<std::string>& keys,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto& client = *self->m_client;
+    auto ph  = self->location();
+    auto& cache_id = self->m_cache_id;
+    if(self->m_near_cache && not keys.empty()) self->m_near_cache->invalidate(keys);
+    auto state = std::make_shared<MultiState>();
+    pack(keys, &state->key_sizes, &state->buffer);
+    exposeMulti(client, *state, tl::bulk_mode::read_only);
+    auto send = [client=self->m_client, cache_id, state]
+                (const tl::provider_handle& ph) -> MultiResponse {
+        return client->m_erase_multi.on(ph)(cache_id, state->key_sizes, state->bulk);
+    };
+    if(req == nullptr) { // synchronous call
+        MultiResponse response = send(*ph);
+        self->followMoves(ph, response, send);
+        completeMulti(response, statuses, "Failed to erase some of the keys");
+    } else { // asynchronous call
+        auto async_response = client.m_erase_multi.on(*ph).async(
+            cache_id, state->key_sizes, state->bulk);
+        auto async_request_impl =
+            AsyncRequestImpl::make(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [impl=self, ph, send, statuses](AsyncRequestImpl& async_request_impl) {
+                MultiResponse response =
+                    async_request_impl.m_async_response->wait();
+                auto location = ph;
+                impl->followMoves(location, response, send);
+                completeMulti(response, statuses, "Failed to erase some of the keys");
+            };
+        *req = AsyncRequest(std::move(async_request_impl));
+    }
+}
+
+std::string CacheHandle::getStats() const {
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    auto ph = self->location();
+    auto send = [this](const tl::provider_handle& ph) -> RequestResult<std::string> {
+        return self->m_client->m_get_stats.on(ph)(self->m_cache_id);
+    };
+    RequestResult<std::string> result = send(*ph);
+    self->followMoves(ph, result, send);
+    if(not result.success())
+        throw Exception(result.error());
+    return result.value();
+}
+
+NearCacheStats CacheHandle::nearCacheStats() const {
+    if(not self) throw Exception("Invalid cachersize::CacheHandle object");
+    if(not self->m_near_cache) return NearCacheStats();
+    return self->m_near_cache->stats();
+}
+
 }
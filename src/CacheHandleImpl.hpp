@@ -7,6 +7,13 @@
 #define __CACHERSIZE_CACHE_HANDLE_IMPL_H
 
 #include <cachersize/UUID.hpp>
+#include <cachersize/RequestResult.hpp>
+#include <cachersize/Exception.hpp>
+#include "NearCache.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
 
 namespace cachersize {
 
@@ -14,18 +21,61 @@ class CacheHandleImpl {
 
     public:
 
+    using Location = std::shared_ptr<const tl::provider_handle>;
+
     UUID                        m_cache_id;
     std::shared_ptr<ClientImpl> m_client;
-    tl::provider_handle         m_ph;
+    // provider holding the cache, replaced by moveTo() when the cache
+    // migrates; requests hold their own reference to it
+    Location                    m_ph;
+    mutable tl::mutex           m_ph_mtx;
+    // null if the handle was created without a near cache
+    std::shared_ptr<NearCache>  m_near_cache;
+    // values are read as compression frames and decompressed locally
+    bool                        m_compressed_transfer = false;
 
     CacheHandleImpl() = default;
     
     CacheHandleImpl(const std::shared_ptr<ClientImpl>& client, 
                        tl::provider_handle&& ph,
-                       const UUID& cache_id)
+                       const UUID& cache_id,
+                       std::shared_ptr<NearCache> near_cache = nullptr,
+                       bool compressed_transfer = false)
     : m_cache_id(cache_id)
     , m_client(client)
-    , m_ph(std::move(ph)) {}
+    , m_ph(std::make_shared<const tl::provider_handle>(std::move(ph)))
+    , m_near_cache(std::move(near_cache))
+    , m_compressed_transfer(compressed_transfer) {}
+
+    Location location() const {
+        std::lock_guard<tl::mutex> lock(m_ph_mtx);
+        return m_ph;
+    }
+
+    /**
+     * @brief Points the handle to the location sent with a CacheMoved
+     * error ("<provider id>@<address>") and returns the new location.
+     * Defined in CacheHandle.cpp.
+     */
+    Location moveTo(const std::string& location);
+
+    /**
+     * @brief If a response reports that the cache migrated (see
+     * Admin::migrateCache), points the handle to the new location and
+     * sends the request again with send(*ph), which returns the new
+     * response. ph is updated to the location that responded.
+     */
+    template<typename Response, typename Send>
+    void followMoves(Location& ph, Response& response, const Send& send) {
+        // a cache that keeps moving is not followed forever
+        static constexpr unsigned kMaxMoves = 8;
+        for(unsigned moves = 0; response.code() == ResultCode::CacheMoved; moves++) {
+            if(moves == kMaxMoves)
+                throw Exception("Cache " + m_cache_id.to_string() + " moved too many times");
+            ph = moveTo(response.error());
+            response = send(*ph);
+        }
+    }
 };
 
 }
@@ -0,0 +1,280 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_CACHE_METRICS_HPP
+#define __CACHERSIZE_CACHE_METRICS_HPP
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace cachersize {
+
+namespace tl = thallium;
+
+/**
+ * @brief Latency histogram in the style of HdrHistogram: values (in
+ * nanoseconds) are counted in buckets whose width doubles with every
+ * power of two and which split each power of two in 2^kSubBucketBits
+ * sub-buckets, so that a recorded value is known with a relative error
+ * of at most 1/2^kSubBucketBits. Values above 2^(kMaxExponent+1) ns
+ * (about two minutes) are counted in the last bucket.
+ */
+class LatencyHistogram {
+
+    public:
+
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr unsigned kSubBuckets    = 1u << kSubBucketBits;
+    static constexpr unsigned kMaxExponent   = 36;
+    static constexpr unsigned kNumBuckets    = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    LatencyHistogram() {
+        for(auto& c : m_counts) c.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    static unsigned bucketOf(uint64_t ns) {
+        if(ns < kSubBuckets) return static_cast<unsigned>(ns);
+        unsigned e = 63 - __builtin_clzll(ns);
+        if(e > kMaxExponent) return kNumBuckets - 1;
+        return ((e - kSubBucketBits + 1) << kSubBucketBits)
+             + static_cast<unsigned>((ns >> (e - kSubBucketBits)) & (kSubBuckets - 1));
+    }
+
+    /**
+     * @brief Largest value counted in a bucket.
+     */
+    static uint64_t upperBound(unsigned bucket) {
+        if(bucket < kSubBuckets) return bucket;
+        unsigned e   = (bucket >> kSubBucketBits) + kSubBucketBits - 1;
+        uint64_t sub = bucket & (kSubBuckets - 1);
+        return ((kSubBuckets + sub + 1) << (e - kSubBucketBits)) - 1;
+    }
+
+    void record(uint64_t ns) {
+        m_counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Adds the counts of this histogram into counts
+     * (of size kNumBuckets) and its sum of values into sum.
+     */
+    void addTo(std::vector<uint64_t>& counts, uint64_t& sum) const {
+        for(unsigned i = 0; i < kNumBuckets; i++)
+            counts[i] += m_counts[i].load(std::memory_order_relaxed);
+        sum += m_sum.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Summarizes merged counts as a JSON object with the number
+     * of values and their mean, p50, p99, p99.9 and max in microseconds.
+     */
+    static nlohmann::json summarize(const std::vector<uint64_t>& counts, uint64_t sum) {
+        uint64_t total = 0;
+        for(auto c : counts) total += c;
+        auto result = nlohmann::json::object();
+        result["count"] = total;
+        if(total == 0) return result;
+        auto percentile = [&](double p) {
+            uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+            uint64_t seen = 0;
+            for(unsigned i = 0; i < kNumBuckets; i++) {
+                seen += counts[i];
+                if(seen >= rank) return upperBound(i) / 1000.0;
+            }
+            return upperBound(kNumBuckets - 1) / 1000.0;
+        };
+        result["mean_us"]  = sum / 1000.0 / total;
+        result["p50_us"]   = percentile(0.5);
+        result["p99_us"]   = percentile(0.99);
+        result["p99.9_us"] = percentile(0.999);
+        result["max_us"]   = percentile(1.0);
+        return result;
+    }
+
+    private:
+
+    std::atomic<uint64_t> m_counts[kNumBuckets];
+    std::atomic<uint64_t> m_sum;
+};
+
+/**
+ * @brief Counters and per-RPC latency histograms of a cache, as
+ * maintained by the provider. Like the reader counters of the
+ * CacheRegistry, they are split in stripes selected by the calling
+ * xstream's rank, each occupying exactly one (64-byte aligned) cache
+ * line, so that RPC handlers running on different xstreams do not
+ * write to shared cache lines. The histograms of a stripe are allocated the first
+ * time an RPC completes on that stripe.
+ */
+class CacheMetrics {
+
+    public:
+
+    enum Rpc : unsigned {
+        COMPUTE_SUM, PUT, GET, ERASE, EXISTS, GET_LEASED,
+        PUT_MULTI, GET_MULTI, ERASE_MULTI, NUM_RPCS
+    };
+
+    static const char* rpcName(unsigned rpc) {
+        static const char* names[NUM_RPCS] = {
+            "compute_sum", "put", "get", "erase", "exists", "get_leased",
+            "put_multi", "get_multi", "erase_multi"
+        };
+        return names[rpc];
+    }
+
+    /**
+     * @brief Records the latency of an RPC when destroyed.
+     */
+    class Timer {
+
+        friend class CacheMetrics;
+
+        CacheMetrics&                         m_metrics;
+        Rpc                                   m_rpc;
+        std::chrono::steady_clock::time_point m_start;
+        bool                                  m_active = true;
+
+        Timer(CacheMetrics& metrics, Rpc rpc)
+        : m_metrics(metrics)
+        , m_rpc(rpc)
+        , m_start(std::chrono::steady_clock::now()) {}
+
+        public:
+
+        Timer(Timer&& other)
+        : m_metrics(other.m_metrics)
+        , m_rpc(other.m_rpc)
+        , m_start(other.m_start) {
+            other.m_active = false;
+        }
+
+        ~Timer() {
+            if(not m_active) return;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count();
+            m_metrics.stripe().histograms()[m_rpc].record(static_cast<uint64_t>(ns));
+        }
+    };
+
+    CacheMetrics() = default;
+
+    CacheMetrics(const CacheMetrics&) = delete;
+    CacheMetrics& operator=(const CacheMetrics&) = delete;
+
+    ~CacheMetrics() {
+        for(auto& s : m_stripes) delete[] s.latency.load();
+    }
+
+    Timer time(Rpc rpc) {
+        return Timer(*this, rpc);
+    }
+
+    void hits(uint64_t n) {
+        if(n) stripe().hits.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void misses(uint64_t n) {
+        if(n) stripe().misses.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void bytesIn(uint64_t n) {
+        if(n) stripe().bytes_in.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void bytesOut(uint64_t n) {
+        if(n) stripe().bytes_out.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of gets (hits and misses) since creation.
+     */
+    uint64_t requests() const {
+        uint64_t n = 0;
+        for(auto& s : m_stripes)
+            n += s.hits.load(std::memory_order_relaxed) + s.misses.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    /**
+     * @brief Returns the counters, hit ratio, and a summary of the
+     * latency histogram of each RPC type that was called.
+     */
+    nlohmann::json toJson() const {
+        uint64_t hits = 0, misses = 0, bytes_in = 0, bytes_out = 0;
+        std::vector<std::vector<uint64_t>> counts(
+            NUM_RPCS, std::vector<uint64_t>(static_cast<size_t>(LatencyHistogram::kNumBuckets), 0));
+        std::vector<uint64_t> sums(NUM_RPCS, 0);
+        for(auto& s : m_stripes) {
+            hits      += s.hits.load(std::memory_order_relaxed);
+            misses    += s.misses.load(std::memory_order_relaxed);
+            bytes_in  += s.bytes_in.load(std::memory_order_relaxed);
+            bytes_out += s.bytes_out.load(std::memory_order_relaxed);
+            auto latency = s.latency.load(std::memory_order_acquire);
+            if(not latency) continue;
+            for(unsigned rpc = 0; rpc < NUM_RPCS; rpc++)
+                latency[rpc].addTo(counts[rpc], sums[rpc]);
+        }
+        auto result = nlohmann::json::object();
+        result["hits"]      = hits;
+        result["misses"]    = misses;
+        result["hit_ratio"] = hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+        result["bytes_in"]  = bytes_in;
+        result["bytes_out"] = bytes_out;
+        auto latency = nlohmann::json::object();
+        for(unsigned rpc = 0; rpc < NUM_RPCS; rpc++) {
+            auto summary = LatencyHistogram::summarize(counts[rpc], sums[rpc]);
+            if(summary["count"].get<uint64_t>() != 0)
+                latency[rpcName(rpc)] = std::move(summary);
+        }
+        result["latency"] = std::move(latency);
+        return result;
+    }
+
+    private:
+
+    static constexpr unsigned kNumStripes = 16;
+
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t>          hits      = { 0 };
+        std::atomic<uint64_t>          misses    = { 0 };
+        std::atomic<uint64_t>          bytes_in  = { 0 };
+        std::atomic<uint64_t>          bytes_out = { 0 };
+        std::atomic<LatencyHistogram*> latency   = { nullptr };
+
+        LatencyHistogram* histograms() {
+            auto h = latency.load(std::memory_order_acquire);
+            if(h) return h;
+            auto fresh = new LatencyHistogram[NUM_RPCS];
+            if(latency.compare_exchange_strong(h, fresh, std::memory_order_acq_rel))
+                return fresh;
+            delete[] fresh;
+            return h;
+        }
+    };
+
+    static_assert(sizeof(Stripe) == 64, "a Stripe should fill a cache line");
+    static_assert(alignof(Stripe) == 64, "a Stripe should be aligned to a cache line");
+
+    Stripe m_stripes[kNumStripes];
+
+    Stripe& stripe() {
+        int rank = tl::xstream::self_rank();
+        return m_stripes[rank < 0 ? 0 : static_cast<unsigned>(rank) % kNumStripes];
+    }
+};
+
+}
+
+#endif
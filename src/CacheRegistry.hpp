@@ -0,0 +1,266 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_CACHE_REGISTRY_HPP
+#define __CACHERSIZE_CACHE_REGISTRY_HPP
+
+#include <thallium.hpp>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+namespace cachersize {
+
+namespace tl = thallium;
+
+/**
+ * @brief Read-mostly map from keys to shared objects, in the style of
+ * sleepable RCU. Readers look up a raw pointer in an immutable snapshot
+ * of the map without taking any lock and without touching the objects'
+ * reference counts. Writers copy the snapshot, modify the copy, publish
+ * it, and wait for a grace period (i.e. until no reader can still be
+ * using the previous snapshot) before releasing it and the objects it
+ * was the last to reference.
+ *
+ * Readers announce themselves by incrementing one of a set of counters
+ * selected by the calling xstream's rank, each on its own cache line,
+ * so that readers on different xstreams do not write to shared cache
+ * lines. Counters come in two generations: a grace period flips the
+ * current generation and waits for the previous one to drain, twice,
+ * so that continuously arriving readers cannot starve a writer.
+ *
+ * A read-side critical section may block or yield (e.g. on a backend's
+ * lock); it only delays writers.
+ */
+template<typename Key, typename Value>
+class CacheRegistry {
+
+    using Map = std::unordered_map<Key, std::shared_ptr<Value>>;
+
+    static constexpr unsigned kNumStripes = 64;
+
+    struct alignas(64) Stripe {
+        std::atomic<int64_t> count = { 0 };
+    };
+
+    static_assert(sizeof(Stripe) == 64, "a Stripe should fill a cache line");
+
+    std::atomic<const Map*> m_current;
+    std::atomic<unsigned>   m_epoch = { 0 };
+    Stripe                  m_readers[2][kNumStripes];
+    tl::mutex               m_write_mtx;
+
+    static unsigned stripeIndex() {
+        int rank = tl::xstream::self_rank();
+        return rank < 0 ? 0 : static_cast<unsigned>(rank) % kNumStripes;
+    }
+
+    void waitForReaders(unsigned epoch) {
+        while(true) {
+            int64_t sum = 0;
+            for(auto& s : m_readers[epoch]) sum += s.count.load();
+            if(sum == 0) return;
+            tl::thread::yield();
+        }
+    }
+
+    void synchronize() {
+        for(int i = 0; i < 2; i++) {
+            unsigned old_epoch = m_epoch.load();
+            m_epoch.store(old_epoch ^ 1);
+            waitForReaders(old_epoch);
+        }
+    }
+
+    void publish(const Map* new_map) {
+        std::unique_ptr<const Map> old_map(m_current.exchange(new_map));
+        synchronize();
+        // old_map is released here, once no reader can reference it
+    }
+
+    public:
+
+    /**
+     * @brief RAII object delimiting a read-side critical section.
+     * Pointers obtained through find() remain valid until the
+     * ReadGuard is destroyed.
+     */
+    class ReadGuard {
+
+        friend class CacheRegistry;
+
+        CacheRegistry*         m_registry;
+        std::atomic<int64_t>*  m_counter = nullptr;
+        const Map*             m_map = nullptr;
+        std::shared_ptr<Value> m_pinned;
+
+        ReadGuard(CacheRegistry& registry)
+        : m_registry(&registry) {
+            enter();
+        }
+
+        public:
+
+        ReadGuard(ReadGuard&& other)
+        : m_registry(other.m_registry)
+        , m_counter(other.m_counter)
+        , m_map(other.m_map)
+        , m_pinned(std::move(other.m_pinned)) {
+            other.m_counter = nullptr;
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        ~ReadGuard() {
+            leave();
+        }
+
+        /**
+         * @brief Leaves the critical section, e.g. to wait for a writer.
+         * Pointers obtained through find() must not be used afterwards.
+         */
+        void leave() {
+            if(m_counter) m_counter->fetch_sub(1, std::memory_order_release);
+            m_counter = nullptr;
+        }
+
+        /**
+         * @brief Leaves the critical section, e.g. before a long wait
+         * that must not delay writers, keeping the object associated with
+         * key (if any) alive until the ReadGuard is destroyed, so that the
+         * pointer obtained through find() for this key remains valid. The
+         * object may have been removed from the registry in the meantime.
+         */
+        void pinAndLeave(const Key& key) {
+            if(!m_counter) return;
+            auto it = m_map->find(key);
+            if(it != m_map->end()) m_pinned = it->second;
+            leave();
+        }
+
+        /**
+         * @brief Enters the critical section again after leave(),
+         * reading the current snapshot of the map.
+         */
+        void enter() {
+            if(m_counter) return;
+            unsigned epoch = m_registry->m_epoch.load();
+            // remember the counter: the ULT may resume on another xstream
+            m_counter = &m_registry->m_readers[epoch][stripeIndex()].count;
+            m_counter->fetch_add(1);
+            m_map = m_registry->m_current.load();
+        }
+
+        /**
+         * @brief Looks up a key.
+         *
+         * @return a raw pointer to the object, or nullptr.
+         */
+        Value* find(const Key& key) const {
+            auto it = m_map->find(key);
+            return it == m_map->end() ? nullptr : it->second.get();
+        }
+    };
+
+    CacheRegistry()
+    : m_current(new Map()) {}
+
+    CacheRegistry(const CacheRegistry&) = delete;
+    CacheRegistry& operator=(const CacheRegistry&) = delete;
+
+    ~CacheRegistry() {
+        delete m_current.load();
+    }
+
+    /**
+     * @brief Enters a read-side critical section.
+     */
+    ReadGuard read() {
+        return ReadGuard(*this);
+    }
+
+    /**
+     * @brief Inserts or replaces an object. The call returns once
+     * the new snapshot is visible and the previous one released.
+     */
+    void insert(const Key& key, std::shared_ptr<Value> value) {
+        std::lock_guard<tl::mutex> lock(m_write_mtx);
+        std::unique_ptr<Map> new_map(new Map(*m_current.load()));
+        (*new_map)[key] = std::move(value);
+        publish(new_map.release());
+    }
+
+    /**
+     * @brief Removes an object. The call returns after a grace period,
+     * so the returned pointer (if not null) is no longer visible to
+     * any reader and the caller may safely tear the object down.
+     *
+     * @return the removed object, or nullptr if the key was not found.
+     */
+    std::shared_ptr<Value> erase(const Key& key) {
+        std::lock_guard<tl::mutex> lock(m_write_mtx);
+        auto current = m_current.load();
+        auto it = current->find(key);
+        if(it == current->end()) return nullptr;
+        std::shared_ptr<Value> removed = it->second;
+        std::unique_ptr<Map> new_map(new Map(*current));
+        new_map->erase(key);
+        publish(new_map.release());
+        return removed;
+    }
+
+    /**
+     * @brief Removes all the objects.
+     */
+    void clear() {
+        std::lock_guard<tl::mutex> lock(m_write_mtx);
+        publish(new Map());
+    }
+
+    /**
+     * @brief Returns a reference to an object that keeps it alive after
+     * it is removed, for operations too long to run in a read-side
+     * critical section (which would delay writers), or nullptr.
+     */
+    std::shared_ptr<Value> get(const Key& key) {
+        auto guard = read();
+        auto it = guard.m_map->find(key);
+        return it == guard.m_map->end() ? nullptr : it->second;
+    }
+
+    /**
+     * @brief Returns the objects of the current snapshot. Unlike the
+     * pointers returned by ReadGuard::find(), the returned references
+     * keep the objects alive after they are removed.
+     */
+    std::vector<std::shared_ptr<Value>> values() {
+        auto guard = read();
+        std::vector<std::shared_ptr<Value>> result;
+        result.reserve(guard.m_map->size());
+        for(auto& p : *guard.m_map) result.push_back(p.second);
+        return result;
+    }
+
+    /**
+     * @brief Calls f(key, value) on every object of the current snapshot,
+     * within a read-side critical section.
+     */
+    template<typename F>
+    void for_each(F&& f) {
+        auto guard = read();
+        for(auto& p : *guard.m_map) f(p.first, *p.second);
+    }
+};
+
+template<typename Key, typename Value>
+constexpr unsigned CacheRegistry<Key, Value>::kNumStripes;
+
+}
+
+#endif
@@ -6,14 +6,18 @@
 #include "cachersize/Exception.hpp"
 #include "cachersize/Client.hpp"
 #include "cachersize/CacheHandle.hpp"
+#include "cachersize/DistributedCacheHandle.hpp"
 #include "cachersize/RequestResult.hpp"
 
 #include "ClientImpl.hpp"
 #include "CacheHandleImpl.hpp"
+#include "DistributedCacheHandleImpl.hpp"
 
 #include <thallium/serialization/stl/string.hpp>
+#include <nlohmann/json.hpp>
 
 namespace tl = thallium;
+using json = nlohmann::json;
 
 namespace cachersize {
 
@@ -51,16 +55,49 @@ CacheHandle Client::makeCacheHandle(
         const std::string& address,
         uint16_t provider_id,
         const UUID& cache_id,
-        bool check) const {
-    auto endpoint  = self->m_engine.lookup(address);
-    auto ph        = tl::provider_handle(endpoint, provider_id);
+        bool check,
+        const std::string& options) const {
+    std::shared_ptr<NearCache> near_cache;
+    bool compressed_transfer = false;
+    try {
+        auto json_options = json::parse(options.empty() ? "{}" : options);
+        if(json_options.contains("compressed_transfer")) {
+            if(!json_options["compressed_transfer"].is_boolean())
+                throw Exception("\"compressed_transfer\" option should be a boolean");
+            compressed_transfer = json_options["compressed_transfer"].get<bool>();
+        }
+        if(json_options.contains("near_cache")) {
+            auto& config = json_options["near_cache"];
+            if(!config.is_object())
+                throw Exception("\"near_cache\" option should be an object");
+            auto max_entries = config.value("max_entries", (size_t)1024);
+            auto max_bytes   = config.value("max_bytes", (size_t)(16*1024*1024));
+            near_cache = NearCache::create(max_entries, max_bytes);
+        }
+    } catch(const json::exception& ex) {
+        throw Exception(std::string("Invalid cache handle options: ") + ex.what());
+    }
+    auto endpoint  = self->m_endpoints->lookup(self->m_engine, address);
+    auto cache_impl = std::make_shared<CacheHandleImpl>(
+        self, tl::provider_handle(endpoint, provider_id), cache_id,
+        std::move(near_cache), compressed_transfer);
     RequestResult<bool> result;
     result.success() = true;
     if(check) {
-        result = self->m_check_cache.on(ph)(cache_id);
+        auto ph = cache_impl->location();
+        try {
+            result = self->m_check_cache.on(*ph)(cache_id);
+        } catch(const std::exception&) {
+            self->m_endpoints->invalidate(address);
+            throw;
+        }
+        // the handle of a cache that migrated points to its new location
+        cache_impl->followMoves(ph, result,
+            [this, &cache_id](const tl::provider_handle& ph) -> RequestResult<bool> {
+                return self->m_check_cache.on(ph)(cache_id);
+            });
     }
     if(result.success()) {
-        auto cache_impl = std::make_shared<CacheHandleImpl>(self, std::move(ph), cache_id);
         return CacheHandle(cache_impl);
     } else {
         throw Exception(result.error());
@@ -68,6 +105,39 @@ CacheHandle Client::makeCacheHandle(
     }
 }
 
+DistributedCacheHandle Client::makeDistributedCacheHandle(
+        const std::vector<CacheMember>& members,
+        bool check,
+        const std::string& options) const {
+    if(members.empty())
+        throw Exception("A distributed cache needs at least one member");
+    size_t num_vnodes = 128;
+    try {
+        auto json_options = json::parse(options.empty() ? "{}" : options);
+        if(json_options.contains("virtual_nodes")) {
+            if(!json_options["virtual_nodes"].is_number_unsigned()
+            || json_options["virtual_nodes"].get<size_t>() == 0)
+                throw Exception("\"virtual_nodes\" option should be a strictly positive integer");
+            num_vnodes = json_options["virtual_nodes"].get<size_t>();
+        }
+    } catch(const json::exception& ex) {
+        throw Exception(std::string("Invalid cache handle options: ") + ex.what());
+    }
+    std::vector<CacheHandle> handles;
+    std::vector<std::string> names;
+    handles.reserve(members.size());
+    names.reserve(members.size());
+    for(auto& member : members) {
+        handles.push_back(makeCacheHandle(
+            member.address, member.provider_id, member.cache_id, check, options));
+        // members are placed on the ring by cache id, so that keys do
+        // not move if a cache is reached through a different address
+        names.push_back(member.cache_id.to_string());
+    }
+    return DistributedCacheHandle(std::make_shared<DistributedCacheHandleImpl>(
+            std::move(handles), names, num_vnodes));
+}
+
 std::string Client::getConfig() const {
     return "{}";
 }
@@ -10,6 +10,11 @@
 #include <thallium/serialization/stl/unordered_set.hpp>
 #include <thallium/serialization/stl/unordered_map.hpp>
 #include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+#include "EndpointCache.hpp"
+#include "Lease.hpp"
+#include "NearCache.hpp"
+#include <mutex>
 
 namespace cachersize {
 
@@ -23,18 +28,79 @@ class ClientImpl {
     tl::remote_procedure m_check_cache;
     tl::remote_procedure m_say_hello;
     tl::remote_procedure m_compute_sum;
+    tl::remote_procedure m_put;
+    tl::remote_procedure m_put_bulk;
+    tl::remote_procedure m_get;
+    tl::remote_procedure m_get_bulk;
+    tl::remote_procedure m_get_leased;
+    tl::remote_procedure m_erase;
+    tl::remote_procedure m_exists;
+    tl::remote_procedure m_put_multi;
+    tl::remote_procedure m_get_multi;
+    tl::remote_procedure m_erase_multi;
+    tl::remote_procedure m_get_stats;
+    // Values larger than this are moved with RDMA instead of
+    // being serialized into the RPC arguments or response.
+    size_t               m_eager_limit = 4096;
+    // Receive space reserved per key by getMulti; values that do
+    // not fit in the batch's receive area are fetched one by one.
+    size_t               m_multi_get_item_size = 1024;
+    // Address at which providers can revoke the leases held by the
+    // near caches of this client (empty if the engine is not listening)
+    std::string          m_self_address;
+    std::shared_ptr<EndpointCache> m_endpoints;
 
     ClientImpl(const tl::engine& engine)
     : m_engine(engine)
     , m_check_cache(m_engine.define("cachersize_check_cache"))
     , m_say_hello(m_engine.define("cachersize_say_hello").disable_response())
     , m_compute_sum(m_engine.define("cachersize_compute_sum"))
-    {}
+    , m_put(m_engine.define("cachersize_put"))
+    , m_put_bulk(m_engine.define("cachersize_put_bulk"))
+    , m_get(m_engine.define("cachersize_get"))
+    , m_get_bulk(m_engine.define("cachersize_get_bulk"))
+    , m_get_leased(m_engine.define("cachersize_get_leased"))
+    , m_erase(m_engine.define("cachersize_erase"))
+    , m_exists(m_engine.define("cachersize_exists"))
+    , m_put_multi(m_engine.define("cachersize_put_multi"))
+    , m_get_multi(m_engine.define("cachersize_get_multi"))
+    , m_erase_multi(m_engine.define("cachersize_erase_multi"))
+    , m_get_stats(m_engine.define("cachersize_get_stats"))
+    , m_endpoints(EndpointCache::of(m_engine))
+    {
+        auto mid = m_engine.get_margo_instance();
+        if(not margo_is_listening(mid)) return;
+        m_self_address = static_cast<std::string>(m_engine.self());
+        // the handler dispatches to near caches by id, so it is
+        // registered once per engine and shared by all the clients
+        static std::mutex registration_mutex;
+        std::lock_guard<std::mutex> lock(registration_mutex);
+        hg_id_t id;
+        hg_bool_t registered = false;
+        margo_provider_registered_name(mid, "cachersize_invalidate",
+            NEAR_CACHE_PROVIDER_ID, &id, &registered);
+        if(not registered)
+            m_engine.define("cachersize_invalidate", &ClientImpl::invalidate,
+                            NEAR_CACHE_PROVIDER_ID);
+    }
 
     ClientImpl(margo_instance_id mid)
     : ClientImpl(tl::engine(mid)) {}
 
     ~ClientImpl() {}
+
+    /**
+     * @brief Handler of the cachersize_invalidate RPC, sent by providers
+     * to revoke the leases held by a near cache. An empty list of keys
+     * revokes all of them.
+     */
+    static void invalidate(const tl::request& req,
+                           uint64_t near_cache_id,
+                           std::vector<std::string>& keys) {
+        auto near_cache = NearCache::find(near_cache_id);
+        if(near_cache) near_cache->invalidate(keys);
+        req.respond();
+    }
 };
 
 }
@@ -0,0 +1,224 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_COMPRESSION_HPP
+#define __CACHERSIZE_COMPRESSION_HPP
+
+#include "config.h"
+#include <cachersize/Exception.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#ifdef CACHERSIZE_HAS_LZ4
+#include <lz4.h>
+#endif
+#ifdef CACHERSIZE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace cachersize {
+
+/**
+ * @brief Compression algorithms. Their value is stored in the first
+ * byte of a frame, so existing values must not be changed.
+ */
+enum class Compression : uint8_t {
+    None = 0,
+    LZ4  = 1,
+    Zstd = 2
+};
+
+/**
+ * Compressed values are stored and sent as frames made of the algorithm
+ * (one byte), the size of the uncompressed value (8 bytes, little endian)
+ * and the compressed bytes. A frame of algorithm None holds the value
+ * as is; the provider uses such frames to send values that it stores
+ * uncompressed to clients that asked for compressed ones.
+ */
+namespace compression {
+
+static constexpr size_t kFrameHeaderSize = 9;
+
+/**
+ * @brief Returns the algorithm with the given name ("none", "lz4", "zstd"),
+ * throwing an Exception if it is unknown or was not enabled at build time.
+ */
+inline Compression fromName(const std::string& name) {
+    if(name == "none") return Compression::None;
+    if(name == "lz4") {
+#ifdef CACHERSIZE_HAS_LZ4
+        return Compression::LZ4;
+#else
+        throw Exception("cachersize was built without LZ4 support (ENABLE_LZ4)");
+#endif
+    }
+    if(name == "zstd") {
+#ifdef CACHERSIZE_HAS_ZSTD
+        return Compression::Zstd;
+#else
+        throw Exception("cachersize was built without Zstd support (ENABLE_ZSTD)");
+#endif
+    }
+    throw Exception("Unknown compression algorithm \"" + name + "\"");
+}
+
+inline const char* name(Compression algorithm) {
+    switch(algorithm) {
+        case Compression::LZ4:  return "lz4";
+        case Compression::Zstd: return "zstd";
+        default:                return "none";
+    }
+}
+
+inline void writeHeader(char* frame, Compression algorithm, uint64_t size) {
+    frame[0] = static_cast<char>(algorithm);
+    for(unsigned i = 0; i < 8; i++)
+        frame[1 + i] = static_cast<char>((size >> (8 * i)) & 0xff);
+}
+
+/**
+ * @brief Size of the uncompressed value held in a frame.
+ */
+inline uint64_t originalSize(const char* frame) {
+    uint64_t size = 0;
+    for(unsigned i = 0; i < 8; i++)
+        size |= static_cast<uint64_t>(static_cast<unsigned char>(frame[1 + i])) << (8 * i);
+    return size;
+}
+
+#ifdef CACHERSIZE_HAS_ZSTD
+/**
+ * @brief Zstd contexts of the calling thread, reused across calls
+ * rather than allocated by each ZSTD_compress/ZSTD_decompress.
+ */
+struct ZstdContexts {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    ~ZstdContexts() {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+    static ZstdContexts& local() {
+        static thread_local ZstdContexts contexts;
+        return contexts;
+    }
+};
+#endif
+
+/**
+ * @brief Compresses size bytes from data into a frame. Returns false,
+ * leaving frame in an unspecified state, if the algorithm is None or
+ * if the frame would not be smaller than the value.
+ *
+ * @param algorithm algorithm
+ * @param level compression level (0 for the algorithm's default)
+ * @param data value
+ * @param size size of the value
+ * @param frame resulting frame
+ */
+inline bool compress(Compression algorithm, int level,
+                     const char* data, size_t size, std::string* frame) {
+    size_t compressed = 0;
+    switch(algorithm) {
+#ifdef CACHERSIZE_HAS_LZ4
+        case Compression::LZ4: {
+            if(size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) return false;
+            frame->resize(kFrameHeaderSize + LZ4_compressBound(static_cast<int>(size)));
+            int r = LZ4_compress_fast(data, &(*frame)[kFrameHeaderSize],
+                    static_cast<int>(size), static_cast<int>(frame->size() - kFrameHeaderSize),
+                    level > 0 ? level : 1);
+            if(r <= 0) return false;
+            compressed = static_cast<size_t>(r);
+            break;
+        }
+#endif
+#ifdef CACHERSIZE_HAS_ZSTD
+        case Compression::Zstd: {
+            frame->resize(kFrameHeaderSize + ZSTD_compressBound(size));
+            size_t r = ZSTD_compressCCtx(ZstdContexts::local().cctx,
+                    &(*frame)[kFrameHeaderSize], frame->size() - kFrameHeaderSize,
+                    data, size, level);
+            if(ZSTD_isError(r)) return false;
+            compressed = r;
+            break;
+        }
+#endif
+        default:
+            (void)level; (void)data;
+            return false;
+    }
+    if(kFrameHeaderSize + compressed >= size) return false;
+    frame->resize(kFrameHeaderSize + compressed);
+    writeHeader(&(*frame)[0], algorithm, size);
+    return true;
+}
+
+/**
+ * @brief Decompresses a frame into value, throwing
+ * an Exception if the frame is invalid.
+ */
+inline void decompress(const char* frame, size_t frame_size, std::string* value) {
+    if(frame_size < kFrameHeaderSize)
+        throw Exception("Invalid compression frame");
+    auto algorithm = static_cast<Compression>(frame[0]);
+    uint64_t size = originalSize(frame);
+    const char* payload = frame + kFrameHeaderSize;
+    size_t payload_size = frame_size - kFrameHeaderSize;
+    if(algorithm == Compression::None) {
+        if(payload_size != size)
+            throw Exception("Invalid compression frame");
+        value->assign(payload, payload_size);
+        return;
+    }
+    switch(algorithm) {
+#ifdef CACHERSIZE_HAS_LZ4
+        case Compression::LZ4: {
+            if(size > static_cast<uint64_t>(LZ4_MAX_INPUT_SIZE))
+                throw Exception("Corrupted LZ4 frame");
+            value->resize(size);
+            int r = LZ4_decompress_safe(payload, &(*value)[0],
+                    static_cast<int>(payload_size), static_cast<int>(size));
+            if(r < 0 || static_cast<uint64_t>(r) != size)
+                throw Exception("Corrupted LZ4 frame");
+            return;
+        }
+#endif
+#ifdef CACHERSIZE_HAS_ZSTD
+        case Compression::Zstd: {
+            if(ZSTD_getFrameContentSize(payload, payload_size) != size)
+                throw Exception("Corrupted Zstd frame");
+            value->resize(size);
+            size_t r = ZSTD_decompressDCtx(ZstdContexts::local().dctx,
+                    &(*value)[0], size, payload, payload_size);
+            if(ZSTD_isError(r) || r != size)
+                throw Exception("Corrupted Zstd frame");
+            return;
+        }
+#endif
+        default:
+            throw Exception("Unsupported compression algorithm in frame ("
+                          + std::to_string(static_cast<unsigned>(algorithm)) + ")");
+    }
+}
+
+inline void decompress(const std::string& frame, std::string* value) {
+    decompress(frame.data(), frame.size(), value);
+}
+
+/**
+ * @brief Appends an uncompressed value to out as a frame of algorithm None.
+ */
+inline void appendRawFrame(const char* data, size_t size, std::string* out) {
+    size_t offset = out->size();
+    out->resize(offset + kFrameHeaderSize + size);
+    writeHeader(&(*out)[offset], Compression::None, size);
+    if(size) std::memcpy(&(*out)[offset + kFrameHeaderSize], data, size);
+}
+
+}
+
+}
+
+#endif
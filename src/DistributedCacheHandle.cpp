@@ -0,0 +1,273 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "cachersize/DistributedCacheHandle.hpp"
+#include "cachersize/Exception.hpp"
+
+#include "AsyncRequestImpl.hpp"
+#include "DistributedCacheHandleImpl.hpp"
+
+#include <exception>
+
+namespace cachersize {
+
+/**
+ * @brief State of a batched operation split across members: the
+ * sub-batch sent to each member and the position of its items in
+ * the caller's batch. It must outlive the call when non-blocking.
+ */
+struct ScatterState {
+    std::vector<std::vector<size_t>>      indices;
+    std::vector<std::vector<std::string>> keys;
+    std::vector<std::vector<std::string>> values;
+    std::vector<std::vector<Status>>      statuses;
+};
+
+static std::shared_ptr<ScatterState> scatter(const DistributedCacheHandleImpl& impl,
+                                             const std::vector<std::string>& keys) {
+    auto state = std::make_shared<ScatterState>();
+    size_t num_members = impl.m_members.size();
+    state->indices.resize(num_members);
+    state->keys.resize(num_members);
+    state->values.resize(num_members);
+    state->statuses.resize(num_members);
+    for(size_t i = 0; i < keys.size(); i++) {
+        auto m = impl.m_ring.memberOf(keys[i]);
+        state->indices[m].push_back(i);
+        state->keys[m].push_back(keys[i]);
+    }
+    return state;
+}
+
+/**
+ * @brief Creates a request that waits for all the per-member requests
+ * of a batch, then calls gather. If a member's request fails, the
+ * others are still waited on before the first error is rethrown.
+ */
+static std::shared_ptr<AsyncRequestImpl> makeGatherRequest(
+        std::vector<AsyncRequest>&& children,
+        std::function<void()>&& gather) {
+    auto async_request_impl = AsyncRequestImpl::make();
+    async_request_impl->m_children = std::move(children);
+    async_request_impl->m_wait_callback =
+        [gather=std::move(gather)](AsyncRequestImpl& async_request_impl) {
+            std::exception_ptr error;
+            for(auto& child : async_request_impl.m_children) {
+                try {
+                    child.wait();
+                } catch(...) {
+                    if(not error) error = std::current_exception();
+                }
+            }
+            if(error) std::rethrow_exception(error);
+            gather();
+        };
+    return async_request_impl;
+}
+
+/**
+ * @brief Places the per-member statuses of a batch back in the order
+ * of the caller's keys, throwing if the caller did not ask for them
+ * and an item failed.
+ */
+static void gatherStatuses(const ScatterState& state,
+                           size_t count,
+                           std::vector<Status>* statuses,
+                           const char* error) {
+    std::vector<Status> local_statuses;
+    if(not statuses) statuses = &local_statuses;
+    statuses->assign(count, Status::OK);
+    for(size_t m = 0; m < state.indices.size(); m++)
+        for(size_t j = 0; j < state.indices[m].size(); j++)
+            (*statuses)[state.indices[m][j]] = state.statuses[m][j];
+    if(statuses == &local_statuses) {
+        for(auto s : local_statuses)
+            if(s != Status::OK) throw Exception(error);
+    }
+}
+
+DistributedCacheHandle::DistributedCacheHandle() = default;
+
+DistributedCacheHandle::DistributedCacheHandle(const std::shared_ptr<DistributedCacheHandleImpl>& impl)
+: self(impl) {}
+
+DistributedCacheHandle::DistributedCacheHandle(const DistributedCacheHandle&) = default;
+
+DistributedCacheHandle::DistributedCacheHandle(DistributedCacheHandle&&) = default;
+
+DistributedCacheHandle& DistributedCacheHandle::operator=(const DistributedCacheHandle&) = default;
+
+DistributedCacheHandle& DistributedCacheHandle::operator=(DistributedCacheHandle&&) = default;
+
+DistributedCacheHandle::~DistributedCacheHandle() = default;
+
+DistributedCacheHandle::operator bool() const {
+    return static_cast<bool>(self);
+}
+
+size_t DistributedCacheHandle::numMembers() const {
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    return self->m_members.size();
+}
+
+const CacheHandle& DistributedCacheHandle::member(size_t index) const {
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    if(index >= self->m_members.size())
+        throw Exception("Invalid member index");
+    return self->m_members[index];
+}
+
+size_t DistributedCacheHandle::memberOf(const std::string& key) const {
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    return self->m_ring.memberOf(key);
+}
+
+void DistributedCacheHandle::put(
+        const std::string& key,
+        const std::string& value,
+        AsyncRequest* req) const
+{
+    put(key, value, PutOptions(), req);
+}
+
+void DistributedCacheHandle::put(
+        const std::string& key,
+        const std::string& value,
+        const PutOptions& options,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    self->owner(key).put(key, value, options, req);
+}
+
+void DistributedCacheHandle::get(
+        const std::string& key,
+        std::string* value,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    self->owner(key).get(key, value, req);
+}
+
+void DistributedCacheHandle::erase(
+        const std::string& key,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    self->owner(key).erase(key, req);
+}
+
+void DistributedCacheHandle::exists(
+        const std::string& key,
+        bool* result,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    self->owner(key).exists(key, result, req);
+}
+
+void DistributedCacheHandle::putMulti(
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& values,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    putMulti(keys, values, PutOptions(), statuses, req);
+}
+
+void DistributedCacheHandle::putMulti(
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& values,
+        const PutOptions& options,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    if(keys.size() != values.size())
+        throw Exception("putMulti requires as many values as keys");
+    auto state = scatter(*self, keys);
+    for(size_t m = 0; m < state->indices.size(); m++)
+        for(auto i : state->indices[m])
+            state->values[m].push_back(values[i]);
+    std::vector<AsyncRequest> children;
+    for(size_t m = 0; m < state->indices.size(); m++) {
+        if(state->keys[m].empty()) continue;
+        children.emplace_back();
+        self->m_members[m].putMulti(state->keys[m], state->values[m], options,
+                                    &state->statuses[m], &children.back());
+    }
+    AsyncRequest request(makeGatherRequest(std::move(children),
+        [state, count=keys.size(), statuses]() {
+            gatherStatuses(*state, count, statuses, "Failed to store some of the values");
+        }));
+    if(req) *req = std::move(request);
+    else request.wait();
+}
+
+void DistributedCacheHandle::getMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* values,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    auto state = scatter(*self, keys);
+    std::vector<AsyncRequest> children;
+    for(size_t m = 0; m < state->indices.size(); m++) {
+        if(state->keys[m].empty()) continue;
+        children.emplace_back();
+        self->m_members[m].getMulti(state->keys[m], &state->values[m],
+                                    &state->statuses[m], &children.back());
+    }
+    AsyncRequest request(makeGatherRequest(std::move(children),
+        [state, count=keys.size(), values, statuses]() {
+            if(values) {
+                values->resize(count);
+                for(size_t m = 0; m < state->indices.size(); m++)
+                    for(size_t j = 0; j < state->indices[m].size(); j++)
+                        (*values)[state->indices[m][j]] = std::move(state->values[m][j]);
+            }
+            gatherStatuses(*state, count, statuses, "Key not found");
+        }));
+    if(req) *req = std::move(request);
+    else request.wait();
+}
+
+void DistributedCacheHandle::eraseMulti(
+        const std::vector<std::string>& keys,
+        std::vector<Status>* statuses,
+        AsyncRequest* req) const
+{
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    auto state = scatter(*self, keys);
+    std::vector<AsyncRequest> children;
+    for(size_t m = 0; m < state->indices.size(); m++) {
+        if(state->keys[m].empty()) continue;
+        children.emplace_back();
+        self->m_members[m].eraseMulti(state->keys[m], &state->statuses[m], &children.back());
+    }
+    AsyncRequest request(makeGatherRequest(std::move(children),
+        [state, count=keys.size(), statuses]() {
+            gatherStatuses(*state, count, statuses, "Failed to erase some of the keys");
+        }));
+    if(req) *req = std::move(request);
+    else request.wait();
+}
+
+NearCacheStats DistributedCacheHandle::nearCacheStats() const {
+    if(not self) throw Exception("Invalid cachersize::DistributedCacheHandle object");
+    NearCacheStats total;
+    for(auto& member : self->m_members) {
+        auto stats = member.nearCacheStats();
+        total.hits          += stats.hits;
+        total.misses        += stats.misses;
+        total.expirations   += stats.expirations;
+        total.invalidations += stats.invalidations;
+        total.evictions     += stats.evictions;
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,34 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_DISTRIBUTED_CACHE_HANDLE_IMPL_H
+#define __CACHERSIZE_DISTRIBUTED_CACHE_HANDLE_IMPL_H
+
+#include <cachersize/CacheHandle.hpp>
+#include "HashRing.hpp"
+
+namespace cachersize {
+
+class DistributedCacheHandleImpl {
+
+    public:
+
+    std::vector<CacheHandle> m_members;
+    HashRing                 m_ring;
+
+    DistributedCacheHandleImpl(std::vector<CacheHandle>&& members,
+                               const std::vector<std::string>& member_names,
+                               size_t num_vnodes)
+    : m_members(std::move(members))
+    , m_ring(member_names, num_vnodes) {}
+
+    const CacheHandle& owner(const std::string& key) const {
+        return m_members[m_ring.memberOf(key)];
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_ENDPOINT_CACHE_H
+#define __CACHERSIZE_ENDPOINT_CACHE_H
+
+#include <thallium.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace cachersize {
+
+namespace tl = thallium;
+
+/**
+ * @brief The EndpointCache keeps the endpoints resolved from address
+ * strings, so that creating handles or issuing admin operations does
+ * not resolve the same address again. One cache is shared by all the
+ * Client, Admin, and Provider objects using the same margo instance,
+ * and is cleared when the engine is finalized (endpoints must not
+ * outlive it).
+ *
+ * Callers should invalidate an address when an RPC sent to it fails,
+ * in case the process behind it has been restarted.
+ */
+class EndpointCache {
+
+    public:
+
+    /**
+     * @brief Returns the cache associated with the engine's margo
+     * instance, creating it if needed.
+     */
+    static std::shared_ptr<EndpointCache> of(const tl::engine& engine) {
+        auto mid = engine.get_margo_instance();
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.caches.find(mid);
+        if(it != r.caches.end()) return it->second;
+        auto cache = std::shared_ptr<EndpointCache>(new EndpointCache());
+        r.caches.emplace(mid, cache);
+        // tl::engine::push_finalize_callback is not const
+        tl::engine e = engine;
+        e.push_finalize_callback(cache.get(), [mid]() {
+            std::shared_ptr<EndpointCache> cache;
+            {
+                auto& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                auto it = r.caches.find(mid);
+                if(it == r.caches.end()) return;
+                cache = std::move(it->second);
+                r.caches.erase(it);
+            }
+            cache->clear();
+        });
+        return cache;
+    }
+
+    /**
+     * @brief Returns the endpoint for an address, resolving it with
+     * the engine only if it is not already cached. Resolution happens
+     * outside of the lock, so concurrent misses on the same address may
+     * both resolve it; the first endpoint inserted is kept.
+     */
+    tl::endpoint lookup(const tl::engine& engine, const std::string& address) {
+        {
+            std::lock_guard<tl::mutex> lock(m_mutex);
+            auto it = m_endpoints.find(address);
+            if(it != m_endpoints.end()) return it->second;
+        }
+        auto endpoint = engine.lookup(address);
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        return m_endpoints.emplace(address, std::move(endpoint)).first->second;
+    }
+
+    /**
+     * @brief Forgets the endpoint of an address.
+     */
+    void invalidate(const std::string& address) {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        m_endpoints.erase(address);
+    }
+
+    /**
+     * @brief Whether the endpoint of an address is cached.
+     */
+    bool contains(const std::string& address) const {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        return m_endpoints.count(address) != 0;
+    }
+
+    void clear() {
+        std::lock_guard<tl::mutex> lock(m_mutex);
+        m_endpoints.clear();
+    }
+
+    private:
+
+    EndpointCache() = default;
+
+    // The registry does not hold engines, which would keep them from
+    // being finalized when the application releases them.
+    struct Registry {
+        std::mutex                                                            mutex;
+        std::unordered_map<margo_instance_id, std::shared_ptr<EndpointCache>> caches;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    mutable tl::mutex                             m_mutex;
+    std::unordered_map<std::string, tl::endpoint> m_endpoints;
+};
+
+}
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "cachersize/EvictionPolicy.hpp"
+
+namespace cachersize {
+
+using json = nlohmann::json;
+
+std::unordered_map<std::string,
+                std::function<std::unique_ptr<EvictionPolicy>(const json&, size_t)>> EvictionPolicyFactory::create_fn;
+
+std::unique_ptr<EvictionPolicy> EvictionPolicyFactory::createPolicy(const std::string& policy_name,
+                                                                    const json& config,
+                                                                    size_t capacity) {
+    auto it = create_fn.find(policy_name);
+    if(it == create_fn.end()) return nullptr;
+    auto& f = it->second;
+    return f(config, capacity);
+}
+
+}
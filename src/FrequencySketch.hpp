@@ -0,0 +1,135 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_FREQUENCY_SKETCH_HPP
+#define __CACHERSIZE_FREQUENCY_SKETCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace cachersize {
+
+/**
+ * @brief Count-min sketch estimating the access frequency of keys, used
+ * as the TinyLFU admission filter (Einziger, Friedman and Manes) of a
+ * cache: a new key is only admitted if its estimated frequency is higher
+ * than that of the entry it would evict.
+ *
+ * Counters are 4 bits wide, packed by 16 in 64-bit words, and each key is
+ * counted in kDepth counters of the same table, so that 65536 counters
+ * take 32 KiB. Counters saturate at 15. Every sample_size increments, all
+ * the counters are halved, so that the sketch ages out the keys that were
+ * popular a long time ago.
+ *
+ * The sketch is thread-safe without locks: counters are updated with
+ * compare-and-swap on their word. Halving is not atomic with respect to
+ * concurrent increments, which may be lost or halved twice; the sketch
+ * only needs to be approximately right.
+ */
+class FrequencySketch {
+
+    public:
+
+    static constexpr unsigned kDepth = 4;
+    static constexpr unsigned kMaxCount = 15;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param counters number of counters (rounded up to a power of 2, at least 16).
+     * @param sample_size number of increments between agings (0 for 10 x counters).
+     */
+    FrequencySketch(size_t counters, size_t sample_size) {
+        size_t words = 1;
+        while(words * 16 < counters) words *= 2;
+        m_mask = words - 1;
+        m_table.reset(new std::atomic<uint64_t>[words]);
+        for(size_t i = 0; i < words; i++)
+            m_table[i].store(0, std::memory_order_relaxed);
+        m_sample_size = sample_size ? sample_size : 10 * words * 16;
+    }
+
+    FrequencySketch(const FrequencySketch&) = delete;
+    FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+    /**
+     * @brief Records an access to the key with the given hash.
+     */
+    void increment(uint64_t hash) {
+        bool added = false;
+        for(unsigned i = 0; i < kDepth; i++) {
+            uint64_t h = rehash(hash, i);
+            auto& word = m_table[h & m_mask];
+            unsigned shift = nibbleOf(h) * 4;
+            uint64_t w = word.load(std::memory_order_relaxed);
+            while(((w >> shift) & 0xf) != kMaxCount) {
+                if(word.compare_exchange_weak(w, w + (uint64_t(1) << shift),
+                                              std::memory_order_relaxed)) {
+                    added = true;
+                    break;
+                }
+            }
+        }
+        if(added && m_additions.fetch_add(1, std::memory_order_relaxed) + 1 == m_sample_size)
+            age();
+    }
+
+    /**
+     * @brief Returns the estimated number of accesses to the key
+     * with the given hash since it was last aged out.
+     */
+    unsigned estimate(uint64_t hash) const {
+        unsigned count = kMaxCount;
+        for(unsigned i = 0; i < kDepth; i++) {
+            uint64_t h = rehash(hash, i);
+            uint64_t w = m_table[h & m_mask].load(std::memory_order_relaxed);
+            unsigned c = static_cast<unsigned>((w >> (nibbleOf(h) * 4)) & 0xf);
+            if(c < count) count = c;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Size of the table in bytes.
+     */
+    size_t memoryUsage() const {
+        return (m_mask + 1) * sizeof(uint64_t);
+    }
+
+    private:
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_table;
+    size_t                                   m_mask = 0;
+    size_t                                   m_sample_size = 0;
+    std::atomic<size_t>                      m_additions = { 0 };
+
+    static uint64_t rehash(uint64_t hash, unsigned i) {
+        // one round of a 64-bit mixer per row, with distinct seeds
+        static constexpr uint64_t seeds[kDepth] = {
+            0xc3a5c85c97cb3127ull, 0xb492b66fbe98f273ull,
+            0x9ae16a3b2f90404full, 0xcbf29ce484222325ull
+        };
+        uint64_t h = (hash + seeds[i]) * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 29);
+    }
+
+    static unsigned nibbleOf(uint64_t h) {
+        return static_cast<unsigned>(h >> 60);
+    }
+
+    void age() {
+        for(size_t i = 0; i <= m_mask; i++) {
+            uint64_t w = m_table[i].load(std::memory_order_relaxed);
+            while(!m_table[i].compare_exchange_weak(w, (w >> 1) & 0x7777777777777777ull,
+                                                    std::memory_order_relaxed)) {}
+        }
+        m_additions.store(m_sample_size / 2, std::memory_order_relaxed);
+    }
+};
+
+}
+
+#endif
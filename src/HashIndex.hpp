@@ -0,0 +1,413 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_HASH_INDEX_HPP
+#define __CACHERSIZE_HASH_INDEX_HPP
+
+#include <string>
+#include <memory>
+#include <utility>
+#include <tuple>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cachersize {
+
+/**
+ * @brief Open-addressing hash table mapping std::string keys to values
+ * of type V, following the "Swiss table" design.
+ *
+ * Entries are stored in a flat array of slots, alongside an array of
+ * one-byte control words. Each control byte is either kEmpty, kDeleted,
+ * or the low 7 bits of the hash of the key stored in the slot (H2).
+ * The high bits of the hash (H1) select a group of 16 slots to probe
+ * first; the 16 control bytes of a group are compared against H2 in
+ * a single SSE2 instruction, so that at most a handful of keys need to
+ * be compared for each lookup. Groups are probed in quadratic order
+ * until a group containing an empty slot is found.
+ *
+ * Slots are allocated in bulk, so no per-entry heap allocation or
+ * pointer chase happens, and keys up to the std::string small-buffer
+ * size (15 bytes with libstdc++) are stored inline in the slot.
+ *
+ * This class is not thread-safe; callers are expected to protect it
+ * (e.g. by sharding and per-shard locking).
+ *
+ * @tparam V Type of values.
+ */
+template<typename V>
+class HashIndex {
+
+    public:
+
+    using key_type    = std::string;
+    using mapped_type = V;
+    using value_type  = std::pair<std::string, V>;
+
+    static constexpr size_t kGroupSize = 16;
+
+    HashIndex() = default;
+
+    /**
+     * @brief Constructor reserving space for a number of entries.
+     */
+    explicit HashIndex(size_t expected_entries) {
+        reserve(expected_entries);
+    }
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    HashIndex(HashIndex&& other) noexcept {
+        swap(other);
+    }
+
+    HashIndex& operator=(HashIndex&& other) noexcept {
+        if(this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~HashIndex() {
+        destroyAll();
+    }
+
+    /**
+     * @brief Number of entries in the index.
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @brief Whether the index is empty.
+     */
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    /**
+     * @brief Number of slots currently allocated.
+     */
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    /**
+     * @brief Ensures that expected_entries entries can be stored
+     * without triggering a rehash.
+     */
+    void reserve(size_t expected_entries) {
+        size_t needed = kGroupSize;
+        while(needed - needed/8 < expected_entries) needed *= 2;
+        if(needed > m_capacity) rehash(needed);
+    }
+
+    /**
+     * @brief Looks up a key.
+     *
+     * @return a pointer to the value, or nullptr if the key is not found.
+     */
+    V* find(const std::string& key) {
+        size_t i = findIndex(key, hashOf(key));
+        return i == npos ? nullptr : &slot(i).second;
+    }
+
+    /**
+     * @brief Looks up a key.
+     *
+     * @return a pointer to the value, or nullptr if the key is not found.
+     */
+    const V* find(const std::string& key) const {
+        size_t i = findIndex(key, hashOf(key));
+        return i == npos ? nullptr : &slot(i).second;
+    }
+
+    /**
+     * @brief Returns 1 if the key exists, 0 otherwise.
+     */
+    size_t count(const std::string& key) const {
+        return find(key) ? 1 : 0;
+    }
+
+    /**
+     * @brief Inserts a key with a value built from the provided
+     * arguments, if the key does not already exist.
+     *
+     * @return a pair containing a pointer to the value associated
+     * with the key and a boolean indicating whether an insertion
+     * took place.
+     */
+    template<typename ... Args>
+    std::pair<V*, bool> emplace(const std::string& key, Args&&... args) {
+        uint64_t h = hashOf(key);
+        size_t i = findIndex(key, h);
+        if(i != npos) return { &slot(i).second, false };
+        if(m_capacity == 0)
+            rehash(kGroupSize);
+        else if(m_size + m_deleted + 1 > maxLoad())
+            // grow if mostly full of live entries, otherwise just purge tombstones
+            rehash(m_size + 1 > maxLoad()/2 ? m_capacity*2 : m_capacity);
+        i = findInsertIndex(h);
+        if(m_ctrl[i] == kDeleted) m_deleted -= 1;
+        new(&m_slots[i]) value_type(std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        m_ctrl[i] = h2(h);
+        m_size += 1;
+        return { &slot(i).second, true };
+    }
+
+    /**
+     * @brief Inserts a key/value pair, or replaces the value
+     * if the key already exists.
+     *
+     * @return a pair containing a pointer to the value and
+     * a boolean indicating whether an insertion took place.
+     */
+    template<typename T>
+    std::pair<V*, bool> insert_or_assign(const std::string& key, T&& value) {
+        auto p = emplace(key, std::forward<T>(value));
+        if(!p.second) *p.first = std::forward<T>(value);
+        return p;
+    }
+
+    /**
+     * @brief Returns a reference to the value associated with the key,
+     * default-constructing it if the key does not exist.
+     */
+    V& operator[](const std::string& key) {
+        return *emplace(key).first;
+    }
+
+    /**
+     * @brief Erases a key.
+     *
+     * @return true if the key was found and erased.
+     */
+    bool erase(const std::string& key) {
+        size_t i = findIndex(key, hashOf(key));
+        if(i == npos) return false;
+        eraseIndex(i);
+        return true;
+    }
+
+    /**
+     * @brief Erases a key, moving its value into the provided
+     * pointer if the key was found.
+     *
+     * @return true if the key was found and erased.
+     */
+    bool extract(const std::string& key, V* value) {
+        size_t i = findIndex(key, hashOf(key));
+        if(i == npos) return false;
+        if(value) *value = std::move(slot(i).second);
+        eraseIndex(i);
+        return true;
+    }
+
+    /**
+     * @brief Removes all entries, keeping the allocated slots.
+     */
+    void clear() {
+        destroyAll();
+        if(m_ctrl) std::memset(m_ctrl.get(), kEmpty, m_capacity);
+        m_size = 0;
+        m_deleted = 0;
+    }
+
+    /**
+     * @brief Calls f(key, value) on every entry, in unspecified order.
+     * f must not insert into or erase from the index.
+     */
+    template<typename F>
+    void for_each(F&& f) {
+        for(size_t i = 0; i < m_capacity; i++)
+            if(isFull(m_ctrl[i])) f(static_cast<const std::string&>(slot(i).first), slot(i).second);
+    }
+
+    /**
+     * @brief Calls f(key, value) on every entry, in unspecified order.
+     */
+    template<typename F>
+    void for_each(F&& f) const {
+        for(size_t i = 0; i < m_capacity; i++)
+            if(isFull(m_ctrl[i])) f(slot(i).first, slot(i).second);
+    }
+
+    /**
+     * @brief Approximate number of bytes used by the index itself
+     * (control bytes and slots, excluding out-of-line key/value data).
+     */
+    size_t memoryUsage() const {
+        return m_capacity * (1 + sizeof(Slot));
+    }
+
+    void swap(HashIndex& other) noexcept {
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_deleted, other.m_deleted);
+    }
+
+    private:
+
+    using Slot = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+    static constexpr int8_t kEmpty   = -128; // 0b10000000
+    static constexpr int8_t kDeleted = -2;   // 0b11111110
+    static constexpr size_t npos     = static_cast<size_t>(-1);
+
+    std::unique_ptr<int8_t[]> m_ctrl;
+    std::unique_ptr<Slot[]>   m_slots;
+    size_t                    m_capacity = 0; // always 0 or a power of 2 >= kGroupSize
+    size_t                    m_size     = 0;
+    size_t                    m_deleted  = 0;
+
+    static bool isFull(int8_t c) { return c >= 0; }
+
+    static uint64_t hashOf(const std::string& key) {
+        // std::hash may be weak in its low bits on some implementations,
+        // so we mix it before splitting it into H1 and H2.
+        uint64_t h = std::hash<std::string>()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static int8_t h2(uint64_t h) { return static_cast<int8_t>(h & 0x7F); }
+
+    size_t maxLoad() const { return m_capacity - m_capacity/8; }
+
+    value_type& slot(size_t i) {
+        return *reinterpret_cast<value_type*>(&m_slots[i]);
+    }
+
+    const value_type& slot(size_t i) const {
+        return *reinterpret_cast<const value_type*>(&m_slots[i]);
+    }
+
+    /**
+     * @brief Returns a bitmask with bit j set if the j-th control
+     * byte of the group starting at g equals c.
+     */
+    uint32_t matchByte(size_t g, int8_t c) const {
+#if defined(__SSE2__)
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_ctrl.get() + g));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c))));
+#else
+        uint32_t mask = 0;
+        for(size_t j = 0; j < kGroupSize; j++)
+            if(m_ctrl[g+j] == c) mask |= (1u << j);
+        return mask;
+#endif
+    }
+
+    /**
+     * @brief Returns a bitmask of the empty or deleted slots
+     * of the group starting at g.
+     */
+    uint32_t matchEmptyOrDeleted(size_t g) const {
+#if defined(__SSE2__)
+        // both kEmpty and kDeleted have their sign bit set
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_ctrl.get() + g));
+        return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+        uint32_t mask = 0;
+        for(size_t j = 0; j < kGroupSize; j++)
+            if(!isFull(m_ctrl[g+j])) mask |= (1u << j);
+        return mask;
+#endif
+    }
+
+    size_t firstGroup(uint64_t h) const {
+        return ((h >> 7) * kGroupSize) & (m_capacity - 1);
+    }
+
+    size_t findIndex(const std::string& key, uint64_t h) const {
+        if(m_size == 0) return npos;
+        size_t g = firstGroup(h);
+        int8_t tag = h2(h);
+        for(size_t step = 1; ; step++) {
+            uint32_t mask = matchByte(g, tag);
+            while(mask) {
+                size_t j = __builtin_ctz(mask);
+                size_t i = g + j;
+                if(slot(i).first == key) return i;
+                mask &= mask - 1;
+            }
+            if(matchByte(g, kEmpty)) return npos;
+            g = (g + step * kGroupSize) & (m_capacity - 1);
+        }
+    }
+
+    size_t findInsertIndex(uint64_t h) const {
+        size_t g = firstGroup(h);
+        for(size_t step = 1; ; step++) {
+            uint32_t mask = matchEmptyOrDeleted(g);
+            if(mask) return g + __builtin_ctz(mask);
+            g = (g + step * kGroupSize) & (m_capacity - 1);
+        }
+    }
+
+    void eraseIndex(size_t i) {
+        slot(i).~value_type();
+        // if the group still has an empty slot, no probe sequence can
+        // have continued past it, so the slot can be marked empty
+        size_t g = i & ~(kGroupSize - 1);
+        if(matchByte(g, kEmpty)) {
+            m_ctrl[i] = kEmpty;
+        } else {
+            m_ctrl[i] = kDeleted;
+            m_deleted += 1;
+        }
+        m_size -= 1;
+    }
+
+    void destroyAll() {
+        if(!std::is_trivially_destructible<value_type>::value) {
+            for(size_t i = 0; i < m_capacity; i++)
+                if(isFull(m_ctrl[i])) slot(i).~value_type();
+        }
+    }
+
+    void rehash(size_t new_capacity) {
+        std::unique_ptr<int8_t[]> old_ctrl  = std::move(m_ctrl);
+        std::unique_ptr<Slot[]>   old_slots = std::move(m_slots);
+        size_t old_capacity = m_capacity;
+        m_ctrl.reset(new int8_t[new_capacity]);
+        m_slots.reset(new Slot[new_capacity]);
+        std::memset(m_ctrl.get(), kEmpty, new_capacity);
+        m_capacity = new_capacity;
+        m_deleted  = 0;
+        for(size_t i = 0; i < old_capacity; i++) {
+            if(!isFull(old_ctrl[i])) continue;
+            auto& entry = *reinterpret_cast<value_type*>(&old_slots[i]);
+            uint64_t h = hashOf(entry.first);
+            size_t j = findInsertIndex(h);
+            new(&m_slots[j]) value_type(std::move(entry.first), std::move(entry.second));
+            m_ctrl[j] = h2(h);
+            entry.~value_type();
+        }
+    }
+};
+
+template<typename V> constexpr size_t HashIndex<V>::kGroupSize;
+template<typename V> constexpr int8_t HashIndex<V>::kEmpty;
+template<typename V> constexpr int8_t HashIndex<V>::kDeleted;
+template<typename V> constexpr size_t HashIndex<V>::npos;
+
+}
+
+#endif
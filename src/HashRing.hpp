@@ -0,0 +1,84 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_HASH_RING_H
+#define __CACHERSIZE_HASH_RING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cachersize {
+
+/**
+ * @brief Consistent hashing ring with virtual nodes. Each member is
+ * placed at num_vnodes pseudo-random points of a 64-bit ring derived
+ * from its name, and a key belongs to the member owning the first
+ * point at or after the key's hash. Adding or removing a member only
+ * moves the keys of the arcs it gains or loses.
+ *
+ * The hash function is fixed (FNV-1a followed by a 64-bit finalizer)
+ * rather than std::hash, so that all processes agree on the placement.
+ */
+class HashRing {
+
+    public:
+
+    HashRing() = default;
+
+    HashRing(const std::vector<std::string>& member_names, size_t num_vnodes) {
+        m_points.reserve(member_names.size() * num_vnodes);
+        for(size_t m = 0; m < member_names.size(); m++) {
+            uint64_t h = hash(member_names[m]);
+            for(size_t v = 0; v < num_vnodes; v++) {
+                m_points.emplace_back(mix(h + v * 0x9e3779b97f4a7c15ULL), m);
+            }
+        }
+        std::sort(m_points.begin(), m_points.end());
+    }
+
+    bool empty() const {
+        return m_points.empty();
+    }
+
+    /**
+     * @brief Returns the index of the member a key belongs to.
+     */
+    size_t memberOf(const std::string& key) const {
+        uint64_t h = hash(key);
+        auto it = std::lower_bound(m_points.begin(), m_points.end(),
+                                   std::make_pair(h, size_t(0)));
+        if(it == m_points.end()) it = m_points.begin();
+        return it->second;
+    }
+
+    static uint64_t hash(const std::string& data) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for(unsigned char c : data) {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        return mix(h);
+    }
+
+    private:
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    std::vector<std::pair<uint64_t, size_t>> m_points;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_INLINE_FUNCTION_H
+#define __CACHERSIZE_INLINE_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cachersize {
+
+template<typename Signature, size_t Capacity>
+class InlineFunction;
+
+/**
+ * @brief Type-erased callable like std::function, but storing callables
+ * of up to Capacity bytes inside the object instead of allocating them.
+ * Larger callables are still supported and allocated on the heap.
+ * InlineFunction objects are neither copyable nor movable.
+ */
+template<typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+
+    public:
+
+    InlineFunction() = default;
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction() {
+        reset();
+    }
+
+    template<typename F,
+             typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+    InlineFunction& operator=(F&& f) {
+        reset();
+        using Fn = typename std::decay<F>::type;
+        assign<Fn>(std::forward<F>(f), std::integral_constant<bool,
+            sizeof(Fn) <= Capacity && alignof(Fn) <= alignof(std::max_align_t)>());
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    explicit operator bool() const {
+        return m_invoke != nullptr;
+    }
+
+    R operator()(Args... args) {
+        return m_invoke(&m_storage, std::forward<Args>(args)...);
+    }
+
+    void reset() {
+        if(m_destroy) m_destroy(&m_storage);
+        m_invoke  = nullptr;
+        m_destroy = nullptr;
+    }
+
+    private:
+
+    template<typename Fn, typename F>
+    void assign(F&& f, std::true_type /* fits inline */) {
+        new (&m_storage) Fn(std::forward<F>(f));
+        m_invoke = [](void* s, Args... args) -> R {
+            return (*static_cast<Fn*>(s))(std::forward<Args>(args)...);
+        };
+        m_destroy = [](void* s) {
+            static_cast<Fn*>(s)->~Fn();
+        };
+    }
+
+    template<typename Fn, typename F>
+    void assign(F&& f, std::false_type /* fits inline */) {
+        new (&m_storage) Fn*(new Fn(std::forward<F>(f)));
+        m_invoke = [](void* s, Args... args) -> R {
+            return (**static_cast<Fn**>(s))(std::forward<Args>(args)...);
+        };
+        m_destroy = [](void* s) {
+            delete *static_cast<Fn**>(s);
+        };
+    }
+
+    using Storage = typename std::aligned_storage<
+        (Capacity < sizeof(void*) ? sizeof(void*) : Capacity),
+        alignof(std::max_align_t)>::type;
+
+    Storage m_storage;
+    R    (*m_invoke)(void*, Args...) = nullptr;
+    void (*m_destroy)(void*)         = nullptr;
+};
+
+}
+
+#endif
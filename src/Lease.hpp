@@ -0,0 +1,44 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_LEASE_H
+#define __CACHERSIZE_LEASE_H
+
+#include <string>
+#include <cstdint>
+
+namespace cachersize {
+
+/**
+ * @brief Provider id under which clients register the
+ * cachersize_invalidate RPC that providers use to revoke the
+ * leases held by near caches.
+ */
+constexpr uint16_t NEAR_CACHE_PROVIDER_ID = 65534;
+
+/**
+ * @brief Value of the response of the cachersize_get_leased RPC.
+ * The content of the value is sent only if its size does not
+ * exceed the eager limit requested by the client. The lease is
+ * the duration (in seconds, 0 if none was granted) for which the
+ * client may keep serving the value without contacting the provider.
+ */
+struct LeasedValue {
+
+    uint64_t    size  = 0;
+    std::string value;
+    double      lease = 0.0;
+
+    template<typename A>
+    void serialize(A& ar) {
+        ar & size;
+        ar & value;
+        ar & lease;
+    }
+};
+
+}
+
+#endif
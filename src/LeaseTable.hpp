@@ -0,0 +1,195 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_LEASE_TABLE_H
+#define __CACHERSIZE_LEASE_TABLE_H
+
+#include <cachersize/UUID.hpp>
+#include <thallium.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cachersize {
+
+namespace tl = thallium;
+
+/**
+ * @brief The LeaseTable keeps track, on the provider side, of the
+ * read leases granted to the near caches of clients, so that the
+ * holders of a key can be told when the key changes. Holders are
+ * identified by their address and the id of their near cache.
+ * Expired leases are forgotten lazily.
+ */
+class LeaseTable {
+
+    public:
+
+    /**
+     * @brief Leases of one holder revoked by a call to revoke() or
+     * revokeAll(). keys is empty when the holder should drop all the
+     * keys of the cache. expiry is the latest expiry time of the
+     * revoked leases (as given by tl::timer::wtime()).
+     */
+    struct Revocation {
+        std::string              address;
+        uint64_t                 near_cache_id;
+        double                   expiry;
+        std::vector<std::string> keys;
+    };
+
+    /**
+     * @brief Whether any lease has ever been granted. Writers use it
+     * to skip looking up the holders of the keys they modify.
+     */
+    bool active() const {
+        return m_active.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Records that a holder may serve a key of a cache until
+     * the specified expiry time.
+     */
+    void grant(const UUID& cache_id,
+               const std::string& key,
+               const std::string& address,
+               uint64_t near_cache_id,
+               double expiry) {
+        auto lease_key = leaseKey(cache_id, key);
+        auto& shard = shardFor(lease_key);
+        double now = tl::timer::wtime();
+        m_active.store(true, std::memory_order_release);
+        std::lock_guard<tl::mutex> lock(shard.mutex);
+        if(++shard.grants % SWEEP_PERIOD == 0)
+            sweep(shard, now);
+        auto& holders = shard.leases[lease_key];
+        for(auto& holder : holders) {
+            if(holder.near_cache_id == near_cache_id && holder.address == address) {
+                holder.expiry = std::max(holder.expiry, expiry);
+                return;
+            }
+        }
+        holders.push_back(Holder{address, near_cache_id, expiry});
+    }
+
+    /**
+     * @brief Removes the leases on the given keys of a cache and
+     * returns, grouped by holder, those that have not yet expired.
+     */
+    std::vector<Revocation> revoke(const UUID& cache_id,
+                                   const std::vector<std::string>& keys) {
+        std::vector<Revocation> result;
+        if(not active()) return result;
+        std::unordered_map<std::string, size_t> index;
+        double now = tl::timer::wtime();
+        for(auto& key : keys) {
+            auto lease_key = leaseKey(cache_id, key);
+            auto& shard = shardFor(lease_key);
+            std::vector<Holder> holders;
+            {
+                std::lock_guard<tl::mutex> lock(shard.mutex);
+                auto it = shard.leases.find(lease_key);
+                if(it == shard.leases.end()) continue;
+                holders = std::move(it->second);
+                shard.leases.erase(it);
+            }
+            for(auto& holder : holders) {
+                if(holder.expiry <= now) continue;
+                addRevocation(result, index, holder).keys.push_back(key);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Removes all the leases on the keys of a cache and returns,
+     * grouped by holder, those that have not yet expired.
+     */
+    std::vector<Revocation> revokeAll(const UUID& cache_id) {
+        std::vector<Revocation> result;
+        if(not active()) return result;
+        std::unordered_map<std::string, size_t> index;
+        std::string prefix = leaseKey(cache_id, "");
+        double now = tl::timer::wtime();
+        for(auto& shard : m_shards) {
+            std::lock_guard<tl::mutex> lock(shard.mutex);
+            for(auto it = shard.leases.begin(); it != shard.leases.end();) {
+                if(it->first.compare(0, prefix.size(), prefix) != 0) {
+                    ++it;
+                    continue;
+                }
+                for(auto& holder : it->second)
+                    if(holder.expiry > now) addRevocation(result, index, holder);
+                it = shard.leases.erase(it);
+            }
+        }
+        return result;
+    }
+
+    private:
+
+    struct Holder {
+        std::string address;
+        uint64_t    near_cache_id;
+        double      expiry;
+    };
+
+    struct Shard {
+        tl::mutex                                            mutex;
+        std::unordered_map<std::string, std::vector<Holder>> leases;
+        size_t                                               grants = 0;
+    };
+
+    static constexpr size_t NUM_SHARDS   = 16;
+    // number of grants on a shard between two sweeps of its expired leases
+    static constexpr size_t SWEEP_PERIOD = 1024;
+
+    std::array<Shard, NUM_SHARDS> m_shards;
+    std::atomic<bool>             m_active{false};
+
+    static std::string leaseKey(const UUID& cache_id, const std::string& key) {
+        std::string result(reinterpret_cast<const char*>(cache_id.m_data), sizeof(cache_id.m_data));
+        result += key;
+        return result;
+    }
+
+    Shard& shardFor(const std::string& lease_key) {
+        return m_shards[std::hash<std::string>()(lease_key) % NUM_SHARDS];
+    }
+
+    static void sweep(Shard& shard, double now) {
+        for(auto it = shard.leases.begin(); it != shard.leases.end();) {
+            auto& holders = it->second;
+            holders.erase(std::remove_if(holders.begin(), holders.end(),
+                [now](const Holder& h) { return h.expiry <= now; }), holders.end());
+            if(holders.empty()) it = shard.leases.erase(it);
+            else ++it;
+        }
+    }
+
+    static Revocation& addRevocation(std::vector<Revocation>& revocations,
+                                     std::unordered_map<std::string, size_t>& index,
+                                     const Holder& holder) {
+        auto id = holder.address + '#' + std::to_string(holder.near_cache_id);
+        auto it = index.find(id);
+        if(it != index.end()) {
+            auto& r = revocations[it->second];
+            r.expiry = std::max(r.expiry, holder.expiry);
+            return r;
+        }
+        index.emplace(std::move(id), revocations.size());
+        revocations.push_back(Revocation{holder.address, holder.near_cache_id, holder.expiry, {}});
+        return revocations.back();
+    }
+};
+
+}
+
+#endif
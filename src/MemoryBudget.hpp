@@ -0,0 +1,191 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_MEMORY_BUDGET_HPP
+#define __CACHERSIZE_MEMORY_BUDGET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace cachersize {
+
+/**
+ * @brief Memory budget of a provider, shared by its caches.
+ *
+ * Every cache that uses memory holds an Account charged against the
+ * budget. Caches that cannot be resized are charged their capacity.
+ * Resizable caches share the rest: a new one gets an equal share, taken
+ * from the others in proportion to their capacity, and rebalance() then
+ * periodically moves memory according to the marginal benefit of each
+ * cache, estimated from the misses on the keys it evicted recently
+ * ("ghost hits"). Resizable caches keep ghosts for the last tenth of
+ * their capacity, so the ghost hits of a period divided by a tenth of the
+ * capacity approximate the hits per byte that the cache would gain by
+ * growing (and, the miss curve being convex, lose by shrinking). Memory
+ * moves from the cache with the flattest miss curve to the one with the
+ * steepest, one step per period; a cache that received no request
+ * during a period shrinks by one step.
+ *
+ * The MemoryBudget only computes capacities; the provider serializes the
+ * calls and applies the capacities to the backends.
+ */
+class MemoryBudget {
+
+    public:
+
+    struct Account {
+        size_t   capacity  = 0;     // bytes charged against the budget
+        size_t   max_bytes = 0;     // upper bound on capacity (0 = none)
+        bool     resizable = false;
+        uint64_t gain      = 0;     // ghost hits during the last period
+        uint64_t requests  = 0;     // requests during the last period
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param total budget in bytes
+     * @param min_bytes capacity under which a resizable cache never shrinks
+     * @param step fraction of the budget moved at each rebalancing step
+     */
+    MemoryBudget(size_t total, size_t min_bytes, double step)
+    : m_total(total)
+    , m_min_bytes(min_bytes)
+    , m_step(std::max<size_t>(1, static_cast<size_t>(step * total))) {}
+
+    size_t total() const {
+        return m_total;
+    }
+
+    /**
+     * @brief Bytes of the budget that are not charged to any account.
+     */
+    size_t available(const std::vector<Account*>& accounts) const {
+        size_t used = 0;
+        for(auto a : accounts) used += a->capacity;
+        return used >= m_total ? 0 : m_total - used;
+    }
+
+    /**
+     * @brief Shrinks resizable accounts, in proportion to their capacity
+     * above min_bytes, until bytes are available.
+     *
+     * @return false (leaving the accounts unchanged) if this is impossible.
+     */
+    bool reserve(const std::vector<Account*>& accounts, size_t bytes) const {
+        size_t free = available(accounts);
+        if(free >= bytes) return true;
+        size_t needed = bytes - free, spare = 0;
+        for(auto a : accounts)
+            if(a->resizable && a->capacity > m_min_bytes) spare += a->capacity - m_min_bytes;
+        if(spare < needed) return false;
+        size_t taken = 0;
+        for(auto a : accounts) {
+            if(!a->resizable || a->capacity <= m_min_bytes) continue;
+            size_t share = static_cast<size_t>(
+                static_cast<double>(a->capacity - m_min_bytes) * needed / spare);
+            share = std::min(share, a->capacity - m_min_bytes);
+            a->capacity -= share;
+            taken += share;
+        }
+        // rounding leftovers
+        for(auto a : accounts) {
+            if(taken >= needed) break;
+            if(!a->resizable || a->capacity <= m_min_bytes) continue;
+            size_t share = std::min(needed - taken, a->capacity - m_min_bytes);
+            a->capacity -= share;
+            taken += share;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Capacity to give a new resizable cache: an equal share of
+     * the memory left to resizable caches, bounded by max_bytes and by
+     * what others can give up. Shrinks the other accounts accordingly.
+     */
+    size_t share(const std::vector<Account*>& accounts, size_t max_bytes) const {
+        size_t fixed = 0, resizable = 0;
+        for(auto a : accounts) {
+            if(a->resizable) resizable += 1;
+            else fixed += a->capacity;
+        }
+        size_t fair = fixed >= m_total ? 0 : (m_total - fixed) / (resizable + 1);
+        if(max_bytes) fair = std::min(fair, max_bytes);
+        fair = std::max(fair, m_min_bytes);
+        while(fair > m_min_bytes && !reserve(accounts, fair))
+            fair = std::max(m_min_bytes, fair / 2);
+        if(!reserve(accounts, fair)) return 0;
+        return fair;
+    }
+
+    /**
+     * @brief Moves memory between resizable accounts according
+     * to the gain and requests of their last period.
+     */
+    void rebalance(const std::vector<Account*>& accounts) const {
+        std::vector<Account*> active;
+        for(auto a : accounts) {
+            if(!a->resizable) continue;
+            if(a->requests == 0) {
+                // idle caches give memory back
+                a->capacity -= std::min(m_step, a->capacity - std::min(a->capacity, m_min_bytes));
+                continue;
+            }
+            active.push_back(a);
+        }
+        auto utility = [](const Account* a) {
+            return a->capacity ? static_cast<double>(a->gain) * 10.0 / a->capacity : 0.0;
+        };
+        auto canGrow = [](const Account* a) {
+            return a->max_bytes == 0 || a->capacity < a->max_bytes;
+        };
+        std::sort(active.begin(), active.end(), [&](const Account* x, const Account* y) {
+            return utility(x) > utility(y);
+        });
+        // free memory goes to the caches that would gain from it
+        size_t free = available(accounts);
+        for(auto a : active) {
+            if(free == 0 || a->gain == 0) break;
+            if(!canGrow(a)) continue;
+            size_t grant = std::min(free, m_step);
+            if(a->max_bytes) grant = std::min(grant, a->max_bytes - a->capacity);
+            a->capacity += grant;
+            free -= grant;
+        }
+        // then one step from the flattest miss curve to the steepest
+        Account* receiver = nullptr;
+        for(auto a : active) {
+            if(a->gain == 0) break;
+            if(canGrow(a)) { receiver = a; break; }
+        }
+        if(!receiver) return;
+        for(auto it = active.rbegin(); it != active.rend(); ++it) {
+            Account* donor = *it;
+            if(donor == receiver) break;
+            if(donor->capacity <= m_min_bytes) continue;
+            // hysteresis, so that memory does not bounce between
+            // caches whose miss curves have similar slopes
+            if(utility(receiver) <= 2.0 * utility(donor)) break;
+            size_t moved = std::min(m_step, donor->capacity - m_min_bytes);
+            if(receiver->max_bytes)
+                moved = std::min(moved, receiver->max_bytes - receiver->capacity);
+            donor->capacity    -= moved;
+            receiver->capacity += moved;
+            break;
+        }
+    }
+
+    private:
+
+    size_t m_total;
+    size_t m_min_bytes;
+    size_t m_step;
+};
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_MIGRATION_HPP
+#define __CACHERSIZE_MIGRATION_HPP
+
+#include <cachersize/Exception.hpp>
+#include <cachersize/RequestResult.hpp>
+#include <cachersize/UUID.hpp>
+#include "Snapshot.hpp"
+
+#include <thallium.hpp>
+#include <thallium/serialization/stl/string.hpp>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cachersize {
+
+namespace tl = thallium;
+
+/**
+ * A cache migrates from a source provider to a destination provider in
+ * batches of records in the format of snapshot chunks (see Snapshot.hpp).
+ * The source exposes each batch as a bulk region and sends its size and
+ * number of entries with cachersize_migrate_batch; the destination pulls
+ * the batch over RDMA and inserts its entries into the cache it created
+ * for the migration. Batches are sent in one of two modes:
+ * - load: entries are inserted unless their key is already in the cache,
+ *   and expired entries are dropped (used for the initial copy);
+ * - overwrite: entries replace the cache's, and an expired entry erases
+ *   its key (used to send again the keys written during the copy).
+ */
+namespace migration {
+
+/**
+ * @brief Sends the entries of a migrating cache to the destination.
+ * Records are appended to a batch in memory; full batches are sent with
+ * non-blocking RPCs, so that up to max_pending batches are in flight
+ * while the caller fills the next one. Methods throw an Exception on
+ * error, including the errors reported by the destination.
+ */
+class Sender {
+
+    struct PendingBatch {
+        std::unique_ptr<std::string> data;
+        tl::bulk                     bulk;
+        tl::async_response           response;
+    };
+
+    tl::engine                   m_engine;
+    const tl::remote_procedure&  m_rpc;
+    tl::provider_handle          m_ph;
+    std::string                  m_token;
+    UUID                         m_cache_id;
+    bool                         m_overwrite;
+    size_t                       m_batch_bytes;
+    size_t                       m_max_pending;
+    std::unique_ptr<std::string> m_batch;
+    uint64_t                     m_batch_entries = 0;
+    uint64_t                     m_applied = 0;
+    std::deque<PendingBatch>     m_pending;
+    std::string                  m_error;
+
+    void waitOldest() {
+        auto& b = m_pending.front();
+        try {
+            RequestResult<uint64_t> r = b.response.wait();
+            if(r.success()) m_applied += r.value();
+            else if(m_error.empty()) m_error = r.error();
+        } catch(const std::exception& ex) {
+            if(m_error.empty()) m_error = ex.what();
+        }
+        m_pending.pop_front();
+    }
+
+    void sendBatch() {
+        if(m_batch_entries == 0) return;
+        std::vector<std::pair<void*, size_t>> segment = {{ &(*m_batch)[0], m_batch->size() }};
+        auto bulk = m_engine.expose(segment, tl::bulk_mode::read_only);
+        auto response = m_rpc.on(m_ph).async(m_token, m_cache_id, bulk,
+                static_cast<uint64_t>(m_batch->size()), m_batch_entries, m_overwrite);
+        // the batch is kept alive until the destination has pulled it
+        m_pending.push_back(PendingBatch{ std::move(m_batch), std::move(bulk), std::move(response) });
+        m_batch.reset(new std::string());
+        m_batch->reserve(m_batch_bytes + snapshot::kRecordHeaderSize);
+        m_batch_entries = 0;
+        while(m_pending.size() > m_max_pending) waitOldest();
+        if(!m_error.empty()) throw Exception(m_error);
+    }
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param engine engine exposing the batches
+     * @param rpc cachersize_migrate_batch
+     * @param ph destination provider
+     * @param token security token of the destination
+     * @param cache_id UUID of the migrating cache
+     * @param overwrite whether batches are sent in overwrite mode
+     * @param batch_bytes size above which a batch is sent
+     * @param max_pending maximum number of batches in flight
+     */
+    Sender(const tl::engine& engine, const tl::remote_procedure& rpc,
+           const tl::provider_handle& ph, const std::string& token,
+           const UUID& cache_id, bool overwrite,
+           size_t batch_bytes, size_t max_pending)
+    : m_engine(engine)
+    , m_rpc(rpc)
+    , m_ph(ph)
+    , m_token(token)
+    , m_cache_id(cache_id)
+    , m_overwrite(overwrite)
+    , m_batch_bytes(batch_bytes)
+    , m_max_pending(max_pending ? max_pending : 1)
+    , m_batch(new std::string()) {
+        m_batch->reserve(m_batch_bytes + snapshot::kRecordHeaderSize);
+    }
+
+    Sender(const Sender&) = delete;
+    Sender& operator=(const Sender&) = delete;
+
+    ~Sender() {
+        while(!m_pending.empty()) waitOldest();
+    }
+
+    /**
+     * @brief Appends an entry.
+     *
+     * @param expiry_ms expiry time in milliseconds since the Unix epoch, or 0.
+     */
+    void add(const std::string& key, const std::string& value, uint64_t expiry_ms) {
+        snapshot::appendRecord(*m_batch, key, value, expiry_ms);
+        m_batch_entries += 1;
+        if(m_batch->size() >= m_batch_bytes) sendBatch();
+    }
+
+    /**
+     * @brief Erases a key at the destination (overwrite mode only).
+     */
+    void erase(const std::string& key) {
+        // expired since the epoch
+        add(key, std::string(), 1);
+    }
+
+    /**
+     * @brief Sends the last batch and waits for all of them.
+     *
+     * @return the number of entries the destination inserted or erased.
+     */
+    uint64_t finish() {
+        sendBatch();
+        while(!m_pending.empty()) waitOldest();
+        if(!m_error.empty()) throw Exception(m_error);
+        return m_applied;
+    }
+};
+
+}
+
+}
+
+#endif
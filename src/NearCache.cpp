@@ -0,0 +1,132 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "NearCache.hpp"
+#include <mutex>
+
+namespace cachersize {
+
+// The registry is a function-local static protected by a std::mutex
+// because it may be used before Argobots is initialized (and after
+// it is finalized, by the destructor of a near cache).
+struct NearCacheRegistry {
+    std::mutex                                             mutex;
+    std::unordered_map<uint64_t, std::weak_ptr<NearCache>> caches;
+    uint64_t                                               next_id = 1;
+};
+
+static NearCacheRegistry& registry() {
+    static NearCacheRegistry r;
+    return r;
+}
+
+std::shared_ptr<NearCache> NearCache::create(size_t max_entries, size_t max_bytes) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto id = r.next_id++;
+    std::shared_ptr<NearCache> cache(new NearCache(id, max_entries, max_bytes));
+    r.caches.emplace(id, cache);
+    return cache;
+}
+
+std::shared_ptr<NearCache> NearCache::find(uint64_t id) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.caches.find(id);
+    if(it == r.caches.end()) return nullptr;
+    return it->second.lock();
+}
+
+NearCache::~NearCache() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.caches.erase(m_id);
+}
+
+uint64_t NearCache::generation() {
+    std::lock_guard<tl::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+bool NearCache::lookup(const std::string& key, std::string* value) {
+    double now = tl::timer::wtime();
+    std::lock_guard<tl::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if(it == m_index.end()) {
+        m_stats.misses += 1;
+        return false;
+    }
+    auto entry = it->second;
+    if(entry->expiry <= now) {
+        // never serve a value past its lease
+        removeLocked(entry);
+        m_stats.misses += 1;
+        m_stats.expirations += 1;
+        return false;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, entry);
+    if(value) *value = entry->value;
+    m_stats.hits += 1;
+    return true;
+}
+
+void NearCache::insert(const std::string& key, const std::string& value,
+                       double expiry, uint64_t generation) {
+    size_t entry_bytes = key.size() + value.size();
+    if(m_max_bytes && entry_bytes > m_max_bytes) return;
+    std::lock_guard<tl::mutex> lock(m_mutex);
+    if(generation != m_generation) return;
+    auto it = m_index.find(key);
+    if(it != m_index.end()) removeLocked(it->second);
+    while(!m_lru.empty()
+       && ((m_max_entries && m_index.size() >= m_max_entries)
+        || (m_max_bytes && m_bytes + entry_bytes > m_max_bytes))) {
+        removeLocked(std::prev(m_lru.end()));
+        m_stats.evictions += 1;
+    }
+    m_lru.push_front(Entry{key, value, expiry});
+    m_index.emplace(key, m_lru.begin());
+    m_bytes += entry_bytes;
+}
+
+void NearCache::invalidate(const std::vector<std::string>& keys) {
+    std::lock_guard<tl::mutex> lock(m_mutex);
+    m_generation += 1;
+    if(keys.empty()) {
+        m_stats.invalidations += m_index.size();
+        m_index.clear();
+        m_lru.clear();
+        m_bytes = 0;
+        return;
+    }
+    for(auto& key : keys) {
+        auto it = m_index.find(key);
+        if(it == m_index.end()) continue;
+        removeLocked(it->second);
+        m_stats.invalidations += 1;
+    }
+}
+
+void NearCache::invalidate(const std::string& key) {
+    std::lock_guard<tl::mutex> lock(m_mutex);
+    m_generation += 1;
+    auto it = m_index.find(key);
+    if(it == m_index.end()) return;
+    removeLocked(it->second);
+    m_stats.invalidations += 1;
+}
+
+NearCacheStats NearCache::stats() {
+    std::lock_guard<tl::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void NearCache::removeLocked(EntryList::iterator it) {
+    m_bytes -= it->key.size() + it->value.size();
+    m_index.erase(it->key);
+    m_lru.erase(it);
+}
+
+}
@@ -0,0 +1,116 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_NEAR_CACHE_H
+#define __CACHERSIZE_NEAR_CACHE_H
+
+#include <cachersize/CacheHandle.hpp>
+#include <thallium.hpp>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cachersize {
+
+namespace tl = thallium;
+
+/**
+ * @brief A NearCache is a bounded, client-local LRU cache of values
+ * read through a CacheHandle. Each entry is valid until the end of
+ * the lease granted by the provider, and is dropped earlier if the
+ * provider revokes the lease (see the cachersize_invalidate RPC).
+ *
+ * Every invalidation bumps a generation counter. A value may only be
+ * inserted with the generation read before it was requested, so that
+ * a response racing with an invalidation is never cached.
+ *
+ * Near caches are registered in a process-wide table so that
+ * invalidations can be dispatched to them by id.
+ */
+class NearCache {
+
+    public:
+
+    /**
+     * @brief Creates and registers a near cache holding at most
+     * max_entries entries and max_bytes bytes of keys and values
+     * (0 meaning no limit).
+     */
+    static std::shared_ptr<NearCache> create(size_t max_entries, size_t max_bytes);
+
+    /**
+     * @brief Finds a registered near cache by id. Returns
+     * nullptr if it does not exist anymore.
+     */
+    static std::shared_ptr<NearCache> find(uint64_t id);
+
+    NearCache(const NearCache&) = delete;
+    NearCache& operator=(const NearCache&) = delete;
+
+    ~NearCache();
+
+    uint64_t id() const {
+        return m_id;
+    }
+
+    uint64_t generation();
+
+    /**
+     * @brief Copies the value of a key if an unexpired entry exists,
+     * and counts a hit or a miss.
+     */
+    bool lookup(const std::string& key, std::string* value);
+
+    /**
+     * @brief Inserts a value valid until expiry (as given by
+     * tl::timer::wtime()), unless an invalidation happened since
+     * the given generation was read.
+     */
+    void insert(const std::string& key, const std::string& value,
+                double expiry, uint64_t generation);
+
+    /**
+     * @brief Drops the given keys, or all the keys if keys is empty.
+     */
+    void invalidate(const std::vector<std::string>& keys);
+
+    void invalidate(const std::string& key);
+
+    NearCacheStats stats();
+
+    private:
+
+    NearCache(uint64_t id, size_t max_entries, size_t max_bytes)
+    : m_id(id)
+    , m_max_entries(max_entries)
+    , m_max_bytes(max_bytes) {}
+
+    struct Entry {
+        std::string key;
+        std::string value;
+        double      expiry;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void removeLocked(EntryList::iterator it);
+
+    const uint64_t m_id;
+    const size_t   m_max_entries;
+    const size_t   m_max_bytes;
+
+    tl::mutex      m_mutex;
+    EntryList      m_lru; // most recently used first
+    std::unordered_map<std::string, EntryList::iterator> m_index;
+    size_t         m_bytes      = 0;
+    uint64_t       m_generation = 0;
+    NearCacheStats m_stats;
+};
+
+}
+
+#endif
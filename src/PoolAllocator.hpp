@@ -0,0 +1,82 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_POOL_ALLOCATOR_H
+#define __CACHERSIZE_POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace cachersize {
+
+/**
+ * @brief Stateless allocator recycling single-object allocations through
+ * per-thread free lists (one per allocated type), so that objects that
+ * are created and destroyed at a high rate, such as the shared state of
+ * asynchronous requests created with std::allocate_shared, do not go
+ * through the global allocator once the free lists are warm. A block
+ * freed on another thread than the one it was allocated on simply joins
+ * that thread's free list. Each free list keeps at most MaxCached blocks.
+ */
+template<typename T, size_t MaxCached = 1024>
+class PoolAllocator {
+
+    public:
+
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = PoolAllocator<U, MaxCached>; };
+
+    PoolAllocator() = default;
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U, MaxCached>&) {}
+
+    T* allocate(size_t n) {
+        if(n != 1)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        auto& blocks = freeList().blocks;
+        if(blocks.empty())
+            return static_cast<T*>(::operator new(sizeof(T)));
+        void* block = blocks.back();
+        blocks.pop_back();
+        return static_cast<T*>(block);
+    }
+
+    void deallocate(T* p, size_t n) {
+        auto& blocks = freeList().blocks;
+        if(n != 1 || blocks.size() >= MaxCached) {
+            ::operator delete(p);
+            return;
+        }
+        blocks.push_back(p);
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U, MaxCached>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U, MaxCached>&) const { return false; }
+
+    private:
+
+    struct FreeList {
+        std::vector<void*> blocks;
+        ~FreeList() {
+            for(auto block : blocks) ::operator delete(block);
+        }
+    };
+
+    static FreeList& freeList() {
+        static thread_local FreeList list;
+        return list;
+    }
+};
+
+}
+
+#endif
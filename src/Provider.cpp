@@ -14,15 +14,13 @@ namespace tl = thallium;
 namespace cachersize {
 
 Provider::Provider(const tl::engine& engine, uint16_t provider_id, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(engine, provider_id, p)) {
+: self(std::make_shared<ProviderImpl>(engine, provider_id, config, p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
 }
 
 Provider::Provider(margo_instance_id mid, uint16_t provider_id, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(mid, provider_id, p)) {
+: self(std::make_shared<ProviderImpl>(mid, provider_id, config, p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
 }
 
 Provider::Provider(Provider&& other) {
@@ -38,7 +36,17 @@ Provider::~Provider() {
 }
 
 std::string Provider::getConfig() const {
-    return "{}";
+    if(not self) return "{}";
+    return self->m_config.dump();
+}
+
+std::string Provider::getStats() const {
+    if(not self) return "{}";
+    auto stats = nlohmann::json::object();
+    self->m_caches.for_each([&stats](const UUID& cache_id, const ProviderImpl::Cache& cache) {
+        stats[cache_id.to_string()] = ProviderImpl::cacheStats(cache);
+    });
+    return stats.dump();
 }
 
 Provider::operator bool() const {
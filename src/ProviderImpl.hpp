@@ -8,30 +8,50 @@
 
 #include "cachersize/Backend.hpp"
 #include "cachersize/UUID.hpp"
+#include "cachersize/Exception.hpp"
+#include "CacheRegistry.hpp"
+#include "CacheMetrics.hpp"
+#include "EndpointCache.hpp"
+#include "Lease.hpp"
+#include "LeaseTable.hpp"
+#include "MemoryBudget.hpp"
+#include "Migration.hpp"
+#include "Snapshot.hpp"
 
 #include <thallium.hpp>
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/vector.hpp>
+#include <thallium/serialization/stl/pair.hpp>
 
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <tuple>
+#include <unordered_map>
 
 #define FIND_CACHE(__var__) \
-        std::shared_ptr<Backend> __var__;\
-        do {\
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);\
-            auto it = m_backends.find(cache_id);\
-            if(it == m_backends.end()) {\
-                result.success() = false;\
+        auto __var__##_guard = m_caches.read();\
+        Cache* __var__##_entry = __var__##_guard.find(cache_id);\
+        if(__var__##_entry == nullptr && awaitSwitchover(cache_id, __var__##_guard))\
+            __var__##_entry = __var__##_guard.find(cache_id);\
+        if(__var__##_entry == nullptr) {\
+            result.success() = false;\
+            if(movedTo(cache_id, &result.error())) {\
+                result.code() = ResultCode::CacheMoved;\
+            } else {\
+                result.code() = ResultCode::CacheNotFound;\
                 result.error() = "Cache with UUID "s + cache_id.to_string() + " not found";\
-                req.respond(result);\
                 spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());\
-                return;\
             }\
-            __var__ = it->second;\
-        }while(0)
+            req.respond(result);\
+            return;\
+        }\
+        Backend* __var__ = __var__##_entry->backend.get();\
+        CacheMetrics& __var__##_metrics = __var__##_entry->metrics;\
+        (void)__var__; (void)__var__##_metrics
 
 namespace cachersize {
 
@@ -47,43 +67,296 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
     public:
 
     std::string          m_token;
-    tl::pool             m_pool;
+    json                 m_config;
+    // Pools handling each class of RPC
+    tl::pool             m_admin_pool;
+    tl::pool             m_data_pool;
+    tl::pool             m_bulk_pool;
+    // Leases granted to near caches (see cachersize_get_leased)
+    double               m_lease_duration;
+    LeaseTable           m_leases;
+    tl::remote_procedure m_invalidate;
+    std::shared_ptr<EndpointCache> m_endpoints;
     // Admin RPC
     tl::remote_procedure m_create_cache;
     tl::remote_procedure m_open_cache;
     tl::remote_procedure m_close_cache;
     tl::remote_procedure m_destroy_cache;
+    tl::remote_procedure m_get_stats;
+    tl::remote_procedure m_snapshot_cache;
+    tl::remote_procedure m_restore_cache;
+    tl::remote_procedure m_migrate_cache;
+    // Provider-to-provider RPC (see Migration.hpp)
+    tl::remote_procedure m_migrate_begin;
+    tl::remote_procedure m_migrate_batch;
+    tl::remote_procedure m_migrate_commit;
+    tl::remote_procedure m_migrate_abort;
     // Client RPC
     tl::remote_procedure m_check_cache;
     tl::remote_procedure m_say_hello;
     tl::remote_procedure m_compute_sum;
-    // Backends
-    std::unordered_map<UUID, std::shared_ptr<Backend>> m_backends;
-    tl::mutex m_backends_mtx;
+    tl::remote_procedure m_put;
+    tl::remote_procedure m_get;
+    tl::remote_procedure m_erase;
+    tl::remote_procedure m_exists;
+    tl::remote_procedure m_get_leased;
+    tl::remote_procedure m_put_bulk;
+    tl::remote_procedure m_get_bulk;
+    tl::remote_procedure m_put_multi;
+    tl::remote_procedure m_get_multi;
+    tl::remote_procedure m_erase_multi;
+    // Caches
+    struct Cache {
+        Cache(std::unique_ptr<Backend>&& b, const std::string& t, const json& c)
+        : backend(std::move(b)), type(t), config(c) {}
+        std::unique_ptr<Backend> backend;
+        CacheMetrics             metrics;
+        // type and configuration, to create the cache on another
+        // provider when it migrates
+        std::string              type;
+        json                     config;
+        // memory budget accounting, protected by m_budget_mtx
+        bool                     budgeted = false;
+        MemoryBudget::Account    budget;
+        uint64_t                 last_ghost_hits = 0;
+        uint64_t                 last_requests = 0;
+        // restoration from a snapshot, see restoreSnapshot()
+        enum { NotRestored, Restoring, Restored, RestoreFailed };
+        std::atomic<int>         restore_state = { NotRestored };
+        std::atomic<uint64_t>    restored_entries = { 0 };
+        // migration to another provider, see migrate(); while tracking
+        // is set, writes record the keys they modify in dirty, with the
+        // expiry (in ms since the Unix epoch, 0 if none) of their value
+        std::atomic<bool>        migrating = { false };
+        std::atomic<bool>        tracking = { false };
+        tl::mutex                dirty_mtx;
+        std::unordered_map<std::string, uint64_t> dirty;
+    };
+    CacheRegistry<UUID, Cache> m_caches;
+    // Memory budget shared by the caches (see MemoryBudget); m_budget_mtx
+    // is taken before entering a read-side section of m_caches, never after
+    std::unique_ptr<MemoryBudget> m_budget;
+    double                        m_rebalance_interval_ms = 0.0;
+    tl::mutex                     m_budget_mtx;
+    tl::condition_variable        m_budget_cv;
+    bool                          m_rebalancer_running = false;
+    bool                          m_stopping = false;
+    // Snapshots; the abt-io instance is created by the first snapshot
+    // or restoration, and m_snapshot_mtx also protects m_restores_running
+    abt_io_instance_id            m_abtio = ABT_IO_INSTANCE_NULL;
+    unsigned                      m_snapshot_threads = 4;
+    size_t                        m_snapshot_chunk_bytes = 4*1024*1024;
+    tl::mutex                     m_snapshot_mtx;
+    tl::condition_variable        m_snapshot_cv;
+    unsigned                      m_restores_running = 0;
+    // Migrations. m_incoming holds the caches being migrated to this
+    // provider, invisible to clients until their switchover; m_moved
+    // records the caches that left (or are leaving) this provider, and
+    // where to. m_migration_mtx is never held while waiting for m_caches.
+    struct Moved {
+        bool        committed = false;
+        std::string location; // "<provider id>@<address>"
+    };
+    size_t                        m_migration_batch_bytes = 4*1024*1024;
+    size_t                        m_migration_pipeline_depth = 4;
+    unsigned                      m_migration_max_rounds = 4;
+    tl::mutex                     m_migration_mtx;
+    tl::condition_variable        m_migration_cv;
+    std::unordered_map<UUID, std::shared_ptr<Cache>> m_incoming;
+    std::unordered_map<UUID, Moved>                  m_moved;
+
+    /**
+     * @brief Parses the provider's configuration. An empty string
+     * is equivalent to an empty object. Throws an Exception if the
+     * configuration is invalid.
+     */
+    static json parseConfig(const std::string& config) {
+        json result = json::object();
+        if(!config.empty()) {
+            try {
+                result = json::parse(config);
+            } catch(const json::parse_error& ex) {
+                throw Exception("Could not parse provider configuration: "s + ex.what());
+            }
+        }
+        if(!result.is_object())
+            throw Exception("Provider configuration should be an object");
+        if(!result.contains("pools"))
+            result["pools"] = json::object();
+        if(!result["pools"].is_object())
+            throw Exception("\"pools\" field of the provider configuration should be an object");
+        for(auto& rpc_class : { "admin", "data", "bulk" }) {
+            auto& pools = result["pools"];
+            if(!pools.contains(rpc_class))
+                pools[rpc_class] = nullptr;
+            else if(!pools[rpc_class].is_string() && !pools[rpc_class].is_null())
+                throw Exception("\"pools."s + rpc_class + "\" field should be a string");
+        }
+        if(!result.contains("lease_duration_ms"))
+            result["lease_duration_ms"] = 1000;
+        if(!result["lease_duration_ms"].is_number_unsigned())
+            throw Exception("\"lease_duration_ms\" field should be an unsigned integer");
+        if(!result.contains("memory_budget"))
+            result["memory_budget"] = json::object();
+        auto& budget = result["memory_budget"];
+        if(!budget.is_object())
+            throw Exception("\"memory_budget\" field should be an object");
+        for(auto& field : { std::make_pair("bytes", 0),
+                            std::make_pair("min_cache_bytes", 1024*1024),
+                            std::make_pair("rebalance_interval_ms", 1000) }) {
+            if(!budget.contains(field.first))
+                budget[field.first] = field.second;
+            if(!budget[field.first].is_number_unsigned())
+                throw Exception("\"memory_budget."s + field.first
+                    + "\" field should be an unsigned integer");
+        }
+        if(budget["rebalance_interval_ms"].get<uint64_t>() == 0)
+            throw Exception("\"memory_budget.rebalance_interval_ms\" field should be strictly positive");
+        if(!budget.contains("step"))
+            budget["step"] = 0.05;
+        if(!budget["step"].is_number()
+        || !(budget["step"].get<double>() > 0.0 && budget["step"].get<double>() <= 1.0))
+            throw Exception("\"memory_budget.step\" field should be a number in (0, 1]");
+        if(!result.contains("snapshot"))
+            result["snapshot"] = json::object();
+        auto& snapshot = result["snapshot"];
+        if(!snapshot.is_object())
+            throw Exception("\"snapshot\" field should be an object");
+        for(auto& field : { std::make_pair("abt_io_threads", 4),
+                            std::make_pair("chunk_bytes", 4*1024*1024) }) {
+            if(!snapshot.contains(field.first))
+                snapshot[field.first] = field.second;
+            if(!snapshot[field.first].is_number_unsigned() || snapshot[field.first].get<uint64_t>() == 0)
+                throw Exception("\"snapshot."s + field.first
+                    + "\" field should be a strictly positive integer");
+        }
+        if(!result.contains("migration"))
+            result["migration"] = json::object();
+        auto& migration = result["migration"];
+        if(!migration.is_object())
+            throw Exception("\"migration\" field should be an object");
+        for(auto& field : { std::make_pair("batch_bytes", 4*1024*1024),
+                            std::make_pair("pipeline_depth", 4),
+                            std::make_pair("max_rounds", 4) }) {
+            if(!migration.contains(field.first))
+                migration[field.first] = field.second;
+            if(!migration[field.first].is_number_unsigned() || migration[field.first].get<uint64_t>() == 0)
+                throw Exception("\"migration."s + field.first
+                    + "\" field should be a strictly positive integer");
+        }
+        return result;
+    }
+
+    /**
+     * @brief Returns the pool named in the "pools" section of the
+     * configuration for a class of RPC, or default_pool if none is.
+     */
+    static tl::pool findPool(const tl::engine& engine, const json& config,
+                             const char* rpc_class, const tl::pool& default_pool) {
+        auto& name = config["pools"][rpc_class];
+        if(name.is_null()) return default_pool;
+        ABT_pool pool = margo_find_pool_by_name(
+            engine.get_margo_instance(), name.get_ref<const std::string&>().c_str());
+        if(pool == ABT_POOL_NULL)
+            throw Exception("Could not find pool \"" + name.get<std::string>()
+                + "\" for " + rpc_class + " RPCs");
+        return tl::pool(pool);
+    }
 
-    ProviderImpl(const tl::engine& engine, uint16_t provider_id, const tl::pool& pool)
+    ProviderImpl(const tl::engine& engine, uint16_t provider_id,
+                 const std::string& config, const tl::pool& pool)
     : tl::provider<ProviderImpl>(engine, provider_id)
-    , m_pool(pool)
-    , m_create_cache(define("cachersize_create_cache", &ProviderImpl::createCache, pool))
-    , m_open_cache(define("cachersize_open_cache", &ProviderImpl::openCache, pool))
-    , m_close_cache(define("cachersize_close_cache", &ProviderImpl::closeCache, pool))
-    , m_destroy_cache(define("cachersize_destroy_cache", &ProviderImpl::destroyCache, pool))
-    , m_check_cache(define("cachersize_check_cache", &ProviderImpl::checkCache, pool))
-    , m_say_hello(define("cachersize_say_hello", &ProviderImpl::sayHello, pool))
-    , m_compute_sum(define("cachersize_compute_sum",  &ProviderImpl::computeSum, pool))
+    , m_config(parseConfig(config))
+    , m_admin_pool(findPool(engine, m_config, "admin", pool))
+    , m_data_pool(findPool(engine, m_config, "data", pool))
+    , m_bulk_pool(findPool(engine, m_config, "bulk", pool))
+    , m_lease_duration(m_config["lease_duration_ms"].get<uint64_t>() / 1000.0)
+    , m_invalidate(get_engine().define("cachersize_invalidate"))
+    , m_endpoints(EndpointCache::of(get_engine()))
+    // Admin RPCs
+    , m_create_cache(define("cachersize_create_cache", &ProviderImpl::createCache, m_admin_pool))
+    , m_open_cache(define("cachersize_open_cache", &ProviderImpl::openCache, m_admin_pool))
+    , m_close_cache(define("cachersize_close_cache", &ProviderImpl::closeCache, m_admin_pool))
+    , m_destroy_cache(define("cachersize_destroy_cache", &ProviderImpl::destroyCache, m_admin_pool))
+    , m_get_stats(define("cachersize_get_stats", &ProviderImpl::getStats, m_admin_pool))
+    , m_snapshot_cache(define("cachersize_snapshot_cache", &ProviderImpl::snapshotCache, m_admin_pool))
+    , m_restore_cache(define("cachersize_restore_cache", &ProviderImpl::restoreCache, m_admin_pool))
+    , m_migrate_cache(define("cachersize_migrate_cache", &ProviderImpl::migrateCache, m_admin_pool))
+    , m_migrate_begin(define("cachersize_migrate_begin", &ProviderImpl::migrateBegin, m_admin_pool))
+    , m_migrate_batch(define("cachersize_migrate_batch", &ProviderImpl::migrateBatch, m_bulk_pool))
+    , m_migrate_commit(define("cachersize_migrate_commit", &ProviderImpl::migrateCommit, m_admin_pool))
+    , m_migrate_abort(define("cachersize_migrate_abort", &ProviderImpl::migrateAbort, m_admin_pool))
+    // Small data RPCs, whose arguments and responses fit in the RPC messages
+    , m_check_cache(define("cachersize_check_cache", &ProviderImpl::checkCache, m_data_pool))
+    , m_say_hello(define("cachersize_say_hello", &ProviderImpl::sayHello, m_data_pool))
+    , m_compute_sum(define("cachersize_compute_sum",  &ProviderImpl::computeSum, m_data_pool))
+    , m_put(define("cachersize_put", &ProviderImpl::put, m_data_pool))
+    , m_get(define("cachersize_get", &ProviderImpl::get, m_data_pool))
+    , m_erase(define("cachersize_erase", &ProviderImpl::erase, m_data_pool))
+    , m_exists(define("cachersize_exists", &ProviderImpl::exists, m_data_pool))
+    , m_get_leased(define("cachersize_get_leased", &ProviderImpl::getLeased, m_data_pool))
+    // RPCs that issue RDMA transfers
+    , m_put_bulk(define("cachersize_put_bulk", &ProviderImpl::putBulk, m_bulk_pool))
+    , m_get_bulk(define("cachersize_get_bulk", &ProviderImpl::getBulk, m_bulk_pool))
+    , m_put_multi(define("cachersize_put_multi", &ProviderImpl::putMulti, m_bulk_pool))
+    , m_get_multi(define("cachersize_get_multi", &ProviderImpl::getMulti, m_bulk_pool))
+    , m_erase_multi(define("cachersize_erase_multi", &ProviderImpl::eraseMulti, m_bulk_pool))
     {
+        m_snapshot_threads     = m_config["snapshot"]["abt_io_threads"].get<unsigned>();
+        m_snapshot_chunk_bytes = m_config["snapshot"]["chunk_bytes"].get<size_t>();
+        m_migration_batch_bytes    = m_config["migration"]["batch_bytes"].get<size_t>();
+        m_migration_pipeline_depth = m_config["migration"]["pipeline_depth"].get<size_t>();
+        m_migration_max_rounds     = m_config["migration"]["max_rounds"].get<unsigned>();
+        auto& budget = m_config["memory_budget"];
+        if(budget["bytes"].get<size_t>() != 0) {
+            m_budget.reset(new MemoryBudget(budget["bytes"].get<size_t>(),
+                                            budget["min_cache_bytes"].get<size_t>(),
+                                            budget["step"].get<double>()));
+            m_rebalance_interval_ms = budget["rebalance_interval_ms"].get<uint64_t>();
+            m_rebalancer_running = true;
+            m_admin_pool.make_thread([this]() { rebalancerLoop(); }, tl::anonymous());
+        }
         spdlog::trace("[provider:{0}] Registered provider with id {0}", id());
     }
 
     ~ProviderImpl() {
         spdlog::trace("[provider:{}] Deregistering provider", id());
+        {
+            std::unique_lock<tl::mutex> lock(m_budget_mtx);
+            m_stopping = true;
+            m_budget_cv.wait(lock, [this]() { return !m_rebalancer_running; });
+        }
+        {
+            std::unique_lock<tl::mutex> lock(m_snapshot_mtx);
+            m_snapshot_cv.wait(lock, [this]() { return m_restores_running == 0; });
+        }
         m_create_cache.deregister();
         m_open_cache.deregister();
         m_close_cache.deregister();
         m_destroy_cache.deregister();
+        m_get_stats.deregister();
+        m_snapshot_cache.deregister();
+        m_restore_cache.deregister();
+        m_migrate_cache.deregister();
+        m_migrate_begin.deregister();
+        m_migrate_batch.deregister();
+        m_migrate_commit.deregister();
+        m_migrate_abort.deregister();
         m_check_cache.deregister();
         m_say_hello.deregister();
         m_compute_sum.deregister();
+        m_put.deregister();
+        m_put_bulk.deregister();
+        m_get.deregister();
+        m_get_bulk.deregister();
+        m_erase.deregister();
+        m_exists.deregister();
+        m_get_leased.deregister();
+        m_put_multi.deregister();
+        m_get_multi.deregister();
+        m_erase_multi.deregister();
+        if(m_abtio != ABT_IO_INSTANCE_NULL)
+            abt_io_finalize(m_abtio);
         spdlog::trace("[provider:{}]    => done!", id());
     }
 
@@ -101,6 +374,7 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
         if(m_token.size() > 0 && m_token != token) {
             result.success() = false;
+            result.code() = ResultCode::InvalidToken;
             result.error() = "Invalid security token";
             req.respond(result);
             spdlog::error("[provider:{}] Invalid security token {}", id(), token);
@@ -139,11 +413,19 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
                     id(), cache_type, cache_id.to_string());
             req.respond(result);
             return;
-        } else {
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);
-            m_backends[cache_id] = std::move(backend);
-            result.value() = cache_id;
         }
+
+        std::string error;
+        if(not addCache(cache_id, std::make_shared<Cache>(std::move(backend), cache_type, json_config),
+                        &error)) {
+            result.success() = false;
+            result.error() = std::move(error);
+            spdlog::error("[provider:{}] Could not add cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            req.respond(result);
+            return;
+        }
+        result.value() = cache_id;
         
         req.respond(result);
         spdlog::trace("[provider:{}] Successfully created cache {} of type {}",
@@ -164,6 +446,7 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
         if(m_token.size() > 0 && m_token != token) {
             result.success() = false;
+            result.code() = ResultCode::InvalidToken;
             result.error() = "Invalid security token";
             req.respond(result);
             spdlog::error("[provider:{}] Invalid security token {}", id(), token);
@@ -182,6 +465,27 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             return;
         }
 
+        // the provider, not the backend, handles the "snapshot" field
+        std::string snapshot_path;
+        bool snapshot_wait = true;
+        if(json_config.is_object() && json_config.contains("snapshot")) {
+            auto snapshot = json_config["snapshot"];
+            json_config.erase("snapshot");
+            if(snapshot.is_string()) snapshot = json{{"path", snapshot}};
+            if(!snapshot.is_object() || !snapshot.contains("path") || !snapshot["path"].is_string()
+            || (snapshot.contains("wait") && !snapshot["wait"].is_boolean())) {
+                result.success() = false;
+                result.error() = "\"snapshot\" field should be a path or an object"
+                                 " with a \"path\" string and an optional \"wait\" boolean";
+                spdlog::error("[provider:{}] Invalid snapshot configuration for cache {}",
+                        id(), cache_id.to_string());
+                req.respond(result);
+                return;
+            }
+            snapshot_path = snapshot["path"].get<std::string>();
+            snapshot_wait = snapshot.value("wait", true);
+        }
+
         std::unique_ptr<Backend> backend;
         try {
             backend = CacheFactory::openCache(cache_type, get_engine(), json_config);
@@ -202,12 +506,38 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
                     id(), cache_type, cache_id.to_string());
             req.respond(result);
             return;
-        } else {
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);
-            m_backends[cache_id] = std::move(backend);
-            result.value() = cache_id;
         }
-        
+
+        std::string error;
+        if(not addCache(cache_id, std::make_shared<Cache>(std::move(backend), cache_type, json_config),
+                        &error)) {
+            result.success() = false;
+            result.error() = std::move(error);
+            spdlog::error("[provider:{}] Could not add cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            req.respond(result);
+            return;
+        }
+        result.value() = cache_id;
+
+        if(!snapshot_path.empty()) {
+            auto cache = m_caches.get(cache_id);
+            if(snapshot_wait) {
+                auto restored = restoreSnapshot(*cache, snapshot_path);
+                if(not restored.success()) {
+                    m_caches.erase(cache_id);
+                    result.success() = false;
+                    result.error() = std::move(restored.error());
+                    spdlog::error("[provider:{}] Could not restore cache {} from {}: {}",
+                            id(), cache_id.to_string(), snapshot_path, result.error());
+                    req.respond(result);
+                    return;
+                }
+            } else {
+                restoreInBackground(cache_id, std::move(cache), snapshot_path);
+            }
+        }
+
         req.respond(result);
         spdlog::trace("[provider:{}] Successfully created cache {} of type {}",
                 id(), cache_id.to_string(), cache_type);
@@ -223,24 +553,31 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
         if(m_token.size() > 0 && m_token != token) {
             result.success() = false;
+            result.code() = ResultCode::InvalidToken;
             result.error() = "Invalid security token";
             req.respond(result);
             spdlog::error("[provider:{}] Invalid security token {}", id(), token);
             return;
         }
 
-        {
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);
-
-            if(m_backends.count(cache_id) == 0) {
-                result.success() = false;
-                result.error() = "Cache "s + cache_id.to_string() + " not found";
-                req.respond(result);
-                spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
-                return;
-            }
-
-            m_backends.erase(cache_id);
+        // erase() returns once in-flight requests on the cache have
+        // completed; the backend is released with the returned pointer
+        auto cache = m_caches.erase(cache_id);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "Cache "s + cache_id.to_string() + " not found";
+            req.respond(result);
+            spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
+            return;
+        }
+        revokeAllLeases(cache_id);
+        // data held only in memory must reach storage before we return
+        result = cache->backend->flush();
+        if(not result.success()) {
+            spdlog::error("[provider:{}] Could not flush cache {} before closing it: {}",
+                    id(), cache_id.to_string(), result.error());
+            result.error() = "Cache closed, but "s + result.error();
         }
         req.respond(result);
         spdlog::trace("[provider:{}] Cache {} successfully closed", id(), cache_id.to_string());
@@ -254,29 +591,873 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
         if(m_token.size() > 0 && m_token != token) {
             result.success() = false;
+            result.code() = ResultCode::InvalidToken;
             result.error() = "Invalid security token";
             req.respond(result);
             spdlog::error("[provider:{}] Invalid security token {}", id(), token);
             return;
         }
 
+        auto cache = m_caches.erase(cache_id);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "Cache "s + cache_id.to_string() + " not found";
+            req.respond(result);
+            spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
+            return;
+        }
+        revokeAllLeases(cache_id);
+        // no request can reach the backend anymore at this point
+        auto flushed = cache->backend->flush();
+        if(not flushed.success())
+            spdlog::error("[provider:{}] Could not flush cache {} before destroying it: {}",
+                    id(), cache_id.to_string(), flushed.error());
+        result = cache->backend->destroy();
+        if(result.success() && not flushed.success()) {
+            result.success() = false;
+            result.error() = "Cache destroyed, but "s + flushed.error();
+        }
+
+        req.respond(result);
+        spdlog::trace("[provider:{}] Cache {} successfully destroyed", id(), cache_id.to_string());
+    }
+
+    /**
+     * @brief Registers a cache, charging it against the memory budget
+     * (if any). A resizable cache gets an equal share of the budget,
+     * taken from the other resizable caches; other caches are charged
+     * their capacity.
+     *
+     * @return false if the budget cannot accommodate the cache.
+     */
+    bool addCache(const UUID& cache_id, std::shared_ptr<Cache> cache, std::string* error) {
+        Backend::MemoryProfile profile;
+        if(not m_budget || not cache->backend->getMemoryProfile(&profile)) {
+            m_caches.insert(cache_id, std::move(cache));
+            return true;
+        }
+        std::unique_lock<tl::mutex> lock(m_budget_mtx);
+        auto caches = budgetedCaches();
+        auto accounts = accountsOf(caches);
+        auto before = capacitiesOf(caches);
+        auto& account = cache->budget;
+        account.resizable = profile.resizable;
+        account.max_bytes = profile.max_bytes;
+        if(profile.resizable) {
+            account.capacity = m_budget->share(accounts, profile.max_bytes);
+        } else {
+            account.capacity = profile.capacity_bytes ? profile.capacity_bytes : profile.used_bytes;
+            if(not m_budget->reserve(accounts, account.capacity)) account.capacity = 0;
+        }
+        if(account.capacity == 0) {
+            *error = "Provider memory budget ("s + std::to_string(m_budget->total())
+                   + " bytes) cannot accommodate this cache";
+            return false;
+        }
+        applyCapacities(caches, before);
+        if(profile.resizable)
+            cache->backend->setMemoryCapacity(account.capacity);
+        cache->budgeted = true;
+        cache->last_ghost_hits = profile.ghost_hits;
+        m_caches.insert(cache_id, std::move(cache));
+        return true;
+    }
+
+    /**
+     * @brief Caches charged against the memory budget.
+     * Must be called with m_budget_mtx held.
+     */
+    std::vector<std::shared_ptr<Cache>> budgetedCaches() {
+        auto caches = m_caches.values();
+        caches.erase(std::remove_if(caches.begin(), caches.end(),
+                    [](const std::shared_ptr<Cache>& c) { return not c->budgeted; }),
+                caches.end());
+        return caches;
+    }
+
+    static std::vector<MemoryBudget::Account*> accountsOf(
+            const std::vector<std::shared_ptr<Cache>>& caches) {
+        std::vector<MemoryBudget::Account*> accounts;
+        for(auto& c : caches) accounts.push_back(&c->budget);
+        return accounts;
+    }
+
+    static std::vector<size_t> capacitiesOf(const std::vector<std::shared_ptr<Cache>>& caches) {
+        std::vector<size_t> capacities;
+        for(auto& c : caches) capacities.push_back(c->budget.capacity);
+        return capacities;
+    }
+
+    /**
+     * @brief Applies the capacities of the accounts that changed since
+     * before, shrinking caches before growing others so that the caches
+     * never use more than the budget.
+     */
+    static void applyCapacities(const std::vector<std::shared_ptr<Cache>>& caches,
+                                const std::vector<size_t>& before) {
+        for(size_t i = 0; i < caches.size(); i++)
+            if(caches[i]->budget.resizable && caches[i]->budget.capacity < before[i])
+                caches[i]->backend->setMemoryCapacity(caches[i]->budget.capacity);
+        for(size_t i = 0; i < caches.size(); i++)
+            if(caches[i]->budget.resizable && caches[i]->budget.capacity > before[i])
+                caches[i]->backend->setMemoryCapacity(caches[i]->budget.capacity);
+    }
+
+    /**
+     * @brief Moves memory across caches (see MemoryBudget::rebalance).
+     */
+    void rebalance() {
+        std::unique_lock<tl::mutex> lock(m_budget_mtx);
+        auto caches = budgetedCaches();
+        for(auto& cache : caches) {
+            Backend::MemoryProfile profile;
+            cache->backend->getMemoryProfile(&profile);
+            uint64_t requests = cache->metrics.requests();
+            cache->budget.gain     = profile.ghost_hits - cache->last_ghost_hits;
+            cache->budget.requests = requests - cache->last_requests;
+            cache->last_ghost_hits = profile.ghost_hits;
+            cache->last_requests   = requests;
+        }
+        auto before = capacitiesOf(caches);
+        m_budget->rebalance(accountsOf(caches));
+        applyCapacities(caches, before);
+        for(size_t i = 0; i < caches.size(); i++) {
+            if(caches[i]->budget.capacity == before[i]) continue;
+            spdlog::trace("[provider:{}] Memory budget: cache capacity changed from {} to {} bytes",
+                    id(), before[i], caches[i]->budget.capacity);
+        }
+    }
+
+    bool budgetStopping() {
+        std::unique_lock<tl::mutex> lock(m_budget_mtx);
+        return m_stopping;
+    }
+
+    void rebalancerLoop() {
+        while(!budgetStopping()) {
+            // sleep in slices so that the destructor does
+            // not wait for a whole rebalancing period
+            double slept = 0.0;
+            while(slept < m_rebalance_interval_ms && !budgetStopping()) {
+                double slice = std::min(100.0, m_rebalance_interval_ms - slept);
+                tl::thread::sleep(get_engine(), slice);
+                slept += slice;
+            }
+            if(slept >= m_rebalance_interval_ms && !budgetStopping())
+                rebalance();
+        }
+        std::unique_lock<tl::mutex> lock(m_budget_mtx);
+        m_rebalancer_running = false;
+        m_budget_cv.notify_all();
+    }
+
+    /**
+     * @brief Returns the abt-io instance used by snapshots,
+     * creating it the first time.
+     */
+    abt_io_instance_id snapshotIO() {
+        std::unique_lock<tl::mutex> lock(m_snapshot_mtx);
+        if(m_abtio == ABT_IO_INSTANCE_NULL) {
+            m_abtio = abt_io_init(static_cast<int>(m_snapshot_threads));
+            if(m_abtio == ABT_IO_INSTANCE_NULL)
+                throw Exception("Could not initialize abt-io for snapshots");
+        }
+        return m_abtio;
+    }
+
+    static uint64_t unixTimeMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Writes the entries of a cache to a snapshot file (see
+     * Snapshot.hpp) while the cache keeps serving requests. Dirty data
+     * is flushed first. The backend's scan feeds a snapshot::Writer,
+     * which keeps up to two chunks per abt-io xstream being written.
+     *
+     * @return a RequestResult whose value is the number of entries written.
+     */
+    RequestResult<uint64_t> writeSnapshot(Cache& cache, const std::string& path) {
+        RequestResult<uint64_t> result;
+        auto flushed = cache.backend->flush();
+        if(not flushed.success()) {
+            result.success() = false;
+            result.error() = "Could not flush the cache: "s + flushed.error();
+            return result;
+        }
+        try {
+            snapshot::Writer writer(snapshotIO(), path,
+                                    m_snapshot_chunk_bytes, 2*m_snapshot_threads);
+            std::string error;
+            auto scanned = cache.backend->scan(
+                [&writer, &error](const std::string& key, const std::string& value, uint64_t ttl_ms) {
+                    if(!error.empty()) return;
+                    try {
+                        writer.add(key, value, ttl_ms ? unixTimeMs() + ttl_ms : 0);
+                    } catch(const Exception& ex) {
+                        error = ex.what();
+                    }
+                });
+            if(not scanned.success()) error = scanned.error();
+            if(not error.empty()) throw Exception(error);
+            result.value() = writer.commit();
+        } catch(const Exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+        }
+        return result;
+    }
+
+    /**
+     * @brief Loads a snapshot into a cache. The chunks of the snapshot are
+     * read and inserted by m_snapshot_threads ULTs (the calling one and
+     * others in the bulk pool), each reading a chunk through abt-io and
+     * passing its entries to the backend's load() as one batch. Entries
+     * that expired since the snapshot are dropped, and keys already in the
+     * cache are kept, so the cache may serve requests meanwhile.
+     *
+     * @return a RequestResult whose value is the number of entries loaded.
+     */
+    RequestResult<uint64_t> restoreSnapshot(Cache& cache, const std::string& path) {
+        RequestResult<uint64_t> result;
+        cache.restore_state = Cache::Restoring;
+        std::unique_ptr<snapshot::Reader> reader;
+        try {
+            reader.reset(new snapshot::Reader(snapshotIO(), path));
+        } catch(const std::exception& ex) {
+            cache.restore_state = Cache::RestoreFailed;
+            result.success() = false;
+            result.error() = ex.what();
+            return result;
+        }
+        std::atomic<size_t>   next_chunk = { 0 };
+        std::atomic<uint64_t> loaded = { 0 };
+        std::atomic<bool>     failed = { false };
+        tl::mutex             error_mtx;
+        std::string           error;
+        auto fail = [&](const std::string& e) {
+            std::unique_lock<tl::mutex> lock(error_mtx);
+            if(!failed.exchange(true)) error = e;
+        };
+        auto work = [&]() {
+            std::vector<std::string> keys, values;
+            std::vector<uint64_t>    ttls;
+            size_t i;
+            while(!failed && (i = next_chunk++) < reader->numChunks()) {
+                keys.clear();
+                values.clear();
+                ttls.clear();
+                uint64_t now = unixTimeMs();
+                try {
+                    reader->readChunk(i, [&](std::string& key, std::string& value, uint64_t expiry_ms) {
+                        if(expiry_ms && expiry_ms <= now) return;
+                        keys.push_back(std::move(key));
+                        values.push_back(std::move(value));
+                        ttls.push_back(expiry_ms ? expiry_ms - now : 0);
+                    });
+                } catch(const std::exception& ex) {
+                    fail(ex.what());
+                    return;
+                }
+                auto r = cache.backend->load(keys, std::move(values), ttls);
+                if(not r.success()) {
+                    fail(r.error());
+                    return;
+                }
+                loaded += r.value();
+                cache.restored_entries += r.value();
+            }
+        };
+        size_t workers = std::min<size_t>(m_snapshot_threads, reader->numChunks());
+        std::vector<tl::managed<tl::thread>> threads;
+        for(size_t w = 1; w < workers; w++)
+            threads.push_back(m_bulk_pool.make_thread(work));
+        work();
+        for(auto& t : threads) t->join();
+        if(failed) {
+            cache.restore_state = Cache::RestoreFailed;
+            result.success() = false;
+            result.error() = error;
+            return result;
+        }
+        cache.restore_state = Cache::Restored;
+        result.value() = loaded.load();
+        return result;
+    }
+
+    /**
+     * @brief Restores a cache from a snapshot in a ULT of the bulk pool,
+     * while the cache serves requests. The outcome is reported by the
+     * cache's statistics and the provider's log.
+     */
+    void restoreInBackground(const UUID& cache_id, std::shared_ptr<Cache> cache,
+                             const std::string& path) {
         {
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);
+            std::unique_lock<tl::mutex> lock(m_snapshot_mtx);
+            m_restores_running += 1;
+        }
+        cache->restore_state = Cache::Restoring;
+        m_bulk_pool.make_thread([this, cache_id, cache, path]() {
+            auto result = restoreSnapshot(*cache, path);
+            if(result.success())
+                spdlog::trace("[provider:{}] Restored {} entries of cache {} from {}",
+                        id(), result.value(), cache_id.to_string(), path);
+            else
+                spdlog::error("[provider:{}] Could not restore cache {} from {}: {}",
+                        id(), cache_id.to_string(), path, result.error());
+            std::unique_lock<tl::mutex> lock(m_snapshot_mtx);
+            m_restores_running -= 1;
+            m_snapshot_cv.notify_all();
+        }, tl::anonymous());
+    }
 
-            if(m_backends.count(cache_id) == 0) {
-                result.success() = false;
-                result.error() = "Cache "s + cache_id.to_string() + " not found";
-                req.respond(result);
-                spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
-                return;
+    void snapshotCache(const tl::request& req,
+                       const std::string& token,
+                       const UUID& cache_id,
+                       const std::string& path) {
+        spdlog::trace("[provider:{}] Received snapshotCache request for cache {}",
+                id(), cache_id.to_string());
+        RequestResult<uint64_t> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        // the snapshot may take long: hold a reference rather
+        // than a read-side section of the registry
+        auto cache = m_caches.get(cache_id);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "Cache "s + cache_id.to_string() + " not found";
+            req.respond(result);
+            spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
+            return;
+        }
+        result = writeSnapshot(*cache, path);
+        if(not result.success())
+            spdlog::error("[provider:{}] Could not snapshot cache {} to {}: {}",
+                    id(), cache_id.to_string(), path, result.error());
+        req.respond(result);
+        spdlog::trace("[provider:{}] Wrote {} entries of cache {} to {}",
+                id(), result.value(), cache_id.to_string(), path);
+    }
+
+    void restoreCache(const tl::request& req,
+                      const std::string& token,
+                      const UUID& cache_id,
+                      const std::string& path) {
+        spdlog::trace("[provider:{}] Received restoreCache request for cache {}",
+                id(), cache_id.to_string());
+        RequestResult<uint64_t> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        auto cache = m_caches.get(cache_id);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "Cache "s + cache_id.to_string() + " not found";
+            req.respond(result);
+            spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
+            return;
+        }
+        result = restoreSnapshot(*cache, path);
+        if(not result.success())
+            spdlog::error("[provider:{}] Could not restore cache {} from {}: {}",
+                    id(), cache_id.to_string(), path, result.error());
+        req.respond(result);
+        spdlog::trace("[provider:{}] Restored {} entries of cache {} from {}",
+                id(), result.value(), cache_id.to_string(), path);
+    }
+
+    // Migrations. The source copies the entries of the cache to a cache
+    // created by the destination for the migration, while the source
+    // keeps serving requests and records the keys they write; it then
+    // sends these keys again, a few rounds at most, until few are left.
+    // The switchover removes the cache from the source's registry, which
+    // waits for in-flight requests; the last written keys are sent and
+    // the destination makes its cache visible. Requests that reach the
+    // source during the switchover wait for it to complete, then, like
+    // all later ones, receive a CacheMoved error with the new location.
+
+    /**
+     * @brief Records a key written while the cache migrates.
+     */
+    void trackWrite(Cache& cache, const std::string& key, uint64_t ttl_ms) {
+        if(not cache.tracking.load()) return;
+        uint64_t expiry_ms = ttl_ms ? unixTimeMs() + ttl_ms : 0;
+        std::unique_lock<tl::mutex> lock(cache.dirty_mtx);
+        cache.dirty[key] = expiry_ms;
+    }
+
+    void trackWrites(Cache& cache, const std::vector<std::string>& keys, uint64_t ttl_ms) {
+        if(not cache.tracking.load()) return;
+        uint64_t expiry_ms = ttl_ms ? unixTimeMs() + ttl_ms : 0;
+        std::unique_lock<tl::mutex> lock(cache.dirty_mtx);
+        for(auto& key : keys) cache.dirty[key] = expiry_ms;
+    }
+
+    /**
+     * @brief Called by requests that do not find their cache: if the cache
+     * is switching over to another provider, leaves the read-side section
+     * of the guard and waits until the switchover completes or fails.
+     *
+     * @return true if the guard was entered again and the cache should
+     * be looked up again.
+     */
+    bool awaitSwitchover(const UUID& cache_id, CacheRegistry<UUID, Cache>::ReadGuard& guard) {
+        std::unique_lock<tl::mutex> lock(m_migration_mtx);
+        auto switching = [this, &cache_id]() {
+            auto it = m_moved.find(cache_id);
+            return it != m_moved.end() && not it->second.committed;
+        };
+        if(not switching()) return false;
+        guard.leave();
+        m_migration_cv.wait(lock, [&switching]() { return not switching(); });
+        lock.unlock();
+        guard.enter();
+        return true;
+    }
+
+    /**
+     * @brief Sets location to where the cache migrated, if it did.
+     */
+    bool movedTo(const UUID& cache_id, std::string* location) {
+        std::unique_lock<tl::mutex> lock(m_migration_mtx);
+        auto it = m_moved.find(cache_id);
+        if(it == m_moved.end() || not it->second.committed) return false;
+        *location = it->second.location;
+        return true;
+    }
+
+    /**
+     * @brief Sends the current value of the keys written since the last
+     * call, or erases them at the destination if they are gone.
+     *
+     * @return the number of keys sent.
+     */
+    size_t sendWrites(const UUID& cache_id, Cache& cache, const tl::provider_handle& ph,
+                      const std::string& token, uint64_t* applied) {
+        std::unordered_map<std::string, uint64_t> dirty;
+        {
+            std::unique_lock<tl::mutex> lock(cache.dirty_mtx);
+            dirty.swap(cache.dirty);
+        }
+        if(dirty.empty()) return 0;
+        migration::Sender sender(get_engine(), m_migrate_batch, ph, token, cache_id, true,
+                                 m_migration_batch_bytes, m_migration_pipeline_depth);
+        uint64_t now = unixTimeMs();
+        for(auto& write : dirty) {
+            auto r = cache.backend->get(write.first);
+            if(r.success() && (write.second == 0 || write.second > now))
+                sender.add(write.first, r.value(), write.second);
+            else
+                sender.erase(write.first);
+        }
+        *applied += sender.finish();
+        return dirty.size();
+    }
+
+    /**
+     * @brief Migrates a cache to another provider (see above). On failure,
+     * the cache stays on this provider and the destination drops its copy.
+     *
+     * @return a RequestResult whose value is the number of entries
+     * inserted, updated or erased at the destination.
+     */
+    RequestResult<uint64_t> migrate(const UUID& cache_id, const std::shared_ptr<Cache>& cache,
+                                    const std::string& address, uint16_t provider_id,
+                                    const std::string& config, const std::string& token) {
+        // the final round of writes is sent while requests wait
+        static constexpr size_t kSwitchoverKeys = 1024;
+        RequestResult<uint64_t> result;
+        result.value() = 0;
+        tl::provider_handle ph;
+        bool begun = false, switching = false, removed = false;
+        try {
+            ph = tl::provider_handle(m_endpoints->lookup(get_engine(), address), provider_id);
+            RequestResult<bool> begin = m_migrate_begin.on(ph)(
+                token, cache_id, cache->type, config.empty() ? cache->config.dump() : config);
+            if(not begin.success()) throw Exception(begin.error());
+            begun = true;
+
+            cache->tracking = true;
+            auto flushed = cache->backend->flush();
+            if(not flushed.success())
+                throw Exception("Could not flush the cache: "s + flushed.error());
+            {
+                migration::Sender sender(get_engine(), m_migrate_batch, ph, token, cache_id, false,
+                                         m_migration_batch_bytes, m_migration_pipeline_depth);
+                std::string error;
+                auto scanned = cache->backend->scan(
+                    [&sender, &error](const std::string& key, const std::string& value, uint64_t ttl_ms) {
+                        if(!error.empty()) return;
+                        try {
+                            sender.add(key, value, ttl_ms ? unixTimeMs() + ttl_ms : 0);
+                        } catch(const Exception& ex) {
+                            error = ex.what();
+                        }
+                    });
+                if(not scanned.success()) error = scanned.error();
+                if(not error.empty()) throw Exception(error);
+                result.value() += sender.finish();
+            }
+            for(unsigned round = 0; round < m_migration_max_rounds; round++) {
+                if(sendWrites(cache_id, *cache, ph, token, &result.value()) <= kSwitchoverKeys)
+                    break;
             }
 
-            result = m_backends[cache_id]->destroy();
-            m_backends.erase(cache_id);
+            {
+                std::unique_lock<tl::mutex> lock(m_migration_mtx);
+                m_moved[cache_id] = Moved{ false, std::to_string(provider_id) + "@" + address };
+            }
+            switching = true;
+            // returns once no request can reach the cache
+            removed = static_cast<bool>(m_caches.erase(cache_id));
+            if(not removed) throw Exception("Cache was closed during its migration");
+            // near caches must stop serving their copies before requests
+            // are released to the destination, and no request can grant
+            // a new lease from now on
+            revokeAllLeases(cache_id);
+            sendWrites(cache_id, *cache, ph, token, &result.value());
+            RequestResult<bool> commit = m_migrate_commit.on(ph)(token, cache_id);
+            if(not commit.success()) throw Exception(commit.error());
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = "Could not migrate cache: "s + ex.what();
+            cache->tracking = false;
+            {
+                std::unique_lock<tl::mutex> lock(cache->dirty_mtx);
+                cache->dirty.clear();
+            }
+            if(removed) m_caches.insert(cache_id, cache);
+            if(switching) {
+                std::unique_lock<tl::mutex> lock(m_migration_mtx);
+                m_moved.erase(cache_id);
+                m_migration_cv.notify_all();
+            }
+            if(begun) {
+                try {
+                    RequestResult<bool> aborted = m_migrate_abort.on(ph)(token, cache_id);
+                    (void)aborted;
+                } catch(const std::exception&) {}
+            }
+            cache->migrating = false;
+            return result;
         }
+        {
+            std::unique_lock<tl::mutex> lock(m_migration_mtx);
+            m_moved[cache_id].committed = true;
+            m_migration_cv.notify_all();
+        }
+        auto destroyed = cache->backend->destroy();
+        if(not destroyed.success())
+            spdlog::warn("[provider:{}] Could not destroy the source of migrated cache {}: {}",
+                    id(), cache_id.to_string(), destroyed.error());
+        return result;
+    }
 
+    void migrateCache(const tl::request& req,
+                      const std::string& token,
+                      const UUID& cache_id,
+                      const std::string& address,
+                      uint16_t provider_id,
+                      const std::string& config) {
+        spdlog::trace("[provider:{}] Received migrateCache request for cache {} to {}@{}",
+                id(), cache_id.to_string(), provider_id, address);
+        RequestResult<uint64_t> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        auto cache = m_caches.get(cache_id);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "Cache "s + cache_id.to_string() + " not found";
+            req.respond(result);
+            spdlog::error("[provider:{}] Cache {} not found", id(), cache_id.to_string());
+            return;
+        }
+        if(cache->migrating.exchange(true)) {
+            result.success() = false;
+            result.error() = "Cache "s + cache_id.to_string() + " is already migrating";
+            req.respond(result);
+            spdlog::error("[provider:{}] Cache {} is already migrating", id(), cache_id.to_string());
+            return;
+        }
+        result = migrate(cache_id, cache, address, provider_id, config, token);
+        if(not result.success())
+            spdlog::error("[provider:{}] Could not migrate cache {} to {}@{}: {}",
+                    id(), cache_id.to_string(), provider_id, address, result.error());
+        req.respond(result);
+        spdlog::trace("[provider:{}] Migrated cache {} to {}@{}",
+                id(), cache_id.to_string(), provider_id, address);
+    }
+
+    void migrateBegin(const tl::request& req,
+                      const std::string& token,
+                      const UUID& cache_id,
+                      const std::string& cache_type,
+                      const std::string& cache_config) {
+        spdlog::trace("[provider:{}] Received migrateBegin request for cache {}",
+                id(), cache_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        json json_config;
+        std::unique_ptr<Backend> backend;
+        try {
+            json_config = json::parse(cache_config);
+            backend = CacheFactory::createCache(cache_type, get_engine(), json_config);
+            if(not backend) throw Exception("Unknown cache type "s + cache_type);
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            spdlog::error("[provider:{}] Could not create migrating cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            req.respond(result);
+            return;
+        }
+
+        auto cache = std::make_shared<Cache>(std::move(backend), cache_type, json_config);
+        bool exists = static_cast<bool>(m_caches.get(cache_id));
+        if(not exists) {
+            std::unique_lock<tl::mutex> lock(m_migration_mtx);
+            exists = not m_incoming.emplace(cache_id, cache).second;
+        }
+        if(exists) {
+            cache->backend->destroy();
+            result.success() = false;
+            result.error() = "Cache "s + cache_id.to_string() + " already exists on the destination";
+            spdlog::error("[provider:{}] Migrating cache {} already exists", id(), cache_id.to_string());
+        }
+        req.respond(result);
+    }
+
+    std::shared_ptr<Cache> incomingCache(const UUID& cache_id, bool remove) {
+        std::unique_lock<tl::mutex> lock(m_migration_mtx);
+        auto it = m_incoming.find(cache_id);
+        if(it == m_incoming.end()) return nullptr;
+        auto cache = it->second;
+        if(remove) m_incoming.erase(it);
+        return cache;
+    }
+
+    void migrateBatch(const tl::request& req,
+                      const std::string& token,
+                      const UUID& cache_id,
+                      tl::bulk& remote_bulk,
+                      uint64_t size,
+                      uint64_t entries,
+                      bool overwrite) {
+        spdlog::trace("[provider:{}] Received migrateBatch request for cache {}",
+                id(), cache_id.to_string());
+        // see Migration.hpp for the two modes of batches
+        RequestResult<uint64_t> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        auto cache = incomingCache(cache_id, false);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "No migration of cache "s + cache_id.to_string() + " in progress";
+            req.respond(result);
+            spdlog::error("[provider:{}] No migration of cache {} in progress", id(), cache_id.to_string());
+            return;
+        }
+
+        std::vector<std::string> keys, values;
+        std::vector<uint64_t>    ttls;
+        uint64_t applied = 0;
+        try {
+            if(size > remote_bulk.size())
+                throw Exception("Invalid size for the bulk region provided");
+            std::string buffer(size, '\0');
+            if(size != 0) {
+                std::vector<std::pair<void*, size_t>> segment = {{ &buffer[0], buffer.size() }};
+                auto local_bulk = get_engine().expose(segment, tl::bulk_mode::write_only);
+                remote_bulk(0, size).on(req.get_endpoint()) >> local_bulk;
+            }
+            uint64_t now = unixTimeMs();
+            bool valid = snapshot::parseRecords(buffer.data(), buffer.size(), entries,
+                [&](std::string& key, std::string& value, uint64_t expiry_ms) {
+                    bool expired = expiry_ms && expiry_ms <= now;
+                    if(not overwrite) {
+                        if(expired) return;
+                        keys.push_back(std::move(key));
+                        values.push_back(std::move(value));
+                        ttls.push_back(expiry_ms ? expiry_ms - now : 0);
+                    } else if(expired) {
+                        cache->backend->erase(key);
+                        applied += 1;
+                    } else {
+                        auto r = cache->backend->putWithTTL(key, std::move(value),
+                                                            expiry_ms ? expiry_ms - now : 0);
+                        if(not r.success()) throw Exception(r.error());
+                        applied += 1;
+                    }
+                });
+            if(not valid) throw Exception("Corrupted migration batch");
+            if(not overwrite) {
+                auto r = cache->backend->load(keys, std::move(values), ttls);
+                if(not r.success()) throw Exception(r.error());
+                applied = r.value();
+            }
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] migrateBatch failed for cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            return;
+        }
+        result.value() = applied;
         req.respond(result);
-        spdlog::trace("[provider:{}] Cache {} successfully destroyed", id(), cache_id.to_string());
+    }
+
+    void migrateCommit(const tl::request& req,
+                       const std::string& token,
+                       const UUID& cache_id) {
+        spdlog::trace("[provider:{}] Received migrateCommit request for cache {}",
+                id(), cache_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        auto cache = incomingCache(cache_id, true);
+        if(not cache) {
+            result.success() = false;
+            result.code() = ResultCode::CacheNotFound;
+            result.error() = "No migration of cache "s + cache_id.to_string() + " in progress";
+            req.respond(result);
+            spdlog::error("[provider:{}] No migration of cache {} in progress", id(), cache_id.to_string());
+            return;
+        }
+        // the cache gets its share of the memory budget (if any) now
+        std::string error;
+        if(not addCache(cache_id, cache, &error)) {
+            cache->backend->destroy();
+            result.success() = false;
+            result.error() = std::move(error);
+            req.respond(result);
+            spdlog::error("[provider:{}] Could not add migrated cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            return;
+        }
+        {
+            // the cache may be coming back to this provider
+            std::unique_lock<tl::mutex> lock(m_migration_mtx);
+            m_moved.erase(cache_id);
+            m_migration_cv.notify_all();
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Cache {} migrated to this provider", id(), cache_id.to_string());
+    }
+
+    void migrateAbort(const tl::request& req,
+                      const std::string& token,
+                      const UUID& cache_id) {
+        spdlog::trace("[provider:{}] Received migrateAbort request for cache {}",
+                id(), cache_id.to_string());
+        RequestResult<bool> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.code() = ResultCode::InvalidToken;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            spdlog::error("[provider:{}] Invalid security token {}", id(), token);
+            return;
+        }
+
+        // in-flight batches hold their own reference to the cache
+        auto cache = incomingCache(cache_id, true);
+        if(cache) cache->backend->destroy();
+        req.respond(result);
+    }
+
+    /**
+     * @brief Returns the statistics of a cache: the provider's counters
+     * and latency histograms (see CacheMetrics), the number of entries,
+     * bytes stored and evictions if the backend reports them, and all
+     * the backend's statistics under "backend".
+     */
+    static json cacheStats(const Cache& cache) {
+        json stats = cache.metrics.toJson();
+        json backend = cache.backend->getStats();
+        for(auto& field : { std::make_pair("entries", "entries"),
+                            std::make_pair("bytes", "bytes_stored"),
+                            std::make_pair("logical_bytes", "bytes_logical"),
+                            std::make_pair("evictions", "evictions"),
+                            std::make_pair("expirations", "expirations") }) {
+            if(backend.contains(field.first) && backend[field.first].is_number())
+                stats[field.second] = backend[field.first];
+        }
+        stats["backend"] = std::move(backend);
+        int restore_state = cache.restore_state.load();
+        if(restore_state != Cache::NotRestored) {
+            static const char* states[] = { "none", "restoring", "restored", "failed" };
+            stats["restore"] = {
+                { "state",   states[restore_state] },
+                { "entries", cache.restored_entries.load() }
+            };
+        }
+        return stats;
+    }
+
+    void getStats(const tl::request& req,
+                  const UUID& cache_id) {
+        spdlog::trace("[provider:{}] Received getStats request for cache {}", id(), cache_id.to_string());
+        RequestResult<std::string> result;
+        FIND_CACHE(cache);
+        result.value() = cacheStats(*cache_entry).dump();
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed getStats on cache {}", id(), cache_id.to_string());
     }
 
     void checkCache(const tl::request& req,
@@ -304,11 +1485,460 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
         spdlog::trace("[provider:{}] Received sayHello request for cache {}", id(), cache_id.to_string());
         RequestResult<int32_t> result;
         FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::COMPUTE_SUM);
         result = cache->computeSum(x, y);
         req.respond(result);
         spdlog::trace("[provider:{}] Successfully executed computeSum on cache {}", id(), cache_id.to_string());
     }
 
+    void put(const tl::request& req,
+             const UUID& cache_id,
+             const std::string& key,
+             std::string& value,
+             uint64_t ttl_ms) {
+        spdlog::trace("[provider:{}] Received put request for cache {}", id(), cache_id.to_string());
+        RequestResult<bool> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::PUT);
+        cache_metrics.bytesIn(key.size() + value.size());
+        result = cache->putWithTTL(key, std::move(value), ttl_ms);
+        trackWrite(*cache_entry, key, ttl_ms);
+        revokeLeases(cache_id, key, cache_guard);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed put on cache {}", id(), cache_id.to_string());
+    }
+
+    void putBulk(const tl::request& req,
+                 const UUID& cache_id,
+                 const std::string& key,
+                 tl::bulk& remote_bulk,
+                 uint64_t ttl_ms) {
+        spdlog::trace("[provider:{}] Received putBulk request for cache {}", id(), cache_id.to_string());
+        RequestResult<bool> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::PUT);
+        std::string value(remote_bulk.size(), '\0');
+        try {
+            std::vector<std::pair<void*, size_t>> segment = {{ &value[0], value.size() }};
+            auto local_bulk = get_engine().expose(segment, tl::bulk_mode::write_only);
+            remote_bulk.on(req.get_endpoint()) >> local_bulk;
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] Bulk pull failed for cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            return;
+        }
+        cache_metrics.bytesIn(key.size() + value.size());
+        result = cache->putWithTTL(key, std::move(value), ttl_ms);
+        trackWrite(*cache_entry, key, ttl_ms);
+        revokeLeases(cache_id, key, cache_guard);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed putBulk on cache {}", id(), cache_id.to_string());
+    }
+
+    void get(const tl::request& req,
+             const UUID& cache_id,
+             const std::string& key,
+             uint64_t eager_limit,
+             bool compressed) {
+        spdlog::trace("[provider:{}] Received get request for cache {}", id(), cache_id.to_string());
+        // The value holds the size of the stored value and, if this size
+        // does not exceed eager_limit, its content. Larger values are
+        // left for the client to fetch via cachersize_get_bulk. If
+        // compressed is true, the value is sent as a compression frame
+        // for the client to decompress.
+        RequestResult<std::pair<uint64_t, std::string>> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::GET);
+        cache_metrics.bytesIn(key.size());
+        auto r = compressed ? cache->getCompressed(key) : cache->get(key);
+        if(not r.success()) {
+            cache_metrics.misses(1);
+            result.success() = false;
+            result.code() = r.code();
+            result.error() = std::move(r.error());
+        } else {
+            cache_metrics.hits(1);
+            result.value().first = r.value().size();
+            if(r.value().size() <= eager_limit)
+                result.value().second = std::move(r.value());
+            cache_metrics.bytesOut(result.value().second.size());
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed get on cache {}", id(), cache_id.to_string());
+    }
+
+    void getBulk(const tl::request& req,
+                 const UUID& cache_id,
+                 const std::string& key,
+                 tl::bulk& remote_bulk,
+                 bool compressed) {
+        spdlog::trace("[provider:{}] Received getBulk request for cache {}", id(), cache_id.to_string());
+        // The value is the actual size of the stored value. Only
+        // min(size, remote_bulk.size()) bytes are pushed, so a client
+        // that receives a size larger than its buffer should retry.
+        RequestResult<uint64_t> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::GET);
+        auto r = compressed ? cache->getCompressed(key) : cache->get(key);
+        if(not r.success()) {
+            result.success() = false;
+            result.code() = r.code();
+            result.error() = std::move(r.error());
+            req.respond(result);
+            return;
+        }
+        auto& value = r.value();
+        result.value() = value.size();
+        size_t size = std::min<size_t>(value.size(), remote_bulk.size());
+        if(size != 0) {
+            try {
+                std::vector<std::pair<void*, size_t>> segment = {{ &value[0], size }};
+                auto local_bulk = get_engine().expose(segment, tl::bulk_mode::read_only);
+                local_bulk >> remote_bulk.on(req.get_endpoint());
+                cache_metrics.bytesOut(size);
+            } catch(const std::exception& ex) {
+                result.success() = false;
+                result.error() = ex.what();
+                spdlog::error("[provider:{}] Bulk push failed for cache {}: {}",
+                        id(), cache_id.to_string(), result.error());
+            }
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed getBulk on cache {}", id(), cache_id.to_string());
+    }
+
+    void erase(const tl::request& req,
+               const UUID& cache_id,
+               const std::string& key) {
+        spdlog::trace("[provider:{}] Received erase request for cache {}", id(), cache_id.to_string());
+        RequestResult<bool> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::ERASE);
+        cache_metrics.bytesIn(key.size());
+        result = cache->erase(key);
+        trackWrite(*cache_entry, key, 0);
+        revokeLeases(cache_id, key, cache_guard);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed erase on cache {}", id(), cache_id.to_string());
+    }
+
+    void exists(const tl::request& req,
+                const UUID& cache_id,
+                const std::string& key) {
+        spdlog::trace("[provider:{}] Received exists request for cache {}", id(), cache_id.to_string());
+        RequestResult<uint8_t> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::EXISTS);
+        cache_metrics.bytesIn(key.size());
+        result = cache->exists(key);
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed exists on cache {}", id(), cache_id.to_string());
+    }
+
+    void getLeased(const tl::request& req,
+                   const UUID& cache_id,
+                   const std::string& key,
+                   uint64_t eager_limit,
+                   const std::string& address,
+                   uint64_t near_cache_id) {
+        spdlog::trace("[provider:{}] Received getLeased request for cache {}", id(), cache_id.to_string());
+        // Same as get, but the value is sent along with a lease during
+        // which the client's near cache may serve it. The lease is
+        // recorded before the value is read, so that any write that the
+        // read does not observe revokes it. Clients whose engine is not
+        // listening (empty address) cannot be notified and only rely on
+        // the lease expiring.
+        RequestResult<LeasedValue> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::GET_LEASED);
+        if(m_lease_duration > 0 && not address.empty())
+            m_leases.grant(cache_id, key, address, near_cache_id,
+                           tl::timer::wtime() + m_lease_duration);
+        cache_metrics.bytesIn(key.size());
+        auto r = cache->get(key);
+        if(not r.success()) {
+            cache_metrics.misses(1);
+            result.success() = false;
+            result.code() = r.code();
+            result.error() = std::move(r.error());
+        } else {
+            cache_metrics.hits(1);
+            result.value().size = r.value().size();
+            if(r.value().size() <= eager_limit) {
+                result.value().value = std::move(r.value());
+                result.value().lease = m_lease_duration;
+            }
+            cache_metrics.bytesOut(result.value().value.size());
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed getLeased on cache {}", id(), cache_id.to_string());
+    }
+
+    // Leases. Writes revoke the leases held on the keys they modify
+    // before responding, so that once a write completes no near cache
+    // can serve the previous value.
+
+    void revokeLeases(const UUID& cache_id, const std::string& key,
+                      CacheRegistry<UUID, Cache>::ReadGuard& guard) {
+        if(not m_leases.active()) return;
+        notifyHolders(cache_id, m_leases.revoke(cache_id, { key }), &guard);
+    }
+
+    void revokeLeases(const UUID& cache_id, const std::vector<std::string>& keys,
+                      CacheRegistry<UUID, Cache>::ReadGuard& guard) {
+        if(not m_leases.active()) return;
+        notifyHolders(cache_id, m_leases.revoke(cache_id, keys), &guard);
+    }
+
+    void revokeAllLeases(const UUID& cache_id) {
+        if(not m_leases.active()) return;
+        notifyHolders(cache_id, m_leases.revokeAll(cache_id));
+    }
+
+    /**
+     * @brief Sends cachersize_invalidate to the holders of revoked
+     * leases and waits for their acknowledgement. A holder that cannot
+     * be reached before its lease expires may still be serving the
+     * value, so in that case we wait for the lease to expire instead.
+     * When called from a request handler, the handler's read guard is
+     * left (keeping the cache alive) before waiting, so that a holder
+     * that does not answer cannot block the removal of caches.
+     */
+    void notifyHolders(const UUID& cache_id,
+                       const std::vector<LeaseTable::Revocation>& revocations,
+                       CacheRegistry<UUID, Cache>::ReadGuard* guard = nullptr) {
+        if(revocations.empty()) return;
+        std::vector<tl::async_response> responses;
+        std::vector<const LeaseTable::Revocation*> notified;
+        double wait_until = 0.0;
+        for(auto& r : revocations) {
+            double remaining = r.expiry - tl::timer::wtime();
+            if(remaining <= 0) continue;
+            try {
+                auto ph = tl::provider_handle(
+                    m_endpoints->lookup(get_engine(), r.address), NEAR_CACHE_PROVIDER_ID);
+                responses.push_back(m_invalidate.on(ph).timed_async(
+                    std::chrono::duration<double>(remaining), r.near_cache_id, r.keys));
+                notified.push_back(&r);
+            } catch(const std::exception& ex) {
+                spdlog::warn("[provider:{}] Could not revoke lease of {} on cache {}: {}",
+                        id(), r.address, cache_id.to_string(), ex.what());
+                m_endpoints->invalidate(r.address);
+                wait_until = std::max(wait_until, r.expiry);
+            }
+        }
+        // an unresponsive holder may keep us waiting until its lease
+        // expires, during which the cache must remain removable
+        if(guard && (not responses.empty() || wait_until > 0.0))
+            guard->pinAndLeave(cache_id);
+        for(size_t i = 0; i < responses.size(); i++) {
+            try {
+                responses[i].wait();
+            } catch(const std::exception& ex) {
+                auto& r = *notified[i];
+                spdlog::warn("[provider:{}] Could not revoke lease of {} on cache {}: {}",
+                        id(), r.address, cache_id.to_string(), ex.what());
+                m_endpoints->invalidate(r.address);
+                wait_until = std::max(wait_until, r.expiry);
+            }
+        }
+        double remaining = wait_until - tl::timer::wtime();
+        if(remaining > 0)
+            tl::thread::sleep(get_engine(), remaining * 1000.0);
+    }
+
+    // Batched operations. The client packs all the keys (then, for
+    // putMulti, all the values) into a single contiguous bulk region
+    // and sends their sizes as RPC arguments. Per-item statuses are
+    // sent back as one byte each (see cachersize::Status).
+
+    /**
+     * @brief Pulls the first size bytes of a remote bulk region
+     * into buffer and splits them into strings of the given sizes.
+     * Throws if the sizes do not add up to at most size.
+     */
+    void unpackBulk(const tl::request& req,
+                    tl::bulk& remote_bulk,
+                    size_t size,
+                    const std::vector<std::vector<uint64_t>*>& sizes,
+                    const std::vector<std::vector<std::string>*>& outputs) {
+        uint64_t total = 0;
+        for(auto s : sizes)
+            for(auto n : *s) total += n;
+        if(total > size || size > remote_bulk.size())
+            throw Exception("Invalid item sizes for the bulk region provided");
+        std::string buffer(size, '\0');
+        if(size != 0) {
+            std::vector<std::pair<void*, size_t>> segment = {{ &buffer[0], size }};
+            auto local_bulk = get_engine().expose(segment, tl::bulk_mode::write_only);
+            remote_bulk(0, size).on(req.get_endpoint()) >> local_bulk;
+        }
+        size_t offset = 0;
+        for(size_t i = 0; i < sizes.size(); i++) {
+            outputs[i]->reserve(sizes[i]->size());
+            for(auto n : *sizes[i]) {
+                outputs[i]->emplace_back(buffer, offset, n);
+                offset += n;
+            }
+        }
+    }
+
+    static std::vector<uint8_t> toWire(const std::vector<Status>& status) {
+        std::vector<uint8_t> result(status.size());
+        for(size_t i = 0; i < status.size(); i++)
+            result[i] = static_cast<uint8_t>(status[i]);
+        return result;
+    }
+
+    void putMulti(const tl::request& req,
+                  const UUID& cache_id,
+                  std::vector<uint64_t>& key_sizes,
+                  std::vector<uint64_t>& value_sizes,
+                  tl::bulk& remote_bulk,
+                  uint64_t ttl_ms) {
+        spdlog::trace("[provider:{}] Received putMulti request for cache {}", id(), cache_id.to_string());
+        RequestResult<std::vector<uint8_t>> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::PUT_MULTI);
+        std::vector<std::string> keys, values;
+        try {
+            if(key_sizes.size() != value_sizes.size())
+                throw Exception("Number of keys and values differ");
+            unpackBulk(req, remote_bulk, remote_bulk.size(),
+                       { &key_sizes, &value_sizes }, { &keys, &values });
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] putMulti failed for cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            return;
+        }
+        cache_metrics.bytesIn(remote_bulk.size());
+        auto r = cache->putMultiWithTTL(keys, std::move(values), ttl_ms);
+        trackWrites(*cache_entry, keys, ttl_ms);
+        revokeLeases(cache_id, keys, cache_guard);
+        if(not r.success()) {
+            result.success() = false;
+            result.code() = r.code();
+            result.error() = std::move(r.error());
+        } else {
+            result.value() = toWire(r.value());
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed putMulti on cache {}", id(), cache_id.to_string());
+    }
+
+    void getMulti(const tl::request& req,
+                  const UUID& cache_id,
+                  std::vector<uint64_t>& key_sizes,
+                  tl::bulk& remote_bulk,
+                  uint64_t keys_size,
+                  bool compressed) {
+        spdlog::trace("[provider:{}] Received getMulti request for cache {}", id(), cache_id.to_string());
+        // The remote bulk region holds the packed keys (keys_size bytes)
+        // followed by a receive area. Values are pushed back-to-back into
+        // the receive area in the order of the keys, for as long as they
+        // fit; the others are marked Status::Deferred for the client to
+        // fetch individually. The value holds the statuses and the sizes
+        // of the values found.
+        RequestResult<std::pair<std::vector<uint8_t>, std::vector<uint64_t>>> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::GET_MULTI);
+        std::vector<std::string> keys, values;
+        try {
+            unpackBulk(req, remote_bulk, keys_size, { &key_sizes }, { &keys });
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] getMulti failed for cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            return;
+        }
+        cache_metrics.bytesIn(keys_size);
+        auto r = compressed ? cache->getMultiCompressed(keys, &values)
+                            : cache->getMulti(keys, &values);
+        if(not r.success()) {
+            result.success() = false;
+            result.code() = r.code();
+            result.error() = std::move(r.error());
+            req.respond(result);
+            return;
+        }
+        auto& status = result.value().first;
+        auto& sizes  = result.value().second;
+        status = toWire(r.value());
+        sizes.resize(keys.size(), 0);
+        size_t capacity = remote_bulk.size() - keys_size;
+        size_t used = 0;
+        std::vector<std::pair<void*, size_t>> segments;
+        cache_metrics.hits(std::count(r.value().begin(), r.value().end(), Status::OK));
+        cache_metrics.misses(std::count(r.value().begin(), r.value().end(), Status::NotFound));
+        for(size_t i = 0; i < keys.size(); i++) {
+            if(r.value()[i] != Status::OK) continue;
+            sizes[i] = values[i].size();
+            if(used + values[i].size() > capacity) {
+                status[i] = static_cast<uint8_t>(Status::Deferred);
+                continue;
+            }
+            if(not values[i].empty())
+                segments.emplace_back(&values[i][0], values[i].size());
+            used += values[i].size();
+        }
+        if(used != 0) {
+            try {
+                auto local_bulk = get_engine().expose(segments, tl::bulk_mode::read_only);
+                local_bulk(0, used) >> remote_bulk(keys_size, used).on(req.get_endpoint());
+                cache_metrics.bytesOut(used);
+            } catch(const std::exception& ex) {
+                result.success() = false;
+                result.error() = ex.what();
+                spdlog::error("[provider:{}] Bulk push failed for cache {}: {}",
+                        id(), cache_id.to_string(), result.error());
+            }
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed getMulti on cache {}", id(), cache_id.to_string());
+    }
+
+    void eraseMulti(const tl::request& req,
+                    const UUID& cache_id,
+                    std::vector<uint64_t>& key_sizes,
+                    tl::bulk& remote_bulk) {
+        spdlog::trace("[provider:{}] Received eraseMulti request for cache {}", id(), cache_id.to_string());
+        RequestResult<std::vector<uint8_t>> result;
+        FIND_CACHE(cache);
+        auto timer = cache_metrics.time(CacheMetrics::ERASE_MULTI);
+        std::vector<std::string> keys;
+        try {
+            unpackBulk(req, remote_bulk, remote_bulk.size(), { &key_sizes }, { &keys });
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            req.respond(result);
+            spdlog::error("[provider:{}] eraseMulti failed for cache {}: {}",
+                    id(), cache_id.to_string(), result.error());
+            return;
+        }
+        cache_metrics.bytesIn(remote_bulk.size());
+        auto r = cache->eraseMulti(keys);
+        trackWrites(*cache_entry, keys, 0);
+        revokeLeases(cache_id, keys, cache_guard);
+        if(not r.success()) {
+            result.success() = false;
+            result.code() = r.code();
+            result.error() = std::move(r.error());
+        } else {
+            result.value() = toWire(r.value());
+        }
+        req.respond(result);
+        spdlog::trace("[provider:{}] Successfully executed eraseMulti on cache {}", id(), cache_id.to_string());
+    }
+
 };
 
 }
@@ -0,0 +1,403 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_SNAPSHOT_HPP
+#define __CACHERSIZE_SNAPSHOT_HPP
+
+#include <cachersize/Exception.hpp>
+#include <abt-io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cachersize {
+
+/**
+ * Snapshot files hold the entries of a cache in a format meant to be
+ * loaded in parallel:
+ *
+ *     [header][chunk 0][chunk 1]...[chunk n-1][index]
+ *
+ * The header holds a magic string, the number of chunks and of entries,
+ * and the offset of the index, which holds the offset, size and number
+ * of entries of each chunk. A chunk is a sequence of records
+ *
+ *     [u32 key size][u32 value size][u64 expiry][key][value]
+ *
+ * where expiry is the time, in milliseconds since the Unix epoch, at
+ * which the entry expires (0 if it does not), so that the time spent
+ * between a snapshot and its restoration counts against the entries'
+ * TTL. Integers are in the byte order of the host: snapshots are meant
+ * to restart a server on the same kind of machine, not to be exchanged.
+ * The same records carry the entries of a cache that migrates from a
+ * provider to another (see Migration.hpp).
+ */
+namespace snapshot {
+
+static constexpr char     kMagic[8] = { 'C', 'S', 'Z', 'S', 'N', 'A', 'P', '1' };
+static constexpr size_t   kHeaderSize = 32;
+static constexpr size_t   kIndexEntrySize = 24;
+static constexpr size_t   kRecordHeaderSize = 16;
+
+struct ChunkInfo {
+    uint64_t offset  = 0;
+    uint64_t size    = 0;
+    uint64_t entries = 0;
+};
+
+inline void appendU32(std::string& out, uint32_t x) {
+    out.append(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+
+inline void appendU64(std::string& out, uint64_t x) {
+    out.append(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+
+inline uint32_t readU32(const char* p) {
+    uint32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+inline uint64_t readU64(const char* p) {
+    uint64_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+/**
+ * @brief Appends a record. Throws if the value is too large.
+ *
+ * @param expiry_ms expiry time in milliseconds since the Unix epoch, or 0.
+ */
+inline void appendRecord(std::string& out, const std::string& key,
+                         const std::string& value, uint64_t expiry_ms) {
+    if(value.size() > UINT32_MAX || key.size() > UINT32_MAX)
+        throw Exception("Entry of key \"" + key + "\" is too large for a record");
+    appendU32(out, static_cast<uint32_t>(key.size()));
+    appendU32(out, static_cast<uint32_t>(value.size()));
+    appendU64(out, expiry_ms);
+    out.append(key);
+    out.append(value);
+}
+
+/**
+ * @brief Calls f(key, value, expiry_ms) on each of the first entries
+ * records of data. The strings passed to f may be moved from.
+ *
+ * @return false if data does not hold that many well-formed records.
+ */
+template<typename F>
+bool parseRecords(const char* data, size_t size, uint64_t entries, F&& f) {
+    std::string key, value;
+    size_t pos = 0;
+    for(uint64_t n = 0; n < entries; n++) {
+        if(size - pos < kRecordHeaderSize) return false;
+        uint32_t ksize     = readU32(data + pos);
+        uint32_t vsize     = readU32(data + pos + 4);
+        uint64_t expiry_ms = readU64(data + pos + 8);
+        pos += kRecordHeaderSize;
+        if(size - pos < static_cast<size_t>(ksize) + vsize) return false;
+        key.assign(data + pos, ksize);
+        value.assign(data + pos + ksize, vsize);
+        pos += static_cast<size_t>(ksize) + vsize;
+        f(key, value, expiry_ms);
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a snapshot file. Records are appended to a chunk in
+ * memory; full chunks are written with non-blocking abt-io writes, at
+ * offsets reserved in the order the chunks are sealed, so that up to
+ * max_pending chunks are written in parallel by the abt-io xstreams
+ * while the caller fills the next ones.
+ *
+ * The snapshot is written to "<path>.tmp" and renamed to path by
+ * commit(), so a snapshot interrupted by an error or a crash never
+ * replaces the previous one. Methods throw an Exception on error.
+ */
+class Writer {
+
+    struct PendingWrite {
+        std::string  data;
+        abt_io_op_t* op  = nullptr;
+        ssize_t      ret = 0;
+    };
+
+    abt_io_instance_id                        m_abtio;
+    std::string                               m_path;
+    std::string                               m_tmp_path;
+    int                                       m_fd = -1;
+    size_t                                    m_chunk_bytes;
+    size_t                                    m_max_pending;
+    std::string                               m_chunk;
+    uint64_t                                  m_chunk_entries = 0;
+    uint64_t                                  m_offset = kHeaderSize;
+    uint64_t                                  m_entries = 0;
+    std::vector<ChunkInfo>                    m_index;
+    std::deque<std::unique_ptr<PendingWrite>> m_pending;
+    std::string                               m_error;
+
+    void waitOldest() {
+        auto& w = *m_pending.front();
+        abt_io_op_wait(w.op);
+        abt_io_op_free(w.op);
+        if(w.ret != static_cast<ssize_t>(w.data.size()) && m_error.empty())
+            m_error = "Could not write snapshot " + m_tmp_path + ": "
+                    + (w.ret < 0 ? std::strerror(static_cast<int>(-w.ret)) : "short write");
+        m_pending.pop_front();
+    }
+
+    void waitAll() {
+        while(!m_pending.empty()) waitOldest();
+        if(!m_error.empty()) throw Exception(m_error);
+    }
+
+    void writeAt(const std::string& data, uint64_t offset) {
+        ssize_t ret = abt_io_pwrite(m_abtio, m_fd, data.data(), data.size(),
+                                    static_cast<off_t>(offset));
+        if(ret != static_cast<ssize_t>(data.size()))
+            throw Exception("Could not write snapshot " + m_tmp_path + ": "
+                    + (ret < 0 ? std::strerror(static_cast<int>(-ret)) : "short write"));
+    }
+
+    void sealChunk() {
+        if(m_chunk.empty()) return;
+        ChunkInfo info;
+        info.offset  = m_offset;
+        info.size    = m_chunk.size();
+        info.entries = m_chunk_entries;
+        m_index.push_back(info);
+        m_offset += m_chunk.size();
+        std::unique_ptr<PendingWrite> w(new PendingWrite());
+        w->data.swap(m_chunk);
+        w->op = abt_io_pwrite_nb(m_abtio, m_fd, w->data.data(), w->data.size(),
+                                 static_cast<off_t>(info.offset), &w->ret);
+        if(!w->op)
+            throw Exception("Could not issue a write to snapshot " + m_tmp_path);
+        m_pending.push_back(std::move(w));
+        m_chunk.reserve(m_chunk_bytes + kRecordHeaderSize);
+        m_chunk_entries = 0;
+        while(m_pending.size() > m_max_pending) waitOldest();
+        if(!m_error.empty()) throw Exception(m_error);
+    }
+
+    public:
+
+    /**
+     * @brief Creates "<path>.tmp".
+     *
+     * @param abtio abt-io instance
+     * @param path path of the snapshot
+     * @param chunk_bytes size above which a chunk is written
+     * @param max_pending maximum number of chunks being written
+     */
+    Writer(abt_io_instance_id abtio, const std::string& path,
+           size_t chunk_bytes, size_t max_pending)
+    : m_abtio(abtio)
+    , m_path(path)
+    , m_tmp_path(path + ".tmp")
+    , m_chunk_bytes(chunk_bytes)
+    , m_max_pending(max_pending ? max_pending : 1) {
+        m_fd = abt_io_open(m_abtio, m_tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(m_fd < 0)
+            throw Exception("Could not create snapshot " + m_tmp_path + ": "
+                    + std::strerror(-m_fd));
+        m_chunk.reserve(m_chunk_bytes + kRecordHeaderSize);
+    }
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /**
+     * @brief Removes the temporary file unless commit() succeeded.
+     */
+    ~Writer() {
+        while(!m_pending.empty()) waitOldest();
+        if(m_fd >= 0) {
+            abt_io_close(m_abtio, m_fd);
+            abt_io_unlink(m_abtio, m_tmp_path.c_str());
+        }
+    }
+
+    /**
+     * @brief Appends an entry.
+     *
+     * @param expiry_ms expiry time in milliseconds since the Unix epoch, or 0.
+     */
+    void add(const std::string& key, const std::string& value, uint64_t expiry_ms) {
+        appendRecord(m_chunk, key, value, expiry_ms);
+        m_chunk_entries += 1;
+        m_entries += 1;
+        if(m_chunk.size() >= m_chunk_bytes) sealChunk();
+    }
+
+    /**
+     * @brief Writes the last chunk, the index and the header,
+     * and atomically replaces the file at path by the snapshot.
+     *
+     * @return the number of entries in the snapshot.
+     */
+    uint64_t commit() {
+        sealChunk();
+        waitAll();
+        std::string index;
+        index.reserve(m_index.size() * kIndexEntrySize);
+        for(auto& c : m_index) {
+            appendU64(index, c.offset);
+            appendU64(index, c.size);
+            appendU64(index, c.entries);
+        }
+        if(!index.empty()) writeAt(index, m_offset);
+        // the header goes last, so that a partial snapshot is invalid
+        std::string header(kMagic, sizeof(kMagic));
+        appendU64(header, m_index.size());
+        appendU64(header, m_entries);
+        appendU64(header, m_offset);
+        writeAt(header, 0);
+        int ret = abt_io_fdatasync(m_abtio, m_fd);
+        if(ret < 0)
+            throw Exception("Could not sync snapshot " + m_tmp_path + ": " + std::strerror(-ret));
+        abt_io_close(m_abtio, m_fd);
+        m_fd = -1;
+        if(std::rename(m_tmp_path.c_str(), m_path.c_str()) != 0) {
+            int err = errno;
+            abt_io_unlink(m_abtio, m_tmp_path.c_str());
+            throw Exception("Could not rename snapshot " + m_tmp_path + " to "
+                    + m_path + ": " + std::strerror(err));
+        }
+        return m_entries;
+    }
+};
+
+/**
+ * @brief Reads a snapshot file. The constructor reads and checks the
+ * header and the index; chunks can then be read concurrently by several
+ * ULTs with readChunk(). Methods throw an Exception on error.
+ */
+class Reader {
+
+    abt_io_instance_id     m_abtio;
+    std::string            m_path;
+    int                    m_fd = -1;
+    uint64_t               m_entries = 0;
+    std::vector<ChunkInfo> m_index;
+
+    void readAt(std::string& data, uint64_t offset) const {
+        size_t done = 0;
+        while(done < data.size()) {
+            ssize_t ret = abt_io_pread(m_abtio, m_fd, &data[done], data.size() - done,
+                                       static_cast<off_t>(offset + done));
+            if(ret < 0)
+                throw Exception("Could not read snapshot " + m_path + ": "
+                        + std::strerror(static_cast<int>(-ret)));
+            if(ret == 0)
+                throw Exception("Snapshot " + m_path + " is truncated");
+            done += ret;
+        }
+    }
+
+    public:
+
+    Reader(abt_io_instance_id abtio, const std::string& path)
+    : m_abtio(abtio)
+    , m_path(path) {
+        m_fd = abt_io_open(m_abtio, m_path.c_str(), O_RDONLY, 0);
+        if(m_fd < 0)
+            throw Exception("Could not open snapshot " + m_path + ": " + std::strerror(-m_fd));
+        std::string header(kHeaderSize, '\0');
+        try {
+            readAt(header, 0);
+        } catch(...) {
+            abt_io_close(m_abtio, m_fd);
+            throw;
+        }
+        if(std::memcmp(header.data(), kMagic, sizeof(kMagic)) != 0) {
+            abt_io_close(m_abtio, m_fd);
+            throw Exception(m_path + " is not a snapshot");
+        }
+        uint64_t chunks       = readU64(header.data() + 8);
+        m_entries             = readU64(header.data() + 16);
+        uint64_t index_offset = readU64(header.data() + 24);
+        // the index and the chunks must lie within the file, so that a
+        // corrupted header or index cannot cause huge allocations
+        struct stat st;
+        if(fstat(m_fd, &st) != 0) {
+            int err = errno;
+            abt_io_close(m_abtio, m_fd);
+            throw Exception("Could not stat snapshot " + m_path + ": " + std::strerror(err));
+        }
+        uint64_t file_size = static_cast<uint64_t>(st.st_size);
+        if(index_offset < kHeaderSize || index_offset > file_size
+        || chunks > (file_size - index_offset) / kIndexEntrySize) {
+            abt_io_close(m_abtio, m_fd);
+            throw Exception("Snapshot " + m_path + " is corrupted");
+        }
+        std::string index(chunks * kIndexEntrySize, '\0');
+        try {
+            readAt(index, index_offset);
+        } catch(...) {
+            abt_io_close(m_abtio, m_fd);
+            throw;
+        }
+        m_index.resize(chunks);
+        for(size_t i = 0; i < chunks; i++) {
+            const char* p = index.data() + i * kIndexEntrySize;
+            m_index[i].offset  = readU64(p);
+            m_index[i].size    = readU64(p + 8);
+            m_index[i].entries = readU64(p + 16);
+            // chunks are between the header and the index
+            if(m_index[i].offset < kHeaderSize || m_index[i].offset > index_offset
+            || m_index[i].size > index_offset - m_index[i].offset) {
+                abt_io_close(m_abtio, m_fd);
+                throw Exception("Snapshot " + m_path + " is corrupted");
+            }
+        }
+    }
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    ~Reader() {
+        abt_io_close(m_abtio, m_fd);
+    }
+
+    size_t numChunks() const {
+        return m_index.size();
+    }
+
+    uint64_t numEntries() const {
+        return m_entries;
+    }
+
+    /**
+     * @brief Reads chunk i and calls f(key, value, expiry_ms) on each
+     * of its records. The strings passed to f may be moved from.
+     * The constructor has checked that the chunk lies within the file.
+     */
+    template<typename F>
+    void readChunk(size_t i, F&& f) const {
+        auto& info = m_index[i];
+        std::string data(info.size, '\0');
+        readAt(data, info.offset);
+        if(!parseRecords(data.data(), data.size(), info.entries, std::forward<F>(f)))
+            throw Exception("Snapshot " + m_path + " is corrupted");
+    }
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_TIMER_WHEEL_HPP
+#define __CACHERSIZE_TIMER_WHEEL_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace cachersize {
+
+/**
+ * @brief Hierarchical timing wheel (Varghese and Lauck) holding one timer
+ * per key. Time is counted in ticks. Level l of the wheel has kSlots slots
+ * each covering kSlots^l ticks, so that a timer expiring within kSlots^(l+1)
+ * ticks is placed in a slot of level l, and moved down a level ("cascaded")
+ * when the wheel reaches the start of the range covered by its slot.
+ * Scheduling and cancelling a timer are O(1); advancing the wheel by one
+ * tick costs O(1) plus the number of timers expiring or cascading, so that
+ * the wheel never scans timers that are not due. Timers further than
+ * kSlots^kLevels ticks are parked in the last level and cascaded again.
+ *
+ * A TimerWheel is not thread-safe; the MemoryCache gives each shard its
+ * own wheel, protected by the shard's lock.
+ */
+class TimerWheel {
+
+    public:
+
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr unsigned kSlots    = 1u << kSlotBits;
+    static constexpr unsigned kLevels   = 4;
+
+    /**
+     * @brief Timer of a key, linked in the list of its slot.
+     */
+    struct Timer {
+        std::string key;
+        uint64_t    expiry = 0; // tick at which the timer fires
+        Timer*      next   = nullptr;
+        Timer**     pprev  = nullptr; // pointer that points to this timer
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param now current tick, the first one that advance() will process.
+     */
+    explicit TimerWheel(uint64_t now = 0)
+    : m_current(now) {
+        for(auto& level : m_slots)
+            for(auto& head : level) head = nullptr;
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    ~TimerWheel() {
+        clear();
+    }
+
+    /**
+     * @brief Number of pending timers.
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @brief Creates a timer firing at the given tick, or at the next
+     * processed tick if this one has already been processed.
+     */
+    Timer* schedule(const std::string& key, uint64_t expiry) {
+        auto timer = new Timer();
+        timer->key    = key;
+        timer->expiry = expiry;
+        place(timer);
+        m_size += 1;
+        return timer;
+    }
+
+    /**
+     * @brief Changes the tick at which a pending timer fires.
+     */
+    void reschedule(Timer* timer, uint64_t expiry) {
+        unlink(timer);
+        timer->expiry = expiry;
+        place(timer);
+    }
+
+    /**
+     * @brief Cancels and frees a pending timer.
+     */
+    void cancel(Timer* timer) {
+        unlink(timer);
+        m_size -= 1;
+        delete timer;
+    }
+
+    /**
+     * @brief Processes all the ticks up to now (included), calling
+     * f(key) for every timer that fires. The timers are freed after
+     * f returns, and f must not schedule or cancel timers.
+     */
+    template<typename F>
+    void advance(uint64_t now, F&& f) {
+        for(; m_current <= now; m_current++) {
+            // cascade from the highest level whose slot starts at this tick
+            unsigned top = 0;
+            while(top + 1 < kLevels && slotOf(m_current, top) == 0) top++;
+            for(unsigned level = top; level > 0; level--)
+                cascade(level, slotOf(m_current, level));
+            auto& head = m_slots[0][slotOf(m_current, 0)];
+            while(head) {
+                auto timer = head;
+                unlink(timer);
+                m_size -= 1;
+                f(timer->key);
+                delete timer;
+            }
+            if(m_size == 0) {
+                // nothing to cascade later: jump to the end
+                if(m_current < now) m_current = now;
+            }
+        }
+    }
+
+    /**
+     * @brief Moves the current tick of a wheel without pending timers
+     * to now (if it is behind), so that timers scheduled after a long
+     * idle period are placed relative to the present and advance()
+     * does not have to walk through the idle ticks.
+     */
+    void skipTo(uint64_t now) {
+        if(m_size == 0 && m_current < now) m_current = now;
+    }
+
+    /**
+     * @brief Frees all the pending timers.
+     */
+    void clear() {
+        for(auto& level : m_slots) {
+            for(auto& head : level) {
+                while(head) {
+                    auto timer = head;
+                    head = timer->next;
+                    delete timer;
+                }
+            }
+        }
+        m_size = 0;
+    }
+
+    private:
+
+    Timer*   m_slots[kLevels][kSlots];
+    uint64_t m_current;
+    size_t   m_size = 0;
+
+    static unsigned slotOf(uint64_t tick, unsigned level) {
+        return static_cast<unsigned>((tick >> (level * kSlotBits)) & (kSlots - 1));
+    }
+
+    void place(Timer* timer) {
+        uint64_t expiry = timer->expiry < m_current ? m_current : timer->expiry;
+        uint64_t delta  = expiry - m_current;
+        unsigned level  = 0;
+        while(level + 1 < kLevels && delta >= (uint64_t(1) << ((level + 1) * kSlotBits)))
+            level++;
+        // beyond the wheel's range, park the timer in the furthest
+        // slot of the last level; it is placed again when cascaded
+        uint64_t range = uint64_t(1) << (kLevels * kSlotBits);
+        if(delta >= range) expiry = m_current + range - 1;
+        auto& head = m_slots[level][slotOf(expiry, level)];
+        timer->next  = head;
+        timer->pprev = &head;
+        if(head) head->pprev = &timer->next;
+        head = timer;
+    }
+
+    void unlink(Timer* timer) {
+        *timer->pprev = timer->next;
+        if(timer->next) timer->next->pprev = timer->pprev;
+        timer->next  = nullptr;
+        timer->pprev = nullptr;
+    }
+
+    void cascade(unsigned level, unsigned slot) {
+        auto timer = m_slots[level][slot];
+        m_slots[level][slot] = nullptr;
+        while(timer) {
+            auto next = timer->next;
+            place(timer);
+            timer = next;
+        }
+    }
+};
+
+}
+
+#endif
@@ -5,6 +5,7 @@
  */
 #include "DummyBackend.hpp"
 #include <iostream>
+#include <mutex>
 
 CACHERSIZE_REGISTER_BACKEND(dummy, DummyCache);
 
@@ -18,8 +19,47 @@ cachersize::RequestResult<int32_t> DummyCache::computeSum(int32_t x, int32_t y)
     return result;
 }
 
+cachersize::RequestResult<bool> DummyCache::put(const std::string& key, std::string&& value) {
+    cachersize::RequestResult<bool> result;
+    std::lock_guard<thallium::mutex> lock(m_data_mtx);
+    m_data[key] = std::move(value);
+    return result;
+}
+
+cachersize::RequestResult<std::string> DummyCache::get(const std::string& key) {
+    cachersize::RequestResult<std::string> result;
+    std::lock_guard<thallium::mutex> lock(m_data_mtx);
+    auto it = m_data.find(key);
+    if(it == m_data.end()) {
+        result.success() = false;
+        result.code() = cachersize::ResultCode::KeyNotFound;
+        result.error() = "Key not found";
+    } else {
+        result.value() = it->second;
+    }
+    return result;
+}
+
+cachersize::RequestResult<bool> DummyCache::erase(const std::string& key) {
+    cachersize::RequestResult<bool> result;
+    std::lock_guard<thallium::mutex> lock(m_data_mtx);
+    m_data.erase(key);
+    return result;
+}
+
+cachersize::RequestResult<uint8_t> DummyCache::exists(const std::string& key) {
+    cachersize::RequestResult<uint8_t> result;
+    std::lock_guard<thallium::mutex> lock(m_data_mtx);
+    result.value() = m_data.count(key) ? 1 : 0;
+    return result;
+}
+
 cachersize::RequestResult<bool> DummyCache::destroy() {
     cachersize::RequestResult<bool> result;
+    {
+        std::lock_guard<thallium::mutex> lock(m_data_mtx);
+        m_data.clear();
+    }
     result.value() = true;
     // or result.success() = true
     return result;
@@ -15,7 +15,9 @@ using json = nlohmann::json;
  */
 class DummyCache : public cachersize::Backend {
    
-    json m_config;
+    json                                         m_config;
+    std::unordered_map<std::string, std::string> m_data;
+    thallium::mutex                              m_data_mtx;
 
     public:
 
@@ -26,24 +28,24 @@ class DummyCache : public cachersize::Backend {
     : m_config(config) {}
 
     /**
-     * @brief Move-constructor.
+     * @brief Move-constructor is deleted (the cache holds a mutex).
      */
-    DummyCache(DummyCache&&) = default;
+    DummyCache(DummyCache&&) = delete;
 
     /**
-     * @brief Copy-constructor.
+     * @brief Copy-constructor is deleted.
      */
-    DummyCache(const DummyCache&) = default;
+    DummyCache(const DummyCache&) = delete;
 
     /**
-     * @brief Move-assignment operator.
+     * @brief Move-assignment operator is deleted.
      */
-    DummyCache& operator=(DummyCache&&) = default;
+    DummyCache& operator=(DummyCache&&) = delete;
 
     /**
-     * @brief Copy-assignment operator.
+     * @brief Copy-assignment operator is deleted.
      */
-    DummyCache& operator=(const DummyCache&) = default;
+    DummyCache& operator=(const DummyCache&) = delete;
 
     /**
      * @brief Destructor.
@@ -65,6 +67,43 @@ class DummyCache : public cachersize::Backend {
      */
     cachersize::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
 
+    /**
+     * @brief Stores a value associated with a key.
+     *
+     * @param key key
+     * @param value value
+     *
+     * @return a RequestResult<bool> indicating whether the value was stored.
+     */
+    cachersize::RequestResult<bool> put(const std::string& key, std::string&& value) override;
+
+    /**
+     * @brief Retrieves the value associated with a key.
+     *
+     * @param key key
+     *
+     * @return a RequestResult containing the value.
+     */
+    cachersize::RequestResult<std::string> get(const std::string& key) override;
+
+    /**
+     * @brief Erases a key and its associated value.
+     *
+     * @param key key
+     *
+     * @return a RequestResult<bool> indicating whether the operation succeeded.
+     */
+    cachersize::RequestResult<bool> erase(const std::string& key) override;
+
+    /**
+     * @brief Checks whether a key exists.
+     *
+     * @param key key
+     *
+     * @return a RequestResult whose value is 1 if the key exists, 0 otherwise.
+     */
+    cachersize::RequestResult<uint8_t> exists(const std::string& key) override;
+
     /**
      * @brief Destroys the underlying cache.
      *
@@ -0,0 +1,141 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "cachersize/EvictionPolicy.hpp"
+#include "IntrusiveList.hpp"
+#include "GhostList.hpp"
+#include <algorithm>
+
+namespace cachersize {
+
+using json = nlohmann::json;
+
+/**
+ * @brief Adaptive Replacement Cache policy (Megiddo & Modha, FAST'03).
+ * Resident keys are split between T1 (seen once recently) and T2 (seen
+ * at least twice), both LRU lists, and recently evicted keys are
+ * remembered in ghost lists B1 and B2. Re-insertion of a ghost key
+ * adapts the target size p of T1. A hit moves the entry to the front
+ * of T2, so touch() requires exclusive access.
+ *
+ * Since the cache decides when to evict (e.g. based on bytes), c is
+ * taken as the capacity given at creation or, if unknown, as the
+ * largest number of resident entries observed.
+ */
+class ARCPolicy : public EvictionPolicy {
+
+    struct Node : public Entry, public ListHook {
+        bool in_t2 = false;
+    };
+
+    IntrusiveList<Node> m_t1;
+    IntrusiveList<Node> m_t2;
+    GhostList           m_b1;
+    GhostList           m_b2;
+    size_t              m_p = 0;
+    size_t              m_c;
+    bool                m_fixed_c;
+    bool                m_last_hit_b2 = false;
+
+    void trimGhosts() {
+        while(m_b1.size() > 0 && m_t1.size() + m_b1.size() > m_c) m_b1.popOldest();
+        while(m_b2.size() > 0 && size() + m_b1.size() + m_b2.size() > 2*m_c) m_b2.popOldest();
+    }
+
+    bool evictFromT1() const {
+        return !m_t1.empty()
+            && (m_t2.empty() || m_t1.size() > m_p || (m_last_hit_b2 && m_t1.size() == m_p));
+    }
+
+    public:
+
+    ARCPolicy(size_t capacity)
+    : m_c(std::max<size_t>(capacity, 1))
+    , m_fixed_c(capacity != 0) {}
+
+    ~ARCPolicy() {
+        m_t1.clear([](Node* n) { delete n; });
+        m_t2.clear([](Node* n) { delete n; });
+    }
+
+    Entry* insert(const std::string& key) override {
+        Node* n = new Node;
+        n->key = key;
+        m_last_hit_b2 = false;
+        if(m_b1.remove(key)) {
+            size_t delta = std::max<size_t>(1, m_b2.size() / std::max<size_t>(m_b1.size(), 1));
+            m_p = std::min(m_c, m_p + delta);
+            n->in_t2 = true;
+            m_t2.pushFront(n);
+        } else if(m_b2.remove(key)) {
+            size_t delta = std::max<size_t>(1, m_b1.size() / std::max<size_t>(m_b2.size(), 1));
+            m_p = m_p > delta ? m_p - delta : 0;
+            m_last_hit_b2 = true;
+            n->in_t2 = true;
+            m_t2.pushFront(n);
+        } else {
+            m_t1.pushFront(n);
+        }
+        if(!m_fixed_c) m_c = std::max(m_c, size());
+        trimGhosts();
+        return n;
+    }
+
+    void touch(Entry* entry) override {
+        Node* n = static_cast<Node*>(entry);
+        if(n->in_t2) {
+            m_t2.moveToFront(n);
+        } else {
+            m_t1.remove(n);
+            n->in_t2 = true;
+            m_t2.pushFront(n);
+        }
+    }
+
+    void remove(Entry* entry) override {
+        Node* n = static_cast<Node*>(entry);
+        if(n->in_t2) m_t2.remove(n);
+        else         m_t1.remove(n);
+        delete n;
+    }
+
+    bool evict(std::string* key) override {
+        Node* n = nullptr;
+        if(evictFromT1()) {
+            n = m_t1.popBack();
+            *key = n->key;
+            m_b1.push(std::move(n->key));
+        } else if(!m_t2.empty()) {
+            n = m_t2.popBack();
+            *key = n->key;
+            m_b2.push(std::move(n->key));
+        } else {
+            return false;
+        }
+        delete n;
+        trimGhosts();
+        return true;
+    }
+
+    bool victim(std::string* key) const override {
+        Node* n = evictFromT1() ? m_t1.back() : m_t2.back();
+        if(!n) return false;
+        *key = n->key;
+        return true;
+    }
+
+    size_t size() const override {
+        return m_t1.size() + m_t2.size();
+    }
+
+    static std::unique_ptr<EvictionPolicy> create(const json& config, size_t capacity) {
+        (void)config;
+        return std::unique_ptr<EvictionPolicy>(new ARCPolicy(capacity));
+    }
+};
+
+}
+
+CACHERSIZE_REGISTER_EVICTION_POLICY(arc, cachersize::ARCPolicy);
@@ -0,0 +1,120 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "cachersize/EvictionPolicy.hpp"
+#include <atomic>
+#include <vector>
+
+namespace cachersize {
+
+using json = nlohmann::json;
+
+/**
+ * @brief CLOCK (second-chance) policy. Entries sit in a circular
+ * array swept by a hand; a hit only sets the entry's reference bit,
+ * so touch() can run concurrently under a shared lock. On eviction
+ * the hand clears reference bits until it finds an unreferenced entry.
+ */
+class ClockPolicy : public EvictionPolicy {
+
+    struct Node : public Entry {
+        std::atomic<bool> referenced = { false };
+        size_t            position   = 0;
+    };
+
+    std::vector<Node*>  m_ring;
+    std::vector<size_t> m_free_positions;
+    size_t              m_hand = 0;
+    size_t              m_size = 0;
+
+    public:
+
+    ClockPolicy(size_t capacity) {
+        m_ring.reserve(capacity);
+    }
+
+    ~ClockPolicy() {
+        for(auto n : m_ring) delete n;
+    }
+
+    Entry* insert(const std::string& key) override {
+        Node* n = new Node;
+        n->key = key;
+        if(m_free_positions.empty()) {
+            n->position = m_ring.size();
+            m_ring.push_back(n);
+        } else {
+            n->position = m_free_positions.back();
+            m_free_positions.pop_back();
+            m_ring[n->position] = n;
+        }
+        m_size += 1;
+        return n;
+    }
+
+    void touch(Entry* entry) override {
+        auto& ref = static_cast<Node*>(entry)->referenced;
+        // avoid dirtying the cache line if the bit is already set
+        if(!ref.load(std::memory_order_relaxed))
+            ref.store(true, std::memory_order_relaxed);
+    }
+
+    void remove(Entry* entry) override {
+        Node* n = static_cast<Node*>(entry);
+        m_ring[n->position] = nullptr;
+        m_free_positions.push_back(n->position);
+        m_size -= 1;
+        delete n;
+    }
+
+    bool evict(std::string* key) override {
+        if(m_size == 0) return false;
+        // terminates within two sweeps since the first sweep
+        // clears every reference bit it passes
+        while(true) {
+            if(m_hand >= m_ring.size()) m_hand = 0;
+            Node* n = m_ring[m_hand];
+            if(n && n->referenced.load(std::memory_order_relaxed)) {
+                n->referenced.store(false, std::memory_order_relaxed);
+            } else if(n) {
+                *key = std::move(n->key);
+                m_ring[m_hand] = nullptr;
+                m_free_positions.push_back(m_hand);
+                m_size -= 1;
+                delete n;
+                m_hand += 1;
+                return true;
+            }
+            m_hand += 1;
+        }
+    }
+
+    bool victim(std::string* key) const override {
+        if(m_size == 0) return false;
+        // the entry under the hand: evict() takes it unless it has
+        // been referenced, which is close enough for admission
+        const Node* n = m_ring[m_hand < m_ring.size() ? m_hand : 0];
+        if(!n) return false;
+        *key = n->key;
+        return true;
+    }
+
+    size_t size() const override {
+        return m_size;
+    }
+
+    bool concurrentTouch() const override {
+        return true;
+    }
+
+    static std::unique_ptr<EvictionPolicy> create(const json& config, size_t capacity) {
+        (void)config;
+        return std::unique_ptr<EvictionPolicy>(new ClockPolicy(capacity));
+    }
+};
+
+}
+
+CACHERSIZE_REGISTER_EVICTION_POLICY(clock, cachersize::ClockPolicy);
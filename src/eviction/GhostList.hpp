@@ -0,0 +1,86 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_GHOST_LIST_HPP
+#define __CACHERSIZE_GHOST_LIST_HPP
+
+#include "IntrusiveList.hpp"
+#include "../HashIndex.hpp"
+#include <string>
+
+namespace cachersize {
+
+/**
+ * @brief Ordered set of keys that have been evicted recently,
+ * used by policies (ARC, S3-FIFO) that adapt to re-references
+ * of evicted keys. Keys are kept in insertion order so that the
+ * oldest can be dropped in O(1).
+ */
+class GhostList {
+
+    struct Node : public ListHook {
+        std::string key;
+    };
+
+    IntrusiveList<Node> m_list;
+    HashIndex<Node*>    m_index;
+
+    public:
+
+    GhostList() = default;
+
+    GhostList(const GhostList&) = delete;
+    GhostList& operator=(const GhostList&) = delete;
+
+    ~GhostList() {
+        m_list.clear([](Node* n) { delete n; });
+    }
+
+    size_t size() const {
+        return m_list.size();
+    }
+
+    bool contains(const std::string& key) const {
+        return m_index.find(key) != nullptr;
+    }
+
+    /**
+     * @brief Adds a key as the most recent ghost.
+     */
+    void push(std::string&& key) {
+        if(m_index.find(key)) return;
+        Node* n = new Node;
+        n->key = std::move(key);
+        m_index.emplace(n->key, n);
+        m_list.pushFront(n);
+    }
+
+    /**
+     * @brief Removes a key if present.
+     *
+     * @return true if the key was found.
+     */
+    bool remove(const std::string& key) {
+        Node* n = nullptr;
+        if(!m_index.extract(key, &n)) return false;
+        m_list.remove(n);
+        delete n;
+        return true;
+    }
+
+    /**
+     * @brief Drops the oldest ghost, if any.
+     */
+    void popOldest() {
+        Node* n = m_list.popBack();
+        if(!n) return;
+        m_index.erase(n->key);
+        delete n;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERSIZE_INTRUSIVE_LIST_HPP
+#define __CACHERSIZE_INTRUSIVE_LIST_HPP
+
+#include <cstddef>
+
+namespace cachersize {
+
+/**
+ * @brief Hook to embed in objects that need to be linked
+ * into an IntrusiveList.
+ */
+struct ListHook {
+    ListHook* prev = nullptr;
+    ListHook* next = nullptr;
+};
+
+/**
+ * @brief Doubly-linked list of objects of type T, where T inherits
+ * from ListHook. The list does not own its elements. All operations
+ * are O(1). The front of the list is the most recently pushed element.
+ */
+template<typename T>
+class IntrusiveList {
+
+    ListHook m_head; // sentinel: m_head.next is the front, m_head.prev the back
+    size_t   m_size = 0;
+
+    public:
+
+    IntrusiveList() {
+        m_head.prev = m_head.next = &m_head;
+    }
+
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    size_t size() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+    void pushFront(T* item) {
+        ListHook* h = item;
+        h->prev = &m_head;
+        h->next = m_head.next;
+        m_head.next->prev = h;
+        m_head.next = h;
+        m_size += 1;
+    }
+
+    void remove(T* item) {
+        ListHook* h = item;
+        h->prev->next = h->next;
+        h->next->prev = h->prev;
+        h->prev = h->next = nullptr;
+        m_size -= 1;
+    }
+
+    void moveToFront(T* item) {
+        remove(item);
+        pushFront(item);
+    }
+
+    T* back() const {
+        return empty() ? nullptr : static_cast<T*>(m_head.prev);
+    }
+
+    T* popBack() {
+        T* item = back();
+        if(item) remove(item);
+        return item;
+    }
+
+    /**
+     * @brief Calls f(item) on each element; f may delete the item.
+     */
+    template<typename F>
+    void clear(F&& f) {
+        ListHook* h = m_head.next;
+        while(h != &m_head) {
+            ListHook* next = h->next;
+            f(static_cast<T*>(h));
+            h = next;
+        }
+        m_head.prev = m_head.next = &m_head;
+        m_size = 0;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "cachersize/EvictionPolicy.hpp"
+#include "IntrusiveList.hpp"
+
+namespace cachersize {
+
+using json = nlohmann::json;
+
+/**
+ * @brief Least-recently-used policy. A hit moves the entry to the
+ * front of a linked list, so touch() requires exclusive access.
+ */
+class LRUPolicy : public EvictionPolicy {
+
+    struct Node : public Entry, public ListHook {};
+
+    IntrusiveList<Node> m_list;
+
+    public:
+
+    ~LRUPolicy() {
+        m_list.clear([](Node* n) { delete n; });
+    }
+
+    Entry* insert(const std::string& key) override {
+        Node* n = new Node;
+        n->key = key;
+        m_list.pushFront(n);
+        return n;
+    }
+
+    void touch(Entry* entry) override {
+        m_list.moveToFront(static_cast<Node*>(entry));
+    }
+
+    void remove(Entry* entry) override {
+        Node* n = static_cast<Node*>(entry);
+        m_list.remove(n);
+        delete n;
+    }
+
+    bool evict(std::string* key) override {
+        Node* n = m_list.popBack();
+        if(!n) return false;
+        *key = std::move(n->key);
+        delete n;
+        return true;
+    }
+
+    bool victim(std::string* key) const override {
+        Node* n = m_list.back();
+        if(!n) return false;
+        *key = n->key;
+        return true;
+    }
+
+    size_t size() const override {
+        return m_list.size();
+    }
+
+    static std::unique_ptr<EvictionPolicy> create(const json& config, size_t capacity) {
+        (void)config;
+        (void)capacity;
+        return std::unique_ptr<EvictionPolicy>(new LRUPolicy());
+    }
+};
+
+}
+
+CACHERSIZE_REGISTER_EVICTION_POLICY(lru, cachersize::LRUPolicy);
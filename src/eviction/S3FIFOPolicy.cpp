@@ -0,0 +1,151 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "cachersize/EvictionPolicy.hpp"
+#include "cachersize/Exception.hpp"
+#include "IntrusiveList.hpp"
+#include "GhostList.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace cachersize {
+
+using json = nlohmann::json;
+
+/**
+ * @brief S3-FIFO policy (Yang et al., SOSP'23). New keys enter a small
+ * FIFO queue; keys accessed again before leaving it are promoted to a
+ * main FIFO queue, others are evicted early and remembered in a ghost
+ * queue so that they go straight to the main queue if re-inserted.
+ * The main queue is a CLOCK-like FIFO with a 2-bit frequency counter.
+ * A hit only increments the counter of the entry, so touch() can run
+ * concurrently under a shared lock.
+ *
+ * Accepted configuration fields:
+ * - "small_queue_ratio" (number, default 0.1): target fraction of
+ *   the entries held by the small queue.
+ */
+class S3FIFOPolicy : public EvictionPolicy {
+
+    struct Node : public Entry, public ListHook {
+        std::atomic<uint8_t> freq    = { 0 };
+        bool                 in_main = false;
+    };
+
+    IntrusiveList<Node> m_small;
+    IntrusiveList<Node> m_main;
+    GhostList           m_ghost;
+    double              m_small_ratio;
+    size_t              m_capacity;
+
+    void trimGhost() {
+        size_t max_ghosts = std::max<size_t>(m_capacity, m_main.size());
+        while(m_ghost.size() > max_ghosts) m_ghost.popOldest();
+    }
+
+    public:
+
+    S3FIFOPolicy(double small_ratio, size_t capacity)
+    : m_small_ratio(small_ratio)
+    , m_capacity(capacity) {}
+
+    ~S3FIFOPolicy() {
+        m_small.clear([](Node* n) { delete n; });
+        m_main.clear([](Node* n) { delete n; });
+    }
+
+    Entry* insert(const std::string& key) override {
+        Node* n = new Node;
+        n->key = key;
+        if(m_ghost.remove(key)) {
+            n->in_main = true;
+            m_main.pushFront(n);
+        } else {
+            m_small.pushFront(n);
+        }
+        return n;
+    }
+
+    void touch(Entry* entry) override {
+        auto& freq = static_cast<Node*>(entry)->freq;
+        // a lost update between concurrent hits is harmless
+        uint8_t f = freq.load(std::memory_order_relaxed);
+        if(f < 3) freq.store(f + 1, std::memory_order_relaxed);
+    }
+
+    void remove(Entry* entry) override {
+        Node* n = static_cast<Node*>(entry);
+        if(n->in_main) m_main.remove(n);
+        else           m_small.remove(n);
+        delete n;
+    }
+
+    bool evict(std::string* key) override {
+        while(size() != 0) {
+            bool from_small = !m_small.empty()
+                && (m_main.empty() || m_small.size() >= m_small_ratio * size());
+            if(from_small) {
+                Node* n = m_small.popBack();
+                if(n->freq.load(std::memory_order_relaxed) > 1) {
+                    n->freq.store(0, std::memory_order_relaxed);
+                    n->in_main = true;
+                    m_main.pushFront(n);
+                    continue;
+                }
+                *key = n->key;
+                m_ghost.push(std::move(n->key));
+                trimGhost();
+                delete n;
+                return true;
+            } else {
+                Node* n = m_main.popBack();
+                uint8_t f = n->freq.load(std::memory_order_relaxed);
+                if(f > 0) {
+                    n->freq.store(f - 1, std::memory_order_relaxed);
+                    m_main.pushFront(n);
+                    continue;
+                }
+                *key = std::move(n->key);
+                delete n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool victim(std::string* key) const override {
+        if(size() == 0) return false;
+        // the back of the queue evict() starts from, ignoring the
+        // promotions and counter decrements it may perform first
+        bool from_small = !m_small.empty()
+            && (m_main.empty() || m_small.size() >= m_small_ratio * size());
+        Node* n = from_small ? m_small.back() : m_main.back();
+        *key = n->key;
+        return true;
+    }
+
+    size_t size() const override {
+        return m_small.size() + m_main.size();
+    }
+
+    bool concurrentTouch() const override {
+        return true;
+    }
+
+    static std::unique_ptr<EvictionPolicy> create(const json& config, size_t capacity) {
+        double small_ratio = 0.1;
+        if(config.contains("small_queue_ratio")) {
+            auto& r = config["small_queue_ratio"];
+            if(!r.is_number() || r.get<double>() <= 0.0 || r.get<double>() >= 1.0)
+                throw Exception("\"small_queue_ratio\" should be a number in (0, 1)");
+            small_ratio = r.get<double>();
+        }
+        return std::unique_ptr<EvictionPolicy>(new S3FIFOPolicy(small_ratio, capacity));
+    }
+};
+
+}
+
+CACHERSIZE_REGISTER_EVICTION_POLICY(s3fifo, cachersize::S3FIFOPolicy);
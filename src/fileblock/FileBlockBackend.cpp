@@ -0,0 +1,843 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "FileBlockBackend.hpp"
+#include <cachersize/Exception.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+
+CACHERSIZE_REGISTER_BACKEND(fileblock, FileBlockCache);
+
+static size_t getUnsigned(const json& config, const char* field, size_t default_value) {
+    if(!config.contains(field))
+        return default_value;
+    auto& v = config[field];
+    if(!v.is_number_unsigned())
+        throw cachersize::Exception(
+            std::string("\"") + field + "\" field should be an unsigned integer");
+    return v.get<size_t>();
+}
+
+FileBlockCache::FileBlockCache(const thallium::engine& engine, const json& config)
+: m_config(config)
+, m_pool(engine.get_handler_pool()) {
+    if(!m_config.is_object())
+        m_config = json::object();
+    size_t num_shards     = getUnsigned(m_config, "num_shards", 16);
+    size_t capacity_bytes = getUnsigned(m_config, "capacity_bytes", 1024*1024*1024);
+    size_t io_threads     = getUnsigned(m_config, "abt_io_threads", 4);
+    m_block_size          = getUnsigned(m_config, "block_size", 65536);
+    m_max_open_files      = getUnsigned(m_config, "max_open_files", 256);
+    if(num_shards == 0)
+        throw cachersize::Exception("\"num_shards\" field should be strictly positive");
+    if(m_block_size == 0)
+        throw cachersize::Exception("\"block_size\" field should be strictly positive");
+    if(io_threads == 0)
+        throw cachersize::Exception("\"abt_io_threads\" field should be strictly positive");
+    if(m_max_open_files == 0)
+        throw cachersize::Exception("\"max_open_files\" field should be strictly positive");
+    if(capacity_bytes < m_block_size * num_shards)
+        throw cachersize::Exception(
+            "\"capacity_bytes\" field should allow at least one block per shard");
+    if(!m_config.contains("root"))
+        m_config["root"] = "";
+    if(!m_config["root"].is_string())
+        throw cachersize::Exception("\"root\" field should be a string");
+    m_root = m_config["root"].get<std::string>();
+    if(!m_root.empty() && m_root.back() != '/')
+        m_root += '/';
+    if(!m_config.contains("writable"))
+        m_config["writable"] = false;
+    if(!m_config["writable"].is_boolean())
+        throw cachersize::Exception("\"writable\" field should be a boolean");
+    m_writable = m_config["writable"].get<bool>();
+    m_config["num_shards"]     = num_shards;
+    m_config["capacity_bytes"] = capacity_bytes;
+    m_config["abt_io_threads"] = io_threads;
+    m_config["block_size"]     = m_block_size;
+    m_config["max_open_files"] = m_max_open_files;
+    m_shard_capacity_bytes = capacity_bytes / num_shards;
+
+    json eviction = json::object();
+    if(m_config.contains("eviction")) {
+        eviction = m_config["eviction"];
+        if(!eviction.is_object())
+            throw cachersize::Exception("\"eviction\" field should be an object");
+    }
+    if(!eviction.contains("policy"))
+        eviction["policy"] = "lru";
+    if(!eviction["policy"].is_string())
+        throw cachersize::Exception("\"eviction.policy\" field should be a string");
+    std::string policy_name = eviction["policy"].get<std::string>();
+    m_config["eviction"] = eviction;
+
+    json readahead = json::object();
+    if(m_config.contains("readahead")) {
+        readahead = m_config["readahead"];
+        if(!readahead.is_object())
+            throw cachersize::Exception("\"readahead\" field should be an object");
+    }
+    if(!readahead.contains("enabled"))
+        readahead["enabled"] = true;
+    if(!readahead["enabled"].is_boolean())
+        throw cachersize::Exception("\"readahead.enabled\" field should be a boolean");
+    m_readahead         = readahead["enabled"].get<bool>();
+    m_ra_trigger        = getUnsigned(readahead, "trigger", 2);
+    m_ra_initial_window = getUnsigned(readahead, "initial_window", 4);
+    m_ra_max_window     = getUnsigned(readahead, "max_window", 64);
+    if(m_ra_trigger == 0)
+        throw cachersize::Exception("\"readahead.trigger\" field should be strictly positive");
+    if(m_ra_initial_window == 0 || m_ra_initial_window > m_ra_max_window)
+        throw cachersize::Exception(
+            "\"readahead.initial_window\" field should be between 1 and \"readahead.max_window\"");
+    readahead["trigger"]        = m_ra_trigger;
+    readahead["initial_window"] = m_ra_initial_window;
+    readahead["max_window"]     = m_ra_max_window;
+    m_config["readahead"] = readahead;
+
+    json write_back = json::object();
+    if(m_config.contains("write_back")) {
+        write_back = m_config["write_back"];
+        if(!write_back.is_object())
+            throw cachersize::Exception("\"write_back\" field should be an object");
+    }
+    if(!write_back.contains("enabled"))
+        write_back["enabled"] = false;
+    if(!write_back["enabled"].is_boolean())
+        throw cachersize::Exception("\"write_back.enabled\" field should be a boolean");
+    if(!write_back.contains("high_watermark"))
+        write_back["high_watermark"] = 0.5;
+    if(!write_back.contains("low_watermark"))
+        write_back["low_watermark"] = 0.25;
+    if(!write_back["high_watermark"].is_number() || !write_back["low_watermark"].is_number())
+        throw cachersize::Exception("\"write_back\" watermarks should be numbers");
+    double high = write_back["high_watermark"].get<double>();
+    double low  = write_back["low_watermark"].get<double>();
+    if(!(0.0 <= low && low < high && high <= 1.0))
+        throw cachersize::Exception(
+            "\"write_back\" watermarks should satisfy 0 <= low_watermark < high_watermark <= 1");
+    size_t flush_threads = getUnsigned(write_back, "flush_threads", 1);
+    m_max_write_size     = getUnsigned(write_back, "max_write_size", 8*1024*1024);
+    if(flush_threads == 0)
+        throw cachersize::Exception("\"write_back.flush_threads\" field should be strictly positive");
+    if(m_max_write_size < m_block_size)
+        throw cachersize::Exception(
+            "\"write_back.max_write_size\" field should be at least the block size");
+    m_write_back = write_back["enabled"].get<bool>();
+    if(m_write_back && !m_writable)
+        throw cachersize::Exception("\"write_back\" requires \"writable\" to be true");
+    write_back["flush_threads"]  = flush_threads;
+    write_back["max_write_size"] = m_max_write_size;
+    m_config["write_back"] = write_back;
+    m_capacity_bytes       = capacity_bytes;
+    m_high_watermark_bytes = static_cast<size_t>(high * capacity_bytes);
+    m_low_watermark_bytes  = static_cast<size_t>(low * capacity_bytes);
+
+    m_shards.reserve(num_shards);
+    m_patterns.reserve(num_shards);
+    for(size_t i = 0; i < num_shards; i++) {
+        m_shards.emplace_back(new Shard());
+        m_patterns.emplace_back(new PatternStripe());
+        m_shards.back()->policy = cachersize::EvictionPolicyFactory::createPolicy(
+            policy_name, eviction, m_shard_capacity_bytes / m_block_size);
+        if(!m_shards.back()->policy)
+            throw cachersize::Exception("Unknown eviction policy \"" + policy_name + "\"");
+    }
+
+    m_abtio = abt_io_init(static_cast<int>(io_threads));
+    if(m_abtio == ABT_IO_INSTANCE_NULL)
+        throw cachersize::Exception("Could not initialize abt-io");
+
+    if(m_write_back) {
+        m_flushers_running = flush_threads;
+        for(size_t i = 0; i < flush_threads; i++)
+            m_pool.make_thread([this]() { flusherLoop(); }, thallium::anonymous());
+    }
+}
+
+FileBlockCache::~FileBlockCache() {
+    if(m_write_back) {
+        // the provider normally flushes before closing the cache;
+        // this is a last attempt, whose errors cannot be reported
+        flush();
+        std::unique_lock<thallium::mutex> lock(m_dirty_mtx);
+        m_stopping = true;
+        m_dirty_cv.notify_all();
+        m_dirty_cv.wait(lock, [this]() { return m_flushers_running == 0; });
+    }
+    while(m_prefetches_in_flight.load() != 0)
+        thallium::thread::yield();
+    // files must be closed before abt-io is finalized
+    m_files.clear();
+    if(m_abtio != ABT_IO_INSTANCE_NULL)
+        abt_io_finalize(m_abtio);
+}
+
+bool FileBlockCache::parseKey(const std::string& key, std::string* path, uint64_t* block) const {
+    auto sep = key.rfind(':');
+    if(sep == std::string::npos || sep == 0 || sep + 1 == key.size())
+        return false;
+    uint64_t b = 0;
+    for(size_t i = sep + 1; i < key.size(); i++) {
+        if(key[i] < '0' || key[i] > '9') return false;
+        b = 10*b + (key[i] - '0');
+    }
+    // the path must stay under the root
+    if(key[0] == '/' || key.find('\0') < sep) return false;
+    for(size_t start = 0; start < sep;) {
+        size_t end = std::min(key.find('/', start), sep);
+        if(end - start == 2 && key[start] == '.' && key[start+1] == '.')
+            return false;
+        start = end + 1;
+    }
+    *block = b;
+    *path = m_root + key.substr(0, sep);
+    return true;
+}
+
+std::shared_ptr<FileBlockCache::File> FileBlockCache::openFile(const std::string& path) {
+    {
+        std::lock_guard<thallium::mutex> lock(m_files_mtx);
+        auto it = m_files.find(path);
+        if(it != m_files.end()) return it->second;
+    }
+    int flags = m_writable ? (O_RDWR | O_CREAT) : O_RDONLY;
+    int fd = abt_io_open(m_abtio, path.c_str(), flags, 0644);
+    if(fd < 0)
+        throw cachersize::Exception(
+            "Could not open file " + path + ": " + std::strerror(-fd));
+    auto file = std::make_shared<File>(m_abtio, fd);
+    std::lock_guard<thallium::mutex> lock(m_files_mtx);
+    // another ULT may have opened the same file concurrently
+    auto it = m_files.find(path);
+    if(it != m_files.end()) return it->second;
+    if(m_files.size() >= m_max_open_files)
+        m_files.erase(m_files.begin()); // closed once its users release it
+    m_files.emplace(path, file);
+    return file;
+}
+
+bool FileBlockCache::readBlock(const std::string& path, uint64_t block,
+                               std::string* data, std::string* error) {
+    if(m_write_back) {
+        // a dirty block is removed from m_dirty only once written,
+        // so if it is not found here the file is up to date
+        std::lock_guard<thallium::mutex> lock(m_dirty_mtx);
+        auto f = m_dirty.find(path);
+        if(f != m_dirty.end()) {
+            auto b = f->second.find(block);
+            if(b != f->second.end()) {
+                *data = b->second.data;
+                return true;
+            }
+        }
+    }
+    std::shared_ptr<File> file;
+    try {
+        file = openFile(path);
+    } catch(const cachersize::Exception& ex) {
+        *error = ex.what();
+        return false;
+    }
+    data->resize(m_block_size);
+    size_t done = 0;
+    off_t offset = static_cast<off_t>(block * m_block_size);
+    while(done < m_block_size) {
+        ssize_t ret = abt_io_pread(m_abtio, file->fd, &(*data)[done],
+                                   m_block_size - done, offset + done);
+        if(ret < 0) {
+            *error = "Could not read from file " + path + ": " + std::strerror(static_cast<int>(-ret));
+            return false;
+        }
+        if(ret == 0) break; // end of file
+        done += ret;
+    }
+    if(done == 0) {
+        *error = "Block is past the end of file " + path;
+        return false;
+    }
+    data->resize(done);
+    return true;
+}
+
+bool FileBlockCache::writeBlocks(const std::string& path, uint64_t first_block,
+                                 const std::string& data, std::string* error) {
+    std::shared_ptr<File> file;
+    try {
+        file = openFile(path);
+    } catch(const cachersize::Exception& ex) {
+        *error = ex.what();
+        return false;
+    }
+    size_t done = 0;
+    off_t offset = static_cast<off_t>(first_block * m_block_size);
+    while(done < data.size()) {
+        ssize_t ret = abt_io_pwrite(m_abtio, file->fd, data.data() + done,
+                                    data.size() - done, offset + done);
+        if(ret < 0) {
+            *error = "Could not write to file " + path + ": " + std::strerror(static_cast<int>(-ret));
+            return false;
+        }
+        done += ret;
+    }
+    return true;
+}
+
+void FileBlockCache::insertLocked(Shard& shard, const std::string& key, std::string&& value,
+                                  bool prefetched) {
+    eraseLocked(shard, key);
+    std::string victim;
+    Entry entry;
+    while(shard.bytes + value.size() > m_shard_capacity_bytes) {
+        if(!shard.policy->evict(&victim)) break;
+        if(!shard.data.extract(victim, &entry)) continue;
+        shard.bytes -= entry.value.size();
+        shard.evictions += 1;
+        if(entry.prefetched) {
+            m_prefetch_wasted += 1;
+            adjustWindow(victim, false);
+        }
+    }
+    shard.bytes += value.size();
+    auto& e = *shard.data.emplace(key).first;
+    e.value = std::move(value);
+    e.policy_entry = shard.policy->insert(key);
+    e.prefetched = prefetched;
+}
+
+std::vector<uint64_t> FileBlockCache::recordAccess(const std::string& path, uint64_t block) {
+    std::vector<uint64_t> blocks;
+    auto& stripe = patternsFor(path);
+    std::lock_guard<thallium::mutex> lock(stripe.mtx);
+    auto it = stripe.files.find(path);
+    if(it == stripe.files.end()) {
+        // bound the number of files tracked, like open files
+        if(stripe.files.size() * m_patterns.size() >= m_max_open_files)
+            stripe.files.erase(stripe.files.begin());
+        auto& p = stripe.files[path];
+        p.last_block = block;
+        p.window = m_ra_initial_window;
+        m_accesses_random += 1;
+        return blocks;
+    }
+    auto& p = it->second;
+    if(block == p.last_block) return blocks; // re-read of the same block
+    if(block > p.last_block && block - p.last_block == p.stride) {
+        p.streak += 1;
+    } else if(block > p.last_block) {
+        p.stride = block - p.last_block;
+        p.streak = 1;
+        p.next_block = 0;
+    } else {
+        p.stride = 0;
+        p.streak = 0;
+        p.next_block = 0;
+    }
+    p.last_block = block;
+    if(p.stride == 0 || p.streak < m_ra_trigger) {
+        m_accesses_random += 1;
+        return blocks;
+    }
+    if(p.stride == 1) m_accesses_sequential += 1;
+    else              m_accesses_strided += 1;
+    uint64_t last = block + p.stride * p.window;
+    for(uint64_t b = std::max(block + p.stride, p.next_block); b <= last; b += p.stride)
+        blocks.push_back(b);
+    p.next_block = std::max(p.next_block, last + p.stride);
+    return blocks;
+}
+
+void FileBlockCache::adjustWindow(const std::string& key, bool used) {
+    std::string path;
+    uint64_t block;
+    if(!parseKey(key, &path, &block)) return;
+    auto& stripe = patternsFor(path);
+    std::lock_guard<thallium::mutex> lock(stripe.mtx);
+    auto it = stripe.files.find(path);
+    if(it == stripe.files.end()) return;
+    auto& window = it->second.window;
+    if(used) window = std::min(window + 1, m_ra_max_window);
+    else     window = std::max<size_t>(window / 2, 1);
+}
+
+void FileBlockCache::prefetch(const std::string& prefix, const std::string& path,
+                              const std::vector<uint64_t>& blocks) {
+    for(auto b : blocks) {
+        std::string key = prefix + std::to_string(b);
+        auto& shard = shardFor(key);
+        auto pending = std::make_shared<PendingRead>();
+        pending->prefetch = true;
+        {
+            ShardLock lock(shard.lock, true);
+            if(shard.data.count(key) || shard.pending.count(key)) continue;
+            shard.pending.emplace(key, pending);
+        }
+        m_prefetch_issued += 1;
+        m_prefetches_in_flight += 1;
+        m_pool.make_thread([this, key, path, b, pending, &shard]() {
+            pending->success = readBlock(path, b, &pending->data, &pending->error);
+            {
+                ShardLock lock(shard.lock, true);
+                shard.pending.erase(key);
+                // blocks past the end of the file are simply not cached
+                if(pending->success && !pending->stale) {
+                    if(pending->claimed)
+                        insertLocked(shard, key, std::string(pending->data));
+                    else
+                        insertLocked(shard, key, std::move(pending->data), true);
+                }
+            }
+            pending->ready.set_value();
+            m_prefetches_in_flight -= 1;
+        }, thallium::anonymous());
+    }
+}
+
+void FileBlockCache::eraseLocked(Shard& shard, const std::string& key) {
+    Entry entry;
+    if(shard.data.extract(key, &entry)) {
+        shard.bytes -= entry.value.size();
+        shard.policy->remove(entry.policy_entry);
+    }
+}
+
+void FileBlockCache::sayHello() {
+    std::cout << "Hello World" << std::endl;
+}
+
+cachersize::RequestResult<int32_t> FileBlockCache::computeSum(int32_t x, int32_t y) {
+    cachersize::RequestResult<int32_t> result;
+    result.value() = x + y;
+    return result;
+}
+
+cachersize::RequestResult<bool> FileBlockCache::put(const std::string& key, std::string&& value) {
+    cachersize::RequestResult<bool> result;
+    std::string path;
+    uint64_t block;
+    if(!m_writable) {
+        result.success() = false;
+        result.error() = "Cache is read-only (\"writable\" is false)";
+        return result;
+    }
+    if(!parseKey(key, &path, &block)) {
+        result.success() = false;
+        result.error() = "Invalid block key \"" + key + "\" (expected \"<path>:<block>\" with a relative path)";
+        return result;
+    }
+    if(value.size() > m_block_size) {
+        result.success() = false;
+        result.error() = "Value is larger than the block size";
+        return result;
+    }
+    if(m_write_back)
+        return putWriteBack(key, path, block, std::move(value));
+    auto& shard = shardFor(key);
+    // the shard's lock is held across the write so that a concurrent
+    // miss cannot cache the content the block had before the write
+    ShardLock lock(shard.lock, true);
+    markStale(shard, key);
+    if(!writeBlocks(path, block, value, &result.error())) {
+        eraseLocked(shard, key);
+        result.success() = false;
+        return result;
+    }
+    // a partial block only overwrites the beginning of the
+    // block, so the full content is unknown until it is read
+    if(value.size() == m_block_size)
+        insertLocked(shard, key, std::move(value));
+    else
+        eraseLocked(shard, key);
+    return result;
+}
+
+/**
+ * @brief Returns the content of a block after
+ * overwriting its beginning with data.
+ */
+static std::string overlay(const std::string& block, const std::string& data) {
+    if(data.size() >= block.size()) return data;
+    std::string result = block;
+    result.replace(0, data.size(), data);
+    return result;
+}
+
+cachersize::RequestResult<bool> FileBlockCache::putWriteBack(
+        const std::string& key, const std::string& path,
+        uint64_t block, std::string&& value) {
+    cachersize::RequestResult<bool> result;
+    {
+        // throttle writers while the flushers cannot keep up
+        std::unique_lock<thallium::mutex> lock(m_dirty_mtx);
+        uint64_t errors = m_flush_errors;
+        if(m_dirty_bytes + value.size() > m_capacity_bytes && !m_draining) {
+            m_draining = true;
+            m_dirty_cv.notify_all();
+        }
+        m_dirty_cv.wait(lock, [&]() {
+            return m_dirty_bytes + value.size() <= m_capacity_bytes
+                || m_flush_errors != errors;
+        });
+        if(m_flush_errors != errors) {
+            result.success() = false;
+            result.error() = "Write-back is failing: " + m_last_flush_error;
+            return result;
+        }
+    }
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, true);
+    markStale(shard, key);
+    auto cached = shard.data.find(key);
+    std::string content;
+    {
+        std::unique_lock<thallium::mutex> dirty_lock(m_dirty_mtx);
+        auto f = m_dirty.find(path);
+        DirtyBlock* dirty = nullptr;
+        if(f != m_dirty.end()) {
+            auto b = f->second.find(block);
+            if(b != f->second.end()) dirty = &b->second;
+        }
+        if(value.size() == m_block_size) {
+            content = std::move(value);
+        } else if(cached) {
+            content = overlay(cached->value, value);
+        } else if(dirty) {
+            content = overlay(dirty->data, value);
+        } else {
+            // the rest of the block is unknown without a
+            // read, so a partial block is written through
+            dirty_lock.unlock();
+            if(!writeBlocks(path, block, value, &result.error()))
+                result.success() = false;
+            return result;
+        }
+        if(!dirty) dirty = &m_dirty[path][block];
+        m_dirty_bytes = m_dirty_bytes - dirty->data.size() + content.size();
+        dirty->data = content;
+        dirty->version = ++m_dirty_version;
+        if(!m_draining && m_dirty_bytes > m_high_watermark_bytes) {
+            m_draining = true;
+            m_dirty_cv.notify_all();
+        }
+    }
+    insertLocked(shard, key, std::move(content));
+    return result;
+}
+
+void FileBlockCache::flusherLoop() {
+    std::unique_lock<thallium::mutex> lock(m_dirty_mtx);
+    while(true) {
+        // pick a file that no other flusher is writing
+        std::string path;
+        m_dirty_cv.wait(lock, [&]() {
+            if(m_stopping) return true;
+            if(!m_draining && m_flush_requests == 0) return false;
+            for(auto& f : m_dirty) {
+                if(m_flushing_paths.count(f.first)) continue;
+                path = f.first;
+                return true;
+            }
+            return false;
+        });
+        if(m_stopping) break;
+        flushFile(lock, path);
+        if(m_draining && m_dirty_bytes <= m_low_watermark_bytes)
+            m_draining = false;
+    }
+    m_flushers_running -= 1;
+    m_dirty_cv.notify_all();
+}
+
+void FileBlockCache::flushFile(std::unique_lock<thallium::mutex>& lock, const std::string& path) {
+    // copy a batch of blocks, in file order
+    std::vector<std::pair<uint64_t, DirtyBlock>> batch;
+    size_t batch_size = 0;
+    for(auto& b : m_dirty[path]) {
+        if(batch_size + b.second.data.size() > m_max_write_size && !batch.empty()) break;
+        batch.emplace_back(b.first, b.second);
+        batch_size += b.second.data.size();
+    }
+    m_flushing_paths.insert(path);
+    lock.unlock();
+
+    // write runs of adjacent blocks; a short block ends a run
+    std::vector<bool> written(batch.size(), false);
+    std::string error;
+    size_t writes = 0, bytes = 0;
+    bool failed = false;
+    for(size_t start = 0; start < batch.size() && !failed;) {
+        size_t end = start + 1;
+        while(end < batch.size()
+           && batch[end].first == batch[end-1].first + 1
+           && batch[end-1].second.data.size() == m_block_size)
+            end += 1;
+        std::string run;
+        for(size_t i = start; i < end; i++) run += batch[i].second.data;
+        if(writeBlocks(path, batch[start].first, run, &error)) {
+            for(size_t i = start; i < end; i++) written[i] = true;
+            writes += 1;
+            bytes += run.size();
+        } else {
+            failed = true;
+        }
+        start = end;
+    }
+
+    lock.lock();
+    m_flushing_paths.erase(path);
+    auto& blocks = m_dirty[path];
+    for(size_t i = 0; i < batch.size(); i++) {
+        if(!written[i]) continue;
+        auto b = blocks.find(batch[i].first);
+        // blocks written again since they were copied stay dirty
+        if(b == blocks.end() || b->second.version != batch[i].second.version) continue;
+        m_dirty_bytes -= b->second.data.size();
+        blocks.erase(b);
+    }
+    if(blocks.empty()) m_dirty.erase(path);
+    m_flush_writes += writes;
+    m_flushed_bytes += bytes;
+    if(failed) {
+        m_flush_errors += 1;
+        m_last_flush_error = error;
+        // wait for the next put or flush() to retry
+        m_draining = false;
+    }
+    m_dirty_cv.notify_all();
+}
+
+cachersize::RequestResult<bool> FileBlockCache::flush() {
+    cachersize::RequestResult<bool> result;
+    if(!m_write_back) return result;
+    std::unique_lock<thallium::mutex> lock(m_dirty_mtx);
+    uint64_t errors = m_flush_errors;
+    m_flush_requests += 1;
+    m_dirty_cv.notify_all();
+    m_dirty_cv.wait(lock, [&]() {
+        return (m_dirty.empty() && m_flushing_paths.empty())
+            || m_flush_errors != errors
+            || m_flushers_running == 0;
+    });
+    m_flush_requests -= 1;
+    if(!m_dirty.empty()) {
+        result.success() = false;
+        result.error() = "Could not flush dirty blocks: " + m_last_flush_error;
+    }
+    return result;
+}
+
+cachersize::RequestResult<std::string> FileBlockCache::get(const std::string& key) {
+    cachersize::RequestResult<std::string> result;
+    std::string path;
+    uint64_t block;
+    if(!parseKey(key, &path, &block)) {
+        result.success() = false;
+        result.error() = "Invalid block key \"" + key + "\" (expected \"<path>:<block>\" with a relative path)";
+        return result;
+    }
+    if(m_readahead) {
+        auto blocks = recordAccess(path, block);
+        if(!blocks.empty())
+            prefetch(key.substr(0, key.rfind(':') + 1), path, blocks);
+    }
+
+    auto& shard = shardFor(key);
+    {
+        ShardLock lock(shard.lock, exclusiveLookup(shard));
+        auto entry = shard.data.find(key);
+        // the first hit on a prefetched block needs the exclusive lock
+        if(entry && !entry->prefetched) {
+            result.value() = entry->value;
+            shard.policy->touch(entry->policy_entry);
+            return result;
+        }
+    }
+
+    std::shared_ptr<PendingRead> pending;
+    bool reader = false;
+    bool prefetch_hit = false;
+    {
+        ShardLock lock(shard.lock, true);
+        auto entry = shard.data.find(key);
+        if(entry) { // prefetched, or filled while we were switching locks
+            result.value() = entry->value;
+            shard.policy->touch(entry->policy_entry);
+            prefetch_hit = entry->prefetched;
+            entry->prefetched = false;
+        } else {
+            auto it = shard.pending.find(key);
+            if(it != shard.pending.end()) {
+                pending = it->second;
+                prefetch_hit = pending->prefetch && !pending->claimed;
+                pending->claimed = true;
+            } else {
+                pending = std::make_shared<PendingRead>();
+                shard.pending.emplace(key, pending);
+                reader = true;
+            }
+        }
+    }
+    if(prefetch_hit) {
+        m_prefetch_hits += 1;
+        adjustWindow(key, true);
+    }
+    if(!pending) return result;
+
+    if(reader) {
+        pending->success = readBlock(path, block, &pending->data, &pending->error);
+        {
+            ShardLock lock(shard.lock, true);
+            shard.pending.erase(key);
+            if(pending->success && !pending->stale)
+                insertLocked(shard, key, std::string(pending->data));
+        }
+        pending->ready.set_value();
+    } else {
+        pending->ready.wait();
+    }
+
+    if(pending->success) {
+        result.value() = pending->data;
+    } else {
+        result.success() = false;
+        result.error() = pending->error;
+    }
+    return result;
+}
+
+cachersize::RequestResult<bool> FileBlockCache::erase(const std::string& key) {
+    cachersize::RequestResult<bool> result;
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, true);
+    eraseLocked(shard, key);
+    return result;
+}
+
+cachersize::RequestResult<uint8_t> FileBlockCache::exists(const std::string& key) {
+    cachersize::RequestResult<uint8_t> result;
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, false);
+    result.value() = shard.data.count(key) ? 1 : 0;
+    return result;
+}
+
+cachersize::RequestResult<bool> FileBlockCache::scan(const ScanFunction& fn) {
+    cachersize::RequestResult<bool> result;
+    std::vector<std::pair<std::string, std::string>> blocks;
+    for(auto& shard : m_shards) {
+        blocks.clear();
+        {
+            ShardLock lock(shard->lock, false);
+            blocks.reserve(shard->data.size());
+            shard->data.for_each([&blocks](const std::string& key, const Entry& entry) {
+                blocks.emplace_back(key, entry.value);
+            });
+        }
+        for(auto& block : blocks)
+            fn(block.first, block.second, 0);
+    }
+    return result;
+}
+
+cachersize::RequestResult<size_t> FileBlockCache::load(const std::vector<std::string>& keys,
+                                                       std::vector<std::string>&& values,
+                                                       const std::vector<uint64_t>& ttls_ms) {
+    (void)ttls_ms;
+    cachersize::RequestResult<size_t> result;
+    result.value() = 0;
+    std::string path;
+    uint64_t block;
+    for(size_t i = 0; i < keys.size(); i++) {
+        if(values[i].empty() || values[i].size() > m_block_size) continue;
+        if(!parseKey(keys[i], &path, &block)) continue;
+        if(m_write_back) {
+            std::lock_guard<thallium::mutex> lock(m_dirty_mtx);
+            auto f = m_dirty.find(path);
+            if(f != m_dirty.end() && f->second.count(block)) continue;
+        }
+        auto& shard = shardFor(keys[i]);
+        ShardLock lock(shard.lock, true);
+        if(shard.data.count(keys[i]) || shard.pending.count(keys[i])) continue;
+        insertLocked(shard, keys[i], std::move(values[i]));
+        result.value() += 1;
+    }
+    return result;
+}
+
+bool FileBlockCache::getMemoryProfile(MemoryProfile* profile) const {
+    profile->capacity_bytes = m_capacity_bytes;
+    profile->max_bytes      = m_capacity_bytes;
+    profile->used_bytes     = 0;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, false);
+        profile->used_bytes += shard->bytes;
+    }
+    profile->resizable = false;
+    return true;
+}
+
+json FileBlockCache::getStats() const {
+    uint64_t issued = m_prefetch_issued.load();
+    uint64_t hits   = m_prefetch_hits.load();
+    json stats = json::object();
+    size_t entries = 0, bytes = 0, evictions = 0;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, false);
+        entries   += shard->data.size();
+        bytes     += shard->bytes;
+        evictions += shard->evictions;
+    }
+    stats["entries"]   = entries;
+    stats["bytes"]     = bytes;
+    stats["evictions"] = evictions;
+    stats["prefetch"] = {
+        { "issued",   issued },
+        { "hits",     hits },
+        { "wasted",   m_prefetch_wasted.load() },
+        { "hit_rate", issued ? static_cast<double>(hits) / issued : 0.0 }
+    };
+    stats["accesses"] = {
+        { "sequential", m_accesses_sequential.load() },
+        { "strided",    m_accesses_strided.load() },
+        { "random",     m_accesses_random.load() }
+    };
+    if(m_write_back) {
+        std::lock_guard<thallium::mutex> lock(m_dirty_mtx);
+        stats["write_back"] = {
+            { "dirty_bytes",   m_dirty_bytes },
+            { "flushed_bytes", m_flushed_bytes },
+            { "flush_writes",  m_flush_writes },
+            { "flush_errors",  m_flush_errors }
+        };
+    }
+    return stats;
+}
+
+cachersize::RequestResult<bool> FileBlockCache::destroy() {
+    cachersize::RequestResult<bool> result;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, true);
+        shard->data.for_each([&shard](const std::string&, Entry& entry) {
+            shard->policy->remove(entry.policy_entry);
+        });
+        shard->data.clear();
+        shard->bytes = 0;
+    }
+    std::lock_guard<thallium::mutex> lock(m_files_mtx);
+    m_files.clear();
+    result.value() = true;
+    return result;
+}
+
+std::unique_ptr<cachersize::Backend> FileBlockCache::create(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<cachersize::Backend>(new FileBlockCache(engine, config));
+}
+
+std::unique_ptr<cachersize::Backend> FileBlockCache::open(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<cachersize::Backend>(new FileBlockCache(engine, config));
+}
@@ -0,0 +1,492 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __FILEBLOCK_BACKEND_HPP
+#define __FILEBLOCK_BACKEND_HPP
+
+#include <cachersize/Backend.hpp>
+#include <cachersize/EvictionPolicy.hpp>
+#include "../HashIndex.hpp"
+#include <abt-io.h>
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+
+using json = nlohmann::json;
+
+/**
+ * Read-through cache of fixed-size blocks of files.
+ *
+ * Keys have the form "<path>:<block>", where <path> is the path of a
+ * file (relative to the "root" directory, or to the working directory
+ * if there is none; absolute paths and ".." components are rejected
+ * so that keys cannot reach files outside of it) and <block> is the
+ * decimal index of a block in this file. get() returns the content of
+ * the block, which is shorter than the block size only for the last
+ * block of the file. On a miss, the block is read with abt-io, whose
+ * own xstreams perform the blocking I/O while the calling ULT waits,
+ * so handler xstreams keep serving requests. Concurrent misses on the
+ * same block share a single read.
+ *
+ * put() requires "writable" to be true. By default it writes the block
+ * to the file (write-through) and updates the cache. In write-back mode,
+ * put() only updates the cache and records the block as dirty, and
+ * background ULTs write dirty blocks to their files, coalescing blocks
+ * that are adjacent in a file into single large writes. Flushing starts
+ * when dirty data exceeds the high watermark and stops below the low
+ * watermark (both fractions of the capacity); puts are throttled while
+ * dirty data would exceed the capacity. Dirty blocks are kept until they
+ * are written, even if their cached copy is evicted, and misses are
+ * served from them. flush() writes all dirty blocks.
+ *
+ * erase() and exists() only act on the cached copy of a block, never
+ * on the file.
+ *
+ * Like the memory backend, cached blocks are spread across shards,
+ * each with its own lock and instance of the eviction policy.
+ *
+ * Read-ahead: the backend tracks the stride between successive block
+ * accesses to each file. Once the same forward stride has been seen
+ * "trigger" times in a row (stride 1 being a sequential pattern, any
+ * other a strided one), the next "window" blocks along the stride are
+ * read asynchronously by ULTs of the engine's handler pool. The window
+ * of each file grows by one block each time a prefetched block is used,
+ * and is halved each time a prefetched block is evicted unused. Other
+ * access patterns are considered random and trigger no read-ahead.
+ * Prefetch counters are reported by getStats().
+ *
+ * Accepted configuration fields:
+ * - "block_size" (integer, default 65536): size of a block in bytes.
+ * - "capacity_bytes" (integer, default 1 GiB): maximum number of bytes
+ *   of cached blocks.
+ * - "num_shards" (integer, default 16): number of shards.
+ * - "abt_io_threads" (integer, default 4): number of xstreams that
+ *   abt-io uses to run I/O operations.
+ * - "max_open_files" (integer, default 256): maximum number of file
+ *   descriptors kept open.
+ * - "root" (string, default ""): directory that paths are relative to.
+ * - "writable" (boolean, default false): whether put() is allowed.
+ * - "eviction" (object, optional): eviction policy configuration, as
+ *   for the memory backend; the default policy is "lru".
+ * - "readahead" (object, optional): read-ahead configuration, with
+ *   fields "enabled" (boolean, default true), "trigger" (integer,
+ *   default 2), "initial_window" (integer, default 4), and
+ *   "max_window" (integer, default 64).
+ * - "write_back" (object, optional): write-back configuration, with
+ *   fields "enabled" (boolean, default false), "high_watermark" (number,
+ *   default 0.5), "low_watermark" (number, default 0.25), "flush_threads"
+ *   (integer, default 1), and "max_write_size" (integer, default 8 MiB,
+ *   the largest coalesced write).
+ */
+class FileBlockCache : public cachersize::Backend {
+
+    struct Entry {
+        std::string                          value;
+        cachersize::EvictionPolicy::Entry*   policy_entry = nullptr;
+        bool                                 prefetched = false; // not used since read ahead
+    };
+
+    /**
+     * @brief Read of a block that is in progress; ULTs that miss
+     * on the same block wait on it instead of issuing their own.
+     */
+    struct PendingRead {
+        thallium::eventual<void> ready;
+        bool                     success = false;
+        bool                     prefetch = false; // issued by read-ahead
+        bool                     claimed = false;  // a get() is waiting for it
+        bool                     stale = false;    // the block was written meanwhile
+        std::string              data;
+        std::string              error;
+    };
+
+    /**
+     * @brief Access pattern of a file, as seen by get().
+     */
+    struct AccessPattern {
+        uint64_t last_block = 0;
+        uint64_t stride = 0;     // 0 until a forward stride is seen
+        unsigned streak = 0;     // consecutive accesses at this stride
+        uint64_t next_block = 0; // first block not yet read ahead
+        size_t   window = 0;     // number of blocks to read ahead
+    };
+
+    /**
+     * @brief Block written in write-back mode and not yet flushed.
+     */
+    struct DirtyBlock {
+        std::string data;
+        uint64_t    version = 0; // changes each time the block is written
+    };
+
+    /**
+     * @brief Stripe of the per-file access patterns.
+     */
+    struct PatternStripe {
+        thallium::mutex                                mtx;
+        std::unordered_map<std::string, AccessPattern> files;
+    };
+
+    struct Shard {
+        thallium::rwlock                                              lock;
+        cachersize::HashIndex<Entry>                                  data;
+        std::unordered_map<std::string, std::shared_ptr<PendingRead>> pending;
+        std::unique_ptr<cachersize::EvictionPolicy>                   policy;
+        size_t                                                        bytes = 0;
+        size_t                                                        evictions = 0;
+    };
+
+    /**
+     * @brief Open file. The descriptor is closed when the last
+     * ULT using it releases its reference.
+     */
+    struct File {
+        abt_io_instance_id abtio;
+        int                fd;
+        File(abt_io_instance_id io, int f) : abtio(io), fd(f) {}
+        ~File() { abt_io_close(abtio, fd); }
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+    };
+
+    /**
+     * @brief Locks a shard in exclusive or shared mode
+     * for the lifetime of the object.
+     */
+    class ShardLock {
+        thallium::rwlock& m_lock;
+        public:
+        ShardLock(thallium::rwlock& lock, bool exclusive)
+        : m_lock(lock) {
+            if(exclusive) m_lock.wrlock();
+            else          m_lock.rdlock();
+        }
+        ~ShardLock() { m_lock.unlock(); }
+        ShardLock(const ShardLock&) = delete;
+        ShardLock& operator=(const ShardLock&) = delete;
+    };
+
+    json                                                   m_config;
+    abt_io_instance_id                                     m_abtio = ABT_IO_INSTANCE_NULL;
+    std::vector<std::unique_ptr<Shard>>                    m_shards;
+    size_t                                                 m_block_size = 0;
+    size_t                                                 m_shard_capacity_bytes = 0;
+    size_t                                                 m_max_open_files = 0;
+    std::string                                            m_root;
+    bool                                                   m_writable = false;
+    std::unordered_map<std::string, std::shared_ptr<File>> m_files;
+    thallium::mutex                                        m_files_mtx;
+
+    thallium::pool                                         m_pool; // runs read-ahead and flusher ULTs
+
+    // read-ahead
+    bool                                                   m_readahead = true;
+    unsigned                                               m_ra_trigger = 2;
+    size_t                                                 m_ra_initial_window = 4;
+    size_t                                                 m_ra_max_window = 64;
+    std::vector<std::unique_ptr<PatternStripe>>            m_patterns;
+    std::atomic<uint64_t>                                  m_prefetches_in_flight = { 0 };
+    std::atomic<uint64_t>                                  m_prefetch_issued = { 0 };
+    std::atomic<uint64_t>                                  m_prefetch_hits = { 0 };
+    std::atomic<uint64_t>                                  m_prefetch_wasted = { 0 };
+    std::atomic<uint64_t>                                  m_accesses_sequential = { 0 };
+    std::atomic<uint64_t>                                  m_accesses_strided = { 0 };
+    std::atomic<uint64_t>                                  m_accesses_random = { 0 };
+
+    // write-back, protected by m_dirty_mtx
+    bool                                                   m_write_back = false;
+    size_t                                                 m_capacity_bytes = 0;
+    size_t                                                 m_high_watermark_bytes = 0;
+    size_t                                                 m_low_watermark_bytes = 0;
+    size_t                                                 m_max_write_size = 0;
+    std::map<std::string, std::map<uint64_t, DirtyBlock>>  m_dirty;
+    std::unordered_set<std::string>                        m_flushing_paths;
+    size_t                                                 m_dirty_bytes = 0;
+    uint64_t                                               m_dirty_version = 0;
+    bool                                                   m_draining = false;
+    unsigned                                               m_flush_requests = 0;
+    uint64_t                                               m_flush_errors = 0;
+    std::string                                            m_last_flush_error;
+    bool                                                   m_stopping = false;
+    unsigned                                               m_flushers_running = 0;
+    uint64_t                                               m_flushed_bytes = 0;
+    uint64_t                                               m_flush_writes = 0;
+    mutable thallium::mutex                                m_dirty_mtx;
+    thallium::condition_variable                           m_dirty_cv;
+
+    Shard& shardFor(const std::string& key) {
+        return *m_shards[std::hash<std::string>()(key) % m_shards.size()];
+    }
+
+    static bool exclusiveLookup(const Shard& shard) {
+        return !shard.policy->concurrentTouch();
+    }
+
+    /**
+     * @brief Splits a key into a file path (with the root prepended)
+     * and a block index.
+     *
+     * @return false if the key is not of the form "<path>:<block>"
+     * or if the path is absolute or has a ".." component.
+     */
+    bool parseKey(const std::string& key, std::string* path, uint64_t* block) const;
+
+    /**
+     * @brief Returns an open file, opening it if needed.
+     * Throws a cachersize::Exception if the file cannot be opened.
+     */
+    std::shared_ptr<File> openFile(const std::string& path);
+
+    /**
+     * @brief Reads a block from its file through abt-io.
+     *
+     * @return false (and sets error) if the block could not be read.
+     */
+    bool readBlock(const std::string& path, uint64_t block,
+                   std::string* data, std::string* error);
+
+    /**
+     * @brief Writes data at the beginning of a block through abt-io.
+     *
+     * @return false (and sets error) if the data could not be written.
+     */
+    bool writeBlocks(const std::string& path, uint64_t first_block,
+                     const std::string& data, std::string* error);
+
+    /**
+     * @brief Stores a block in write-back mode.
+     */
+    cachersize::RequestResult<bool> putWriteBack(
+            const std::string& key, const std::string& path,
+            uint64_t block, std::string&& value);
+
+    /**
+     * @brief Main loop of the flusher ULTs.
+     */
+    void flusherLoop();
+
+    /**
+     * @brief Writes up to max_write_size bytes of the dirty blocks of
+     * a file, coalescing adjacent blocks. m_dirty_mtx must be held
+     * by lock, which is released during the writes.
+     */
+    void flushFile(std::unique_lock<thallium::mutex>& lock, const std::string& path);
+
+    /**
+     * @brief Inserts a block in a shard whose lock is held
+     * exclusively, evicting other blocks to make room.
+     */
+    void insertLocked(Shard& shard, const std::string& key, std::string&& value,
+                      bool prefetched = false);
+
+    PatternStripe& patternsFor(const std::string& path) {
+        return *m_patterns[std::hash<std::string>()(path) % m_patterns.size()];
+    }
+
+    /**
+     * @brief Records an access to a block of a file and returns the
+     * blocks to read ahead, if the file's access pattern calls for it.
+     */
+    std::vector<uint64_t> recordAccess(const std::string& path, uint64_t block);
+
+    /**
+     * @brief Grows (used = true) or shrinks (used = false) the
+     * read-ahead window of the file a prefetched block belongs to.
+     */
+    void adjustWindow(const std::string& key, bool used);
+
+    /**
+     * @brief Reads blocks of a file asynchronously, skipping those
+     * that are already cached or being read.
+     *
+     * @param prefix key prefix of the file ("<path>:")
+     * @param path path of the file, with the root prepended
+     * @param blocks blocks to read
+     */
+    void prefetch(const std::string& prefix, const std::string& path,
+                  const std::vector<uint64_t>& blocks);
+
+    /**
+     * @brief Prevents a read of the block in progress from caching
+     * the content the block had before a write. The shard's lock
+     * must be held exclusively.
+     */
+    static void markStale(Shard& shard, const std::string& key) {
+        auto it = shard.pending.find(key);
+        if(it != shard.pending.end()) it->second->stale = true;
+    }
+
+    /**
+     * @brief Drops the cached copy of a block from a shard whose
+     * lock is held exclusively.
+     */
+    void eraseLocked(Shard& shard, const std::string& key);
+
+    public:
+
+    /**
+     * @brief Constructor. Throws a cachersize::Exception if the
+     * configuration is invalid or abt-io cannot be initialized.
+     */
+    FileBlockCache(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Move-constructor is deleted.
+     */
+    FileBlockCache(FileBlockCache&&) = delete;
+
+    /**
+     * @brief Copy-constructor is deleted.
+     */
+    FileBlockCache(const FileBlockCache&) = delete;
+
+    /**
+     * @brief Move-assignment operator is deleted.
+     */
+    FileBlockCache& operator=(FileBlockCache&&) = delete;
+
+    /**
+     * @brief Copy-assignment operator is deleted.
+     */
+    FileBlockCache& operator=(const FileBlockCache&) = delete;
+
+    /**
+     * @brief Destructor. Flushes dirty blocks, waits for read-ahead
+     * in progress, closes the files, and finalizes abt-io.
+     */
+    virtual ~FileBlockCache();
+
+    /**
+     * @brief Prints Hello World.
+     */
+    void sayHello() override;
+
+    /**
+     * @brief Compute the sum of two integers.
+     *
+     * @param x first integer
+     * @param y second integer
+     *
+     * @return a RequestResult containing the result.
+     */
+    cachersize::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    /**
+     * @brief Writes a block to its file and caches it. The value
+     * may not be larger than the block size.
+     *
+     * @param key "<path>:<block>" key
+     * @param value content of the block
+     *
+     * @return a RequestResult<bool> indicating whether the block was written.
+     */
+    cachersize::RequestResult<bool> put(const std::string& key, std::string&& value) override;
+
+    /**
+     * @brief Retrieves a block, reading it from its file on a miss.
+     *
+     * @param key "<path>:<block>" key
+     *
+     * @return a RequestResult containing the content of the block.
+     */
+    cachersize::RequestResult<std::string> get(const std::string& key) override;
+
+    /**
+     * @brief Drops the cached copy of a block.
+     *
+     * @param key "<path>:<block>" key
+     *
+     * @return a RequestResult<bool> indicating whether the operation succeeded.
+     */
+    cachersize::RequestResult<bool> erase(const std::string& key) override;
+
+    /**
+     * @brief Checks whether a block is currently cached.
+     *
+     * @param key "<path>:<block>" key
+     *
+     * @return a RequestResult whose value is 1 if the block is cached, 0 otherwise.
+     */
+    cachersize::RequestResult<uint8_t> exists(const std::string& key) override;
+
+    /**
+     * @brief Returns the number of blocks and of bytes cached, the
+     * number of blocks evicted, the read-ahead counters: number of prefetches
+     * issued, used ("hits"), and evicted unused ("wasted"), the hit
+     * rate, and the number of accesses classified as sequential,
+     * strided, and random; and the write-back counters: dirty bytes,
+     * bytes flushed, number of writes issued, and flush errors.
+     */
+    json getStats() const override;
+
+    /**
+     * @brief Calls fn on every cached block (dirty blocks that are
+     * no longer cached are not visited).
+     */
+    cachersize::RequestResult<bool> scan(const ScanFunction& fn) override;
+
+    /**
+     * @brief Caches blocks restored from a snapshot without writing them
+     * to their files. Blocks that are cached, being read, or dirty are
+     * skipped, as are blocks larger than the block size. The snapshot is
+     * assumed to be consistent with the current content of the files.
+     */
+    cachersize::RequestResult<size_t> load(const std::vector<std::string>& keys,
+                                           std::vector<std::string>&& values,
+                                           const std::vector<uint64_t>& ttls_ms) override;
+
+    /**
+     * @brief Reports the cache's capacity, which cannot be changed.
+     */
+    bool getMemoryProfile(MemoryProfile* profile) const override;
+
+    /**
+     * @brief Writes all the dirty blocks to their files (write-back
+     * mode only; a no-op otherwise).
+     *
+     * @return a RequestResult<bool> indicating whether all
+     * the blocks were written.
+     */
+    cachersize::RequestResult<bool> flush() override;
+
+    /**
+     * @brief Drops all the cached blocks and closes the files.
+     * The files themselves are left untouched.
+     *
+     * @return a RequestResult<bool> instance indicating
+     * whether the cache was successfully destroyed.
+     */
+    cachersize::RequestResult<bool> destroy() override;
+
+    /**
+     * @brief Static factory function used by the CacheFactory to
+     * create a FileBlockCache.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the cache
+     *
+     * @return a unique_ptr to a cache
+     */
+    static std::unique_ptr<cachersize::Backend> create(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Static factory function used by the CacheFactory to
+     * open a FileBlockCache. The cache starts empty and refills
+     * from the files.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the cache
+     *
+     * @return a unique_ptr to a cache
+     */
+    static std::unique_ptr<cachersize::Backend> open(const thallium::engine& engine, const json& config);
+};
+
+#endif
@@ -0,0 +1,683 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include "MemoryBackend.hpp"
+#include <cachersize/Exception.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+CACHERSIZE_REGISTER_BACKEND(memory, MemoryCache);
+
+static size_t getUnsigned(const json& config, const char* field, size_t default_value) {
+    if(!config.contains(field))
+        return default_value;
+    auto& v = config[field];
+    if(!v.is_number_unsigned())
+        throw cachersize::Exception(
+            std::string("\"") + field + "\" field should be an unsigned integer");
+    return v.get<size_t>();
+}
+
+static uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<typename EntryType>
+static bool isExpired(const EntryType& entry) {
+    return entry.expiry_ms && entry.expiry_ms <= nowMs();
+}
+
+MemoryCache::MemoryCache(const thallium::engine& engine, const json& config)
+: m_config(config)
+, m_engine(engine)
+, m_pool(engine.get_handler_pool()) {
+    if(!m_config.is_object())
+        m_config = json::object();
+    size_t num_shards       = getUnsigned(m_config, "num_shards", 16);
+    size_t capacity_bytes   = getUnsigned(m_config, "capacity_bytes", 0);
+    size_t capacity_entries = getUnsigned(m_config, "capacity_entries", 0);
+    m_default_ttl_ms        = getUnsigned(m_config, "default_ttl_ms", 0);
+    m_ttl_resolution_ms     = getUnsigned(m_config, "ttl_resolution_ms", 10);
+    if(num_shards == 0)
+        throw cachersize::Exception("\"num_shards\" field should be strictly positive");
+    if(m_ttl_resolution_ms == 0)
+        throw cachersize::Exception("\"ttl_resolution_ms\" field should be strictly positive");
+    m_config["num_shards"]        = num_shards;
+    m_config["capacity_bytes"]    = capacity_bytes;
+    m_config["capacity_entries"]  = capacity_entries;
+    m_config["default_ttl_ms"]    = m_default_ttl_ms;
+    m_config["ttl_resolution_ms"] = m_ttl_resolution_ms;
+    // a non-zero capacity never rounds down to "unlimited"
+    if(capacity_bytes)
+        m_shard_capacity_bytes = std::max<size_t>(1, capacity_bytes / num_shards);
+    m_max_capacity_bytes = capacity_bytes;
+    if(capacity_entries)
+        m_shard_capacity_entries = std::max<size_t>(1, capacity_entries / num_shards);
+
+    json eviction = json::object();
+    if(m_config.contains("eviction")) {
+        eviction = m_config["eviction"];
+        if(!eviction.is_object())
+            throw cachersize::Exception("\"eviction\" field should be an object");
+    }
+    if(!eviction.contains("policy"))
+        eviction["policy"] = "none";
+    if(!eviction["policy"].is_string())
+        throw cachersize::Exception("\"eviction.policy\" field should be a string");
+    std::string policy_name = eviction["policy"].get<std::string>();
+    m_config["eviction"] = eviction;
+
+    json compression = json::object();
+    if(m_config.contains("compression")) {
+        compression = m_config["compression"];
+        if(!compression.is_object())
+            throw cachersize::Exception("\"compression\" field should be an object");
+    }
+    if(!compression.contains("algorithm"))
+        compression["algorithm"] = "none";
+    if(!compression["algorithm"].is_string())
+        throw cachersize::Exception("\"compression.algorithm\" field should be a string");
+    m_compression = cachersize::compression::fromName(compression["algorithm"].get<std::string>());
+    m_compression_min_size = getUnsigned(compression, "min_size", 256);
+    if(compression.contains("level") && !compression["level"].is_number_integer())
+        throw cachersize::Exception("\"compression.level\" field should be an integer");
+    m_compression_level = compression.value("level", 0);
+    compression["min_size"] = m_compression_min_size;
+    compression["level"]    = m_compression_level;
+    m_config["compression"] = compression;
+
+    json admission = json::object();
+    if(m_config.contains("admission")) {
+        admission = m_config["admission"];
+        if(!admission.is_object())
+            throw cachersize::Exception("\"admission\" field should be an object");
+    }
+    if(!admission.contains("enabled"))
+        admission["enabled"] = false;
+    if(!admission["enabled"].is_boolean())
+        throw cachersize::Exception("\"admission.enabled\" field should be a boolean");
+    // 16 counters per entry make collisions between
+    // resident keys unlikely, as in Caffeine's sketch
+    size_t admission_counters = getUnsigned(admission, "counters",
+                                            capacity_entries ? 16 * capacity_entries : 65536);
+    size_t admission_sample   = getUnsigned(admission, "sample_size", 10 * admission_counters);
+    if(admission_counters == 0)
+        throw cachersize::Exception("\"admission.counters\" field should be strictly positive");
+    if(admission_sample == 0)
+        throw cachersize::Exception("\"admission.sample_size\" field should be strictly positive");
+    if(admission["enabled"].get<bool>()) {
+        if(policy_name == "none")
+            throw cachersize::Exception("\"admission\" requires an eviction policy");
+        m_admission.reset(new cachersize::FrequencySketch(admission_counters, admission_sample));
+    }
+    admission["counters"]    = admission_counters;
+    admission["sample_size"] = admission_sample;
+    m_config["admission"] = admission;
+
+    m_shards.reserve(num_shards);
+    for(size_t i = 0; i < num_shards; i++) {
+        m_shards.emplace_back(new Shard());
+        if(policy_name == "none") continue;
+        m_shards.back()->policy = cachersize::EvictionPolicyFactory::createPolicy(
+            policy_name, eviction, m_shard_capacity_entries);
+        if(!m_shards.back()->policy)
+            throw cachersize::Exception("Unknown eviction policy \"" + policy_name + "\"");
+    }
+    if(m_default_ttl_ms) startExpirer();
+}
+
+MemoryCache::~MemoryCache() {
+    std::unique_lock<thallium::mutex> lock(m_expirer_mtx);
+    m_stopping = true;
+    m_expirer_cv.wait(lock, [this]() { return !m_expirer_running; });
+}
+
+uint64_t MemoryCache::expiryFor(uint64_t ttl_ms) const {
+    if(ttl_ms == 0) ttl_ms = m_default_ttl_ms;
+    return ttl_ms ? nowMs() + ttl_ms : 0;
+}
+
+void MemoryCache::setExpiry(Shard& shard, const std::string& key, Entry& entry, uint64_t expiry_ms) {
+    entry.expiry_ms = expiry_ms;
+    if(!expiry_ms) {
+        cancelExpiry(shard, entry);
+        return;
+    }
+    // the timer fires at the first tick at or after the expiry time
+    uint64_t tick = (expiry_ms + m_ttl_resolution_ms - 1) / m_ttl_resolution_ms;
+    if(!shard.wheel)
+        shard.wheel.reset(new cachersize::TimerWheel(nowMs() / m_ttl_resolution_ms));
+    if(entry.timer) shard.wheel->reschedule(entry.timer, tick);
+    else            entry.timer = shard.wheel->schedule(key, tick);
+}
+
+void MemoryCache::startExpirer() {
+    if(m_expirer_started.load(std::memory_order_acquire)) return;
+    std::unique_lock<thallium::mutex> lock(m_expirer_mtx);
+    if(m_expirer_started.load(std::memory_order_relaxed)) return;
+    m_expirer_running = true;
+    m_pool.make_thread([this]() { expirerLoop(); }, thallium::anonymous());
+    m_expirer_started.store(true, std::memory_order_release);
+}
+
+void MemoryCache::expirerLoop() {
+    while(true) {
+        thallium::thread::sleep(m_engine, static_cast<double>(m_ttl_resolution_ms));
+        {
+            std::unique_lock<thallium::mutex> lock(m_expirer_mtx);
+            if(m_stopping) break;
+        }
+        expire();
+    }
+    std::unique_lock<thallium::mutex> lock(m_expirer_mtx);
+    m_expirer_running = false;
+    m_expirer_cv.notify_all();
+}
+
+void MemoryCache::expire() {
+    uint64_t now = nowMs() / m_ttl_resolution_ms;
+    Entry entry;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, true);
+        if(!shard->wheel) continue;
+        if(shard->wheel->size() == 0) {
+            shard->wheel->skipTo(now);
+            continue;
+        }
+        shard->wheel->advance(now, [&](const std::string& key) {
+            if(!shard->data.extract(key, &entry)) return;
+            removeBytes(*shard, key, entry);
+            shard->expirations += 1;
+            if(shard->policy) shard->policy->remove(entry.policy_entry);
+        });
+    }
+}
+
+void MemoryCache::evictLocked(Shard& shard, const std::string& victim) {
+    Entry entry;
+    if(shard.data.extract(victim, &entry)) {
+        cancelExpiry(shard, entry);
+        removeBytes(shard, victim, entry);
+        shard.evictions += 1;
+        if(m_track_ghosts.load(std::memory_order_relaxed))
+            addGhost(shard, victim, victim.size() + entry.value.size());
+    }
+}
+
+void MemoryCache::addGhost(Shard& shard, const std::string& key, size_t bytes) {
+    uint64_t hash = std::hash<std::string>()(key);
+    shard.ghosts.emplace_back(hash, bytes);
+    shard.ghost_index[hash] += 1;
+    shard.ghost_bytes += bytes;
+    size_t max_bytes = m_shard_capacity_bytes.load(std::memory_order_relaxed) / 10;
+    while(!shard.ghosts.empty() && shard.ghost_bytes > max_bytes) {
+        auto& ghost = shard.ghosts.front();
+        auto it = shard.ghost_index.find(ghost.first);
+        if(--it->second == 0) shard.ghost_index.erase(it);
+        shard.ghost_bytes -= ghost.second;
+        shard.ghosts.pop_front();
+    }
+}
+
+void MemoryCache::makeRoom(Shard& shard, size_t entry_bytes) {
+    std::string victim;
+    while(isFull(shard, entry_bytes)) {
+        if(!shard.policy->evict(&victim)) break;
+        evictLocked(shard, victim);
+    }
+}
+
+bool MemoryCache::admit(Shard& shard, const std::string& key) {
+    // only peek at the victim: evicting it and inserting it back
+    // would look like a hit (or a ghost hit) to the policy
+    std::string victim;
+    if(!shard.policy->victim(&victim)) return true;
+    return m_admission->estimate(std::hash<std::string>()(key))
+         > m_admission->estimate(std::hash<std::string>()(victim));
+}
+
+void MemoryCache::sayHello() {
+    std::cout << "Hello World" << std::endl;
+}
+
+cachersize::RequestResult<int32_t> MemoryCache::computeSum(int32_t x, int32_t y) {
+    cachersize::RequestResult<int32_t> result;
+    result.value() = x + y;
+    return result;
+}
+
+bool MemoryCache::compress(std::string& value) const {
+    if(m_compression == cachersize::Compression::None || value.size() < m_compression_min_size)
+        return false;
+    std::string frame;
+    if(!cachersize::compression::compress(m_compression, m_compression_level,
+                                          value.data(), value.size(), &frame))
+        return false;
+    // the frame was allocated for the worst case
+    frame.shrink_to_fit();
+    value = std::move(frame);
+    return true;
+}
+
+const char* MemoryCache::putLocked(Shard& shard, const std::string& key, std::string&& value,
+                                   bool compressed, uint64_t expiry_ms) {
+    size_t entry_bytes = key.size() + value.size();
+    if(m_shard_capacity_bytes && entry_bytes > m_shard_capacity_bytes)
+        return "Value is too large for this cache";
+    auto old_entry = shard.data.find(key);
+    size_t old_bytes = old_entry ? key.size() + old_entry->value.size() : 0;
+
+    if(shard.policy) {
+        // only new keys go through the admission filter, so
+        // that a rejected put never leaves a stale value behind
+        if(!old_entry && m_admission && isFull(shard, entry_bytes) && !admit(shard, key)) {
+            shard.rejections += 1;
+            return nullptr;
+        }
+        // the old entry is dropped first so that making room
+        // never has to pick between it and other victims
+        if(old_entry) {
+            cancelExpiry(shard, *old_entry);
+            shard.policy->remove(old_entry->policy_entry);
+            removeBytes(shard, key, *old_entry);
+            shard.data.erase(key);
+        }
+        makeRoom(shard, entry_bytes);
+        auto& entry = *shard.data.emplace(key).first;
+        entry.value = std::move(value);
+        entry.compressed = compressed;
+        entry.policy_entry = shard.policy->insert(key);
+        setExpiry(shard, key, entry, expiry_ms);
+        addBytes(shard, key, entry);
+        return nullptr;
+    }
+
+    size_t new_bytes = shard.bytes - old_bytes + entry_bytes;
+    if(m_shard_capacity_bytes && new_bytes > m_shard_capacity_bytes)
+        return "Cache is full (capacity_bytes reached)";
+    if(!old_entry) {
+        if(m_shard_capacity_entries && shard.data.size() >= m_shard_capacity_entries)
+            return "Cache is full (capacity_entries reached)";
+        old_entry = shard.data.emplace(key).first;
+    } else {
+        removeBytes(shard, key, *old_entry);
+    }
+    old_entry->value = std::move(value);
+    old_entry->compressed = compressed;
+    setExpiry(shard, key, *old_entry, expiry_ms);
+    addBytes(shard, key, *old_entry);
+    return nullptr;
+}
+
+bool MemoryCache::getLocked(Shard& shard, const std::string& key, std::string* value,
+                            bool framed, bool* compressed) {
+    auto entry = shard.data.find(key);
+    // an expired entry may not have been reclaimed yet
+    if(!entry || isExpired(*entry)) return false;
+    if(framed && !entry->compressed) {
+        value->clear();
+        cachersize::compression::appendRawFrame(entry->value.data(), entry->value.size(), value);
+    } else {
+        *value = entry->value;
+    }
+    *compressed = framed || entry->compressed;
+    if(shard.policy) shard.policy->touch(entry->policy_entry);
+    return true;
+}
+
+void MemoryCache::eraseLocked(Shard& shard, const std::string& key) {
+    Entry entry;
+    if(shard.data.extract(key, &entry)) {
+        cancelExpiry(shard, entry);
+        removeBytes(shard, key, entry);
+        if(shard.policy) shard.policy->remove(entry.policy_entry);
+    }
+}
+
+template<typename F>
+void MemoryCache::forEachShard(const std::vector<std::string>& keys, F&& f) {
+    // counting sort of the item indices by shard, so that
+    // each shard is locked once for the whole batch
+    size_t num_shards = m_shards.size();
+    std::vector<size_t> shard_of(keys.size());
+    std::vector<size_t> offsets(num_shards + 1, 0);
+    for(size_t i = 0; i < keys.size(); i++) {
+        shard_of[i] = shardIndex(keys[i]);
+        offsets[shard_of[i] + 1] += 1;
+    }
+    for(size_t s = 0; s < num_shards; s++)
+        offsets[s + 1] += offsets[s];
+    std::vector<size_t> order(keys.size());
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < keys.size(); i++)
+        order[next[shard_of[i]]++] = i;
+    for(size_t s = 0; s < num_shards; s++) {
+        if(offsets[s] == offsets[s + 1]) continue;
+        f(*m_shards[s], order.data() + offsets[s], offsets[s + 1] - offsets[s]);
+    }
+}
+
+cachersize::RequestResult<bool> MemoryCache::put(const std::string& key, std::string&& value) {
+    return putWithTTL(key, std::move(value), 0);
+}
+
+cachersize::RequestResult<bool> MemoryCache::putWithTTL(const std::string& key, std::string&& value,
+                                                        uint64_t ttl_ms) {
+    cachersize::RequestResult<bool> result;
+    uint64_t expiry_ms = expiryFor(ttl_ms);
+    if(expiry_ms) startExpirer();
+    recordAccess(key);
+    bool compressed = compress(value);
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, true);
+    auto error = putLocked(shard, key, std::move(value), compressed, expiry_ms);
+    if(error) {
+        result.success() = false;
+        result.error() = error;
+    }
+    return result;
+}
+
+cachersize::RequestResult<std::string> MemoryCache::lookup(const std::string& key, bool framed) {
+    cachersize::RequestResult<std::string> result;
+    recordAccess(key);
+    auto& shard = shardFor(key);
+    bool found = false, compressed = false;
+    {
+        ShardLock lock(shard.lock, exclusiveLookup(shard));
+        found = getLocked(shard, key, &result.value(), framed, &compressed);
+        if(!found) checkGhost(shard, key);
+    }
+    if(!found) {
+        result.success() = false;
+        result.code() = cachersize::ResultCode::KeyNotFound;
+        result.error() = "Key not found";
+    } else if(compressed && !framed) {
+        std::string frame = std::move(result.value());
+        try {
+            cachersize::compression::decompress(frame, &result.value());
+        } catch(const cachersize::Exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+        }
+    }
+    return result;
+}
+
+cachersize::RequestResult<std::string> MemoryCache::get(const std::string& key) {
+    return lookup(key, false);
+}
+
+cachersize::RequestResult<std::string> MemoryCache::getCompressed(const std::string& key) {
+    return lookup(key, true);
+}
+
+cachersize::RequestResult<bool> MemoryCache::erase(const std::string& key) {
+    cachersize::RequestResult<bool> result;
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, true);
+    eraseLocked(shard, key);
+    return result;
+}
+
+cachersize::RequestResult<std::vector<cachersize::Status>> MemoryCache::putMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>&& values) {
+    return putMultiWithTTL(keys, std::move(values), 0);
+}
+
+cachersize::RequestResult<std::vector<cachersize::Status>> MemoryCache::putMultiWithTTL(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>&& values,
+        uint64_t ttl_ms) {
+    cachersize::RequestResult<std::vector<cachersize::Status>> result;
+    uint64_t expiry_ms = expiryFor(ttl_ms);
+    if(expiry_ms) startExpirer();
+    std::vector<char> compressed(keys.size());
+    for(size_t i = 0; i < keys.size(); i++) {
+        recordAccess(keys[i]);
+        compressed[i] = compress(values[i]);
+    }
+    auto& status = result.value();
+    status.resize(keys.size(), cachersize::Status::OK);
+    forEachShard(keys, [&](Shard& shard, const size_t* items, size_t count) {
+        ShardLock lock(shard.lock, true);
+        for(size_t j = 0; j < count; j++) {
+            size_t i = items[j];
+            if(putLocked(shard, keys[i], std::move(values[i]), compressed[i], expiry_ms))
+                status[i] = cachersize::Status::Error;
+        }
+    });
+    return result;
+}
+
+cachersize::RequestResult<std::vector<cachersize::Status>> MemoryCache::lookupMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* values,
+        bool framed) {
+    cachersize::RequestResult<std::vector<cachersize::Status>> result;
+    auto& status = result.value();
+    status.resize(keys.size(), cachersize::Status::OK);
+    values->resize(keys.size());
+    for(auto& key : keys)
+        recordAccess(key);
+    std::vector<char> compressed(keys.size(), 0);
+    forEachShard(keys, [&](Shard& shard, const size_t* items, size_t count) {
+        ShardLock lock(shard.lock, exclusiveLookup(shard));
+        for(size_t j = 0; j < count; j++) {
+            size_t i = items[j];
+            bool c = false;
+            if(!getLocked(shard, keys[i], &(*values)[i], framed, &c)) {
+                status[i] = cachersize::Status::NotFound;
+                checkGhost(shard, keys[i]);
+            }
+            compressed[i] = c;
+        }
+    });
+    if(framed) return result;
+    std::string frame;
+    for(size_t i = 0; i < keys.size(); i++) {
+        if(!compressed[i]) continue;
+        frame = std::move((*values)[i]);
+        try {
+            cachersize::compression::decompress(frame, &(*values)[i]);
+        } catch(const cachersize::Exception&) {
+            status[i] = cachersize::Status::Error;
+        }
+    }
+    return result;
+}
+
+cachersize::RequestResult<std::vector<cachersize::Status>> MemoryCache::getMulti(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* values) {
+    return lookupMulti(keys, values, false);
+}
+
+cachersize::RequestResult<std::vector<cachersize::Status>> MemoryCache::getMultiCompressed(
+        const std::vector<std::string>& keys,
+        std::vector<std::string>* frames) {
+    return lookupMulti(keys, frames, true);
+}
+
+cachersize::RequestResult<std::vector<cachersize::Status>> MemoryCache::eraseMulti(
+        const std::vector<std::string>& keys) {
+    cachersize::RequestResult<std::vector<cachersize::Status>> result;
+    result.value().resize(keys.size(), cachersize::Status::OK);
+    forEachShard(keys, [&](Shard& shard, const size_t* items, size_t count) {
+        ShardLock lock(shard.lock, true);
+        for(size_t j = 0; j < count; j++)
+            eraseLocked(shard, keys[items[j]]);
+    });
+    return result;
+}
+
+cachersize::RequestResult<uint8_t> MemoryCache::exists(const std::string& key) {
+    cachersize::RequestResult<uint8_t> result;
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, false);
+    auto entry = shard.data.find(key);
+    result.value() = entry && !isExpired(*entry) ? 1 : 0;
+    return result;
+}
+
+json MemoryCache::getStats() const {
+    size_t entries = 0, bytes = 0, logical_bytes = 0, evictions = 0, expirations = 0;
+    size_t rejections = 0;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, false);
+        entries       += shard->data.size();
+        bytes         += shard->bytes;
+        logical_bytes += shard->logical_bytes;
+        evictions     += shard->evictions;
+        expirations   += shard->expirations;
+        rejections    += shard->rejections;
+    }
+    json stats = json::object();
+    stats["entries"]       = entries;
+    stats["bytes"]         = bytes;
+    stats["logical_bytes"] = logical_bytes;
+    stats["compression"]   = cachersize::compression::name(m_compression);
+    stats["evictions"]     = evictions;
+    stats["expirations"]   = expirations;
+    stats["capacity_bytes"] = m_shard_capacity_bytes.load() * m_shards.size();
+    if(m_track_ghosts.load()) {
+        uint64_t ghost_hits = 0;
+        for(auto& shard : m_shards) ghost_hits += shard->ghost_hits.load();
+        stats["ghost_hits"] = ghost_hits;
+    }
+    if(m_admission) {
+        stats["admission_rejections"]   = rejections;
+        stats["admission_sketch_bytes"] = m_admission->memoryUsage();
+    }
+    return stats;
+}
+
+cachersize::RequestResult<bool> MemoryCache::scan(const ScanFunction& fn) {
+    cachersize::RequestResult<bool> result;
+    struct Copy {
+        std::string key;
+        std::string value;
+        bool        compressed;
+        uint64_t    expiry_ms;
+    };
+    std::vector<Copy> copies;
+    std::string value;
+    for(auto& shard : m_shards) {
+        copies.clear();
+        {
+            ShardLock lock(shard->lock, false);
+            copies.reserve(shard->data.size());
+            shard->data.for_each([&copies](const std::string& key, const Entry& entry) {
+                if(isExpired(entry)) return;
+                copies.push_back(Copy{key, entry.value, entry.compressed, entry.expiry_ms});
+            });
+        }
+        uint64_t now = nowMs();
+        for(auto& copy : copies) {
+            if(copy.expiry_ms && copy.expiry_ms <= now) continue;
+            uint64_t ttl_ms = copy.expiry_ms ? copy.expiry_ms - now : 0;
+            if(!copy.compressed) {
+                fn(copy.key, copy.value, ttl_ms);
+                continue;
+            }
+            try {
+                cachersize::compression::decompress(copy.value, &value);
+            } catch(const cachersize::Exception& ex) {
+                result.success() = false;
+                result.error() = ex.what();
+                return result;
+            }
+            fn(copy.key, value, ttl_ms);
+        }
+    }
+    return result;
+}
+
+cachersize::RequestResult<size_t> MemoryCache::load(const std::vector<std::string>& keys,
+                                                    std::vector<std::string>&& values,
+                                                    const std::vector<uint64_t>& ttls_ms) {
+    cachersize::RequestResult<size_t> result;
+    size_t loaded = 0;
+    bool expires = false;
+    std::vector<char> compressed(keys.size());
+    for(size_t i = 0; i < keys.size(); i++) {
+        compressed[i] = compress(values[i]);
+        expires = expires || ttls_ms[i];
+    }
+    if(expires) startExpirer();
+    uint64_t now = nowMs();
+    forEachShard(keys, [&](Shard& shard, const size_t* items, size_t count) {
+        ShardLock lock(shard.lock, true);
+        for(size_t j = 0; j < count; j++) {
+            size_t i = items[j];
+            auto entry = shard.data.find(keys[i]);
+            if(entry && !isExpired(*entry)) continue;
+            uint64_t expiry_ms = ttls_ms[i] ? now + ttls_ms[i] : 0;
+            if(putLocked(shard, keys[i], std::move(values[i]), compressed[i], expiry_ms))
+                continue;
+            // the admission filter may have rejected the entry
+            if(shard.data.find(keys[i])) loaded += 1;
+        }
+    });
+    result.value() = loaded;
+    return result;
+}
+
+bool MemoryCache::getMemoryProfile(MemoryProfile* profile) const {
+    profile->capacity_bytes = m_shard_capacity_bytes.load() * m_shards.size();
+    profile->max_bytes      = m_max_capacity_bytes;
+    profile->used_bytes     = 0;
+    profile->ghost_hits     = 0;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, false);
+        profile->used_bytes += shard->bytes;
+        profile->ghost_hits += shard->ghost_hits.load();
+    }
+    profile->resizable = m_shards.front()->policy != nullptr;
+    return true;
+}
+
+void MemoryCache::setMemoryCapacity(size_t bytes) {
+    if(!m_shards.front()->policy) return;
+    m_shard_capacity_bytes = std::max<size_t>(1, bytes / m_shards.size());
+    m_track_ghosts = true;
+    size_t capacity = m_shard_capacity_bytes.load();
+    std::string victim;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, true);
+        while(shard->bytes > capacity && shard->policy->evict(&victim))
+            evictLocked(*shard, victim);
+    }
+}
+
+cachersize::RequestResult<bool> MemoryCache::destroy() {
+    cachersize::RequestResult<bool> result;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, true);
+        if(shard->policy) {
+            shard->data.for_each([&shard](const std::string&, Entry& entry) {
+                shard->policy->remove(entry.policy_entry);
+            });
+        }
+        if(shard->wheel) shard->wheel->clear();
+        shard->data.clear();
+        shard->bytes = 0;
+        shard->logical_bytes = 0;
+    }
+    result.value() = true;
+    return result;
+}
+
+std::unique_ptr<cachersize::Backend> MemoryCache::create(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<cachersize::Backend>(new MemoryCache(engine, config));
+}
+
+std::unique_ptr<cachersize::Backend> MemoryCache::open(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<cachersize::Backend>(new MemoryCache(engine, config));
+}
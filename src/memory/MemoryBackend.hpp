@@ -0,0 +1,577 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MEMORY_BACKEND_HPP
+#define __MEMORY_BACKEND_HPP
+
+#include <cachersize/Backend.hpp>
+#include <cachersize/EvictionPolicy.hpp>
+#include "../HashIndex.hpp"
+#include "../TimerWheel.hpp"
+#include "../Compression.hpp"
+#include "../FrequencySketch.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+using json = nlohmann::json;
+
+/**
+ * In-memory implementation of a cachersize Backend.
+ *
+ * The hash table is split into a number of shards, each protected by
+ * its own Argobots reader-writer lock, so that RPC handlers running on
+ * different xstreams only contend when they access keys in the same
+ * shard. Each shard indexes its keys with an open-addressing HashIndex
+ * and has its own instance of the eviction policy, so that the policy's
+ * metadata is never protected by a cache-wide lock. When the policy's
+ * touch() is safe to call concurrently (e.g. CLOCK, S3-FIFO), lookups
+ * only take the shard's lock in shared mode.
+ *
+ * Accepted configuration fields:
+ * - "num_shards" (integer, default 16): number of shards.
+ * - "capacity_bytes" (integer, default 0 = unlimited): maximum number
+ *   of bytes (keys + values) stored in the cache.
+ * - "capacity_entries" (integer, default 0 = unlimited): maximum
+ *   number of entries stored in the cache.
+ * - "eviction" (object, optional): eviction policy configuration, with
+ *   a "policy" field naming a registered EvictionPolicy ("lru", "clock",
+ *   "s3fifo", "arc") or "none" (the default), and any option accepted
+ *   by this policy. Without eviction, puts fail once the cache is full.
+ *
+ * - "default_ttl_ms" (integer, default 0 = none): time to live of the
+ *   entries stored without an explicit TTL.
+ * - "ttl_resolution_ms" (integer, default 10): granularity with which
+ *   expired entries are reclaimed.
+ * - "compression" (object, optional): value compression, with fields
+ *   "algorithm" ("none" (default), "lz4" or "zstd", if enabled at build
+ *   time), "min_size" (integer, default 256), the size under which values
+ *   are stored as is, and "level" (integer, default 0 = the algorithm's
+ *   default).
+ * - "admission" (object, optional): TinyLFU admission filter, with fields
+ *   "enabled" (boolean, default false), "counters" (integer, default
+ *   16 x capacity_entries, or 65536 if unlimited), the size of the frequency
+ *   sketch, and "sample_size" (integer, default 10 x counters), the number
+ *   of accesses after which the sketch is aged. It requires an eviction
+ *   policy.
+ *
+ * Capacities are split evenly across shards. They apply to the bytes
+ * actually stored, i.e. after compression. Values are compressed before,
+ * and decompressed after, taking their shard's lock; a value that does
+ * not shrink is stored as is.
+ *
+ * Entries with a TTL are registered in a hierarchical timer wheel owned
+ * by their shard (allocated the first time the shard stores such an
+ * entry). A background ULT, started the first time an entry with a TTL
+ * is stored, advances the wheels every ttl_resolution_ms and reclaims
+ * the entries whose timer fired. Lookups also check the entry's expiry
+ * time, so an expired entry is never returned, even before its timer
+ * has fired.
+ *
+ * With admission enabled, every put and get of a key is recorded in a
+ * count-min sketch shared by all the shards and updated without locks.
+ * When storing a new key requires an eviction, the key is only stored
+ * if its estimated frequency is higher than that of the policy's victim;
+ * otherwise the victim stays and the put succeeds without storing the
+ * value, as if it had been evicted right away. This keeps one-shot scans
+ * from flushing frequently accessed entries out of the cache.
+ *
+ * A cache with an eviction policy can be resized by the provider's
+ * memory budget. Its capacity_bytes, if any, is then an upper bound on
+ * its capacity. Once resized, each shard remembers the hashes of the keys
+ * it evicted last, up to a tenth of its capacity, and counts the misses
+ * on these keys ("ghost hits"), i.e. the hits it would have had with 10%
+ * more memory.
+ */
+class MemoryCache : public cachersize::Backend {
+
+    struct Entry {
+        std::string                          value;
+        cachersize::EvictionPolicy::Entry*   policy_entry = nullptr;
+        uint64_t                             expiry_ms = 0; // 0 if the entry does not expire
+        cachersize::TimerWheel::Timer*       timer = nullptr;
+        bool                                 compressed = false; // value is a compression frame
+    };
+
+    struct Shard {
+        thallium::rwlock                              lock;
+        cachersize::HashIndex<Entry>                  data;
+        std::unique_ptr<cachersize::EvictionPolicy>   policy;
+        size_t                                        bytes = 0;         // as stored
+        size_t                                        logical_bytes = 0; // before compression
+        size_t                                        evictions = 0;
+        size_t                                        expirations = 0;
+        size_t                                        rejections = 0; // by the admission filter
+        std::unique_ptr<cachersize::TimerWheel>       wheel;
+        // recently evicted keys (hash, bytes), oldest first
+        std::deque<std::pair<uint64_t, size_t>>       ghosts;
+        std::unordered_map<uint64_t, unsigned>        ghost_index;
+        size_t                                        ghost_bytes = 0;
+        std::atomic<uint64_t>                         ghost_hits = { 0 };
+    };
+
+    /**
+     * @brief Locks a shard in exclusive or shared mode
+     * for the lifetime of the object.
+     */
+    class ShardLock {
+        thallium::rwlock& m_lock;
+        public:
+        ShardLock(thallium::rwlock& lock, bool exclusive)
+        : m_lock(lock) {
+            if(exclusive) m_lock.wrlock();
+            else          m_lock.rdlock();
+        }
+        ~ShardLock() { m_lock.unlock(); }
+        ShardLock(const ShardLock&) = delete;
+        ShardLock& operator=(const ShardLock&) = delete;
+    };
+
+    json                                m_config;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<size_t>                 m_shard_capacity_bytes   = { 0 };
+    size_t                              m_max_capacity_bytes     = 0;
+    std::atomic<bool>                   m_track_ghosts = { false };
+    size_t                              m_shard_capacity_entries = 0;
+    uint64_t                            m_default_ttl_ms = 0;
+    uint64_t                            m_ttl_resolution_ms = 10;
+    cachersize::Compression             m_compression = cachersize::Compression::None;
+    size_t                              m_compression_min_size = 256;
+    int                                 m_compression_level = 0;
+    std::unique_ptr<cachersize::FrequencySketch> m_admission;
+
+    // expirer ULT
+    thallium::engine                    m_engine;
+    thallium::pool                      m_pool;
+    std::atomic<bool>                   m_expirer_started = { false };
+    bool                                m_expirer_running = false;
+    bool                                m_stopping = false;
+    thallium::mutex                     m_expirer_mtx;
+    thallium::condition_variable        m_expirer_cv;
+
+    size_t shardIndex(const std::string& key) const {
+        return std::hash<std::string>()(key) % m_shards.size();
+    }
+
+    Shard& shardFor(const std::string& key) {
+        return *m_shards[shardIndex(key)];
+    }
+
+    /**
+     * @brief Whether a lookup in the shard must take its lock
+     * in exclusive mode to update the eviction policy.
+     */
+    static bool exclusiveLookup(const Shard& shard) {
+        return shard.policy && !shard.policy->concurrentTouch();
+    }
+
+    /**
+     * @brief Records an access to a key in the admission filter, if any.
+     */
+    void recordAccess(const std::string& key) {
+        if(m_admission) m_admission->increment(std::hash<std::string>()(key));
+    }
+
+    /**
+     * @brief Whether the shard (whose lock must be held exclusively)
+     * must evict entries before storing an entry of the given size.
+     */
+    bool isFull(const Shard& shard, size_t entry_bytes) const {
+        return (m_shard_capacity_bytes && shard.bytes + entry_bytes > m_shard_capacity_bytes)
+            || (m_shard_capacity_entries && shard.data.size() >= m_shard_capacity_entries);
+    }
+
+    /**
+     * @brief Asks the admission filter whether a new key is worth evicting
+     * the policy's next victim. Nothing is evicted: if the key is admitted,
+     * the caller makes room for it with makeRoom(). Must be called with the
+     * shard's lock held exclusively.
+     *
+     * @return whether the key is admitted.
+     */
+    bool admit(Shard& shard, const std::string& key);
+
+    /**
+     * @brief Evicts entries from the shard (whose lock must be held
+     * exclusively) until an entry of the given size fits.
+     */
+    void makeRoom(Shard& shard, size_t entry_bytes);
+
+    /**
+     * @brief Evicts an entry chosen by the policy from a shard
+     * whose lock is held exclusively.
+     */
+    void evictLocked(Shard& shard, const std::string& victim);
+
+    /**
+     * @brief Remembers an evicted key, forgetting the oldest ghosts if they
+     * exceed a tenth of the shard's capacity. The shard's lock must be
+     * held exclusively.
+     */
+    void addGhost(Shard& shard, const std::string& key, size_t bytes);
+
+    /**
+     * @brief Counts a miss on a recently evicted key. The shard's lock
+     * must be held (in shared mode at least).
+     */
+    void checkGhost(Shard& shard, const std::string& key) const {
+        if(!m_track_ghosts.load(std::memory_order_relaxed) || shard.ghost_index.empty()) return;
+        if(shard.ghost_index.count(std::hash<std::string>()(key)))
+            shard.ghost_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Stores a value in a shard whose lock is held exclusively.
+     *
+     * @return nullptr on success, an error message otherwise.
+     */
+    const char* putLocked(Shard& shard, const std::string& key, std::string&& value,
+                          bool compressed, uint64_t expiry_ms);
+
+    /**
+     * @brief Copies a value, as stored, from a shard whose lock is held
+     * (exclusively if exclusiveLookup(shard) is true). If framed is true,
+     * values stored uncompressed are copied as frames of algorithm None.
+     *
+     * @param[out] compressed whether the value copied is a compression
+     * frame that the caller must decompress (always true if framed).
+     *
+     * @return false if the key was not found.
+     */
+    bool getLocked(Shard& shard, const std::string& key, std::string* value,
+                   bool framed, bool* compressed);
+
+    /**
+     * @brief Implementation of get (framed = false) and getCompressed
+     * (framed = true). Compressed values are decompressed, if needed,
+     * after the shard's lock has been released.
+     */
+    cachersize::RequestResult<std::string> lookup(const std::string& key, bool framed);
+
+    /**
+     * @brief Implementation of getMulti and getMultiCompressed.
+     */
+    cachersize::RequestResult<std::vector<cachersize::Status>> lookupMulti(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>* values,
+            bool framed);
+
+    /**
+     * @brief Replaces a value by its compression frame if the cache is
+     * configured to compress it and it shrinks.
+     *
+     * @return whether the value was compressed.
+     */
+    bool compress(std::string& value) const;
+
+    /**
+     * @brief Size of an entry's value before compression.
+     */
+    static size_t logicalSize(const Entry& entry) {
+        return entry.compressed ? cachersize::compression::originalSize(entry.value.data())
+                                : entry.value.size();
+    }
+
+    static void addBytes(Shard& shard, const std::string& key, const Entry& entry) {
+        shard.bytes         += key.size() + entry.value.size();
+        shard.logical_bytes += key.size() + logicalSize(entry);
+    }
+
+    static void removeBytes(Shard& shard, const std::string& key, const Entry& entry) {
+        shard.bytes         -= key.size() + entry.value.size();
+        shard.logical_bytes -= key.size() + logicalSize(entry);
+    }
+
+    /**
+     * @brief Erases a key from a shard whose lock is held exclusively.
+     */
+    void eraseLocked(Shard& shard, const std::string& key);
+
+    /**
+     * @brief Sets the expiry time of an entry of a shard whose lock is
+     * held exclusively, scheduling, moving or cancelling its timer.
+     */
+    void setExpiry(Shard& shard, const std::string& key, Entry& entry, uint64_t expiry_ms);
+
+    /**
+     * @brief Cancels the timer of an entry removed from a shard
+     * whose lock is held exclusively.
+     */
+    static void cancelExpiry(Shard& shard, Entry& entry) {
+        if(entry.timer) shard.wheel->cancel(entry.timer);
+        entry.timer = nullptr;
+    }
+
+    /**
+     * @brief Returns the time at which an entry stored now with the
+     * given TTL (or the default TTL if 0) expires, or 0 if it does not.
+     */
+    uint64_t expiryFor(uint64_t ttl_ms) const;
+
+    /**
+     * @brief Starts the expirer ULT if it is not running yet.
+     */
+    void startExpirer();
+
+    /**
+     * @brief Main loop of the expirer ULT.
+     */
+    void expirerLoop();
+
+    /**
+     * @brief Reclaims the entries whose timer fired.
+     */
+    void expire();
+
+    /**
+     * @brief Groups the items of a batch by shard and calls
+     * f(shard, item_indices, count) once for each shard involved.
+     */
+    template<typename F>
+    void forEachShard(const std::vector<std::string>& keys, F&& f);
+
+    public:
+
+    /**
+     * @brief Constructor. Throws a cachersize::Exception if the
+     * configuration is invalid.
+     */
+    MemoryCache(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Move-constructor is deleted.
+     */
+    MemoryCache(MemoryCache&&) = delete;
+
+    /**
+     * @brief Copy-constructor is deleted.
+     */
+    MemoryCache(const MemoryCache&) = delete;
+
+    /**
+     * @brief Move-assignment operator is deleted.
+     */
+    MemoryCache& operator=(MemoryCache&&) = delete;
+
+    /**
+     * @brief Copy-assignment operator is deleted.
+     */
+    MemoryCache& operator=(const MemoryCache&) = delete;
+
+    /**
+     * @brief Destructor. Stops the expirer ULT.
+     */
+    virtual ~MemoryCache();
+
+    /**
+     * @brief Prints Hello World.
+     */
+    void sayHello() override;
+
+    /**
+     * @brief Compute the sum of two integers.
+     *
+     * @param x first integer
+     * @param y second integer
+     *
+     * @return a RequestResult containing the result.
+     */
+    cachersize::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    /**
+     * @brief Stores a value associated with a key. If storing the value
+     * would exceed the capacity of the key's shard, entries are evicted
+     * or, if the cache has no eviction policy, the put fails.
+     *
+     * @param key key
+     * @param value value
+     *
+     * @return a RequestResult<bool> indicating whether the value was stored.
+     */
+    cachersize::RequestResult<bool> put(const std::string& key, std::string&& value) override;
+
+    /**
+     * @brief Stores a value that expires after ttl_ms milliseconds
+     * (or after the cache's default TTL if ttl_ms is 0).
+     *
+     * @param key key
+     * @param value value
+     * @param ttl_ms time to live in milliseconds
+     *
+     * @return a RequestResult<bool> indicating whether the value was stored.
+     */
+    cachersize::RequestResult<bool> putWithTTL(const std::string& key, std::string&& value,
+                                               uint64_t ttl_ms) override;
+
+    /**
+     * @brief Retrieves the value associated with a key.
+     *
+     * @param key key
+     *
+     * @return a RequestResult containing the value.
+     */
+    cachersize::RequestResult<std::string> get(const std::string& key) override;
+
+    /**
+     * @brief Retrieves the value associated with a key as a compression
+     * frame, without decompressing it if it is stored compressed.
+     *
+     * @param key key
+     *
+     * @return a RequestResult containing the frame.
+     */
+    cachersize::RequestResult<std::string> getCompressed(const std::string& key) override;
+
+    /**
+     * @brief Erases a key and its associated value.
+     *
+     * @param key key
+     *
+     * @return a RequestResult<bool> indicating whether the operation succeeded.
+     */
+    cachersize::RequestResult<bool> erase(const std::string& key) override;
+
+    /**
+     * @brief Stores a batch of key/value pairs, locking
+     * each shard involved only once.
+     *
+     * @param keys keys
+     * @param values values
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    cachersize::RequestResult<std::vector<cachersize::Status>> putMulti(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>&& values) override;
+
+    /**
+     * @brief Stores a batch of key/value pairs that expire after
+     * ttl_ms milliseconds (or after the cache's default TTL if 0).
+     *
+     * @param keys keys
+     * @param values values
+     * @param ttl_ms time to live in milliseconds
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    cachersize::RequestResult<std::vector<cachersize::Status>> putMultiWithTTL(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>&& values,
+            uint64_t ttl_ms) override;
+
+    /**
+     * @brief Retrieves a batch of values, locking
+     * each shard involved only once.
+     *
+     * @param[in] keys keys
+     * @param[out] values values
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    cachersize::RequestResult<std::vector<cachersize::Status>> getMulti(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>* values) override;
+
+    /**
+     * @brief Retrieves a batch of values as compression frames,
+     * locking each shard involved only once.
+     *
+     * @param[in] keys keys
+     * @param[out] frames frames
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    cachersize::RequestResult<std::vector<cachersize::Status>> getMultiCompressed(
+            const std::vector<std::string>& keys,
+            std::vector<std::string>* frames) override;
+
+    /**
+     * @brief Erases a batch of keys, locking
+     * each shard involved only once.
+     *
+     * @param keys keys
+     *
+     * @return a RequestResult containing the status of each item.
+     */
+    cachersize::RequestResult<std::vector<cachersize::Status>> eraseMulti(
+            const std::vector<std::string>& keys) override;
+
+    /**
+     * @brief Checks whether a key exists.
+     *
+     * @param key key
+     *
+     * @return a RequestResult whose value is 1 if the key exists, 0 otherwise.
+     */
+    cachersize::RequestResult<uint8_t> exists(const std::string& key) override;
+
+    /**
+     * @brief Returns the number of entries, of bytes (keys + values)
+     * stored and of bytes before compression, and the number of
+     * entries evicted, expired and rejected by the admission filter.
+     */
+    json getStats() const override;
+
+    /**
+     * @brief Calls fn on every entry, copying the entries of one shard
+     * at a time under the shard's lock, and decompressing values once
+     * the lock is released.
+     */
+    cachersize::RequestResult<bool> scan(const ScanFunction& fn) override;
+
+    /**
+     * @brief Inserts entries restored from a snapshot,
+     * skipping the keys already present.
+     */
+    cachersize::RequestResult<size_t> load(const std::vector<std::string>& keys,
+                                           std::vector<std::string>&& values,
+                                           const std::vector<uint64_t>& ttls_ms) override;
+
+    /**
+     * @brief Reports the cache as resizable if it has an eviction policy.
+     */
+    bool getMemoryProfile(MemoryProfile* profile) const override;
+
+    /**
+     * @brief Changes the capacity in bytes, evicting entries if needed.
+     */
+    void setMemoryCapacity(size_t bytes) override;
+
+    /**
+     * @brief Destroys the underlying cache.
+     *
+     * @return a RequestResult<bool> instance indicating
+     * whether the database was successfully destroyed.
+     */
+    cachersize::RequestResult<bool> destroy() override;
+
+    /**
+     * @brief Static factory function used by the CacheFactory to
+     * create a MemoryCache.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the cache
+     *
+     * @return a unique_ptr to a cache
+     */
+    static std::unique_ptr<cachersize::Backend> create(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Static factory function used by the CacheFactory to
+     * open a MemoryCache. Since the cache is not persistent,
+     * this is equivalent to creating a new, empty cache.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the cache
+     *
+     * @return a unique_ptr to a cache
+     */
+    static std::unique_ptr<cachersize::Backend> open(const thallium::engine& engine, const json& config);
+};
+
+#endif
@@ -0,0 +1,642 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "TieredBackend.hpp"
+#include <cachersize/Exception.hpp>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+
+CACHERSIZE_REGISTER_BACKEND(tiered, TieredCache);
+
+static size_t getUnsigned(const json& config, const char* field, size_t default_value) {
+    if(!config.contains(field))
+        return default_value;
+    auto& v = config[field];
+    if(!v.is_number_unsigned())
+        throw cachersize::Exception(
+            std::string("\"") + field + "\" field should be an unsigned integer");
+    return v.get<size_t>();
+}
+
+TieredCache::TieredCache(const thallium::engine& engine, const json& config)
+: m_config(config)
+, m_engine(engine)
+, m_pool(engine.get_handler_pool()) {
+    if(!m_config.is_object())
+        m_config = json::object();
+    size_t num_shards       = getUnsigned(m_config, "num_shards", 16);
+    size_t memory_bytes     = getUnsigned(m_config, "memory_bytes", 256*1024*1024);
+    size_t io_threads       = getUnsigned(m_config, "abt_io_threads", 2);
+    m_disk_bytes            = getUnsigned(m_config, "disk_bytes", 4ull*1024*1024*1024);
+    m_segment_bytes         = getUnsigned(m_config, "segment_bytes", 64*1024*1024);
+    m_write_buffer_bytes    = getUnsigned(m_config, "write_buffer_bytes", 1024*1024);
+    m_compaction_interval_ms = getUnsigned(m_config, "compaction_interval_ms", 100);
+    if(num_shards == 0)
+        throw cachersize::Exception("\"num_shards\" field should be strictly positive");
+    if(memory_bytes < num_shards)
+        throw cachersize::Exception(
+            "\"memory_bytes\" field should allow at least one byte per shard");
+    if(io_threads == 0)
+        throw cachersize::Exception("\"abt_io_threads\" field should be strictly positive");
+    if(m_segment_bytes <= kRecordHeaderSize
+    || m_segment_bytes > std::numeric_limits<uint32_t>::max())
+        throw cachersize::Exception(
+            "\"segment_bytes\" field should be between 9 and 4294967295");
+    if(m_disk_bytes < 2 * m_segment_bytes)
+        throw cachersize::Exception(
+            "\"disk_bytes\" field should allow at least two segments");
+    if(m_write_buffer_bytes == 0 || m_write_buffer_bytes > m_segment_bytes)
+        throw cachersize::Exception(
+            "\"write_buffer_bytes\" field should be between 1 and \"segment_bytes\"");
+    if(m_compaction_interval_ms == 0)
+        throw cachersize::Exception("\"compaction_interval_ms\" field should be strictly positive");
+    if(!m_config.contains("compaction_threshold"))
+        m_config["compaction_threshold"] = 0.5;
+    if(!m_config["compaction_threshold"].is_number())
+        throw cachersize::Exception("\"compaction_threshold\" field should be a number");
+    m_compaction_threshold = m_config["compaction_threshold"].get<double>();
+    if(!(0.0 <= m_compaction_threshold && m_compaction_threshold <= 1.0))
+        throw cachersize::Exception("\"compaction_threshold\" field should be between 0 and 1");
+    if(!m_config.contains("spill_dir") || !m_config["spill_dir"].is_string())
+        throw cachersize::Exception("\"spill_dir\" field should be a string");
+    std::string spill_dir = m_config["spill_dir"].get<std::string>();
+    m_config["num_shards"]             = num_shards;
+    m_config["memory_bytes"]           = memory_bytes;
+    m_config["disk_bytes"]             = m_disk_bytes;
+    m_config["segment_bytes"]          = m_segment_bytes;
+    m_config["write_buffer_bytes"]     = m_write_buffer_bytes;
+    m_config["compaction_interval_ms"] = m_compaction_interval_ms;
+    m_config["abt_io_threads"]         = io_threads;
+    m_shard_memory_bytes = memory_bytes / num_shards;
+
+    json eviction = json::object();
+    if(m_config.contains("eviction")) {
+        eviction = m_config["eviction"];
+        if(!eviction.is_object())
+            throw cachersize::Exception("\"eviction\" field should be an object");
+    }
+    if(!eviction.contains("policy"))
+        eviction["policy"] = "lru";
+    if(!eviction["policy"].is_string())
+        throw cachersize::Exception("\"eviction.policy\" field should be a string");
+    std::string policy_name = eviction["policy"].get<std::string>();
+    m_config["eviction"] = eviction;
+
+    m_shards.reserve(num_shards);
+    for(size_t i = 0; i < num_shards; i++) {
+        m_shards.emplace_back(new Shard());
+        m_shards.back()->policy = cachersize::EvictionPolicyFactory::createPolicy(
+            policy_name, eviction, 0);
+        if(!m_shards.back()->policy)
+            throw cachersize::Exception("Unknown eviction policy \"" + policy_name + "\"");
+    }
+
+    // each cache spills to its own directory, so that
+    // caches sharing a spill_dir never see each other's files
+    std::string dir_template = spill_dir + "/cachersize-XXXXXX";
+    std::vector<char> dir(dir_template.begin(), dir_template.end());
+    dir.push_back('\0');
+    if(!mkdtemp(dir.data()))
+        throw cachersize::Exception(
+            "Could not create a directory in " + spill_dir + ": " + std::strerror(errno));
+    m_dir = dir.data();
+
+    m_abtio = abt_io_init(static_cast<int>(io_threads));
+    if(m_abtio == ABT_IO_INSTANCE_NULL) {
+        rmdir(m_dir.c_str());
+        throw cachersize::Exception("Could not initialize abt-io");
+    }
+
+    m_ults_running = 2;
+    m_pool.make_thread([this]() { flusherLoop(); }, thallium::anonymous());
+    m_pool.make_thread([this]() { compactorLoop(); }, thallium::anonymous());
+}
+
+TieredCache::~TieredCache() {
+    {
+        std::unique_lock<thallium::mutex> lock(m_log_mtx);
+        m_stopping = true;
+        m_log_cv.notify_all();
+        m_log_cv.wait(lock, [this]() { return m_ults_running == 0; });
+    }
+    // segment files must be closed before abt-io is finalized
+    clear();
+    abt_io_finalize(m_abtio);
+    rmdir(m_dir.c_str());
+}
+
+void TieredCache::openSegment() {
+    uint32_t id = m_next_segment++;
+    std::string path = m_dir + "/segment-" + std::to_string(id) + ".log";
+    int fd = abt_io_open(m_abtio, path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0)
+        throw cachersize::Exception(
+            "Could not create file " + path + ": " + std::strerror(-fd));
+    m_active = std::make_shared<Segment>(m_abtio, fd, id, path);
+    m_segments.emplace(id, m_active);
+}
+
+void TieredCache::sealBuffer() {
+    if(!m_buffer) return;
+    m_sealed_bytes += m_buffer->data.size();
+    m_sealed.emplace_back(m_active, std::move(m_buffer));
+    m_buffer.reset();
+    m_log_cv.notify_all();
+}
+
+bool TieredCache::appendRecord(const std::string& key, const char* value, size_t value_size,
+                               DiskEntry* location) {
+    size_t record_size = kRecordHeaderSize + key.size() + value_size;
+    if(record_size > m_segment_bytes) return false;
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    if(!m_active || m_active->size + record_size > m_segment_bytes) {
+        sealBuffer();
+        try {
+            openSegment();
+        } catch(const cachersize::Exception& ex) {
+            m_write_errors += 1;
+            m_last_error = ex.what();
+            m_active.reset();
+            return false;
+        }
+    }
+    if(!m_buffer) {
+        m_buffer = std::make_shared<WriteBuffer>();
+        m_buffer->offset = m_active->size;
+        m_buffer->data.reserve(m_write_buffer_bytes);
+        m_active->unwritten.push_back(m_buffer);
+    }
+    location->segment = m_active->id;
+    location->size    = static_cast<uint32_t>(record_size);
+    location->offset  = m_active->size;
+    uint32_t header[2] = { static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value_size) };
+    m_buffer->data.append(reinterpret_cast<const char*>(header), kRecordHeaderSize);
+    m_buffer->data.append(key);
+    m_buffer->data.append(value, value_size);
+    m_active->size       += record_size;
+    m_active->live_bytes += record_size;
+    m_file_bytes         += record_size;
+    if(m_buffer->data.size() >= m_write_buffer_bytes)
+        sealBuffer();
+    return true;
+}
+
+void TieredCache::markDead(const DiskEntry& location) {
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    auto it = m_segments.find(location.segment);
+    if(it != m_segments.end())
+        it->second->live_bytes -= location.size;
+}
+
+bool TieredCache::readRecord(const DiskEntry& location, std::string* key,
+                             std::string* value, std::string* error) {
+    // the record is read in value, then its header and key are cut off
+    std::shared_ptr<Segment> segment;
+    bool buffered = false;
+    {
+        std::unique_lock<thallium::mutex> lock(m_log_mtx);
+        auto it = m_segments.find(location.segment);
+        if(it == m_segments.end()) return false;
+        segment = it->second;
+        for(auto& buffer : segment->unwritten) {
+            if(location.offset < buffer->offset
+            || location.offset + location.size > buffer->offset + buffer->data.size())
+                continue;
+            value->assign(buffer->data, location.offset - buffer->offset, location.size);
+            buffered = true;
+            break;
+        }
+    }
+    if(!buffered) {
+        value->resize(location.size);
+        size_t done = 0;
+        while(done < location.size) {
+            ssize_t ret = abt_io_pread(m_abtio, segment->fd, &(*value)[done],
+                                       location.size - done, location.offset + done);
+            if(ret < 0) {
+                *error = "Could not read from file " + segment->path + ": "
+                       + std::strerror(static_cast<int>(-ret));
+                return false;
+            }
+            if(ret == 0) {
+                *error = "Unexpected end of file " + segment->path;
+                return false;
+            }
+            done += ret;
+        }
+    }
+    uint32_t header[2];
+    std::memcpy(header, value->data(), kRecordHeaderSize);
+    if(kRecordHeaderSize + header[0] + header[1] != location.size) {
+        *error = "Corrupted record in file " + segment->path;
+        return false;
+    }
+    key->assign(*value, kRecordHeaderSize, header[0]);
+    value->erase(0, kRecordHeaderSize + header[0]);
+    return true;
+}
+
+void TieredCache::makeRoom(Shard& shard, size_t entry_bytes) {
+    std::string victim;
+    Entry entry;
+    DiskEntry location;
+    while(shard.memory_bytes + entry_bytes > m_shard_memory_bytes) {
+        if(!shard.policy->evict(&victim)) break;
+        if(!shard.memory.extract(victim, &entry)) continue;
+        shard.memory_bytes -= victim.size() + entry.value.size();
+        if(appendRecord(victim, entry.value.data(), entry.value.size(), &location)) {
+            shard.disk.insert_or_assign(victim, location);
+            shard.demotions += 1;
+        } else {
+            shard.evictions += 1;
+        }
+    }
+}
+
+void TieredCache::eraseLocked(Shard& shard, const std::string& key) {
+    Entry entry;
+    if(shard.memory.extract(key, &entry)) {
+        shard.memory_bytes -= key.size() + entry.value.size();
+        shard.policy->remove(entry.policy_entry);
+        return;
+    }
+    DiskEntry location;
+    if(shard.disk.extract(key, &location))
+        markDead(location);
+}
+
+void TieredCache::throttle() {
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    m_log_cv.wait(lock, [this]() {
+        return m_stopping || m_sealed_bytes <= 4 * m_write_buffer_bytes;
+    });
+}
+
+void TieredCache::flusherLoop() {
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    while(true) {
+        m_log_cv.wait(lock, [this]() { return m_stopping || !m_sealed.empty(); });
+        if(m_stopping) break;
+        auto segment = std::move(m_sealed.front().first);
+        auto buffer  = std::move(m_sealed.front().second);
+        m_sealed.pop_front();
+        lock.unlock();
+        std::string error;
+        size_t done = 0;
+        // the buffers of a failed segment are dropped with it
+        for(unsigned attempt = 0; !segment->failed && attempt < kMaxWriteAttempts; attempt++) {
+            if(attempt > 0)
+                thallium::thread::sleep(m_engine, 10.0 * attempt);
+            error.clear();
+            while(done < buffer->data.size()) {
+                ssize_t ret = abt_io_pwrite(m_abtio, segment->fd, buffer->data.data() + done,
+                                            buffer->data.size() - done, buffer->offset + done);
+                if(ret < 0) {
+                    error = "Could not write to file " + segment->path + ": "
+                          + std::strerror(static_cast<int>(-ret));
+                    break;
+                }
+                done += ret;
+            }
+            if(error.empty()) break;
+        }
+        lock.lock();
+        m_sealed_bytes -= buffer->data.size();
+        if(error.empty() && !segment->failed) {
+            auto& unwritten = segment->unwritten;
+            unwritten.erase(std::find(unwritten.begin(), unwritten.end(), buffer));
+        } else if(!error.empty()) {
+            // the buffer stays readable from memory until the
+            // compactor drops the segment and evicts its entries
+            m_write_errors += 1;
+            m_last_error = error;
+            segment->failed = true;
+            if(segment == m_active) {
+                sealBuffer();
+                m_active.reset();
+            }
+        }
+        m_log_cv.notify_all();
+    }
+    m_ults_running -= 1;
+    m_log_cv.notify_all();
+}
+
+void TieredCache::compactorLoop() {
+    while(true) {
+        thallium::thread::sleep(m_engine, static_cast<double>(m_compaction_interval_ms));
+        {
+            std::unique_lock<thallium::mutex> lock(m_log_mtx);
+            if(m_stopping) break;
+        }
+        compact();
+    }
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    m_ults_running -= 1;
+    m_log_cv.notify_all();
+}
+
+void TieredCache::compact() {
+    while(true) {
+        std::shared_ptr<Segment> victim;
+        bool relocate = false;
+        {
+            std::unique_lock<thallium::mutex> lock(m_log_mtx);
+            if(m_stopping) return;
+            if(m_file_bytes > m_disk_bytes) {
+                // records are at most segment_bytes, so with disk_bytes
+                // allowing two segments, the oldest one is never active
+                auto& oldest = m_segments.begin()->second;
+                if(oldest == m_active || (!oldest->unwritten.empty() && !oldest->failed)) return;
+                victim = oldest;
+            } else {
+                for(auto& s : m_segments) {
+                    auto& segment = s.second;
+                    if(segment->failed) {
+                        victim = segment;
+                        break;
+                    }
+                    if(segment == m_active || !segment->unwritten.empty()) continue;
+                    if(segment->live_bytes == 0
+                    || segment->live_bytes < m_compaction_threshold * segment->size) {
+                        victim = segment;
+                        relocate = true;
+                        break;
+                    }
+                }
+            }
+            if(!victim) return;
+            if(victim->live_bytes == 0) {
+                m_file_bytes -= victim->size;
+                m_segments.erase(victim->id);
+                continue;
+            }
+        }
+        reclaimSegment(victim, relocate);
+    }
+}
+
+void TieredCache::reclaimSegment(const std::shared_ptr<Segment>& segment, bool relocate) {
+    std::string data;
+    if(relocate) {
+        data.resize(segment->size);
+        size_t done = 0;
+        while(done < data.size()) {
+            ssize_t ret = abt_io_pread(m_abtio, segment->fd, &data[done],
+                                       data.size() - done, done);
+            if(ret <= 0) {
+                // the live records are lost, evict them instead
+                relocate = false;
+                break;
+            }
+            done += ret;
+        }
+    }
+    if(relocate) {
+        std::string key;
+        uint64_t offset = 0;
+        uint32_t header[2];
+        while(offset + kRecordHeaderSize <= data.size()) {
+            std::memcpy(header, &data[offset], kRecordHeaderSize);
+            size_t record_size = kRecordHeaderSize + header[0] + header[1];
+            if(offset + record_size > data.size()) break;
+            key.assign(data, offset + kRecordHeaderSize, header[0]);
+            auto& shard = shardFor(key);
+            ShardLock lock(shard.lock, true);
+            auto location = shard.disk.find(key);
+            // records that were erased, overwritten or promoted are dead
+            if(location && location->segment == segment->id && location->offset == offset) {
+                if(!appendRecord(key, &data[offset + kRecordHeaderSize + header[0]],
+                                 header[1], location)) {
+                    shard.disk.erase(key);
+                    shard.evictions += 1;
+                }
+            }
+            offset += record_size;
+        }
+    } else {
+        std::vector<std::string> keys;
+        for(auto& shard : m_shards) {
+            ShardLock lock(shard->lock, true);
+            keys.clear();
+            shard->disk.for_each([&](const std::string& key, DiskEntry& location) {
+                if(location.segment == segment->id) keys.push_back(key);
+            });
+            for(auto& key : keys)
+                shard->disk.erase(key);
+            shard->evictions += keys.size();
+        }
+    }
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    if(!m_segments.erase(segment->id)) return; // dropped by clear()
+    m_file_bytes -= segment->size;
+    if(relocate) m_compactions += 1;
+}
+
+void TieredCache::clear() {
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, true);
+        shard->memory.for_each([&shard](const std::string&, Entry& entry) {
+            shard->policy->remove(entry.policy_entry);
+        });
+        shard->memory.clear();
+        shard->disk.clear();
+        shard->memory_bytes = 0;
+    }
+    std::unique_lock<thallium::mutex> lock(m_log_mtx);
+    // a buffer being written by the flusher is accounted for by the flusher
+    for(auto& sealed : m_sealed)
+        m_sealed_bytes -= sealed.second->data.size();
+    m_sealed.clear();
+    m_buffer.reset();
+    m_active.reset();
+    m_segments.clear();
+    m_file_bytes = 0;
+    m_log_cv.notify_all();
+}
+
+void TieredCache::sayHello() {
+    std::cout << "Hello World" << std::endl;
+}
+
+cachersize::RequestResult<int32_t> TieredCache::computeSum(int32_t x, int32_t y) {
+    cachersize::RequestResult<int32_t> result;
+    result.value() = x + y;
+    return result;
+}
+
+cachersize::RequestResult<bool> TieredCache::put(const std::string& key, std::string&& value) {
+    cachersize::RequestResult<bool> result;
+    size_t entry_bytes = key.size() + value.size();
+    if(kRecordHeaderSize + entry_bytes > m_segment_bytes && entry_bytes > m_shard_memory_bytes) {
+        result.success() = false;
+        result.error() = "Value is too large for this cache";
+        return result;
+    }
+    throttle();
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, true);
+    eraseLocked(shard, key);
+    if(entry_bytes > m_shard_memory_bytes) {
+        DiskEntry location;
+        if(!appendRecord(key, value.data(), value.size(), &location)) {
+            result.success() = false;
+            result.error() = "Could not append the value to the disk tier";
+            return result;
+        }
+        shard.disk.emplace(key, location);
+        return result;
+    }
+    makeRoom(shard, entry_bytes);
+    auto& entry = *shard.memory.emplace(key).first;
+    entry.value = std::move(value);
+    entry.policy_entry = shard.policy->insert(key);
+    shard.memory_bytes += entry_bytes;
+    return result;
+}
+
+cachersize::RequestResult<std::string> TieredCache::get(const std::string& key) {
+    cachersize::RequestResult<std::string> result;
+    auto& shard = shardFor(key);
+    DiskEntry location;
+    {
+        ShardLock lock(shard.lock, exclusiveLookup(shard));
+        auto entry = shard.memory.find(key);
+        if(entry) {
+            result.value() = entry->value;
+            shard.policy->touch(entry->policy_entry);
+            return result;
+        }
+        auto disk_entry = shard.disk.find(key);
+        if(!disk_entry) {
+            result.success() = false;
+            result.code() = cachersize::ResultCode::KeyNotFound;
+            result.error() = "Key not found";
+            return result;
+        }
+        location = *disk_entry;
+    }
+    // the record is read without holding the shard's lock; if it is
+    // erased or overwritten meanwhile, the value read is returned
+    // as if the get had completed first, but it is not promoted
+    std::string record_key, error;
+    if(!readRecord(location, &record_key, &result.value(), &error) || record_key != key) {
+        result.success() = false;
+        if(error.empty() && record_key.empty()) {
+            // the segment was dropped, evicting the key
+            result.code() = cachersize::ResultCode::KeyNotFound;
+            result.error() = "Key not found";
+        } else {
+            result.error() = error.empty() ? "Corrupted record in the disk tier" : error;
+        }
+        return result;
+    }
+    size_t entry_bytes = key.size() + result.value().size();
+    if(entry_bytes > m_shard_memory_bytes) return result;
+    throttle();
+    ShardLock lock(shard.lock, true);
+    auto disk_entry = shard.disk.find(key);
+    if(!disk_entry || !(*disk_entry == location)) return result;
+    shard.disk.erase(key);
+    markDead(location);
+    makeRoom(shard, entry_bytes);
+    auto& entry = *shard.memory.emplace(key).first;
+    entry.value = result.value();
+    entry.policy_entry = shard.policy->insert(key);
+    shard.memory_bytes += entry_bytes;
+    shard.promotions += 1;
+    return result;
+}
+
+cachersize::RequestResult<bool> TieredCache::erase(const std::string& key) {
+    cachersize::RequestResult<bool> result;
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, true);
+    eraseLocked(shard, key);
+    return result;
+}
+
+cachersize::RequestResult<uint8_t> TieredCache::exists(const std::string& key) {
+    cachersize::RequestResult<uint8_t> result;
+    auto& shard = shardFor(key);
+    ShardLock lock(shard.lock, false);
+    result.value() = shard.memory.count(key) || shard.disk.count(key) ? 1 : 0;
+    return result;
+}
+
+bool TieredCache::getMemoryProfile(MemoryProfile* profile) const {
+    profile->capacity_bytes = m_shard_memory_bytes * m_shards.size();
+    profile->max_bytes      = profile->capacity_bytes;
+    profile->used_bytes     = 0;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, false);
+        profile->used_bytes += shard->memory_bytes;
+    }
+    profile->resizable = false;
+    return true;
+}
+
+json TieredCache::getStats() const {
+    size_t memory_entries = 0, memory_bytes = 0, disk_entries = 0;
+    size_t promotions = 0, demotions = 0, evictions = 0;
+    for(auto& shard : m_shards) {
+        ShardLock lock(shard->lock, false);
+        memory_entries += shard->memory.size();
+        memory_bytes   += shard->memory_bytes;
+        disk_entries   += shard->disk.size();
+        promotions     += shard->promotions;
+        demotions      += shard->demotions;
+        evictions      += shard->evictions;
+    }
+    json disk = json::object();
+    size_t live_bytes = 0;
+    {
+        std::unique_lock<thallium::mutex> lock(m_log_mtx);
+        for(auto& s : m_segments)
+            live_bytes += s.second->live_bytes;
+        disk["segments"]          = m_segments.size();
+        disk["file_bytes"]        = m_file_bytes;
+        disk["unwritten_bytes"]   = m_sealed_bytes + (m_buffer ? m_buffer->data.size() : 0);
+        disk["compactions"]       = m_compactions;
+        disk["write_errors"]      = m_write_errors;
+        if(m_write_errors) disk["last_error"] = m_last_error;
+    }
+    disk["entries"]    = disk_entries;
+    disk["live_bytes"] = live_bytes;
+    json memory = json::object();
+    memory["entries"] = memory_entries;
+    memory["bytes"]   = memory_bytes;
+    json stats = json::object();
+    stats["entries"]    = memory_entries + disk_entries;
+    stats["bytes"]      = memory_bytes + live_bytes;
+    stats["evictions"]  = evictions;
+    stats["promotions"] = promotions;
+    stats["demotions"]  = demotions;
+    stats["memory"]     = std::move(memory);
+    stats["disk"]       = std::move(disk);
+    return stats;
+}
+
+cachersize::RequestResult<bool> TieredCache::destroy() {
+    cachersize::RequestResult<bool> result;
+    clear();
+    result.value() = true;
+    return result;
+}
+
+std::unique_ptr<cachersize::Backend> TieredCache::create(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<cachersize::Backend>(new TieredCache(engine, config));
+}
+
+std::unique_ptr<cachersize::Backend> TieredCache::open(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<cachersize::Backend>(new TieredCache(engine, config));
+}
@@ -0,0 +1,420 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __TIERED_BACKEND_HPP
+#define __TIERED_BACKEND_HPP
+
+#include <cachersize/Backend.hpp>
+#include <cachersize/EvictionPolicy.hpp>
+#include "../HashIndex.hpp"
+#include <abt-io.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+#include <string>
+
+using json = nlohmann::json;
+
+/**
+ * Two-tier implementation of a cachersize Backend, keeping the hot
+ * entries in memory and spilling the others to files on local storage
+ * (typically an NVMe drive).
+ *
+ * The memory tier is organized like the MemoryCache: keys are split
+ * across shards, each with its own reader-writer lock, HashIndex and
+ * eviction policy. Instead of being dropped, the entries that the policy
+ * evicts are demoted to the disk tier: they are appended to a log made
+ * of fixed-size segment files, written through abt-io, and each shard
+ * keeps a compact index mapping the keys it demoted to the location of
+ * their record (segment, offset, size). A key lives in at most one tier.
+ * A hit in the disk tier reads the record without holding the shard's
+ * lock and promotes the entry back to memory, marking the record dead.
+ *
+ * Records are appended to an in-memory write buffer, so that demotion
+ * never waits for the disk. Full buffers are written by a background
+ * flusher ULT, and remain readable until then. A buffer that still
+ * cannot be written after a few attempts marks its segment as failed:
+ * no record is appended to it anymore, and the compactor drops it,
+ * evicting its entries from the cache. A background compactor
+ * ULT copies the live records of the segments that are mostly dead to
+ * the end of the log before deleting them, and, when the disk tier
+ * exceeds its capacity, deletes the oldest segment, evicting its
+ * entries from the cache.
+ *
+ * Accepted configuration fields:
+ * - "spill_dir" (string, required): directory in which the cache
+ *   creates a private subdirectory holding its segment files.
+ * - "memory_bytes" (integer, default 256 MiB): capacity of the memory
+ *   tier (keys + values), split evenly across shards.
+ * - "disk_bytes" (integer, default 4 GiB): capacity of the disk tier
+ *   (segment files, including dead records).
+ * - "num_shards" (integer, default 16): number of shards.
+ * - "segment_bytes" (integer, default 64 MiB): size of a segment file.
+ * - "write_buffer_bytes" (integer, default 1 MiB): size of the write
+ *   buffers; puts wait for the flusher when more than four buffers are
+ *   waiting to be written.
+ * - "compaction_threshold" (number, default 0.5): a segment is compacted
+ *   once the fraction of its bytes that are live falls below it.
+ * - "compaction_interval_ms" (integer, default 100): period of the
+ *   compactor.
+ * - "abt_io_threads" (integer, default 2): number of abt-io threads.
+ * - "eviction" (object, optional): eviction policy of the memory tier,
+ *   with a "policy" field naming a registered EvictionPolicy (default
+ *   "lru") and any option accepted by this policy.
+ *
+ * Values too large for a shard of the memory tier are written directly
+ * to the disk tier. The cache is not persistent: its segment files are
+ * deleted when it is closed or destroyed. TTLs are not supported.
+ */
+class TieredCache : public cachersize::Backend {
+
+    struct Entry {
+        std::string                          value;
+        cachersize::EvictionPolicy::Entry*   policy_entry = nullptr;
+    };
+
+    /**
+     * @brief Location of a record in the disk tier.
+     */
+    struct DiskEntry {
+        uint32_t segment = 0;
+        uint32_t size    = 0; // size of the record, header included
+        uint64_t offset  = 0;
+        bool operator==(const DiskEntry& other) const {
+            return segment == other.segment && offset == other.offset;
+        }
+    };
+
+    struct Shard {
+        thallium::rwlock                              lock;
+        cachersize::HashIndex<Entry>                  memory;
+        cachersize::HashIndex<DiskEntry>              disk;
+        std::unique_ptr<cachersize::EvictionPolicy>   policy;
+        size_t                                        memory_bytes = 0;
+        size_t                                        promotions = 0;
+        size_t                                        demotions = 0;
+        size_t                                        evictions = 0; // from the cache
+    };
+
+    /**
+     * @brief Bytes appended to a segment but not written yet.
+     */
+    struct WriteBuffer {
+        uint64_t    offset = 0; // offset of the buffer in its segment
+        std::string data;
+    };
+
+    /**
+     * @brief Segment file of the log. The file is closed and deleted
+     * once the segment has been dropped from the log and the last ULT
+     * reading it releases its reference.
+     */
+    struct Segment {
+        abt_io_instance_id                        abtio;
+        int                                       fd;
+        uint32_t                                  id;
+        std::string                               path;
+        uint64_t                                  size = 0;       // bytes appended
+        uint64_t                                  live_bytes = 0; // bytes of live records
+        bool                                      failed = false; // a write failed for good
+        std::deque<std::shared_ptr<WriteBuffer>>  unwritten;      // oldest first
+        Segment(abt_io_instance_id io, int f, uint32_t i, std::string p)
+        : abtio(io), fd(f), id(i), path(std::move(p)) {}
+        ~Segment() {
+            abt_io_close(abtio, fd);
+            abt_io_unlink(abtio, path.c_str());
+        }
+        Segment(const Segment&) = delete;
+        Segment& operator=(const Segment&) = delete;
+    };
+
+    /**
+     * @brief Locks a shard in exclusive or shared mode
+     * for the lifetime of the object.
+     */
+    class ShardLock {
+        thallium::rwlock& m_lock;
+        public:
+        ShardLock(thallium::rwlock& lock, bool exclusive)
+        : m_lock(lock) {
+            if(exclusive) m_lock.wrlock();
+            else          m_lock.rdlock();
+        }
+        ~ShardLock() { m_lock.unlock(); }
+        ShardLock(const ShardLock&) = delete;
+        ShardLock& operator=(const ShardLock&) = delete;
+    };
+
+    static constexpr size_t   kRecordHeaderSize = 8;
+    static constexpr unsigned kMaxWriteAttempts = 3;
+
+    json                                                m_config;
+    std::vector<std::unique_ptr<Shard>>                 m_shards;
+    size_t                                              m_shard_memory_bytes = 0;
+    size_t                                              m_disk_bytes = 0;
+    size_t                                              m_segment_bytes = 0;
+    size_t                                              m_write_buffer_bytes = 0;
+    double                                              m_compaction_threshold = 0.5;
+    uint64_t                                            m_compaction_interval_ms = 100;
+    std::string                                         m_dir;
+    abt_io_instance_id                                  m_abtio = ABT_IO_INSTANCE_NULL;
+
+    // log, protected by m_log_mtx; a shard's lock may be
+    // held when taking m_log_mtx, but not the other way around
+    mutable thallium::mutex                             m_log_mtx;
+    thallium::condition_variable                        m_log_cv;
+    std::map<uint32_t, std::shared_ptr<Segment>>        m_segments;
+    std::shared_ptr<Segment>                            m_active;
+    std::shared_ptr<WriteBuffer>                        m_buffer;   // being filled
+    std::deque<std::pair<std::shared_ptr<Segment>,
+                         std::shared_ptr<WriteBuffer>>> m_sealed;   // waiting for the flusher
+    size_t                                              m_sealed_bytes = 0;
+    size_t                                              m_file_bytes = 0;
+    uint32_t                                            m_next_segment = 0;
+    size_t                                              m_write_errors = 0;
+    std::string                                         m_last_error;
+    size_t                                              m_compactions = 0;
+
+    // background ULTs
+    thallium::engine                                    m_engine;
+    thallium::pool                                      m_pool;
+    bool                                                m_stopping = false;
+    unsigned                                            m_ults_running = 0;
+
+    size_t shardIndex(const std::string& key) const {
+        return std::hash<std::string>()(key) % m_shards.size();
+    }
+
+    Shard& shardFor(const std::string& key) {
+        return *m_shards[shardIndex(key)];
+    }
+
+    /**
+     * @brief Whether a lookup in the shard must take its lock
+     * in exclusive mode to update the eviction policy.
+     */
+    static bool exclusiveLookup(const Shard& shard) {
+        return !shard.policy->concurrentTouch();
+    }
+
+    /**
+     * @brief Opens a new segment and makes it the active one, throwing
+     * an Exception if its file cannot be created. Must be called with
+     * m_log_mtx held.
+     */
+    void openSegment();
+
+    /**
+     * @brief Seals the write buffer of the active segment, handing
+     * it to the flusher. Must be called with m_log_mtx held.
+     */
+    void sealBuffer();
+
+    /**
+     * @brief Appends a record to the log. Must be called with
+     * the lock of the key's shard held exclusively.
+     *
+     * @param[out] location location of the record.
+     *
+     * @return false if the record could not be appended.
+     */
+    bool appendRecord(const std::string& key, const char* value, size_t value_size,
+                      DiskEntry* location);
+
+    /**
+     * @brief Marks a record as dead.
+     */
+    void markDead(const DiskEntry& location);
+
+    /**
+     * @brief Reads a record from its write buffer or from its file.
+     *
+     * @return false if the segment has been dropped, in which case
+     * the error is left empty, or if the record could not be read.
+     */
+    bool readRecord(const DiskEntry& location, std::string* key,
+                    std::string* value, std::string* error);
+
+    /**
+     * @brief Demotes entries from the memory tier of the shard (whose
+     * lock must be held exclusively) until an entry of the given size fits.
+     */
+    void makeRoom(Shard& shard, size_t entry_bytes);
+
+    /**
+     * @brief Removes a key from both tiers of a shard
+     * whose lock is held exclusively.
+     */
+    void eraseLocked(Shard& shard, const std::string& key);
+
+    /**
+     * @brief Waits until few enough write buffers are waiting for
+     * the flusher. Must be called without holding any shard lock.
+     */
+    void throttle();
+
+    /**
+     * @brief Main loop of the flusher ULT.
+     */
+    void flusherLoop();
+
+    /**
+     * @brief Main loop of the compactor ULT.
+     */
+    void compactorLoop();
+
+    /**
+     * @brief Reclaims segments until none needs compaction
+     * and the disk tier fits in its capacity.
+     */
+    void compact();
+
+    /**
+     * @brief Drops a sealed segment from the log, after either moving
+     * its live records to the active segment (relocate = true) or
+     * evicting them from the cache.
+     */
+    void reclaimSegment(const std::shared_ptr<Segment>& segment, bool relocate);
+
+    /**
+     * @brief Drops all the segments and entries.
+     */
+    void clear();
+
+    public:
+
+    /**
+     * @brief Constructor. Throws a cachersize::Exception if the
+     * configuration is invalid or the spill directory cannot be used.
+     */
+    TieredCache(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Move-constructor is deleted.
+     */
+    TieredCache(TieredCache&&) = delete;
+
+    /**
+     * @brief Copy-constructor is deleted.
+     */
+    TieredCache(const TieredCache&) = delete;
+
+    /**
+     * @brief Move-assignment operator is deleted.
+     */
+    TieredCache& operator=(TieredCache&&) = delete;
+
+    /**
+     * @brief Copy-assignment operator is deleted.
+     */
+    TieredCache& operator=(const TieredCache&) = delete;
+
+    /**
+     * @brief Destructor. Stops the background ULTs
+     * and deletes the segment files.
+     */
+    virtual ~TieredCache();
+
+    /**
+     * @brief Prints Hello World.
+     */
+    void sayHello() override;
+
+    /**
+     * @brief Compute the sum of two integers.
+     *
+     * @param x first integer
+     * @param y second integer
+     *
+     * @return a RequestResult containing the result.
+     */
+    cachersize::RequestResult<int32_t> computeSum(int32_t x, int32_t y) override;
+
+    /**
+     * @brief Stores a value in the memory tier, demoting
+     * entries to the disk tier to make room for it.
+     *
+     * @param key key
+     * @param value value
+     *
+     * @return a RequestResult<bool> indicating whether the value was stored.
+     */
+    cachersize::RequestResult<bool> put(const std::string& key, std::string&& value) override;
+
+    /**
+     * @brief Retrieves the value associated with a key, promoting
+     * it to the memory tier if it was found in the disk tier.
+     *
+     * @param key key
+     *
+     * @return a RequestResult containing the value.
+     */
+    cachersize::RequestResult<std::string> get(const std::string& key) override;
+
+    /**
+     * @brief Erases a key and its associated value from both tiers.
+     *
+     * @param key key
+     *
+     * @return a RequestResult<bool> indicating whether the operation succeeded.
+     */
+    cachersize::RequestResult<bool> erase(const std::string& key) override;
+
+    /**
+     * @brief Checks whether a key exists in either tier.
+     *
+     * @param key key
+     *
+     * @return a RequestResult whose value is 1 if the key exists, 0 otherwise.
+     */
+    cachersize::RequestResult<uint8_t> exists(const std::string& key) override;
+
+    /**
+     * @brief Returns the number of entries and bytes in each tier,
+     * and the number of promotions, demotions, compactions
+     * and entries evicted from the disk tier.
+     */
+    json getStats() const override;
+
+    /**
+     * @brief Reports the capacity of the memory tier, which cannot be
+     * changed (the disk tier is not charged against memory budgets).
+     */
+    bool getMemoryProfile(MemoryProfile* profile) const override;
+
+    /**
+     * @brief Destroys the underlying cache.
+     *
+     * @return a RequestResult<bool> instance indicating
+     * whether the database was successfully destroyed.
+     */
+    cachersize::RequestResult<bool> destroy() override;
+
+    /**
+     * @brief Static factory function used by the CacheFactory to
+     * create a TieredCache.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the cache
+     *
+     * @return a unique_ptr to a cache
+     */
+    static std::unique_ptr<cachersize::Backend> create(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Static factory function used by the CacheFactory to
+     * open a TieredCache. Since the cache is not persistent,
+     * this is equivalent to creating a new, empty cache.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the cache
+     *
+     * @return a unique_ptr to a cache
+     */
+    static std::unique_ptr<cachersize::Backend> open(const thallium::engine& engine, const json& config);
+};
+
+#endif
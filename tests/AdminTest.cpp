@@ -4,6 +4,11 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <cachersize/Admin.hpp>
+#include <cachersize/Client.hpp>
+#include <cachersize/Provider.hpp>
+#include <cachersize/RequestResult.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include "EndpointCache.hpp"
 #include <cppunit/extensions/HelperMacros.h>
 
 extern thallium::engine engine;
@@ -13,6 +18,9 @@ class AdminTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( AdminTest );
     CPPUNIT_TEST( testAdminCreateCache );
+    CPPUNIT_TEST( testProviderConfig );
+    CPPUNIT_TEST( testEndpointCache );
+    CPPUNIT_TEST( testResultCodes );
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr const char* cache_config = "{ \"path\" : \"mydb\" }";
@@ -46,5 +54,99 @@ class AdminTest : public CppUnit::TestFixture
             admin.destroyCache(addr, 0, bad_id),
             cachersize::Exception);
     }
+
+    void testProviderConfig() {
+        // Invalid JSON
+        CPPUNIT_ASSERT_THROW_MESSAGE("Provider should throw on invalid JSON",
+                cachersize::Provider(engine, 1, "{ \"pools\" : "),
+                cachersize::Exception);
+
+        // Unknown pool name
+        CPPUNIT_ASSERT_THROW_MESSAGE("Provider should throw on unknown pool",
+                cachersize::Provider(engine, 1, "{ \"pools\" : { \"bulk\" : \"nopool\" } }"),
+                cachersize::Exception);
+
+        // Default configuration reports the pools it uses
+        cachersize::Provider provider(engine, 1);
+        std::string config = provider.getConfig();
+        CPPUNIT_ASSERT(config.find("\"pools\"") != std::string::npos);
+        CPPUNIT_ASSERT(config.find("\"admin\"") != std::string::npos);
+    }
+
+    void testEndpointCache() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+        // shared by all the objects using the engine
+        auto endpoints = cachersize::EndpointCache::of(engine);
+        endpoints->invalidate(addr);
+
+        auto cache_id = admin.createCache(addr, 0, "memory", "{}");
+        CPPUNIT_ASSERT_MESSAGE("admin calls should cache the endpoint", endpoints->contains(addr));
+        auto resolved = endpoints->lookup(engine, addr).get_addr();
+
+        // handles and further admin calls reuse it
+        for(int i = 0; i < 4; i++) {
+            auto cache = client.makeCacheHandle(addr, 0, cache_id);
+            cache.put("key", "value");
+            admin.getCacheStats(addr, 0, cache_id);
+            CPPUNIT_ASSERT(endpoints->lookup(engine, addr).get_addr() == resolved);
+        }
+
+        // an RPC that fails (no provider 42) invalidates it
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "admin call to an unknown provider should fail",
+                admin.createCache(addr, 42, "memory", "{}"),
+                std::exception);
+        CPPUNIT_ASSERT_MESSAGE("a failed call should invalidate the endpoint",
+                !endpoints->contains(addr));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+        CPPUNIT_ASSERT(endpoints->contains(addr));
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testResultCodes() {
+        using cachersize::RequestResult;
+        using cachersize::ResultCode;
+        cachersize::Provider provider(engine, 3);
+        provider.setSecurityToken("secret");
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        auto cache_id = admin.createCache(addr, 3, "memory", "{}", "secret");
+
+        // codes and error strings sent by the provider reach the caller
+        auto destroy = engine.define("cachersize_destroy_cache");
+        auto exists  = engine.define("cachersize_exists");
+        thallium::provider_handle ph(engine.lookup(addr), 3);
+
+        RequestResult<bool> denied = destroy.on(ph)(std::string("wrong"), cache_id);
+        CPPUNIT_ASSERT(!denied.success());
+        CPPUNIT_ASSERT(denied.code() == ResultCode::InvalidToken);
+        CPPUNIT_ASSERT_EQUAL(std::string("Invalid security token"), denied.error());
+
+        auto bad_id = cachersize::UUID::generate();
+        RequestResult<bool> missing = destroy.on(ph)(std::string("secret"), bad_id);
+        CPPUNIT_ASSERT(!missing.success());
+        CPPUNIT_ASSERT(missing.code() == ResultCode::CacheNotFound);
+        CPPUNIT_ASSERT(missing.error().find(bad_id.to_string()) != std::string::npos);
+
+        RequestResult<uint8_t> no_cache = exists.on(ph)(bad_id, std::string("key"));
+        CPPUNIT_ASSERT(no_cache.code() == ResultCode::CacheNotFound);
+        RequestResult<uint8_t> found = exists.on(ph)(cache_id, std::string("key"));
+        CPPUNIT_ASSERT(found.success());
+        CPPUNIT_ASSERT(found.code() == ResultCode::Success);
+
+        // and surface as exceptions through the public API
+        std::string error;
+        try {
+            admin.destroyCache(addr, 3, cache_id, "wrong");
+        } catch(const cachersize::Exception& ex) {
+            error = ex.what();
+        }
+        CPPUNIT_ASSERT_EQUAL(std::string("Invalid security token"), error);
+        RequestResult<bool> destroyed = destroy.on(ph)(std::string("secret"), cache_id);
+        CPPUNIT_ASSERT(destroyed.success());
+    }
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( AdminTest );
@@ -0,0 +1,147 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <cachersize/Provider.hpp>
+#include <nlohmann/json.hpp>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class BudgetTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( BudgetTest );
+    CPPUNIT_TEST( testShares );
+    CPPUNIT_TEST( testIdleShrink );
+    CPPUNIT_TEST( testRebalance );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr uint16_t provider_id = 1;
+    static constexpr size_t   MiB = 1024*1024;
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    // an 8 MiB budget moved by steps of 512 KiB
+    static std::string providerConfig(unsigned rebalance_interval_ms) {
+        return "{ \"memory_budget\" : { \"bytes\" : " + std::to_string(8*MiB)
+            + ", \"min_cache_bytes\" : " + std::to_string(MiB)
+            + ", \"step\" : 0.0625"
+            + ", \"rebalance_interval_ms\" : " + std::to_string(rebalance_interval_ms) + " } }";
+    }
+
+    static std::string resizableConfig() {
+        return "{ \"num_shards\" : 1, \"eviction\" : { \"policy\" : \"lru\" } }";
+    }
+
+    static std::string fixedConfig(size_t capacity_bytes) {
+        return "{ \"num_shards\" : 1, \"capacity_bytes\" : " + std::to_string(capacity_bytes) + " }";
+    }
+
+    static size_t capacityOf(cachersize::CacheHandle& cache) {
+        return nlohmann::json::parse(cache.getStats())["backend"]["capacity_bytes"].get<size_t>();
+    }
+
+    void testShares() {
+        cachersize::Provider provider(engine, provider_id, providerConfig(60000));
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto id_a = admin.createCache(addr, provider_id, "memory", resizableConfig());
+        auto a = client.makeCacheHandle(addr, provider_id, id_a);
+        CPPUNIT_ASSERT_EQUAL(8*MiB, capacityOf(a));
+
+        auto id_b = admin.createCache(addr, provider_id, "memory", resizableConfig());
+        auto b = client.makeCacheHandle(addr, provider_id, id_b);
+        CPPUNIT_ASSERT_EQUAL(4*MiB, capacityOf(a));
+        CPPUNIT_ASSERT_EQUAL(4*MiB, capacityOf(b));
+
+        // a cache without eviction is charged its capacity
+        auto id_c = admin.createCache(addr, provider_id, "memory", fixedConfig(2*MiB));
+        CPPUNIT_ASSERT_EQUAL(3*MiB, capacityOf(a));
+        CPPUNIT_ASSERT_EQUAL(3*MiB, capacityOf(b));
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "creating a cache larger than what is left of the budget should fail",
+                admin.createCache(addr, provider_id, "memory", fixedConfig(8*MiB)),
+                cachersize::Exception);
+
+        // resizable caches stay within their share
+        std::string value(64*1024, 'v');
+        for(unsigned i = 0; i < 128; i++)
+            a.put("key" + std::to_string(i), value);
+        auto stats = nlohmann::json::parse(a.getStats())["backend"];
+        CPPUNIT_ASSERT(stats["bytes"].get<size_t>() <= 3*MiB);
+        CPPUNIT_ASSERT(stats["evictions"].get<size_t>() > 0);
+
+        // destroying a cache gives its memory back to the next one
+        admin.destroyCache(addr, provider_id, id_c);
+        auto id_d = admin.createCache(addr, provider_id, "memory", resizableConfig());
+        auto d = client.makeCacheHandle(addr, provider_id, id_d);
+        CPPUNIT_ASSERT(capacityOf(d) >= 2*MiB);
+        CPPUNIT_ASSERT(capacityOf(a) + capacityOf(b) + capacityOf(d) <= 8*MiB);
+
+        admin.destroyCache(addr, provider_id, id_a);
+        admin.destroyCache(addr, provider_id, id_b);
+        admin.destroyCache(addr, provider_id, id_d);
+    }
+
+    void testIdleShrink() {
+        cachersize::Provider provider(engine, provider_id, providerConfig(10));
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, provider_id, "memory", resizableConfig());
+        auto cache = client.makeCacheHandle(addr, provider_id, cache_id);
+
+        // 14 periods take the cache from 8 MiB down to 1 MiB
+        thallium::thread::sleep(engine, 1000.0);
+        CPPUNIT_ASSERT_EQUAL(MiB, capacityOf(cache));
+
+        admin.destroyCache(addr, provider_id, cache_id);
+    }
+
+    void testRebalance() {
+        cachersize::Provider provider(engine, provider_id, providerConfig(50));
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto id_a = admin.createCache(addr, provider_id, "memory", resizableConfig());
+        auto a = client.makeCacheHandle(addr, provider_id, id_a);
+        auto id_b = admin.createCache(addr, provider_id, "memory", resizableConfig());
+        auto b = client.makeCacheHandle(addr, provider_id, id_b);
+        b.put("key", "value");
+
+        // a cycles over a working set slightly larger than its 4 MiB, so
+        // that its misses are on keys it just evicted; b only hits
+        std::string value(64*1024, 'v');
+        std::string v;
+        for(unsigned round = 0; round < 100 && capacityOf(a) <= 4*MiB; round++) {
+            for(unsigned i = 0; i < 68; i++) {
+                auto key = "key" + std::to_string(i);
+                try {
+                    a.get(key, &v);
+                } catch(const cachersize::Exception&) {
+                    a.put(key, value);
+                }
+                b.get("key", &v);
+            }
+        }
+        CPPUNIT_ASSERT(capacityOf(a) > 4*MiB);
+        CPPUNIT_ASSERT(capacityOf(b) < 4*MiB);
+        CPPUNIT_ASSERT(capacityOf(a) + capacityOf(b) <= 8*MiB);
+
+        admin.destroyCache(addr, provider_id, id_a);
+        admin.destroyCache(addr, provider_id, id_b);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( BudgetTest );
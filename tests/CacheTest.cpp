@@ -16,6 +16,15 @@ class CacheTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testMakeCacheHandle );
     CPPUNIT_TEST( testSayHello );
     CPPUNIT_TEST( testComputeSum );
+    CPPUNIT_TEST( testPutGet );
+    CPPUNIT_TEST( testPutGetLarge );
+    CPPUNIT_TEST( testEraseExists );
+    CPPUNIT_TEST( testMulti );
+    CPPUNIT_TEST( testNearCache );
+    CPPUNIT_TEST( testAsyncSets );
+    CPPUNIT_TEST( testStats );
+    CPPUNIT_TEST( testTTL );
+    CPPUNIT_TEST( testCompression );
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr const char* cache_config = "{ \"path\" : \"mydb\" }";
@@ -103,5 +112,405 @@ class CacheTest : public CppUnit::TestFixture
                 request.wait());
     }
 
+    void testPutGet() {
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.put() should not throw.",
+                my_cache.put("matthieu", "dorier"));
+
+        std::string value;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.get() should not throw for an existing key.",
+                my_cache.get("matthieu", &value));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                "my_cache.get() should return the value that was put",
+                std::string("dorier"), value);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_cache.get() should throw for a non-existing key.",
+                my_cache.get("rob", &value),
+                cachersize::Exception);
+
+        cachersize::AsyncRequest request;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.put() should not throw when called asynchronously.",
+                my_cache.put("phil", "carns", &request));
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "request.wait() should not throw.",
+                request.wait());
+
+        value.clear();
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.get() should not throw when called asynchronously.",
+                my_cache.get("phil", &value, &request));
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "request.wait() should not throw.",
+                request.wait());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                "asynchronous my_cache.get() should return the value that was put",
+                std::string("carns"), value);
+    }
+
+    void testPutGetLarge() {
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        // large enough to go through the bulk (RDMA) path
+        std::string large_value(1024*1024, 'x');
+        for(size_t i = 0; i < large_value.size(); i += 4096)
+            large_value[i] = 'a' + (i/4096) % 26;
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.put() should not throw for a large value.",
+                my_cache.put("large", large_value));
+
+        std::string value;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.get() should not throw for a large value.",
+                my_cache.get("large", &value));
+        CPPUNIT_ASSERT_MESSAGE(
+                "my_cache.get() should return the large value that was put",
+                large_value == value);
+    }
+
+    void testEraseExists() {
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        my_cache.put("matthieu", "dorier");
+
+        bool b = false;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.exists() should not throw.",
+                my_cache.exists("matthieu", &b));
+        CPPUNIT_ASSERT_MESSAGE(
+                "my_cache.exists() should return true for an existing key",
+                b);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.erase() should not throw.",
+                my_cache.erase("matthieu"));
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.exists() should not throw.",
+                my_cache.exists("matthieu", &b));
+        CPPUNIT_ASSERT_MESSAGE(
+                "my_cache.exists() should return false for an erased key",
+                !b);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.erase() should not throw for a non-existing key.",
+                my_cache.erase("matthieu"));
+    }
+
+    void testMulti() {
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        std::vector<std::string> keys, values;
+        for(unsigned i = 0; i < 64; i++) {
+            keys.push_back("key" + std::to_string(i));
+            values.push_back(std::string(i*8, 'a' + (i % 26)));
+        }
+        // larger than the receive space reserved per key
+        values[7] = std::string(32*1024, 'z');
+
+        std::vector<cachersize::Status> statuses;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.putMulti() should not throw.",
+                my_cache.putMulti(keys, values, &statuses));
+        CPPUNIT_ASSERT_EQUAL(keys.size(), statuses.size());
+        for(auto s : statuses)
+            CPPUNIT_ASSERT(s == cachersize::Status::OK);
+
+        auto lookup = keys;
+        lookup.push_back("missing");
+        std::vector<std::string> out;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_cache.getMulti() should not throw when statuses are requested.",
+                my_cache.getMulti(lookup, &out, &statuses));
+        CPPUNIT_ASSERT_EQUAL(lookup.size(), out.size());
+        for(unsigned i = 0; i < keys.size(); i++) {
+            CPPUNIT_ASSERT(statuses[i] == cachersize::Status::OK);
+            CPPUNIT_ASSERT_EQUAL(values[i], out[i]);
+        }
+        CPPUNIT_ASSERT(statuses.back() == cachersize::Status::NotFound);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "my_cache.getMulti() should throw for a missing key without statuses.",
+                my_cache.getMulti(lookup, &out),
+                cachersize::Exception);
+
+        cachersize::AsyncRequest req;
+        my_cache.eraseMulti({ keys[0], keys[7], "missing" }, nullptr, &req);
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "eraseMulti's request should not throw.",
+                req.wait());
+
+        bool b = true;
+        my_cache.exists(keys[7], &b);
+        CPPUNIT_ASSERT_MESSAGE(
+                "my_cache.exists() should return false for a key erased by eraseMulti",
+                !b);
+        my_cache.exists(keys[1], &b);
+        CPPUNIT_ASSERT_MESSAGE(
+                "eraseMulti should not erase other keys",
+                b);
+    }
+
+
+    void testNearCache() {
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto near = client.makeCacheHandle(addr, 0, cache_id, true,
+                "{ \"near_cache\" : { \"max_entries\" : 16 } }");
+        auto other = client.makeCacheHandle(addr, 0, cache_id);
+
+        near.put("matthieu", "dorier");
+
+        std::string value;
+        near.get("matthieu", &value);
+        CPPUNIT_ASSERT_EQUAL(std::string("dorier"), value);
+        value.clear();
+        near.get("matthieu", &value);
+        CPPUNIT_ASSERT_EQUAL(std::string("dorier"), value);
+
+        auto stats = near.nearCacheStats();
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats.hits);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats.misses);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, stats.hitRatio(), 1e-9);
+
+        // a write through another handle revokes the lease
+        other.put("matthieu", "mdorier");
+        near.get("matthieu", &value);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                "near cache should not serve a value that was overwritten",
+                std::string("mdorier"), value);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, near.nearCacheStats().invalidations);
+
+        other.erase("matthieu");
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "near cache should not serve a value that was erased",
+                near.get("matthieu", &value),
+                cachersize::Exception);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "makeCacheHandle should throw on invalid options",
+                client.makeCacheHandle(addr, 0, cache_id, true, "{ \"near_cache\" : 1 }"),
+                cachersize::Exception);
+    }
+
+    void testAsyncSets() {
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        const size_t count = 16;
+        std::vector<cachersize::AsyncRequest> reqs(count);
+        for(size_t i = 0; i < count; i++)
+            my_cache.put("key" + std::to_string(i), "value" + std::to_string(i), &reqs[i]);
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "AsyncRequest::waitAll() should not throw.",
+                cachersize::AsyncRequest::waitAll(reqs));
+
+        std::vector<std::string> values(count);
+        for(size_t i = 0; i < count; i++)
+            my_cache.get("key" + std::to_string(i), &values[i], &reqs[i]);
+        size_t completed = 0, index;
+        while((index = cachersize::AsyncRequest::waitAny(reqs)) != reqs.size()) {
+            CPPUNIT_ASSERT(reqs[index].completed());
+            reqs[index].wait();
+            completed += 1;
+        }
+        CPPUNIT_ASSERT_EQUAL(count, completed);
+        for(size_t i = 0; i < count; i++)
+            CPPUNIT_ASSERT_EQUAL("value" + std::to_string(i), values[i]);
+
+        std::vector<size_t> indices;
+        CPPUNIT_ASSERT_EQUAL((size_t)0, cachersize::AsyncRequest::testSome(reqs, &indices));
+
+        std::string value;
+        thallium::eventual<bool> succeeded;
+        {
+            cachersize::AsyncRequest req;
+            my_cache.get("key0", &value, &req);
+            req.onCompletion([&succeeded](std::exception_ptr error) {
+                    succeeded.set_value(error == nullptr);
+                }, engine.get_handler_pool());
+        }
+        CPPUNIT_ASSERT_MESSAGE("completion callback should report success", succeeded.wait());
+        CPPUNIT_ASSERT_EQUAL(std::string("value0"), value);
+
+        thallium::eventual<bool> failed;
+        {
+            cachersize::AsyncRequest req;
+            my_cache.get("missing", &value, &req);
+            req.onCompletion([&failed](std::exception_ptr error) {
+                    failed.set_value(error != nullptr);
+                }, engine.get_handler_pool());
+        }
+        CPPUNIT_ASSERT_MESSAGE("completion callback should report failure", failed.wait());
+    }
+
+    void testStats() {
+        cachersize::Client client(engine);
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        my_cache.put("matthieu", "dorier");
+        std::string value;
+        my_cache.get("matthieu", &value);
+        CPPUNIT_ASSERT_THROW(my_cache.get("unknown", &value), cachersize::Exception);
+
+        std::string stats_str;
+        CPPUNIT_ASSERT_NO_THROW(stats_str = my_cache.getStats());
+        auto stats = nlohmann::json::parse(stats_str);
+        CPPUNIT_ASSERT_EQUAL(1, stats["hits"].get<int>());
+        CPPUNIT_ASSERT_EQUAL(1, stats["misses"].get<int>());
+        CPPUNIT_ASSERT(stats["bytes_in"].get<int>() >= 14);
+        CPPUNIT_ASSERT(stats["bytes_out"].get<int>() >= 6);
+        CPPUNIT_ASSERT_EQUAL(1, stats["latency"]["put"]["count"].get<int>());
+        CPPUNIT_ASSERT_EQUAL(2, stats["latency"]["get"]["count"].get<int>());
+        CPPUNIT_ASSERT(stats["latency"]["get"]["p99_us"].get<double>() > 0);
+        CPPUNIT_ASSERT(stats.contains("backend"));
+
+        auto admin_stats = nlohmann::json::parse(admin.getCacheStats(addr, 0, cache_id));
+        CPPUNIT_ASSERT_EQUAL(stats["hits"], admin_stats["hits"]);
+
+        CPPUNIT_ASSERT_THROW(
+                admin.getCacheStats(addr, 0, cachersize::UUID::generate()),
+                cachersize::Exception);
+    }
+
+    void testTTL() {
+        cachersize::Client client(engine);
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        // expiration is implemented by the memory backend
+        auto ttl_cache_id = admin.createCache(addr, 0, "memory",
+                "{ \"default_ttl_ms\" : 300, \"ttl_resolution_ms\" : 10 }");
+        cachersize::CacheHandle my_cache = client.makeCacheHandle(addr, 0, ttl_cache_id);
+
+        cachersize::PutOptions options;
+        options.ttl_ms = 50;
+        my_cache.put("short", "lived", options);
+        my_cache.putMulti({ "a", "b" }, { "1", "2" }, options);
+        my_cache.put("default", "ttl");
+        bool exists = false;
+        my_cache.exists("short", &exists);
+        CPPUNIT_ASSERT(exists);
+
+        std::string value;
+        thallium::thread::sleep(engine, 100);
+        CPPUNIT_ASSERT_THROW(my_cache.get("short", &value), cachersize::Exception);
+        my_cache.exists("a", &exists);
+        CPPUNIT_ASSERT(!exists);
+        my_cache.get("default", &value);
+        CPPUNIT_ASSERT_EQUAL(std::string("ttl"), value);
+
+        // putting a key again resets its expiry time
+        options.ttl_ms = 60000;
+        my_cache.put("default", "long", options);
+        thallium::thread::sleep(engine, 300);
+        my_cache.get("default", &value);
+        CPPUNIT_ASSERT_EQUAL(std::string("long"), value);
+
+        // expired entries are reclaimed, not only hidden
+        nlohmann::json stats;
+        for(int i = 0; i < 100; i++) {
+            stats = nlohmann::json::parse(my_cache.getStats());
+            if(stats["expirations"].get<int>() == 3) break;
+            thallium::thread::sleep(engine, 10);
+        }
+        CPPUNIT_ASSERT_EQUAL(3, stats["expirations"].get<int>());
+        CPPUNIT_ASSERT_EQUAL(1, stats["entries"].get<int>());
+
+        admin.destroyCache(addr, 0, ttl_cache_id);
+
+        // backends without expiration reject a TTL rather than ignore it
+        auto dummy_id = admin.createCache(addr, 0, "dummy", "{}");
+        auto dummy = client.makeCacheHandle(addr, 0, dummy_id);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "put() with a TTL should fail on a cache without expiration",
+                dummy.put("short", "lived", options),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "putMulti() with a TTL should fail on a cache without expiration",
+                dummy.putMulti({ "a", "b" }, { "1", "2" }, options),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_NO_THROW(dummy.put("forever", "lived"));
+        admin.destroyCache(addr, 0, dummy_id);
+    }
+
+    void testCompression() {
+        cachersize::Client client(engine);
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        // compression is implemented by the memory backend, with
+        // whichever algorithm cachersize was built with
+        cachersize::UUID zcache_id;
+        bool created = false;
+        for(auto algorithm : { "zstd", "lz4" }) {
+            try {
+                zcache_id = admin.createCache(addr, 0, "memory",
+                    std::string("{ \"compression\" : { \"algorithm\" : \"")
+                    + algorithm + "\", \"min_size\" : 64 } }");
+                created = true;
+                break;
+            } catch(const cachersize::Exception&) {}
+        }
+        if(!created) return;
+        auto plain = client.makeCacheHandle(addr, 0, zcache_id);
+        auto remote = client.makeCacheHandle(addr, 0, zcache_id, true,
+                                             "{ \"compressed_transfer\" : true }");
+
+        std::string large, small = "tiny";
+        while(large.size() < 65536)
+            large += "step=" + std::to_string(large.size() % 97) + " status=ok ";
+        plain.put("large", large);
+        plain.put("small", small);
+
+        auto bytesOut = [&]() {
+            return nlohmann::json::parse(plain.getStats())["bytes_out"].get<size_t>();
+        };
+        std::string value;
+        size_t before = bytesOut();
+        plain.get("large", &value);
+        CPPUNIT_ASSERT(value == large);
+        size_t plain_bytes = bytesOut() - before;
+        before = bytesOut();
+        remote.get("large", &value);
+        CPPUNIT_ASSERT(value == large);
+        size_t compressed_bytes = bytesOut() - before;
+        CPPUNIT_ASSERT(compressed_bytes < plain_bytes);
+        remote.get("small", &value);
+        CPPUNIT_ASSERT_EQUAL(small, value);
+
+        std::vector<std::string> values;
+        std::vector<cachersize::Status> statuses;
+        remote.getMulti({ "small", "large", "missing" }, &values, &statuses);
+        CPPUNIT_ASSERT_EQUAL(small, values[0]);
+        CPPUNIT_ASSERT(values[1] == large);
+        CPPUNIT_ASSERT(statuses[2] == cachersize::Status::NotFound);
+
+        auto stats = nlohmann::json::parse(plain.getStats());
+        CPPUNIT_ASSERT(stats["bytes_stored"].get<size_t>() < stats["bytes_logical"].get<size_t>());
+        CPPUNIT_ASSERT_EQUAL(large.size() + small.size() + 10, stats["bytes_logical"].get<size_t>());
+
+        admin.destroyCache(addr, 0, zcache_id);
+    }
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( CacheTest );
@@ -0,0 +1,138 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <cachersize/Coroutine.hpp>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+using cachersize::Task;
+using cachersize::EventLoop;
+using cachersize::AwaitableCacheHandle;
+
+class CoroutineTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( CoroutineTest );
+    CPPUNIT_TEST( testPutGet );
+    CPPUNIT_TEST( testNestedTasks );
+    CPPUNIT_TEST( testMulti );
+    CPPUNIT_TEST( testErrors );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr const char* cache_config = "{ \"path\" : \"mydb\" }";
+    cachersize::UUID cache_id;
+
+    public:
+
+    void setUp() {
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        cache_id = admin.createCache(addr, 0, cache_type, cache_config);
+    }
+
+    void tearDown() {
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    AwaitableCacheHandle makeHandle() {
+        cachersize::Client client(engine);
+        return client.makeCacheHandle(engine.self(), 0, cache_id);
+    }
+
+    static Task<void> putGet(AwaitableCacheHandle cache, std::string key, std::string* result) {
+        co_await cache.put(key, "value-" + key);
+        bool found = co_await cache.exists(key);
+        CPPUNIT_ASSERT(found);
+        *result = co_await cache.get(key);
+        co_await cache.erase(key);
+        found = co_await cache.exists(key);
+        CPPUNIT_ASSERT(!found);
+    }
+
+    void testPutGet() {
+        auto cache = makeHandle();
+        EventLoop loop;
+        std::vector<std::string> results(16);
+        for(unsigned i = 0; i < results.size(); i++)
+            loop.spawn(putGet(cache, "key" + std::to_string(i), &results[i]));
+        CPPUNIT_ASSERT_NO_THROW(loop.run());
+        for(unsigned i = 0; i < results.size(); i++)
+            CPPUNIT_ASSERT_EQUAL("value-key" + std::to_string(i), results[i]);
+    }
+
+    static Task<int32_t> sum(AwaitableCacheHandle cache, int32_t x, int32_t y) {
+        int32_t r = co_await cache.computeSum(x, y);
+        co_return r;
+    }
+
+    static Task<void> sumAll(AwaitableCacheHandle cache, int32_t* result) {
+        int32_t a = co_await sum(cache, 1, 2);
+        int32_t b = co_await sum(cache, a, 39);
+        *result = b;
+    }
+
+    void testNestedTasks() {
+        auto cache = makeHandle();
+        EventLoop loop;
+        int32_t result = 0;
+        loop.spawn(sumAll(cache, &result));
+        loop.run();
+        CPPUNIT_ASSERT_EQUAL(42, result);
+    }
+
+    static Task<void> multi(AwaitableCacheHandle cache, bool* ok) {
+        std::vector<std::string> keys   = { "a", "b", "c" };
+        std::vector<std::string> values = { "1", "2", "3" };
+        auto statuses = co_await cache.putMulti(keys, values);
+        CPPUNIT_ASSERT_EQUAL((size_t)3, statuses.size());
+        keys.push_back("d");
+        auto result = co_await cache.getMulti(keys);
+        CPPUNIT_ASSERT_EQUAL(std::string("2"), result.values[1]);
+        CPPUNIT_ASSERT(result.statuses[3] == cachersize::Status::NotFound);
+        co_await cache.eraseMulti(keys);
+        *ok = true;
+    }
+
+    void testMulti() {
+        auto cache = makeHandle();
+        EventLoop loop;
+        bool ok = false;
+        loop.spawn(multi(cache, &ok));
+        loop.run();
+        CPPUNIT_ASSERT(ok);
+    }
+
+    static Task<void> getMissing(AwaitableCacheHandle cache) {
+        co_await cache.get("missing");
+    }
+
+    static Task<void> catchMissing(AwaitableCacheHandle cache, bool* caught) {
+        try {
+            co_await getMissing(cache);
+        } catch(const cachersize::Exception&) {
+            *caught = true;
+        }
+    }
+
+    void testErrors() {
+        auto cache = makeHandle();
+        bool caught = false;
+        {
+            EventLoop loop;
+            loop.spawn(catchMissing(cache, &caught));
+            loop.run();
+        }
+        CPPUNIT_ASSERT(caught);
+        EventLoop loop;
+        loop.spawn(getMissing(cache));
+        CPPUNIT_ASSERT_THROW(loop.run(), cachersize::Exception);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( CoroutineTest );
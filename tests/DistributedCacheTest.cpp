@@ -0,0 +1,123 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <cachersize/Provider.hpp>
+#include <cachersize/DistributedCacheHandle.hpp>
+#include <algorithm>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class DistributedCacheTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( DistributedCacheTest );
+    CPPUNIT_TEST( testPutGet );
+    CPPUNIT_TEST( testMulti );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr const char* cache_config = "{ \"path\" : \"mydb\" }";
+    static constexpr uint16_t num_members = 4;
+
+    std::vector<std::unique_ptr<cachersize::Provider>> providers;
+    std::vector<cachersize::CacheMember> members;
+
+    public:
+
+    void setUp() {
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        // provider 0 is created by Main.cpp
+        for(uint16_t i = 0; i < num_members; i++) {
+            if(i != 0)
+                providers.emplace_back(new cachersize::Provider(engine, 10 + i));
+            uint16_t provider_id = i == 0 ? 0 : 10 + i;
+            auto cache_id = admin.createCache(addr, provider_id, cache_type, cache_config);
+            members.push_back(cachersize::CacheMember{addr, provider_id, cache_id});
+        }
+    }
+
+    void tearDown() {
+        cachersize::Admin admin(engine);
+        for(auto& member : members)
+            admin.destroyCache(member.address, member.provider_id, member.cache_id);
+        members.clear();
+        providers.clear();
+    }
+
+    void testPutGet() {
+        cachersize::Client client(engine);
+        auto handle = client.makeDistributedCacheHandle(members);
+        CPPUNIT_ASSERT_EQUAL((size_t)num_members, handle.numMembers());
+
+        std::vector<size_t> keys_per_member(num_members, 0);
+        for(unsigned i = 0; i < 256; i++) {
+            auto key = "key" + std::to_string(i);
+            handle.put(key, "value" + std::to_string(i));
+            keys_per_member[handle.memberOf(key)] += 1;
+        }
+        for(unsigned i = 0; i < 256; i++) {
+            auto key = "key" + std::to_string(i);
+            std::string value;
+            CPPUNIT_ASSERT_NO_THROW(handle.get(key, &value));
+            CPPUNIT_ASSERT_EQUAL("value" + std::to_string(i), value);
+            // the key is stored by its owner only
+            CPPUNIT_ASSERT_NO_THROW(handle.member(handle.memberOf(key)).get(key, &value));
+        }
+        for(auto n : keys_per_member)
+            CPPUNIT_ASSERT_MESSAGE("keys should be spread over all the members", n > 0);
+
+        // placement does not depend on the order of the members
+        auto reversed = members;
+        std::reverse(reversed.begin(), reversed.end());
+        auto other = client.makeDistributedCacheHandle(reversed);
+        for(unsigned i = 0; i < 256; i++) {
+            auto key = "key" + std::to_string(i);
+            CPPUNIT_ASSERT_EQUAL(handle.memberOf(key),
+                                 num_members - 1 - other.memberOf(key));
+        }
+
+        handle.erase("key0");
+        bool b = true;
+        handle.exists("key0", &b);
+        CPPUNIT_ASSERT(!b);
+    }
+
+    void testMulti() {
+        cachersize::Client client(engine);
+        auto handle = client.makeDistributedCacheHandle(members);
+
+        std::vector<std::string> keys, values;
+        for(unsigned i = 0; i < 64; i++) {
+            keys.push_back("key" + std::to_string(i));
+            values.push_back("value" + std::to_string(i));
+        }
+        std::vector<cachersize::Status> statuses;
+        CPPUNIT_ASSERT_NO_THROW(handle.putMulti(keys, values, &statuses));
+        CPPUNIT_ASSERT_EQUAL(keys.size(), statuses.size());
+
+        auto missing = keys;
+        missing.push_back("missing");
+        std::vector<std::string> got;
+        cachersize::AsyncRequest req;
+        CPPUNIT_ASSERT_NO_THROW(handle.getMulti(missing, &got, &statuses, &req));
+        CPPUNIT_ASSERT_NO_THROW(req.wait());
+        CPPUNIT_ASSERT_EQUAL(missing.size(), got.size());
+        for(size_t i = 0; i < keys.size(); i++) {
+            CPPUNIT_ASSERT(statuses[i] == cachersize::Status::OK);
+            CPPUNIT_ASSERT_EQUAL(values[i], got[i]);
+        }
+        CPPUNIT_ASSERT(statuses.back() == cachersize::Status::NotFound);
+        CPPUNIT_ASSERT_THROW(handle.getMulti(missing, &got), cachersize::Exception);
+
+        CPPUNIT_ASSERT_NO_THROW(handle.eraseMulti(keys));
+        bool b = true;
+        handle.exists(keys[0], &b);
+        CPPUNIT_ASSERT(!b);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( DistributedCacheTest );
@@ -0,0 +1,177 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class EvictionTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( EvictionTest );
+    CPPUNIT_TEST( testNoEviction );
+    CPPUNIT_TEST( testPolicies );
+    CPPUNIT_TEST( testInvalidPolicy );
+    CPPUNIT_TEST( testAdmission );
+    CPPUNIT_TEST( testRejectionKeepsVictim );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr unsigned capacity = 64;
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    static std::string makeConfig(const std::string& policy, bool admission = false) {
+        return "{ \"num_shards\" : 1, \"capacity_entries\" : "
+            + std::to_string(capacity)
+            + ", \"eviction\" : { \"policy\" : \"" + policy + "\" }"
+            + ", \"admission\" : { \"enabled\" : " + (admission ? "true" : "false") + " } }";
+    }
+
+    void testNoEviction() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "memory", makeConfig("none"));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        for(unsigned i = 0; i < capacity; i++)
+            cache.put("key" + std::to_string(i), "value");
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "put should fail on a full cache without eviction",
+                cache.put("one-too-many", "value"),
+                cachersize::Exception);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testPolicies() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        for(auto policy : { "lru", "clock", "s3fifo", "arc" }) {
+            auto cache_id = admin.createCache(addr, 0, "memory", makeConfig(policy));
+            auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+            std::string value;
+            cache.put("hot", "value");
+            for(unsigned i = 0; i < 4*capacity; i++) {
+                CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                        std::string("put should evict with policy ") + policy,
+                        cache.put("key" + std::to_string(i), "value"));
+                cache.get("hot", &value);
+            }
+
+            unsigned resident = 0;
+            for(unsigned i = 0; i < 4*capacity; i++) {
+                bool b = false;
+                cache.exists("key" + std::to_string(i), &b);
+                if(b) resident += 1;
+            }
+            CPPUNIT_ASSERT_MESSAGE(
+                    std::string("cache should not exceed its capacity with policy ") + policy,
+                    resident < capacity);
+
+            bool hot = false;
+            cache.exists("hot", &hot);
+            CPPUNIT_ASSERT_MESSAGE(
+                    std::string("frequently accessed key should not be evicted with policy ") + policy,
+                    hot);
+
+            admin.destroyCache(addr, 0, cache_id);
+        }
+    }
+
+    void testInvalidPolicy() {
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "createCache should fail with an unknown eviction policy",
+                admin.createCache(addr, 0, "memory", makeConfig("blabla")),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "createCache should fail with an admission filter but no eviction policy",
+                admin.createCache(addr, 0, "memory", makeConfig("none", true)),
+                cachersize::Exception);
+    }
+
+    void testAdmission() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "memory", makeConfig("lru", true));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        // fill the cache with keys accessed a few times each
+        std::string value;
+        for(unsigned i = 0; i < capacity; i++) {
+            cache.put("hot" + std::to_string(i), "value");
+            for(unsigned j = 0; j < 3; j++)
+                cache.get("hot" + std::to_string(i), &value);
+        }
+        // a scan of keys accessed once must not flush them
+        for(unsigned i = 0; i < 4*capacity; i++) {
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "put rejected by the admission filter should not fail",
+                    cache.put("scan" + std::to_string(i), "value"));
+        }
+        for(unsigned i = 0; i < capacity; i++) {
+            bool b = false;
+            cache.exists("hot" + std::to_string(i), &b);
+            CPPUNIT_ASSERT_MESSAGE("frequently accessed key should not be evicted by a scan", b);
+        }
+        auto stats = nlohmann::json::parse(cache.getStats())["backend"];
+        CPPUNIT_ASSERT_EQUAL((size_t)4*capacity, stats["admission_rejections"].get<size_t>());
+
+        // a key requested more often than the resident ones is admitted
+        for(unsigned j = 0; j < 8; j++)
+            CPPUNIT_ASSERT_THROW(cache.get("popular", &value), cachersize::Exception);
+        cache.put("popular", "value");
+        bool popular = false;
+        cache.exists("popular", &popular);
+        CPPUNIT_ASSERT(popular);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testRejectionKeepsVictim() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "memory", makeConfig("lru", true));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        std::string value;
+        for(unsigned i = 0; i < capacity; i++) {
+            cache.put("hot" + std::to_string(i), "value");
+            for(unsigned j = 0; j < 3; j++)
+                cache.get("hot" + std::to_string(i), &value);
+        }
+        // a rejected put must not refresh the least recently used key
+        cache.put("cold", "value");
+        for(unsigned j = 0; j < 8; j++)
+            CPPUNIT_ASSERT_THROW(cache.get("popular", &value), cachersize::Exception);
+        cache.put("popular", "value");
+
+        bool b = true;
+        cache.exists("hot0", &b);
+        CPPUNIT_ASSERT_MESSAGE("least recently used key should be evicted", !b);
+        cache.exists("hot1", &b);
+        CPPUNIT_ASSERT_MESSAGE("second least recently used key should be kept", b);
+        auto stats = nlohmann::json::parse(cache.getStats())["backend"];
+        CPPUNIT_ASSERT_EQUAL((size_t)1, stats["admission_rejections"].get<size_t>());
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( EvictionTest );
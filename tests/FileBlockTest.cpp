@@ -0,0 +1,250 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <fstream>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class FileBlockTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( FileBlockTest );
+    CPPUNIT_TEST( testReadBlocks );
+    CPPUNIT_TEST( testWriteThrough );
+    CPPUNIT_TEST( testInvalidKeys );
+    CPPUNIT_TEST( testPathTraversal );
+    CPPUNIT_TEST( testReadAhead );
+    CPPUNIT_TEST( testWriteBack );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr size_t block_size = 1024;
+    static constexpr const char* file_name = "fileblock-test.dat";
+    std::string content;
+
+    public:
+
+    void setUp() {
+        // 15 full blocks and a partial one
+        content.clear();
+        for(size_t i = 0; i < 15*block_size + 100; i++)
+            content.push_back('a' + (i % 26));
+        std::ofstream f(file_name, std::ios::binary);
+        f.write(content.data(), content.size());
+    }
+
+    void tearDown() {
+        std::remove(file_name);
+    }
+
+    static std::string makeConfig(bool writable, bool readahead = false, bool write_back = false) {
+        return "{ \"block_size\" : " + std::to_string(block_size)
+            + ", \"num_shards\" : 2, \"capacity_bytes\" : 65536"
+            + ", \"abt_io_threads\" : 1"
+            + ", \"readahead\" : { \"enabled\" : " + (readahead ? "true" : "false") + " }"
+            + ", \"write_back\" : { \"enabled\" : " + (write_back ? "true" : "false") + " }"
+            + ", \"writable\" : " + (writable ? "true" : "false") + " }";
+    }
+
+    static std::string key(unsigned block) {
+        return std::string(file_name) + ":" + std::to_string(block);
+    }
+
+    void testReadBlocks() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "fileblock", makeConfig(false));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        for(unsigned i = 0; i < 16; i++) {
+            bool cached = true;
+            cache.exists(key(i), &cached);
+            CPPUNIT_ASSERT_MESSAGE("block should not be cached before being read", !cached);
+            std::string block;
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "cache.get() should read the block from the file",
+                    cache.get(key(i), &block));
+            CPPUNIT_ASSERT_EQUAL(content.substr(i*block_size, block_size), block);
+            cache.exists(key(i), &cached);
+            CPPUNIT_ASSERT_MESSAGE("block should be cached after being read", cached);
+        }
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "cache.get() should throw for a block past the end of the file",
+                cache.get(key(16), nullptr),
+                cachersize::Exception);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "cache.put() should throw on a read-only cache",
+                cache.put(key(0), std::string(block_size, 'z')),
+                cachersize::Exception);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testWriteThrough() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "fileblock", makeConfig(true));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        std::string block;
+        cache.get(key(1), &block);
+        cache.put(key(1), std::string(block_size, 'z'));
+        cache.get(key(1), &block);
+        CPPUNIT_ASSERT_EQUAL(std::string(block_size, 'z'), block);
+
+        // a partial write must not leave a stale cached block
+        cache.put(key(1), std::string(10, 'y'));
+        cache.get(key(1), &block);
+        CPPUNIT_ASSERT_EQUAL(std::string(10, 'y') + std::string(block_size - 10, 'z'), block);
+
+        admin.destroyCache(addr, 0, cache_id);
+
+        std::ifstream f(file_name, std::ios::binary);
+        std::string on_disk((std::istreambuf_iterator<char>(f)),
+                             std::istreambuf_iterator<char>());
+        CPPUNIT_ASSERT_EQUAL(block, on_disk.substr(block_size, block_size));
+    }
+
+    void testInvalidKeys() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "fileblock", makeConfig(false));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        for(auto k : { "no-block-index", "fileblock-test.dat:", "fileblock-test.dat:x1" }) {
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    std::string("cache.get() should throw for invalid key ") + k,
+                    cache.get(k, nullptr),
+                    cachersize::Exception);
+        }
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "cache.get() should throw for a missing file",
+                cache.get("no-such-file.dat:0", nullptr),
+                cachersize::Exception);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testPathTraversal() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "fileblock", makeConfig(true));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        for(auto k : { "../fileblock-escape.dat:0", "sub/../../fileblock-escape.dat:0",
+                       "..:0", "/tmp/fileblock-escape.dat:0" }) {
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    std::string("cache.get() should throw for key ") + k,
+                    cache.get(k, nullptr),
+                    cachersize::Exception);
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    std::string("cache.put() should throw for key ") + k,
+                    cache.put(k, "value"),
+                    cachersize::Exception);
+        }
+        std::ifstream escaped("/tmp/fileblock-escape.dat");
+        CPPUNIT_ASSERT_MESSAGE("put() should not create files outside of the root", !escaped.good());
+
+        // other relative paths are still accepted
+        std::string block;
+        CPPUNIT_ASSERT_NO_THROW(cache.get("./" + key(0), &block));
+        CPPUNIT_ASSERT_EQUAL(content.substr(0, block_size), block);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testReadAhead() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "fileblock", makeConfig(false, true));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        // two sequential accesses after the first one trigger read-ahead
+        std::string block;
+        for(unsigned i = 0; i < 3; i++)
+            cache.get(key(i), &block);
+
+        bool cached = false;
+        for(unsigned attempt = 0; attempt < 200 && !cached; attempt++) {
+            cache.exists(key(3), &cached);
+            if(!cached) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT_MESSAGE("the next block should have been read ahead", cached);
+
+        for(unsigned i = 3; i < 16; i++) {
+            cache.get(key(i), &block);
+            CPPUNIT_ASSERT_EQUAL(content.substr(i*block_size, block_size), block);
+        }
+
+        // a random access pattern does not trigger read-ahead
+        cache.get(key(9), &block);
+        cache.get(key(2), &block);
+        cache.erase(key(5));
+        cache.get(key(4), &block);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        cache.exists(key(5), &cached);
+        CPPUNIT_ASSERT_MESSAGE("random accesses should not trigger read-ahead", !cached);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testWriteBack() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "write-back should require a writable cache",
+                admin.createCache(addr, 0, "fileblock", makeConfig(false, false, true)),
+                cachersize::Exception);
+
+        auto cache_id = admin.createCache(addr, 0, "fileblock", makeConfig(true, false, true));
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        // adjacent blocks, to be coalesced into one write
+        for(unsigned i = 4; i < 8; i++)
+            cache.put(key(i), std::string(block_size, 'A' + i));
+        // partial write of a dirty block
+        cache.put(key(5), std::string(10, 'x'));
+
+        std::string block;
+        cache.get(key(5), &block);
+        CPPUNIT_ASSERT_EQUAL(std::string(10, 'x') + std::string(block_size - 10, 'A' + 5), block);
+        cache.erase(key(6)); // dirty data must survive the cached copy
+        cache.get(key(6), &block);
+        CPPUNIT_ASSERT_EQUAL(std::string(block_size, 'A' + 6), block);
+
+        // closing the cache flushes the dirty blocks
+        admin.closeCache(addr, 0, cache_id);
+
+        std::ifstream f(file_name, std::ios::binary);
+        std::string on_disk((std::istreambuf_iterator<char>(f)),
+                             std::istreambuf_iterator<char>());
+        CPPUNIT_ASSERT_EQUAL(content.substr(0, 4*block_size), on_disk.substr(0, 4*block_size));
+        CPPUNIT_ASSERT_EQUAL(std::string(block_size, 'A' + 4), on_disk.substr(4*block_size, block_size));
+        CPPUNIT_ASSERT_EQUAL(std::string(10, 'x') + std::string(block_size - 10, 'A' + 5),
+                             on_disk.substr(5*block_size, block_size));
+        CPPUNIT_ASSERT_EQUAL(std::string(block_size, 'A' + 7), on_disk.substr(7*block_size, block_size));
+        CPPUNIT_ASSERT_EQUAL(content.substr(8*block_size), on_disk.substr(8*block_size));
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( FileBlockTest );
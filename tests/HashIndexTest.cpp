@@ -0,0 +1,141 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class HashIndexTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( HashIndexTest );
+    CPPUNIT_TEST( testAgainstUnorderedMap );
+    CPPUNIT_TEST( testGrowAndEraseAll );
+    CPPUNIT_TEST_SUITE_END();
+
+    using Index = cachersize::HashIndex<uint64_t>;
+    using Reference = std::unordered_map<std::string, uint64_t>;
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    static void checkSame(const Index& index, const Reference& reference) {
+        CPPUNIT_ASSERT_EQUAL(reference.size(), index.size());
+        CPPUNIT_ASSERT_EQUAL(reference.empty(), index.empty());
+        size_t visited = 0;
+        index.for_each([&](const std::string& key, const uint64_t& value) {
+            auto it = reference.find(key);
+            CPPUNIT_ASSERT_MESSAGE("index holds a key erased from the reference",
+                    it != reference.end());
+            CPPUNIT_ASSERT_EQUAL(it->second, value);
+            visited += 1;
+        });
+        CPPUNIT_ASSERT_EQUAL(reference.size(), visited);
+    }
+
+    void testAgainstUnorderedMap() {
+        Index index;
+        Reference reference;
+        std::mt19937_64 rng(42);
+        // few enough distinct keys that inserts, erases and finds hit
+        // existing keys often, and leave tombstones behind
+        std::uniform_int_distribution<unsigned> key_dist(0, 2000);
+        std::uniform_int_distribution<unsigned> op_dist(0, 9);
+
+        for(unsigned step = 0; step < 200000; step++) {
+            // long keys are stored out of line, short ones inline
+            unsigned k = key_dist(rng);
+            std::string key = (k % 3 == 0 ? "a-key-longer-than-the-small-buffer-" : "k")
+                            + std::to_string(k);
+            uint64_t value = rng();
+            unsigned op = op_dist(rng);
+            if(op < 4) {
+                auto r = index.insert_or_assign(key, value);
+                bool inserted = reference.count(key) == 0;
+                reference[key] = value;
+                CPPUNIT_ASSERT_EQUAL(inserted, r.second);
+                CPPUNIT_ASSERT_EQUAL(value, *r.first);
+            } else if(op < 5) {
+                auto r = index.emplace(key, value);
+                auto e = reference.emplace(key, value);
+                CPPUNIT_ASSERT_EQUAL(e.second, r.second);
+                CPPUNIT_ASSERT_EQUAL(e.first->second, *r.first);
+            } else if(op < 7) {
+                CPPUNIT_ASSERT_EQUAL(reference.erase(key) == 1, index.erase(key));
+            } else if(op < 8) {
+                uint64_t extracted = 0;
+                auto it = reference.find(key);
+                bool found = index.extract(key, &extracted);
+                CPPUNIT_ASSERT_EQUAL(it != reference.end(), found);
+                if(found) {
+                    CPPUNIT_ASSERT_EQUAL(it->second, extracted);
+                    reference.erase(it);
+                }
+            } else {
+                auto it = reference.find(key);
+                const uint64_t* v = index.find(key);
+                CPPUNIT_ASSERT_EQUAL(it != reference.end(), v != nullptr);
+                if(v) CPPUNIT_ASSERT_EQUAL(it->second, *v);
+                CPPUNIT_ASSERT_EQUAL(reference.count(key), index.count(key));
+            }
+            if(step % 10000 == 0) checkSame(index, reference);
+        }
+        checkSame(index, reference);
+
+        index.clear();
+        reference.clear();
+        checkSame(index, reference);
+        CPPUNIT_ASSERT(index.find("k1") == nullptr);
+    }
+
+    void testGrowAndEraseAll() {
+        Index index;
+        Reference reference;
+        const unsigned num_keys = 50000;
+
+        // growth from an empty index, through many rehashes
+        size_t capacity = index.capacity();
+        unsigned rehashes = 0;
+        for(unsigned i = 0; i < num_keys; i++) {
+            auto key = "key" + std::to_string(i);
+            CPPUNIT_ASSERT(index.emplace(key, i).second);
+            reference.emplace(key, i);
+            if(index.capacity() != capacity) {
+                capacity = index.capacity();
+                rehashes += 1;
+            }
+        }
+        CPPUNIT_ASSERT(rehashes > 5);
+        CPPUNIT_ASSERT(index.capacity() >= num_keys);
+        checkSame(index, reference);
+
+        // erasing back to empty, in an order unrelated to insertion
+        std::vector<unsigned> order(num_keys);
+        for(unsigned i = 0; i < num_keys; i++) order[i] = i;
+        std::shuffle(order.begin(), order.end(), std::mt19937(7));
+        for(unsigned n = 0; n < num_keys; n++) {
+            auto key = "key" + std::to_string(order[n]);
+            CPPUNIT_ASSERT(index.erase(key));
+            CPPUNIT_ASSERT(!index.erase(key));
+            reference.erase(key);
+            if(n % 5000 == 0) checkSame(index, reference);
+        }
+        CPPUNIT_ASSERT(index.empty());
+        checkSame(index, reference);
+
+        // the index is still usable after being emptied
+        for(unsigned i = 0; i < num_keys; i += 7) {
+            index["key" + std::to_string(i)] = i;
+            reference["key" + std::to_string(i)] = i;
+        }
+        checkSame(index, reference);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( HashIndexTest );
@@ -0,0 +1,187 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <cachersize/Provider.hpp>
+#include <nlohmann/json.hpp>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class MigrationTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( MigrationTest );
+    CPPUNIT_TEST( testMigrate );
+    CPPUNIT_TEST( testWritesDuringMigration );
+    CPPUNIT_TEST( testFailedMigration );
+    CPPUNIT_TEST( testNearCacheReader );
+    CPPUNIT_TEST_SUITE_END();
+
+    // small batches, so that several are in flight
+    static constexpr uint16_t source_id = 1;
+    static constexpr uint16_t dest_id = 2;
+    static constexpr const char* provider_config =
+        "{ \"migration\" : { \"batch_bytes\" : 4096, \"pipeline_depth\" : 4 } }";
+    static constexpr const char* cache_config = "{ \"num_shards\" : 4 }";
+    static constexpr unsigned num_keys = 1000;
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    static std::string value(unsigned i) {
+        return std::string(100 + i % 200, 'a' + (i % 26));
+    }
+
+    static void fill(cachersize::CacheHandle& cache) {
+        for(unsigned i = 0; i < num_keys; i++)
+            cache.put("key" + std::to_string(i), value(i));
+    }
+
+    static void check(cachersize::CacheHandle& cache) {
+        std::string v;
+        for(unsigned i = 0; i < num_keys; i++) {
+            CPPUNIT_ASSERT_NO_THROW(cache.get("key" + std::to_string(i), &v));
+            CPPUNIT_ASSERT_EQUAL(value(i), v);
+        }
+    }
+
+    void testMigrate() {
+        cachersize::Provider source(engine, source_id, provider_config);
+        cachersize::Provider dest(engine, dest_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, source_id, "memory", cache_config);
+        auto cache = client.makeCacheHandle(addr, source_id, cache_id);
+        fill(cache);
+        CPPUNIT_ASSERT(admin.migrateCache(addr, source_id, cache_id, addr, dest_id) >= num_keys);
+
+        // the handle follows the cache to the destination
+        check(cache);
+        cache.put("new-key", "new-value");
+        auto moved = client.makeCacheHandle(addr, dest_id, cache_id);
+        std::string v;
+        moved.get("new-key", &v);
+        CPPUNIT_ASSERT_EQUAL(std::string("new-value"), v);
+        auto stats = nlohmann::json::parse(cache.getStats());
+        CPPUNIT_ASSERT_EQUAL((size_t)num_keys + 1, stats["entries"].get<size_t>());
+
+        // so do handles created after the migration
+        auto late = client.makeCacheHandle(addr, source_id, cache_id);
+        late.get("new-key", &v);
+        CPPUNIT_ASSERT_EQUAL(std::string("new-value"), v);
+
+        // and the cache can migrate back
+        admin.migrateCache(addr, dest_id, cache_id, addr, source_id);
+        check(cache);
+        check(moved);
+        admin.destroyCache(addr, source_id, cache_id);
+    }
+
+    void testWritesDuringMigration() {
+        cachersize::Provider source(engine, source_id, provider_config);
+        cachersize::Provider dest(engine, dest_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, source_id, "memory", cache_config);
+        auto cache = client.makeCacheHandle(addr, source_id, cache_id);
+        fill(cache);
+
+        // writes handled before, during and after the copy all reach
+        // the destination
+        std::vector<std::string> values(num_keys);
+        std::vector<cachersize::AsyncRequest> requests(num_keys);
+        for(unsigned i = 0; i < num_keys; i++) {
+            auto key = "key" + std::to_string(i);
+            values[i] = "updated" + std::to_string(i);
+            if(i % 10 == 0) cache.erase(key, &requests[i]);
+            else cache.put(key, values[i], &requests[i]);
+        }
+        admin.migrateCache(addr, source_id, cache_id, addr, dest_id);
+        for(auto& r : requests) r.wait();
+
+        auto moved = client.makeCacheHandle(addr, dest_id, cache_id);
+        std::string v;
+        for(unsigned i = 0; i < num_keys; i++) {
+            auto key = "key" + std::to_string(i);
+            bool found = true;
+            moved.exists(key, &found);
+            CPPUNIT_ASSERT_EQUAL(i % 10 != 0, found);
+            if(!found) continue;
+            moved.get(key, &v);
+            CPPUNIT_ASSERT_EQUAL(values[i], v);
+        }
+        admin.destroyCache(addr, dest_id, cache_id);
+    }
+
+    void testFailedMigration() {
+        cachersize::Provider source(engine, source_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "migrating an unknown cache should fail",
+                admin.migrateCache(addr, source_id, cachersize::UUID::generate(), addr, 0),
+                cachersize::Exception);
+
+        auto cache_id = admin.createCache(addr, source_id, "memory", cache_config);
+        auto cache = client.makeCacheHandle(addr, source_id, cache_id);
+        fill(cache);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "migrating a cache to its own provider should fail",
+                admin.migrateCache(addr, source_id, cache_id, addr, source_id),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "migrating a cache with an invalid configuration should fail",
+                admin.migrateCache(addr, source_id, cache_id, addr, 0, "not json"),
+                cachersize::Exception);
+
+        // the cache stays on the source
+        check(cache);
+        cache.put("new-key", "new-value");
+        admin.destroyCache(addr, source_id, cache_id);
+    }
+
+    void testNearCacheReader() {
+        cachersize::Provider source(engine, source_id, provider_config);
+        cachersize::Provider dest(engine, dest_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, source_id, "memory", cache_config);
+        auto reader = client.makeCacheHandle(addr, source_id, cache_id, true,
+                "{ \"near_cache\" : { \"max_entries\" : 16 } }");
+        auto writer = client.makeCacheHandle(addr, source_id, cache_id);
+        writer.put("key", "old-value");
+
+        // the reader now holds a lease from the source
+        std::string v;
+        reader.get("key", &v);
+        reader.get("key", &v);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, reader.nearCacheStats().hits);
+
+        // the lease is revoked before requests reach the destination,
+        // which knows nothing about it
+        admin.migrateCache(addr, source_id, cache_id, addr, dest_id);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, reader.nearCacheStats().invalidations);
+        writer.put("key", "new-value");
+        reader.get("key", &v);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                "near cache should not serve a value overwritten after a migration",
+                std::string("new-value"), v);
+
+        admin.destroyCache(addr, dest_id, cache_id);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( MigrationTest );
@@ -0,0 +1,231 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <cachersize/Provider.hpp>
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class SnapshotTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SnapshotTest );
+    CPPUNIT_TEST( testSnapshotAndOpen );
+    CPPUNIT_TEST( testBackgroundRestore );
+    CPPUNIT_TEST( testRestoreKeepsNewerValues );
+    CPPUNIT_TEST( testInvalidSnapshot );
+    CPPUNIT_TEST( testCorruptedSnapshot );
+    CPPUNIT_TEST_SUITE_END();
+
+    // small chunks, so that snapshots are written and loaded in parallel
+    static constexpr uint16_t provider_id = 1;
+    static constexpr const char* provider_config =
+        "{ \"snapshot\" : { \"chunk_bytes\" : 4096, \"abt_io_threads\" : 4 } }";
+    static constexpr const char* cache_config = "{ \"num_shards\" : 4 }";
+    static constexpr const char* path = "SnapshotTest.snapshot";
+    static constexpr unsigned num_keys = 1000;
+
+    public:
+
+    void setUp() {}
+    void tearDown() {
+        std::remove(path);
+    }
+
+    static std::string value(unsigned i) {
+        return std::string(100 + i % 200, 'a' + (i % 26));
+    }
+
+    static void fill(cachersize::CacheHandle& cache) {
+        for(unsigned i = 0; i < num_keys; i++)
+            cache.put("key" + std::to_string(i), value(i));
+        // expires long before the test ends
+        cachersize::PutOptions options;
+        options.ttl_ms = 100;
+        cache.put("short-lived", "value", options);
+    }
+
+    static void check(cachersize::CacheHandle& cache) {
+        std::string v;
+        for(unsigned i = 0; i < num_keys; i++) {
+            CPPUNIT_ASSERT_NO_THROW(cache.get("key" + std::to_string(i), &v));
+            CPPUNIT_ASSERT_EQUAL(value(i), v);
+        }
+    }
+
+    void testSnapshotAndOpen() {
+        cachersize::Provider provider(engine, provider_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto source_id = admin.createCache(addr, provider_id, "memory", cache_config);
+        auto source = client.makeCacheHandle(addr, provider_id, source_id);
+        fill(source);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)num_keys + 1,
+                admin.snapshotCache(addr, provider_id, source_id, path));
+        admin.destroyCache(addr, provider_id, source_id);
+        thallium::thread::sleep(engine, 200.0);
+
+        auto config = nlohmann::json::parse(cache_config);
+        config["snapshot"] = path;
+        auto cache_id = admin.openCache(addr, provider_id, "memory", config);
+        auto cache = client.makeCacheHandle(addr, provider_id, cache_id);
+        check(cache);
+        bool found = true;
+        cache.exists("short-lived", &found);
+        CPPUNIT_ASSERT(!found);
+
+        auto stats = nlohmann::json::parse(cache.getStats());
+        CPPUNIT_ASSERT_EQUAL(std::string("restored"), stats["restore"]["state"].get<std::string>());
+        CPPUNIT_ASSERT_EQUAL((size_t)num_keys, stats["restore"]["entries"].get<size_t>());
+
+        admin.destroyCache(addr, provider_id, cache_id);
+    }
+
+    void testBackgroundRestore() {
+        cachersize::Provider provider(engine, provider_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto source_id = admin.createCache(addr, provider_id, "memory", cache_config);
+        auto source = client.makeCacheHandle(addr, provider_id, source_id);
+        fill(source);
+        admin.snapshotCache(addr, provider_id, source_id, path);
+        admin.destroyCache(addr, provider_id, source_id);
+
+        auto config = nlohmann::json::parse(cache_config);
+        config["snapshot"] = { { "path", path }, { "wait", false } };
+        auto cache_id = admin.openCache(addr, provider_id, "memory", config);
+        auto cache = client.makeCacheHandle(addr, provider_id, cache_id);
+        // the cache serves requests while it is restored
+        cache.put("new-key", "new-value");
+
+        std::string state;
+        for(unsigned i = 0; i < 100 && state != "restored"; i++) {
+            thallium::thread::sleep(engine, 10.0);
+            state = nlohmann::json::parse(cache.getStats())["restore"]["state"].get<std::string>();
+        }
+        CPPUNIT_ASSERT_EQUAL(std::string("restored"), state);
+        check(cache);
+        std::string v;
+        cache.get("new-key", &v);
+        CPPUNIT_ASSERT_EQUAL(std::string("new-value"), v);
+
+        admin.destroyCache(addr, provider_id, cache_id);
+    }
+
+    void testRestoreKeepsNewerValues() {
+        cachersize::Provider provider(engine, provider_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, provider_id, "memory", cache_config);
+        auto cache = client.makeCacheHandle(addr, provider_id, cache_id);
+        fill(cache);
+        admin.snapshotCache(addr, provider_id, cache_id, path);
+
+        cache.put("key0", "newer");
+        cache.erase("key1");
+        // only the erased key is loaded again
+        CPPUNIT_ASSERT_EQUAL((uint64_t)1, admin.restoreCache(addr, provider_id, cache_id, path));
+        std::string v;
+        cache.get("key0", &v);
+        CPPUNIT_ASSERT_EQUAL(std::string("newer"), v);
+        cache.get("key1", &v);
+        CPPUNIT_ASSERT_EQUAL(value(1), v);
+
+        admin.destroyCache(addr, provider_id, cache_id);
+    }
+
+    void testInvalidSnapshot() {
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "memory", cache_config);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "restoring a missing snapshot should fail",
+                admin.restoreCache(addr, 0, cache_id, "no-such-snapshot"),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "opening a cache from a missing snapshot should fail",
+                admin.openCache(addr, 0, "memory", std::string("{ \"snapshot\" : \"no-such-snapshot\" }")),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "an invalid snapshot field should be rejected",
+                admin.openCache(addr, 0, "memory", std::string("{ \"snapshot\" : 42 }")),
+                cachersize::Exception);
+        admin.destroyCache(addr, 0, cache_id);
+
+        auto dummy_id = admin.createCache(addr, 0, "dummy", "{}");
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "snapshotting a backend that cannot be scanned should fail",
+                admin.snapshotCache(addr, 0, dummy_id, path),
+                cachersize::Exception);
+        admin.destroyCache(addr, 0, dummy_id);
+    }
+
+    void testCorruptedSnapshot() {
+        cachersize::Provider provider(engine, provider_id, provider_config);
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, provider_id, "memory", cache_config);
+        auto cache = client.makeCacheHandle(addr, provider_id, cache_id);
+        fill(cache);
+        admin.snapshotCache(addr, provider_id, cache_id, path);
+        std::string content;
+        {
+            std::ifstream f(path, std::ios::binary);
+            content.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+        auto rewrite = [](const std::string& data) {
+            std::ofstream f(path, std::ios::binary | std::ios::trunc);
+            f.write(data.data(), data.size());
+        };
+
+        // the index is past the end of a truncated file
+        rewrite(content.substr(0, content.size() / 2));
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "restoring a truncated snapshot should fail",
+                admin.restoreCache(addr, provider_id, cache_id, path),
+                cachersize::Exception);
+
+        // a huge number of chunks in the header
+        auto corrupted = content;
+        for(int i = 8; i < 16; i++) corrupted[i] = '\xff';
+        rewrite(corrupted);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "restoring a snapshot with a corrupted header should fail",
+                admin.restoreCache(addr, provider_id, cache_id, path),
+                cachersize::Exception);
+
+        // a chunk that extends past the index (first index entry's size)
+        corrupted = content;
+        uint64_t index_offset;
+        std::memcpy(&index_offset, content.data() + 24, sizeof(index_offset));
+        for(int i = 0; i < 8; i++) corrupted[index_offset + 8 + i] = '\x7f';
+        rewrite(corrupted);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "restoring a snapshot with a corrupted index should fail",
+                admin.restoreCache(addr, provider_id, cache_id, path),
+                cachersize::Exception);
+
+        // the cache is still usable
+        check(cache);
+        admin.destroyCache(addr, provider_id, cache_id);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( SnapshotTest );
@@ -0,0 +1,151 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cachersize/Client.hpp>
+#include <cachersize/Admin.hpp>
+#include <nlohmann/json.hpp>
+
+extern thallium::engine engine;
+extern std::string cache_type;
+
+class TieredTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TieredTest );
+    CPPUNIT_TEST( testDemoteAndPromote );
+    CPPUNIT_TEST( testOverwriteAndErase );
+    CPPUNIT_TEST( testDiskEviction );
+    CPPUNIT_TEST( testInvalidConfig );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr size_t value_size = 500;
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    // a memory tier of about 8 values and a disk tier of about 128
+    static std::string makeConfig() {
+        return "{ \"spill_dir\" : \".\", \"num_shards\" : 1"
+               ", \"memory_bytes\" : 4096, \"disk_bytes\" : 65536"
+               ", \"segment_bytes\" : 8192, \"write_buffer_bytes\" : 1024"
+               ", \"compaction_interval_ms\" : 10, \"abt_io_threads\" : 1 }";
+    }
+
+    static std::string value(unsigned i) {
+        return std::string(value_size, 'a' + (i % 26));
+    }
+
+    static nlohmann::json backendStats(cachersize::CacheHandle& cache) {
+        return nlohmann::json::parse(cache.getStats())["backend"];
+    }
+
+    void testDemoteAndPromote() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "tiered", makeConfig());
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        for(unsigned i = 0; i < 20; i++)
+            cache.put("key" + std::to_string(i), value(i));
+        auto stats = backendStats(cache);
+        CPPUNIT_ASSERT(stats["demotions"].get<size_t>() >= 12);
+        CPPUNIT_ASSERT_EQUAL((size_t)20, stats["entries"].get<size_t>());
+
+        for(unsigned i = 0; i < 20; i++) {
+            bool found = false;
+            cache.exists("key" + std::to_string(i), &found);
+            CPPUNIT_ASSERT(found);
+            std::string v;
+            CPPUNIT_ASSERT_NO_THROW(cache.get("key" + std::to_string(i), &v));
+            CPPUNIT_ASSERT_EQUAL(value(i), v);
+        }
+        stats = backendStats(cache);
+        CPPUNIT_ASSERT(stats["promotions"].get<size_t>() >= 12);
+        CPPUNIT_ASSERT_EQUAL((size_t)20, stats["entries"].get<size_t>());
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testOverwriteAndErase() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "tiered", makeConfig());
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        // key0 and key1 end up in the disk tier
+        for(unsigned i = 0; i < 12; i++)
+            cache.put("key" + std::to_string(i), value(i));
+        cache.put("key0", "new value");
+        cache.erase("key1");
+
+        std::string v;
+        cache.get("key0", &v);
+        CPPUNIT_ASSERT_EQUAL(std::string("new value"), v);
+        bool found = true;
+        cache.exists("key1", &found);
+        CPPUNIT_ASSERT(!found);
+        CPPUNIT_ASSERT_THROW(cache.get("key1", &v), cachersize::Exception);
+
+        // a value too large for the memory tier goes to the disk tier
+        std::string large(6000, 'z');
+        cache.put("large", large);
+        cache.get("large", &v);
+        CPPUNIT_ASSERT_EQUAL(large, v);
+
+        CPPUNIT_ASSERT_THROW(cache.put("huge", std::string(10000, 'z')), cachersize::Exception);
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testDiskEviction() {
+        cachersize::Admin admin(engine);
+        cachersize::Client client(engine);
+        std::string addr = engine.self();
+
+        auto cache_id = admin.createCache(addr, 0, "tiered", makeConfig());
+        auto cache = client.makeCacheHandle(addr, 0, cache_id);
+
+        for(unsigned i = 0; i < 400; i++)
+            cache.put("key" + std::to_string(i), value(i));
+        // let the compactor bring the disk tier back within its capacity
+        thallium::thread::sleep(engine, 200.0);
+
+        auto stats = backendStats(cache);
+        CPPUNIT_ASSERT(stats["evictions"].get<size_t>() > 0);
+        CPPUNIT_ASSERT(stats["disk"]["file_bytes"].get<size_t>() <= 65536);
+        CPPUNIT_ASSERT(stats["entries"].get<size_t>() < 400);
+
+        // the most recent values are still cached
+        for(unsigned i = 395; i < 400; i++) {
+            std::string v;
+            CPPUNIT_ASSERT_NO_THROW(cache.get("key" + std::to_string(i), &v));
+            CPPUNIT_ASSERT_EQUAL(value(i), v);
+        }
+
+        admin.destroyCache(addr, 0, cache_id);
+    }
+
+    void testInvalidConfig() {
+        cachersize::Admin admin(engine);
+        std::string addr = engine.self();
+
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "creating a tiered cache without spill_dir should fail",
+                admin.createCache(addr, 0, "tiered", "{}"),
+                cachersize::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "creating a tiered cache with a disk tier smaller than two segments should fail",
+                admin.createCache(addr, 0, "tiered",
+                    "{ \"spill_dir\" : \".\", \"segment_bytes\" : 4096, \"disk_bytes\" : 4096 }"),
+                cachersize::Exception);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( TieredTest );